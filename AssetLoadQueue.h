@@ -0,0 +1,149 @@
+#pragma once
+#include "pch.h"
+#include "ResourceRegistry.h"
+#include "ThreadPool.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <future>
+#include <chrono>
+#include <functional>
+
+// AssetLoadQueue is the bookkeeping behind AssetLoader, kept apart from Texture and ObjectStore so that it can be
+// tested without a device or image files. The three halves of loading a resource are handed in: create makes the
+// (empty) resource, decode turns a file into an Image on a worker thread, and upload fills the resource from the
+// Image on the thread that calls Update.
+//
+// Load looks the file up in the registry first, so every request for the same file shares one decode and one
+// resource. A new resource is added to the registry straight away, with the queue as its reload source.
+template <typename Resource, typename Image>
+class AssetLoadQueue
+{
+public:
+	using CreateFunction = std::function<std::shared_ptr<Resource>()>;
+	using DecodeFunction = std::function<std::unique_ptr<Image>(const std::string& filename)>;	// Runs on a worker
+	using UploadFunction = std::function<void(Resource& resource, const Image& image)>;
+
+	// The registry must not reload anything through the queue once the queue is gone
+	AssetLoadQueue(ResourceRegistry<Resource>& registry, ThreadPool& pool, CreateFunction create, DecodeFunction decode, UploadFunction upload) :
+		m_registry(registry), m_pool(pool), m_create(create), m_decode(decode), m_upload(upload) {}
+	AssetLoadQueue(const AssetLoadQueue&) = delete;
+	AssetLoadQueue& operator=(const AssetLoadQueue&) = delete;
+	~AssetLoadQueue() { Clear(); }
+
+	std::shared_ptr<Resource> Load(const std::string& filename);
+
+	// Uploads at most maxUploads finished resources, in request order. Rethrows the exception of a decode that
+	// failed - that request is dropped, so the next call carries on with the rest
+	void Update(unsigned int maxUploads);
+
+	// Blocks until every resource requested so far has been uploaded
+	void WaitForAll();
+
+	// Waits for decodes that are still running and drops them without uploading
+	void Clear();
+
+	size_t PendingCount() const { return m_pending.size(); }
+
+private:
+	struct Pending
+	{
+		std::shared_ptr<Resource> resource;
+		std::shared_ptr<std::unique_ptr<Image>> image;	// Filled in by the worker
+		std::future<void> decoded;
+	};
+
+	std::shared_ptr<Resource> Queue(const std::string& filename);
+	void Upload(Pending& pending);
+
+	ResourceRegistry<Resource>& m_registry;
+	ThreadPool& m_pool;
+	CreateFunction m_create;
+	DecodeFunction m_decode;
+	UploadFunction m_upload;
+	std::vector<Pending> m_pending;
+};
+
+template <typename Resource, typename Image>
+std::shared_ptr<Resource> AssetLoadQueue<Resource, Image>::Load(const std::string& filename)
+{
+	typename ResourceRegistry<Resource>::Handle existing = m_registry.Find(filename);
+	if (existing.IsValid())
+		return m_registry.Get(existing);
+
+	std::shared_ptr<Resource> resource = Queue(filename);
+	m_registry.Add(filename, resource, [this, filename]() { return Queue(filename); });
+	return resource;
+}
+
+template <typename Resource, typename Image>
+std::shared_ptr<Resource> AssetLoadQueue<Resource, Image>::Queue(const std::string& filename)
+{
+	Pending pending;
+	pending.resource = m_create();
+	pending.image = std::make_shared<std::unique_ptr<Image>>();
+
+	// Only the decode runs on the worker - it gets its own copies of everything it needs
+	DecodeFunction decode = m_decode;
+	std::shared_ptr<std::unique_ptr<Image>> image = pending.image;
+	pending.decoded = m_pool.Submit([decode, filename, image]() { *image = decode(filename); });
+
+	m_pending.push_back(std::move(pending));
+	return m_pending.back().resource;
+}
+
+template <typename Resource, typename Image>
+void AssetLoadQueue<Resource, Image>::Update(unsigned int maxUploads)
+{
+	// Uploads happen in request order, so the first resources a scene asks for show up first
+	unsigned int uploads = 0;
+	size_t iii = 0;
+	while (iii < m_pending.size() && uploads < maxUploads)
+	{
+		if (m_pending[iii].decoded.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		{
+			++iii;
+			continue;
+		}
+
+		Pending pending = std::move(m_pending[iii]);
+		m_pending.erase(m_pending.begin() + iii);
+
+		Upload(pending);
+		++uploads;
+	}
+}
+
+template <typename Resource, typename Image>
+void AssetLoadQueue<Resource, Image>::WaitForAll()
+{
+	while (!m_pending.empty())
+	{
+		Pending pending = std::move(m_pending.front());
+		m_pending.erase(m_pending.begin());
+
+		Upload(pending);
+	}
+}
+
+template <typename Resource, typename Image>
+void AssetLoadQueue<Resource, Image>::Clear()
+{
+	// The workers write into the pending images, so they have to finish before the entries go away
+	for (Pending& pending : m_pending)
+	{
+		if (pending.decoded.valid())
+			pending.decoded.wait();
+	}
+
+	m_pending.clear();
+}
+
+template <typename Resource, typename Image>
+void AssetLoadQueue<Resource, Image>::Upload(Pending& pending)
+{
+	// Rethrows anything the decode threw
+	pending.decoded.get();
+	m_upload(*pending.resource, **pending.image);
+}
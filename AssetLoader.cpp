@@ -0,0 +1,60 @@
+#include "AssetLoader.h"
+
+std::shared_ptr<DeviceResources> AssetLoader::m_deviceResources = nullptr;
+std::unique_ptr<AssetLoadQueue<Texture, DirectX::ScratchImage>> AssetLoader::m_textures = nullptr;
+
+void AssetLoader::Initialize(std::shared_ptr<DeviceResources> deviceResources)
+{
+	m_deviceResources = deviceResources;
+	m_textures = std::make_unique<AssetLoadQueue<Texture, DirectX::ScratchImage>>(
+		ObjectStore::GetTextureRegistry(),
+		ThreadPool::Default(),
+		[]() { return std::make_shared<Texture>(m_deviceResources); },
+		Decode,
+		[](Texture& texture, const DirectX::ScratchImage& image) { texture.Upload(image); }
+	);
+}
+
+void AssetLoader::Shutdown()
+{
+	m_textures = nullptr;
+	m_deviceResources = nullptr;
+}
+
+std::shared_ptr<Texture> AssetLoader::LoadTexture(const std::string& filename)
+{
+	return m_textures->Load(filename);
+}
+
+void AssetLoader::Update(unsigned int maxUploads)
+{
+	m_textures->Update(maxUploads);
+}
+
+void AssetLoader::WaitForAll()
+{
+	m_textures->WaitForAll();
+}
+
+std::unique_ptr<DirectX::ScratchImage> AssetLoader::Decode(const std::string& filename)
+{
+	// WIC needs COM on every thread that uses it. The pool's threads are not ours to set up, so each task
+	// initializes (and releases) it for itself
+	HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+	std::unique_ptr<DirectX::ScratchImage> image;
+	try
+	{
+		// The loader only ever creates textures in the default format
+		image = Texture::Decode(filename, DXGI_FORMAT_R8G8B8A8_UNORM);
+	}
+	catch (...)
+	{
+		if (SUCCEEDED(hr))
+			CoUninitialize();
+		throw;
+	}
+
+	if (SUCCEEDED(hr))
+		CoUninitialize();
+	return image;
+}
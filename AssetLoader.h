@@ -0,0 +1,49 @@
+#pragma once
+#include "pch.h"
+
+#include "AssetLoadQueue.h"
+#include "DeviceResources.h"
+#include "ObjectStore.h"
+#include "Texture.h"
+#include "ThreadPool.h"
+
+#include <memory>
+#include <string>
+
+// AssetLoader is intended to be a static class
+//
+// AssetLoader decodes textures on ThreadPool::Default() so that loading a scene does not block on reading and
+// converting every image file one after the other. LoadTexture hands back the Texture straight away - it can be
+// added to a TextureArray immediately and simply binds as a null view until it is ready. Update, called once a
+// frame on the thread that owns the device context, uploads the textures whose decode has finished.
+//
+// Textures are stored in ObjectStore under their filename, so every request for the same file (e.g. the
+// materials of a model sharing a texture) shares one decode and one GPU texture. They are registered with the
+// file as their reload source, so ObjectStore may evict them once nothing uses them any more. The bookkeeping is
+// done by an AssetLoadQueue.
+class AssetLoader
+{
+public:
+	static void Initialize(std::shared_ptr<DeviceResources> deviceResources);
+
+	// Waits for decodes that are still running and drops them without uploading
+	static void Shutdown();
+
+	static std::shared_ptr<Texture> LoadTexture(const std::string& filename);
+
+	// Uploads at most maxUploads finished textures. Rethrows the exception of a decode that failed
+	static void Update(unsigned int maxUploads = 4);
+
+	// Blocks until every texture requested so far has been uploaded
+	static void WaitForAll();
+
+	static size_t PendingCount() { return m_textures == nullptr ? 0 : m_textures->PendingCount(); }
+
+private:
+	AssetLoader() {} // Disallow creation of an AssetLoader object
+
+	static std::unique_ptr<DirectX::ScratchImage> Decode(const std::string& filename);
+
+	static std::shared_ptr<DeviceResources> m_deviceResources;
+	static std::unique_ptr<AssetLoadQueue<Texture, DirectX::ScratchImage>> m_textures;
+};
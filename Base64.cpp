@@ -1,103 +1,222 @@
 #include "Base64.h"
 
-const uint8_t Base64::tableDecodeBase64[128] = {
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 62, 0, 0, 0, 63,
-    52, 53, 54, 55, 56, 57, 58, 59, 60, 61, 0, 0, 0, 64, 0, 0,
-    0, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14,
-    15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 0, 0, 0, 0, 0,
-    0, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
-    41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, 0, 0, 0, 0, 0
+// 0xFF marks every character that is not part of the base64 alphabet (including '=', which is only valid as
+// padding and is handled separately)
+const uint8_t Base64::tableDecodeBase64[256] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 62,   0xFF, 0xFF, 0xFF, 63,
+    52,   53,   54,   55,   56,   57,   58,   59,   60,   61,   0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0,    1,    2,    3,    4,    5,    6,    7,    8,    9,    10,   11,   12,   13,   14,
+    15,   16,   17,   18,   19,   20,   21,   22,   23,   24,   25,   0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 26,   27,   28,   29,   30,   31,   32,   33,   34,   35,   36,   37,   38,   39,   40,
+    41,   42,   43,   44,   45,   46,   47,   48,   49,   50,   51,   0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF
 };
 
-const char* Base64::tableEncodeBase64 = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/=";
+const char* Base64::tableEncodeBase64 = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 
-inline char Base64::EncodeChar(uint8_t b) {
-    return tableEncodeBase64[size_t(b)];
+Base64::Implementation Base64::s_implementation = Base64::BestImplementation();
+
+Base64::Implementation Base64::BestImplementation() {
+    if (CpuFeatures::HasAvx2())
+        return Implementation::AVX2;
+    if (CpuFeatures::HasSsse3())
+        return Implementation::SSSE3;
+    return Implementation::SCALAR;
 }
 
-inline uint8_t Base64::DecodeChar(char c) {
-    if (c & 0x80) {
-        std::ostringstream oss;
-        oss << "Invalid base64 char value: " << sizeof(c);
-        throw Base64Exception(__LINE__, __FILE__, oss.str());
-    }
-    return Base64::tableDecodeBase64[size_t(c & 0x7F)]; // TODO faster with lookup table or ifs?
+void Base64::SetImplementation(Implementation implementation) {
+    // AVX2 implies SSSE3, so the order of the enum is also the order of support
+    s_implementation = std::min(implementation, BestImplementation());
 }
 
-void Base64::Encode(const uint8_t* in, size_t inLength, std::string& out) {
-    size_t outLength = ((inLength + 2) / 3) * 4;
-
-    size_t j = out.size();
-    out.resize(j + outLength);
-
-    for (size_t i = 0; i < inLength; i += 3) {
-        uint8_t b = (in[i] & 0xFC) >> 2;
-        out[j++] = EncodeChar(b);
-
-        b = (in[i] & 0x03) << 4;
-        if (i + 1 < inLength) {
-            b |= (in[i + 1] & 0xF0) >> 4;
-            out[j++] = EncodeChar(b);
-
-            b = (in[i + 1] & 0x0F) << 2;
-            if (i + 2 < inLength) {
-                b |= (in[i + 2] & 0xC0) >> 6;
-                out[j++] = EncodeChar(b);
-
-                b = in[i + 2] & 0x3F;
-                out[j++] = EncodeChar(b);
-            }
-            else {
-                out[j++] = EncodeChar(b);
-                out[j++] = '=';
-            }
-        }
-        else {
-            out[j++] = EncodeChar(b);
-            out[j++] = '=';
-            out[j++] = '=';
-        }
-    }
+void Base64::ThrowInvalidCharacter(const char* in, size_t inLength, size_t index) {
+    std::ostringstream oss;
+    oss << "Invalid base64 char value: " << static_cast<int>(static_cast<uint8_t>(in[index])) << " at index " << index
+        << " of \"" << std::string(in, std::min(size_t(32), inLength)) << "\"";
+    throw Base64Exception(__LINE__, __FILE__, oss.str());
 }
 
-void Base64::Encode(const std::vector<uint8_t>& in, std::string& out) {
-    Base64::Encode(in.data(), in.size(), out);
+// =======================================================================
+// Encoding
+
+void Base64::Encode(const uint8_t* in, size_t inLength, char* out) {
+    size_t i = 0;
+    size_t j = 0;
+
+    switch (s_implementation) {
+    case Implementation::AVX2:
+        EncodeAvx2(in, inLength, out, i, j);
+        [[fallthrough]];
+    case Implementation::SSSE3:
+        EncodeSsse3(in, inLength, out, i, j);
+        break;
+    default:
+        break;
+    }
+
+    // Whole groups of 3 bytes
+    for (; i + 3 <= inLength; i += 3) {
+        uint32_t triple = (uint32_t(in[i]) << 16) | (uint32_t(in[i + 1]) << 8) | uint32_t(in[i + 2]);
+        out[j++] = tableEncodeBase64[(triple >> 18) & 0x3F];
+        out[j++] = tableEncodeBase64[(triple >> 12) & 0x3F];
+        out[j++] = tableEncodeBase64[(triple >> 6) & 0x3F];
+        out[j++] = tableEncodeBase64[triple & 0x3F];
+    }
+
+    // 1 or 2 bytes left over are padded with '='
+    if (i < inLength) {
+        uint32_t triple = uint32_t(in[i]) << 16;
+        if (i + 1 < inLength)
+            triple |= uint32_t(in[i + 1]) << 8;
+
+        out[j++] = tableEncodeBase64[(triple >> 18) & 0x3F];
+        out[j++] = tableEncodeBase64[(triple >> 12) & 0x3F];
+        out[j++] = i + 1 < inLength ? tableEncodeBase64[(triple >> 6) & 0x3F] : '=';
+        out[j++] = '=';
+    }
 }
 
 std::string Base64::Encode(const std::vector<uint8_t>& in) {
-    std::string encoded;
-    Base64::Encode(in, encoded);
+    std::string encoded(EncodedSize(in.size()), '\0');
+    Base64::Encode(in.data(), in.size(), encoded.data());
     return encoded;
 }
 
-size_t Base64::Decode(const char* in, size_t inLength, uint8_t*& out) {
+// Splits 12 bytes into 16 6-bit values (one per byte) - see Wojciech Mula's "base64 encoding with SIMD"
+static inline __m128i EncodeReshuffle(__m128i in) {
+    in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+
+    const __m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0FC0FC00));
+    const __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+    const __m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003F03F0));
+    const __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+    return _mm_or_si128(t1, t3);
+}
+
+// Maps 6-bit values to their characters by adding the offset of the range each one falls in
+static inline __m128i EncodeTranslate(__m128i in) {
+    const __m128i lut = _mm_setr_epi8(65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0);
+
+    __m128i indices = _mm_subs_epu8(in, _mm_set1_epi8(51));
+    __m128i mask = _mm_cmpgt_epi8(in, _mm_set1_epi8(25));
+    indices = _mm_sub_epi8(indices, mask);
+    return _mm_add_epi8(in, _mm_shuffle_epi8(lut, indices));
+}
+
+void Base64::EncodeSsse3(const uint8_t* in, size_t inLength, char* out, size_t& i, size_t& j) {
+    // Each iteration reads 16 bytes but only encodes the first 12
+    for (; i + 16 <= inLength; i += 12, j += 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + j), EncodeTranslate(EncodeReshuffle(bytes)));
+    }
+}
+
+void Base64::EncodeAvx2(const uint8_t* in, size_t inLength, char* out, size_t& i, size_t& j) {
+    if (i + 32 > inLength)
+        return;
+
+    const __m256i lut = _mm256_setr_epi8(
+        65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0,
+        65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0);
+
+    // Each iteration encodes 24 bytes, 12 per lane. The lower lane expects its bytes at offset 4 and the upper lane
+    // at offset 0, which is what loading from 4 bytes before the input gives. The very first load cannot start before
+    // the input, so its lower lane is moved up by a dword instead
+    __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+    bytes = _mm256_permutevar8x32_epi32(bytes, _mm256_setr_epi32(0, 0, 1, 2, 3, 4, 5, 6));
+
+    while (true) {
+        bytes = _mm256_shuffle_epi8(bytes, _mm256_set_epi8(
+            10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1,
+            14, 15, 13, 14, 11, 12, 10, 11, 8, 9, 7, 8, 5, 6, 4, 5));
+
+        const __m256i t0 = _mm256_and_si256(bytes, _mm256_set1_epi32(0x0FC0FC00));
+        const __m256i t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+        const __m256i t2 = _mm256_and_si256(bytes, _mm256_set1_epi32(0x003F03F0));
+        const __m256i t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+        const __m256i values = _mm256_or_si256(t1, t3);
+
+        __m256i indices = _mm256_subs_epu8(values, _mm256_set1_epi8(51));
+        __m256i mask = _mm256_cmpgt_epi8(values, _mm256_set1_epi8(25));
+        indices = _mm256_sub_epi8(indices, mask);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + j), _mm256_add_epi8(values, _mm256_shuffle_epi8(lut, indices)));
+
+        i += 24;
+        j += 32;
+
+        // The next load covers [i - 4, i + 28)
+        if (i + 28 > inLength)
+            break;
+
+        bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i - 4));
+    }
+
+    _mm256_zeroupper();
+}
+
+// =======================================================================
+// Decoding
+
+size_t Base64::DecodedSize(const char* in, size_t inLength) {
     if (inLength % 4 != 0) {
         std::ostringstream oss;
         oss << "Invalid base64 encoded data: \"" << std::string(in, std::min(size_t(32), inLength)) << "\", length: " << inLength;
         throw Base64Exception(__LINE__, __FILE__, oss.str());
     }
 
-    if (inLength < 4) {
-        out = nullptr;
+    if (inLength < 4)
         return 0;
-    }
 
-    int nEquals = int(in[inLength - 1] == '=') +
-        int(in[inLength - 2] == '=');
+    // Only the last quartet may be padded, with at most two '='
+    size_t nEquals = 0;
+    if (in[inLength - 1] == '=')
+        nEquals = in[inLength - 2] == '=' ? 2 : 1;
 
-    size_t outLength = (inLength * 3) / 4 - nEquals;
-    out = new uint8_t[outLength];
-    memset(out, 0, outLength);
+    return (inLength * 3) / 4 - nEquals;
+}
+
+size_t Base64::Decode(const char* in, size_t inLength, uint8_t* out) {
+    size_t outLength = DecodedSize(in, inLength);
+    if (inLength < 4)
+        return 0;
 
-    size_t i, j = 0;
+    // Everything but the last quartet (which may hold padding) is decoded by the fastest implementation available
+    size_t bodyLength = inLength - 4;
+    size_t i = 0;
+    size_t j = 0;
 
-    for (i = 0; i + 4 < inLength; i += 4) {
-        uint8_t b0 = DecodeChar(in[i]);
-        uint8_t b1 = DecodeChar(in[i + 1]);
-        uint8_t b2 = DecodeChar(in[i + 2]);
-        uint8_t b3 = DecodeChar(in[i + 3]);
+    switch (s_implementation) {
+    case Implementation::AVX2:
+        DecodeAvx2(in, bodyLength, out, outLength, i, j);
+        [[fallthrough]];
+    case Implementation::SSSE3:
+        DecodeSsse3(in, bodyLength, out, outLength, i, j);
+        break;
+    default:
+        break;
+    }
+
+    for (; i < bodyLength; i += 4) {
+        uint8_t b0 = tableDecodeBase64[uint8_t(in[i])];
+        uint8_t b1 = tableDecodeBase64[uint8_t(in[i + 1])];
+        uint8_t b2 = tableDecodeBase64[uint8_t(in[i + 2])];
+        uint8_t b3 = tableDecodeBase64[uint8_t(in[i + 3])];
+
+        // Invalid characters are 0xFF, so a single test covers all four
+        if ((b0 | b1 | b2 | b3) & 0x80) {
+            for (size_t k = i; ; ++k)
+                if (tableDecodeBase64[uint8_t(in[k])] & 0x80)
+                    ThrowInvalidCharacter(in, inLength, k);
+        }
 
         out[j++] = (uint8_t)((b0 << 2) | (b1 >> 4));
         out[j++] = (uint8_t)((b1 << 4) | (b2 >> 2));
@@ -105,32 +224,107 @@ size_t Base64::Decode(const char* in, size_t inLength, uint8_t*& out) {
     }
 
     {
-        uint8_t b0 = DecodeChar(in[i]);
-        uint8_t b1 = DecodeChar(in[i + 1]);
-        uint8_t b2 = DecodeChar(in[i + 2]);
-        uint8_t b3 = DecodeChar(in[i + 3]);
+        size_t padding = (inLength * 3) / 4 - outLength;
+        uint8_t b0 = tableDecodeBase64[uint8_t(in[i])];
+        uint8_t b1 = tableDecodeBase64[uint8_t(in[i + 1])];
+        uint8_t b2 = padding >= 2 ? 0 : tableDecodeBase64[uint8_t(in[i + 2])];
+        uint8_t b3 = padding >= 1 ? 0 : tableDecodeBase64[uint8_t(in[i + 3])];
+
+        if ((b0 | b1 | b2 | b3) & 0x80) {
+            for (size_t k = i; ; ++k)
+                if (tableDecodeBase64[uint8_t(in[k])] & 0x80)
+                    ThrowInvalidCharacter(in, inLength, k);
+        }
 
         out[j++] = (uint8_t)((b0 << 2) | (b1 >> 4));
-        if (b2 < 64) out[j++] = (uint8_t)((b1 << 4) | (b2 >> 2));
-        if (b3 < 64) out[j++] = (uint8_t)((b2 << 6) | b3);
+        if (padding < 2) out[j++] = (uint8_t)((b1 << 4) | (b2 >> 2));
+        if (padding < 1) out[j++] = (uint8_t)((b2 << 6) | b3);
     }
 
     return outLength;
 }
 
-size_t Base64::Decode(const std::string& in, std::vector<uint8_t>& out) {
-    uint8_t* outPtr = nullptr;
-    size_t decodedSize = Base64::Decode(in.data(), in.size(), outPtr);
-    if (outPtr == nullptr) {
-        return 0;
+std::vector<uint8_t> Base64::Decode(std::string_view in) {
+    std::vector<uint8_t> result(DecodedSize(in.data(), in.size()));
+    Base64::Decode(in.data(), in.size(), result.data());
+    return result;
+}
+
+// Translates characters to their 6-bit values in place and returns false if any character is not part of the
+// alphabet. The characters are classified by their high and low nibbles - see Wojciech Mula's "base64 decoding
+// with SIMD" (the same tables are used for both halves of the AVX2 version)
+static inline bool DecodeTranslate(__m128i& str) {
+    const __m128i lutLo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m128i lutHi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m128i lutRoll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i mask2F = _mm_set1_epi8(0x2F);
+
+    const __m128i hiNibbles = _mm_and_si128(_mm_srli_epi32(str, 4), mask2F);
+    const __m128i loNibbles = _mm_and_si128(str, mask2F);
+    const __m128i hi = _mm_shuffle_epi8(lutHi, hiNibbles);
+    const __m128i lo = _mm_shuffle_epi8(lutLo, loNibbles);
+
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128())) != 0xFFFF)
+        return false;
+
+    const __m128i eq2F = _mm_cmpeq_epi8(str, mask2F);
+    const __m128i roll = _mm_shuffle_epi8(lutRoll, _mm_add_epi8(eq2F, hiNibbles));
+    str = _mm_add_epi8(str, roll);
+    return true;
+}
+
+void Base64::DecodeSsse3(const char* in, size_t inLength, uint8_t* out, size_t outLength, size_t& i, size_t& j) {
+    // 16 characters become 12 bytes, but the store writes 16
+    for (; i + 16 <= inLength && j + 16 <= outLength; i += 16, j += 12) {
+        __m128i str = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        if (!DecodeTranslate(str))
+            return;
+
+        // Pack the 6-bit values: pairs into 12 bits, then pairs of those into 24 bits, then drop the empty bytes
+        const __m128i mergeAbAndBc = _mm_maddubs_epi16(str, _mm_set1_epi32(0x01400140));
+        __m128i bytes = _mm_madd_epi16(mergeAbAndBc, _mm_set1_epi32(0x00011000));
+        bytes = _mm_shuffle_epi8(bytes, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + j), bytes);
     }
-    out.assign(outPtr, outPtr + decodedSize);
-    delete[] outPtr;
-    return decodedSize;
 }
 
-std::vector<uint8_t> Base64::Decode(const std::string& in) {
-    std::vector<uint8_t> result;
-    Base64::Decode(in, result);
-    return result;
-}
\ No newline at end of file
+void Base64::DecodeAvx2(const char* in, size_t inLength, uint8_t* out, size_t outLength, size_t& i, size_t& j) {
+    const __m256i lutLo = _mm256_setr_epi8(
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m256i lutHi = _mm256_setr_epi8(
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m256i lutRoll = _mm256_setr_epi8(
+        0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i mask2F = _mm256_set1_epi8(0x2F);
+
+    // 32 characters become 24 bytes, but the store writes 32
+    for (; i + 32 <= inLength && j + 32 <= outLength; i += 32, j += 24) {
+        __m256i str = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+
+        const __m256i hiNibbles = _mm256_and_si256(_mm256_srli_epi32(str, 4), mask2F);
+        const __m256i loNibbles = _mm256_and_si256(str, mask2F);
+        const __m256i hi = _mm256_shuffle_epi8(lutHi, hiNibbles);
+        const __m256i lo = _mm256_shuffle_epi8(lutLo, loNibbles);
+
+        if (!_mm256_testz_si256(lo, hi))
+            break;
+
+        const __m256i eq2F = _mm256_cmpeq_epi8(str, mask2F);
+        const __m256i roll = _mm256_shuffle_epi8(lutRoll, _mm256_add_epi8(eq2F, hiNibbles));
+        str = _mm256_add_epi8(str, roll);
+
+        // Same packing as the SSSE3 version, then move the 12 bytes of the upper lane next to those of the lower lane
+        const __m256i mergeAbAndBc = _mm256_maddubs_epi16(str, _mm256_set1_epi32(0x01400140));
+        __m256i bytes = _mm256_madd_epi16(mergeAbAndBc, _mm256_set1_epi32(0x00011000));
+        bytes = _mm256_shuffle_epi8(bytes, _mm256_setr_epi8(
+            2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+            2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+        bytes = _mm256_permutevar8x32_epi32(bytes, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, -1, -1));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + j), bytes);
+    }
+
+    _mm256_zeroupper();
+}
@@ -1,30 +1,65 @@
 #pragma once
 #include "pch.h"
 #include "Base64Exception.h"
+#include "CpuFeatures.h"
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <stdint.h>
 #include <sstream>
 
+#include <tmmintrin.h>
+#include <immintrin.h>
+
+// Base64 encodes and decodes with SSSE3 or AVX2 when the processor supports them (16 / 32 characters per
+// iteration) and falls back to the scalar code otherwise. The implementation is chosen once at runtime from
+// CpuFeatures. Every implementation produces exactly the same output and rejects the same input.
 class Base64
 {
 public:
-	static std::vector<uint8_t> Decode(const std::string& data);
+	enum class Implementation
+	{
+		SCALAR,
+		SSSE3,
+		AVX2
+	};
+
+	static std::vector<uint8_t> Decode(std::string_view data);
 	static std::string Encode(const std::vector<uint8_t>& in);
 
+	// Number of bytes Decode writes for the given text. Throws Base64Exception if the length is not a multiple of 4
+	static size_t DecodedSize(const char* in, size_t inLength);
+
+	// Decodes straight into out, which must have room for DecodedSize(in, inLength) bytes. Returns the number of
+	// bytes written. Throws Base64Exception on any character that is not part of the base64 alphabet
+	static size_t Decode(const char* in, size_t inLength, uint8_t* out);
+
+	static size_t EncodedSize(size_t inLength) { return ((inLength + 2) / 3) * 4; }
+
+	// Encodes into out, which must have room for EncodedSize(inLength) characters
+	static void Encode(const uint8_t* in, size_t inLength, char* out);
+
+	// Selecting an implementation the processor does not support falls back to the best one it does support
+	static Implementation GetImplementation() { return s_implementation; }
+	static void SetImplementation(Implementation implementation);
+
 private:
 	Base64() {} // Disallow creation of an Base64 object
 
-	static size_t Decode(const std::string& in, std::vector<uint8_t>& out);
-	static size_t Decode(const char* in, size_t inLength, uint8_t*& out);
+	static Implementation BestImplementation();
 
-	static void Encode(const std::vector<uint8_t>& in, std::string& out);
-	static void Encode(const uint8_t* in, size_t inLength, std::string& out);
+	// The SIMD loops stop at the first invalid character (or once the input or output is too short for another
+	// full register) and leave the rest to the scalar code, which also reports any error
+	static void DecodeSsse3(const char* in, size_t inLength, uint8_t* out, size_t outLength, size_t& i, size_t& j);
+	static void DecodeAvx2(const char* in, size_t inLength, uint8_t* out, size_t outLength, size_t& i, size_t& j);
+	static void EncodeSsse3(const uint8_t* in, size_t inLength, char* out, size_t& i, size_t& j);
+	static void EncodeAvx2(const uint8_t* in, size_t inLength, char* out, size_t& i, size_t& j);
 
-	static inline uint8_t DecodeChar(char c);
-	static inline char EncodeChar(uint8_t b);
+	[[noreturn]] static void ThrowInvalidCharacter(const char* in, size_t inLength, size_t index);
 
-	static const uint8_t tableDecodeBase64[128];
+	static const uint8_t tableDecodeBase64[256];
 	static const char* tableEncodeBase64;
-};
\ No newline at end of file
+
+	static Implementation s_implementation;
+};
@@ -2,15 +2,45 @@
 #include "pch.h"
 #include "DeviceResources.h"
 #include "DeviceResourcesException.h"
+#include "PipelineState.h"
 
 #include <memory>
 
+// Where on the pipeline a bindable binds. stage uses the numbering shared by ConstantBufferBindingLocation,
+// TextureBindingLocation and SamplerStateBindingLocation (COMPUTE_SHADER = 0 ... PIXEL_SHADER = 5) and, with slot,
+// is only set for the per stage arrays. Two bindables with the same BindableSlot replace each other's binding
+struct BindableSlot
+{
+	enum class Type
+	{
+		VERTEX_SHADER,
+		PIXEL_SHADER,
+		INPUT_LAYOUT,
+		RASTERIZER_STATE,
+		DEPTH_STENCIL_STATE,
+		MESH,				// Topology, vertex buffer slot 0 and the index buffer
+		CONSTANT_BUFFERS,
+		SHADER_RESOURCES,
+		SAMPLERS
+	};
+
+	Type type;
+	int stage = 0;
+	unsigned int slot = 0;
+
+	auto operator<=>(const BindableSlot&) const = default;
+};
+
 class Bindable
 {
 public:
 	Bindable(std::shared_ptr<DeviceResources> deviceResources);
 
 	virtual void Bind() = 0;
+	virtual BindableSlot Slot() const = 0;
+
+	// True for the vertex shaders and input layouts that read the per instance data in the InstanceBuffer
+	virtual bool ReadsInstanceData() const { return false; }
 
 protected:
 	std::shared_ptr<DeviceResources> m_deviceResources;
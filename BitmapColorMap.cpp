@@ -0,0 +1,75 @@
+#include "BitmapColorMap.h"
+
+BitmapColorMap::BitmapColorMap(const std::string& filename, int width, int height) :
+	m_file(filename),
+	m_width(width),
+	m_height(height),
+	m_rowPitch(((static_cast<size_t>(width) * 3) + 3) & ~static_cast<size_t>(3)),
+	m_pixels(nullptr)
+{
+	std::ostringstream oss;
+
+	BITMAPFILEHEADER bitmapFileHeader;
+	BITMAPINFOHEADER bitmapInfoHeader;
+	if (m_file.Size() < sizeof(BITMAPFILEHEADER) + sizeof(BITMAPINFOHEADER))
+	{
+		oss << "Failed to read bitmap headers: " << filename;
+		throw TerrainMeshException(__LINE__, __FILE__, oss.str());
+	}
+	std::memcpy(&bitmapFileHeader, m_file.Data(), sizeof(BITMAPFILEHEADER));
+	std::memcpy(&bitmapInfoHeader, m_file.Data() + sizeof(BITMAPFILEHEADER), sizeof(BITMAPINFOHEADER));
+
+	if (bitmapFileHeader.bfType != 0x4D42 || bitmapInfoHeader.biBitCount != 24 || bitmapInfoHeader.biCompression != BI_RGB)
+	{
+		oss << "Color map is not an uncompressed 24 bit bitmap: " << filename;
+		throw TerrainMeshException(__LINE__, __FILE__, oss.str());
+	}
+
+	// Make sure the color map dimensions are the same as the terrain dimensions for easy 1 to 1 mapping.
+	if ((bitmapInfoHeader.biWidth != width) || (bitmapInfoHeader.biHeight != height))
+	{
+		oss << "Bitmap info header height and width do not match the config file height and width:" << std::endl;
+		oss << "    Bitmap:" << std::endl;
+		oss << "        Height: " << bitmapInfoHeader.biHeight << std::endl;
+		oss << "        Width:  " << bitmapInfoHeader.biWidth << std::endl;
+		oss << "    Config file:" << std::endl;
+		oss << "        Height: " << height << std::endl;
+		oss << "        Width:  " << width << std::endl;
+		throw TerrainMeshException(__LINE__, __FILE__, oss.str());
+	}
+
+	size_t expectedSize = static_cast<size_t>(bitmapFileHeader.bfOffBits) + (m_rowPitch * height);
+	if (m_file.Size() < expectedSize)
+	{
+		oss << "Bitmap file is too small for its dimensions: " << filename << std::endl;
+		oss << "    Expected: " << expectedSize << " bytes" << std::endl;
+		oss << "    Actual:   " << m_file.Size() << " bytes" << std::endl;
+		throw TerrainMeshException(__LINE__, __FILE__, oss.str());
+	}
+
+	m_pixels = m_file.Data() + bitmapFileHeader.bfOffBits;
+}
+
+void BitmapColorMap::ReadRows(int firstRow, int rowCount, DirectX::XMFLOAT3* colors) const
+{
+	for (int j = 0; j < rowCount; j++)
+	{
+		const uint8_t* source = Row(firstRow + j);
+		DirectX::XMFLOAT3* destination = colors + (static_cast<size_t>(m_width) * j);
+
+		// Pixels are stored blue, green, red
+		for (int i = 0; i < m_width; i++)
+		{
+			destination[i].z = (float)source[(i * 3)] / 255.0f;
+			destination[i].y = (float)source[(i * 3) + 1] / 255.0f;
+			destination[i].x = (float)source[(i * 3) + 2] / 255.0f;
+		}
+	}
+}
+
+void BitmapColorMap::Release(int firstRow, int rowCount) const
+{
+	// The rows are stored bottom to top, so the last terrain row of the range comes first in the file
+	size_t offset = static_cast<size_t>(Row(firstRow + rowCount - 1) - m_file.Data());
+	m_file.Release(offset, m_rowPitch * rowCount);
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include "pch.h"
+#include "MemoryMappedFile.h"
+#include "TerrainMeshException.h"
+
+#include <string>
+#include <sstream>
+#include <cstring>
+#include <stdint.h>
+
+// BitmapColorMap is a read-only view of the 24 bit bitmap that colors the terrain (one pixel per height map
+// sample). Like RawHeightMap, the file is memory mapped instead of read into memory and pixels are only converted
+// to colors when a band of rows is asked for, so the whole map is never resident no matter how large it is.
+//
+// Bitmaps are stored bottom to top, so terrain row j is the (height - 1 - j)th row of pixels in the file.
+class BitmapColorMap
+{
+public:
+	// Throws TerrainMeshException if the file is not an uncompressed 24 bit bitmap of exactly width x height
+	BitmapColorMap(const std::string& filename, int width, int height);
+	BitmapColorMap(const BitmapColorMap&) = delete;
+	BitmapColorMap& operator=(const BitmapColorMap&) = delete;
+
+	int Width() const { return m_width; }
+	int Height() const { return m_height; }
+
+	// Converts terrain rows [firstRow, firstRow + rowCount) into (r, g, b) colors between 0 and 1, row major.
+	// colors must hold width * rowCount values
+	void ReadRows(int firstRow, int rowCount, DirectX::XMFLOAT3* colors) const;
+
+	// Lets the rows go from the working set once they are no longer needed
+	void Release(int firstRow, int rowCount) const;
+
+private:
+	const uint8_t* Row(int j) const { return m_pixels + (m_rowPitch * (static_cast<size_t>(m_height) - 1 - j)); }
+
+	MemoryMappedFile m_file;
+	int m_width, m_height;
+	size_t m_rowPitch;			// Rows of pixels are padded to a multiple of 4 bytes
+	const uint8_t* m_pixels;
+};
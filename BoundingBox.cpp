@@ -24,22 +24,38 @@ BoundingBox::BoundingBox(std::shared_ptr<DeviceResources> deviceResources, const
 	{
 		DirectX::XMStoreFloat3(&position, p);
 
-		if (position.x > m_maxX)
-			m_maxX = position.x;
-		else if (position.x < m_minX)
-			m_minX = position.x;
-
-		if (position.y > m_maxY)
-			m_maxY = position.y;
-		else if (position.y < m_minY)
-			m_minY = position.y;
-
-		if (position.z > m_maxZ)
-			m_maxZ = position.z;
-		else if (position.z < m_minZ)
-			m_minZ = position.z;
+		// Not else-if: the first position has to set both the min and the max
+		m_minX = std::min(m_minX, position.x);
+		m_maxX = std::max(m_maxX, position.x);
+		m_minY = std::min(m_minY, position.y);
+		m_maxY = std::max(m_maxY, position.y);
+		m_minZ = std::min(m_minZ, position.z);
+		m_maxZ = std::max(m_maxZ, position.z);
 	}
 
+	CreateCorners();
+}
+
+BoundingBox::BoundingBox(std::shared_ptr<DeviceResources> deviceResources, const XMFLOAT3& minimum, const XMFLOAT3& maximum) :
+	m_deviceResources(deviceResources),
+	m_minX(minimum.x),
+	m_maxX(maximum.x),
+	m_minY(minimum.y),
+	m_maxY(maximum.y),
+	m_minZ(minimum.z),
+	m_maxZ(maximum.z)
+#ifndef NDEBUG
+	,m_topology(D3D11_PRIMITIVE_TOPOLOGY_LINELIST),
+	m_vertexBuffer(nullptr),
+	m_vertexCount(0),
+	m_sizeOfVertex(0)
+#endif
+{
+	CreateCorners();
+}
+
+void BoundingBox::CreateCorners()
+{
 	// Create the 8 vertices
 	xyz = DirectX::XMVectorSet(m_minX, m_minY, m_minZ, 1.0f);
 	Xyz = DirectX::XMVectorSet(m_maxX, m_minY, m_minZ, 1.0f);
@@ -216,39 +232,34 @@ void BoundingBox::Draw(const XMMATRIX& parentModelMatrix, const XMMATRIX& viewMa
 	ID3D11DeviceContext4* context = m_deviceResources->D3DDeviceContext();
 
 	// Set topology (should be line list)
-	GFX_THROW_INFO_ONLY(
-		context->IASetPrimitiveTopology(m_topology)
-	);
+	if (PipelineState::SetPrimitiveTopology(m_topology))
+	{
+		GFX_THROW_INFO_ONLY(
+			context->IASetPrimitiveTopology(m_topology)
+		);
+	}
 
 	// Set vertex buffers
 	const UINT stride = m_sizeOfVertex;
 	const UINT offset = 0u;
-	GFX_THROW_INFO_ONLY(
-		context->IASetVertexBuffers(0u, 1u, m_vertexBuffer.GetAddressOf(), &stride, &offset)
-	);
-
-	// Update the Model/View/Projection constant buffer that is bound to slot 0 in the vertex shader
-	D3D11_MAPPED_SUBRESOURCE ms;
-	ZeroMemory(&ms, sizeof(D3D11_MAPPED_SUBRESOURCE));
-
-	Microsoft::WRL::ComPtr<ID3D11Buffer> vsBuffer;
-	GFX_THROW_INFO_ONLY(
-		context->VSGetConstantBuffers(0, 1, vsBuffer.ReleaseAndGetAddressOf())
-	);
-
-	GFX_THROW_INFO(
-		context->Map(vsBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &ms)
-	);
+	if (PipelineState::SetVertexBuffer(m_vertexBuffer.Get(), stride, offset))
+	{
+		GFX_THROW_INFO_ONLY(
+			context->IASetVertexBuffers(0u, 1u, m_vertexBuffer.GetAddressOf(), &stride, &offset)
+		);
+	}
 
-	ModelViewProjectionConstantBuffer* mappedBuffer = (ModelViewProjectionConstantBuffer*)ms.pData;
+	// Write the Model/View/Projection constants to the ring buffer and bind them to slot 0 in the vertex shader
+	ModelViewProjectionConstantBuffer constants;
 	XMMATRIX viewProjection = viewMatrix * projectionMatrix;
-	DirectX::XMStoreFloat4x4(&(mappedBuffer->model), parentModelMatrix);
-	DirectX::XMStoreFloat4x4(&(mappedBuffer->modelViewProjection), parentModelMatrix * viewProjection);
-	DirectX::XMStoreFloat4x4(&(mappedBuffer->inverseTransposeModel), DirectX::XMMatrixTranspose(DirectX::XMMatrixInverse(nullptr, parentModelMatrix)));
-
-	GFX_THROW_INFO_ONLY(
-		context->Unmap(vsBuffer.Get(), 0)
-	);
+	DirectX::XMStoreFloat4x4(&(constants.model), parentModelMatrix);
+	DirectX::XMStoreFloat4x4(&(constants.modelViewProjection), parentModelMatrix * viewProjection);
+	DirectX::XMStoreFloat4x4(&(constants.inverseTransposeModel), DirectX::XMMatrixTranspose(DirectX::XMMatrixInverse(nullptr, parentModelMatrix)));
+
+	ConstantRingBuffer::Map(ConstantRingBuffer::AlignedSize(sizeof(ModelViewProjectionConstantBuffer)));
+	unsigned int firstConstant = ConstantRingBuffer::Write(constants);
+	ConstantRingBuffer::Unmap();
+	ConstantRingBuffer::BindVS(0u, firstConstant, sizeof(ModelViewProjectionConstantBuffer));
 
 
 	// Issue the Draw call
@@ -1,6 +1,8 @@
 #pragma once
 #include "pch.h"
 #include "DeviceResources.h"
+#include "PipelineState.h"
+#include "ConstantRingBuffer.h"
 #include "HLSLStructures.h"
 
 #include <vector>
@@ -17,12 +19,15 @@ class BoundingBox
 {
 public:
 	BoundingBox(std::shared_ptr<DeviceResources> deviceResources, const std::vector<DirectX::XMVECTOR>& positions);
+	BoundingBox(std::shared_ptr<DeviceResources> deviceResources, const DirectX::XMFLOAT3& minimum, const DirectX::XMFLOAT3& maximum);
 
 	bool RayIntersectionTest(DirectX::XMVECTOR rayOrigin, DirectX::XMVECTOR rayDirection, float& distance);
 	void GetBoundingBoxPositionsWithTransformation(const DirectX::XMMATRIX& tranformation, std::vector<DirectX::XMVECTOR>& positions);
 
 
 private:
+	void CreateCorners();
+
 	std::shared_ptr<DeviceResources> m_deviceResources;
 
 	float m_minX, m_maxX;
@@ -22,15 +22,8 @@ Box::Box(std::shared_ptr<DeviceResources> deviceResources, std::shared_ptr<MoveL
 	CreateAndAddPSBufferArray();
 
 	PreDrawUpdate = [this]() {
-		// Pretty much every object will need to submit model/view/projection data to the vertex shader
-		// The Scene binds a ModelViewProjectionConstantBuffer object to slot 0 of the vertex shader that
-		// can be mapped and written to by any object. The reason we don't automatically perform this update
-		// for every drawable is that not every drawable actually requires this update. For example, the Terrain
-		// is not a drawable, but instead houses many TerrainCells that are drawable. However, each of these 
-		// TerrainCells do not require this update because Terrain is able to set up the model view projection 
-		// buffer once before trying to draw each TerrainCell
-		UpdateModelViewProjectionConstantBuffer();
-
+		// The model/view/projection constants do not need updating here - they are written to the
+		// ConstantRingBuffer for every node right before it is drawn
 
 		// Updating of any additional constant buffers or other pipeline resources should go here
 	};
@@ -13,7 +13,6 @@ CenterOnOriginScene::CenterOnOriginScene(std::shared_ptr<DeviceResources> device
 	m_moveLookController = std::make_shared<CenterOnOriginMoveLookController>(m_hWnd, deviceResources);
 
 	CreateWindowSizeDependentResources();
-	CreateAndBindModelViewProjectionBuffer();
 	/*
 	// Sky Dome
 	//     MUST be added first because it needs to be rendered first because depth test is turned off
@@ -107,36 +106,6 @@ void CenterOnOriginScene::CreateWindowSizeDependentResources()
 	m_projectionMatrix = perspectiveMatrix * orientationMatrix;
 }
 
-void CenterOnOriginScene::CreateAndBindModelViewProjectionBuffer()
-{
-	// Basically all objects that get rendered need to bind model/view/projection matrices
-	// to the vertex shader. Instead of each object attempting to bind the same constant buffer,
-	// the scene can set this buffer once at the start of the program and each update simply needs 
-	// to update the members of the constant buffer that its vertex shader program will use
-
-	//
-	// I don't think we need to do this because it will be done by the Scene
-	//
-	/*
-	INFOMAN(m_deviceResources);
-
-	// Create a dynamic usage constant buffer that can be updated from the CPU
-	std::shared_ptr<ConstantBuffer> modelViewProjectionConstantBuffer = std::make_shared<ConstantBuffer>(m_deviceResources);
-	modelViewProjectionConstantBuffer->CreateBuffer<ModelViewProjectionConstantBuffer>(
-		D3D11_USAGE_DYNAMIC,			// Usage: Dynamic
-		D3D11_CPU_ACCESS_WRITE,			// CPU Access: CPU will be able to write using Map
-		0,								// Misc Flags: No miscellaneous flags
-		0								// Structured Byte Stride: Not totally sure, but I don't think this needs to be set because even though it is a structured buffer, there is only a single element
-		// Not supplying any initial data
-		);
-
-	ID3D11Buffer* buffer[1] = { modelViewProjectionConstantBuffer->GetRawBufferPointer() };
-	GFX_THROW_INFO_ONLY(
-		m_deviceResources->D3DDeviceContext()->VSSetConstantBuffers(0u, 1u, buffer)
-	);
-	*/
-}
-
 /*
 std::shared_ptr<Drawable> CenterOnOriginScene::CreateDrawable()
 {
@@ -175,9 +144,17 @@ void CenterOnOriginScene::Update(std::shared_ptr<StepTimer> timer, std::shared_p
 
 void CenterOnOriginScene::Draw()
 {
-	// Draw all drawables - NOTE: If using a SkyDome, it MUST be the first drawable
+	// Every drawable submits its nodes to the queue, which then draws them grouped by pass, shader and material.
+	// The SkyDome is in the BACKGROUND pass, so it is drawn first no matter where it is in m_drawables
+	m_renderQueue.Clear();
+	for (std::shared_ptr<Drawable> drawable : m_drawables)
+		drawable->Submit(m_renderQueue);
+
+	m_renderQueue.Sort();
+	m_renderQueue.Execute(m_renderBackend);
+
 	for (std::shared_ptr<Drawable> drawable : m_drawables)
-		drawable->Draw();
+		drawable->DrawBoundingBoxes();
 }
 
 void CenterOnOriginScene::DrawImGui()
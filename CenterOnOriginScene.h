@@ -14,6 +14,8 @@
 #include "TerrainMesh.h"
 #include "Frustum.h"
 #include "CenterOnOriginMoveLookController.h"
+#include "RenderQueue.h"
+#include "DeviceContextRenderBackend.h"
 
 #include "Drawable.h"
 #include "Box.h"
@@ -50,7 +52,6 @@ public:
 
 private:
 	void CreateWindowSizeDependentResources();
-	void CreateAndBindModelViewProjectionBuffer();
 
 
 	HWND												m_hWnd;
@@ -67,6 +68,10 @@ private:
 	// Drawables
 	std::vector<std::shared_ptr<Drawable>>				m_drawables;
 
+	// Draw submission
+	RenderQueue											m_renderQueue;
+	DeviceContextRenderBackend							m_renderBackend;
+
 
 
 public:
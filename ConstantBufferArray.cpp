@@ -2,7 +2,10 @@
 #include "ObjectStore.h"
 
 ConstantBufferArray::ConstantBufferArray(std::shared_ptr<DeviceResources> deviceResources, ConstantBufferBindingLocation bindToStage) :
-	Bindable(deviceResources)
+	Bindable(deviceResources),
+	// The vertex and pixel shader buffers start at slot 1, behind the ConstantRingBuffer and lighting buffers in slot 0
+	m_slot({ BindableSlot::Type::CONSTANT_BUFFERS, static_cast<int>(bindToStage),
+		bindToStage == ConstantBufferBindingLocation::VERTEX_SHADER || bindToStage == ConstantBufferBindingLocation::PIXEL_SHADER ? 1u : 0u })
 {
 	switch (bindToStage)
 	{
@@ -38,6 +41,9 @@ void ConstantBufferArray::Bind()
 
 void ConstantBufferArray::BindCS()
 {
+	if (!PipelineState::SetConstantBuffers(static_cast<int>(ConstantBufferBindingLocation::COMPUTE_SHADER), 0u, static_cast<unsigned int>(m_rawBufferPointers.size()), m_rawBufferPointers.data()))
+		return;
+
 	INFOMAN(m_deviceResources);
 	GFX_THROW_INFO_ONLY(
 		m_deviceResources->D3DDeviceContext()->CSSetConstantBuffers(0u, static_cast<unsigned int>(m_rawBufferPointers.size()), m_rawBufferPointers.data())
@@ -47,6 +53,9 @@ void ConstantBufferArray::BindCS()
 void ConstantBufferArray::BindVS()
 {
 	// IMPORTANT: Model/view/projection buffer is always bound to slot 0, so additional buffers MUST be bound starting at slot 1
+	if (!PipelineState::SetConstantBuffers(static_cast<int>(ConstantBufferBindingLocation::VERTEX_SHADER), 1u, static_cast<unsigned int>(m_rawBufferPointers.size()), m_rawBufferPointers.data()))
+		return;
+
 	INFOMAN(m_deviceResources);
 	GFX_THROW_INFO_ONLY(
 		m_deviceResources->D3DDeviceContext()->VSSetConstantBuffers(1u, static_cast<unsigned int>(m_rawBufferPointers.size()), m_rawBufferPointers.data())
@@ -55,6 +64,9 @@ void ConstantBufferArray::BindVS()
 
 void ConstantBufferArray::BindHS()
 {
+	if (!PipelineState::SetConstantBuffers(static_cast<int>(ConstantBufferBindingLocation::HULL_SHADER), 0u, static_cast<unsigned int>(m_rawBufferPointers.size()), m_rawBufferPointers.data()))
+		return;
+
 	INFOMAN(m_deviceResources);
 	GFX_THROW_INFO_ONLY(
 		m_deviceResources->D3DDeviceContext()->HSSetConstantBuffers(0u, static_cast<unsigned int>(m_rawBufferPointers.size()), m_rawBufferPointers.data())
@@ -63,6 +75,9 @@ void ConstantBufferArray::BindHS()
 
 void ConstantBufferArray::BindDS()
 {
+	if (!PipelineState::SetConstantBuffers(static_cast<int>(ConstantBufferBindingLocation::DOMAIN_SHADER), 0u, static_cast<unsigned int>(m_rawBufferPointers.size()), m_rawBufferPointers.data()))
+		return;
+
 	INFOMAN(m_deviceResources);
 	GFX_THROW_INFO_ONLY(
 		m_deviceResources->D3DDeviceContext()->DSSetConstantBuffers(0u, static_cast<unsigned int>(m_rawBufferPointers.size()), m_rawBufferPointers.data())
@@ -71,6 +86,9 @@ void ConstantBufferArray::BindDS()
 
 void ConstantBufferArray::BindGS()
 {
+	if (!PipelineState::SetConstantBuffers(static_cast<int>(ConstantBufferBindingLocation::GEOMETRY_SHADER), 0u, static_cast<unsigned int>(m_rawBufferPointers.size()), m_rawBufferPointers.data()))
+		return;
+
 	INFOMAN(m_deviceResources);
 	GFX_THROW_INFO_ONLY(
 		m_deviceResources->D3DDeviceContext()->GSSetConstantBuffers(0u, static_cast<unsigned int>(m_rawBufferPointers.size()), m_rawBufferPointers.data())
@@ -80,6 +98,9 @@ void ConstantBufferArray::BindGS()
 void ConstantBufferArray::BindPS()
 {
 	// IMPORTANT: Scene lighting is always bound to slot 0, so additional buffers MUST be bound starting at slot 1
+	if (!PipelineState::SetConstantBuffers(static_cast<int>(ConstantBufferBindingLocation::PIXEL_SHADER), 1u, static_cast<unsigned int>(m_rawBufferPointers.size()), m_rawBufferPointers.data()))
+		return;
+
 	INFOMAN(m_deviceResources);
 	GFX_THROW_INFO_ONLY(
 		m_deviceResources->D3DDeviceContext()->PSSetConstantBuffers(1u, static_cast<unsigned int>(m_rawBufferPointers.size()), m_rawBufferPointers.data())
@@ -27,6 +27,7 @@ public:
 	void ClearBuffers();
 	
 	void Bind() override;
+	BindableSlot Slot() const override { return m_slot; }
 
 	void UpdateSubresource(int index, void* data);
 
@@ -35,6 +36,7 @@ public:
 
 private:
 	std::function<void()> BindFunc;
+	BindableSlot m_slot;
 
 	void BindCS();
 	void BindVS();
@@ -0,0 +1,119 @@
+#include "ConstantRingBuffer.h"
+
+std::shared_ptr<DeviceResources> ConstantRingBuffer::m_deviceResources = nullptr;
+Microsoft::WRL::ComPtr<ID3D11Buffer> ConstantRingBuffer::m_buffer = nullptr;
+RingAllocator ConstantRingBuffer::m_ring(ConstantRingBuffer::ALIGNMENT);
+uint8_t* ConstantRingBuffer::m_mapped = nullptr;
+unsigned int ConstantRingBuffer::m_mapCount = 0;
+unsigned int ConstantRingBuffer::m_lastFrameMapCount = 0;
+
+void ConstantRingBuffer::Initialize(std::shared_ptr<DeviceResources> deviceResources, size_t capacity)
+{
+	m_deviceResources = deviceResources;
+
+	INFOMAN(m_deviceResources);
+
+	// Both are D3D11.1 features that every Windows 10 driver is expected to have. Binding with offsets is the whole
+	// point of the ring, while mapping without NO_OVERWRITE only costs a discard per batch
+	D3D11_FEATURE_DATA_D3D11_OPTIONS options = {};
+	GFX_THROW_INFO(
+		m_deviceResources->D3DDevice()->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options))
+	);
+	if (!options.ConstantBufferOffsetting)
+		throw DeviceResourcesException(__LINE__, __FILE__, E_NOTIMPL);
+
+	m_ring.SetNoOverwriteSupported(options.MapNoOverwriteOnDynamicConstantBuffer);
+
+	CreateBuffer(AlignedSize(capacity));
+}
+
+void ConstantRingBuffer::Shutdown()
+{
+	m_buffer = nullptr;
+	m_mapped = nullptr;
+	m_ring.Reset(0);
+	m_deviceResources = nullptr;
+}
+
+void ConstantRingBuffer::BeginFrame()
+{
+	m_ring.BeginFrame();
+
+	m_lastFrameMapCount = m_mapCount;
+	m_mapCount = 0;
+}
+
+void ConstantRingBuffer::Map(size_t bytes)
+{
+	INFOMAN(m_deviceResources);
+
+	// Draws that were already issued keep the old buffer alive, so it can simply be replaced
+	if (bytes > m_ring.Capacity())
+		CreateBuffer(m_ring.GrownCapacity(bytes));
+
+	D3D11_MAP mapType = m_ring.Begin(bytes) ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE;
+
+	D3D11_MAPPED_SUBRESOURCE ms;
+	ZeroMemory(&ms, sizeof(D3D11_MAPPED_SUBRESOURCE));
+	GFX_THROW_INFO(
+		m_deviceResources->D3DDeviceContext()->Map(m_buffer.Get(), 0, mapType, 0, &ms)
+	);
+
+	m_mapped = static_cast<uint8_t*>(ms.pData);
+	++m_mapCount;
+}
+
+void ConstantRingBuffer::Unmap()
+{
+	INFOMAN(m_deviceResources);
+	GFX_THROW_INFO_ONLY(
+		m_deviceResources->D3DDeviceContext()->Unmap(m_buffer.Get(), 0)
+	);
+
+	m_mapped = nullptr;
+}
+
+unsigned int ConstantRingBuffer::Write(const void* data, size_t size)
+{
+	if (m_mapped == nullptr)
+		throw DeviceResourcesException(__LINE__, __FILE__, E_ILLEGAL_METHOD_CALL);
+
+	size_t offset;
+	if (!m_ring.Allocate(size, offset))
+		throw DeviceResourcesException(__LINE__, __FILE__, E_BOUNDS);
+
+	memcpy(m_mapped + offset, data, size);
+	return static_cast<unsigned int>(offset / 16);
+}
+
+void ConstantRingBuffer::BindVS(unsigned int slot, unsigned int firstConstant, size_t size)
+{
+	const unsigned int constantCount = static_cast<unsigned int>(AlignedSize(size) / 16);
+	if (!PipelineState::SetConstantBufferRange(static_cast<int>(ConstantBufferBindingLocation::VERTEX_SHADER), slot, m_buffer.Get(), firstConstant, constantCount))
+		return;
+
+	INFOMAN(m_deviceResources);
+	ID3D11Buffer* const buffers[1] = { m_buffer.Get() };
+	GFX_THROW_INFO_ONLY(
+		m_deviceResources->D3DDeviceContext()->VSSetConstantBuffers1(slot, 1u, buffers, &firstConstant, &constantCount)
+	);
+}
+
+void ConstantRingBuffer::CreateBuffer(size_t capacity)
+{
+	INFOMAN(m_deviceResources);
+
+	D3D11_BUFFER_DESC desc;
+	desc.ByteWidth = static_cast<UINT>(capacity);
+	desc.Usage = D3D11_USAGE_DYNAMIC;
+	desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	desc.MiscFlags = 0;
+	desc.StructureByteStride = 0;
+
+	GFX_THROW_INFO(
+		m_deviceResources->D3DDevice()->CreateBuffer(&desc, nullptr, m_buffer.ReleaseAndGetAddressOf())
+	);
+
+	m_ring.Reset(capacity);
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include "pch.h"
+#include "DeviceResources.h"
+#include "DeviceResourcesException.h"
+#include "PipelineState.h"
+#include "ConstantBufferArray.h"
+#include "RingAllocator.h"
+
+#include <memory>
+#include <algorithm>
+#include <stdint.h>
+
+// ConstantRingBuffer is intended to be a static class
+//
+// ConstantRingBuffer holds the per draw constants of a whole frame (the ModelViewProjectionConstantBuffer of every
+// node) in one large dynamic buffer. Instead of a Map/Unmap of a small buffer for every draw, the constants for a
+// batch of draws are all written under a single Map and each draw binds its own part of the buffer with
+// VSSetConstantBuffers1:
+//
+//		ConstantRingBuffer::Map(count * ConstantRingBuffer::AlignedSize(sizeof(T)));
+//		offsets[i] = ConstantRingBuffer::Write(constants[i]);	// for each draw
+//		ConstantRingBuffer::Unmap();
+//		ConstantRingBuffer::BindVS(0, offsets[i], sizeof(T));	// before each draw
+//
+// Nothing can be drawn with the buffer while it is mapped, which is why the writes have to be batched. The first
+// Map of a frame, and any Map that does not fit behind the previous batch, discards the buffer; every other Map uses
+// NO_OVERWRITE, so the ranges that earlier draws of the frame use are left alone. Where each range goes is worked
+// out by a RingAllocator.
+class ConstantRingBuffer
+{
+public:
+	// Constant buffer offsets must be a multiple of 16 constants (256 bytes), and so must the size of a bound range
+	static constexpr size_t ALIGNMENT = 256;
+
+	static void Initialize(std::shared_ptr<DeviceResources> deviceResources, size_t capacity = 1024 * 1024);
+	static void Shutdown();
+
+	static void BeginFrame();
+
+	// Maps the buffer with room for at least bytes more bytes. The buffer grows if bytes is more than its capacity
+	static void Map(size_t bytes);
+	static void Unmap();
+
+	// Copies data into the next range and returns the first constant (16 bytes) of the range. Only valid between Map
+	// and Unmap
+	static unsigned int Write(const void* data, size_t size);
+	template <typename T>
+	static unsigned int Write(const T& data) { return Write(&data, sizeof(T)); }
+
+	// Binds size bytes starting at firstConstant (as returned by Write) to a vertex shader constant buffer slot
+	static void BindVS(unsigned int slot, unsigned int firstConstant, size_t size);
+
+	static size_t AlignedSize(size_t size) { return (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1); }
+
+	// Number of times the buffer was mapped during the last complete frame
+	static unsigned int GetFrameMapCount() { return m_lastFrameMapCount; }
+
+private:
+	ConstantRingBuffer() {} // Disallow creation of a ConstantRingBuffer object
+
+	static void CreateBuffer(size_t capacity);
+
+	static std::shared_ptr<DeviceResources> m_deviceResources;
+	static Microsoft::WRL::ComPtr<ID3D11Buffer> m_buffer;
+	static RingAllocator m_ring;
+	static uint8_t* m_mapped;			// nullptr when the buffer is not mapped
+	static unsigned int m_mapCount;
+	static unsigned int m_lastFrameMapCount;
+};
@@ -2,6 +2,7 @@
 
 using Microsoft::WRL::ComPtr;
 using DirectX::XMFLOAT3;
+using DirectX::XMFLOAT4;
 
 
 ContentWindow::ContentWindow(int width, int height, const char* name) :
@@ -17,7 +18,8 @@ ContentWindow::ContentWindow(int width, int height, const char* name) :
 #ifndef NDEBUG
 	,m_io(ImGui::GetIO()),
 	m_centerOnOriginScene(nullptr),
-	m_useCenterOnOriginScene(false)
+	m_useCenterOnOriginScene(false),
+	m_showSphereField(false)
 #endif
 {
 	// Create the device resources
@@ -74,9 +76,14 @@ ContentWindow::ContentWindow(int width, int height, const char* name) :
 
 	// We now have access to the device, so we now need to initialize the object store before creating the scene
 	ObjectStore::Initialize(m_deviceResources);
+	ObjectStore::SetTextureBudget(512 * 1024 * 1024);
+	ObjectStore::SetMeshBudget(256 * 1024 * 1024);
+	AssetLoader::Initialize(m_deviceResources);
+	ConstantRingBuffer::Initialize(m_deviceResources);
+	InstanceBuffer::Initialize(m_deviceResources);
 
 	ObjectStoreAddShaders();
-	ObjectStoreAddTerrains(); // Must call this first because ObjectStoreAddMeshes tries to lookup the terrains
+	ObjectStoreAddTerrains();
 	ObjectStoreAddMeshes();
 	ObjectStoreAddConstantBuffers();
 	ObjectStoreAddRasterStates();
@@ -113,6 +120,9 @@ ContentWindow::ContentWindow(int width, int height, const char* name) :
 ContentWindow::~ContentWindow()
 {
 	// Have to make sure to delete objects on close
+	AssetLoader::Shutdown();
+	ConstantRingBuffer::Shutdown();
+	InstanceBuffer::Shutdown();
 	ObjectStore::DestructObjects();
 }
 
@@ -297,6 +307,35 @@ void ContentWindow::AddSceneObjects()
 }
 
 #ifndef NDEBUG
+void ContentWindow::ShowSphereField(bool show)
+{
+	if (!show)
+	{
+		for (std::shared_ptr<Drawable> sphere : m_sphereField)
+			m_scene->RemoveDrawable(sphere);
+		m_sphereField.clear();
+		return;
+	}
+
+	// Every sphere shares its mesh, shaders, states and material, so the render queue draws the whole field
+	// with a single instanced draw call
+	for (int row = 0; row < 16; ++row)
+	{
+		for (int column = 0; column < 16; ++column)
+		{
+			std::shared_ptr<Drawable> sphere = m_scene->CreateDrawable(BasicModelType::Sphere);
+			sphere->AddBindable("phong-instanced-vertex-shader");		// Vertex Shader
+			sphere->AddBindable("phong-instanced-vertex-shader-IA");	// Input Layout
+			sphere->AddBindable("phong-pixel-shader");					// Pixel Shader
+			sphere->AddBindable("sphere-field-buffers-PS");			// Material
+			sphere->SetInstanced(true);
+			sphere->SetPosition(XMFLOAT3(30.0f + column * 2.5f, 22.0f, 390.0f + row * 2.5f));
+			sphere->SetScale(0.5f);
+			m_sphereField.push_back(sphere);
+		}
+	}
+}
+
 void ContentWindow::AddCenterOnOriginSceneObjects()
 {
 	// Sky Dome
@@ -449,8 +488,24 @@ void ContentWindow::ObjectStoreAddShaders()
 	phongTextureLayout->AddDescription("POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0);
 	phongTextureLayout->AddDescription("TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0);
 	phongTextureLayout->AddDescription("NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0);
+	phongTextureLayout->AddDescription("TANGENT", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0);
 	phongTextureLayout->CreateLayout();
 
+	// The instanced variants take the same vertices plus the InstanceBuffer in slot 1
+	std::shared_ptr<InputLayout> phongInstancedLayout = std::make_shared<InputLayout>(m_deviceResources, L"PhongInstancedVertexShader.cso");
+	phongInstancedLayout->AddDescription("POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0,                            0, D3D11_INPUT_PER_VERTEX_DATA, 0);
+	phongInstancedLayout->AddDescription(  "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0);
+	InstanceBuffer::AddInputElements(*phongInstancedLayout);
+	phongInstancedLayout->CreateLayout();
+
+	std::shared_ptr<InputLayout> phongTextureInstancedLayout = std::make_shared<InputLayout>(m_deviceResources, L"PhongTextureInstancedVertexShader.cso");
+	phongTextureInstancedLayout->AddDescription("POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0);
+	phongTextureInstancedLayout->AddDescription("TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0);
+	phongTextureInstancedLayout->AddDescription("NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0);
+	phongTextureInstancedLayout->AddDescription("TANGENT", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0);
+	InstanceBuffer::AddInputElements(*phongTextureInstancedLayout);
+	phongTextureInstancedLayout->CreateLayout();
+
 	ObjectStore::AddBindable("phong-vertex-shader-IA", phongLayout);
 	ObjectStore::AddBindable("phong-vertex-shader", std::make_shared<VertexShader>(m_deviceResources, phongLayout->GetVertexShaderFileBlob()));
 	ObjectStore::AddBindable("phong-pixel-shader", std::make_shared<PixelShader>(m_deviceResources, L"PhongPixelShader.cso"));
@@ -460,6 +515,12 @@ void ContentWindow::ObjectStoreAddShaders()
 	ObjectStore::AddBindable("phong-texture-pixel-shader", std::make_shared<PixelShader>(m_deviceResources, L"PhongTexturePixelShader.cso"));
 	ObjectStore::AddBindable("phong-texture-specular-pixel-shader", std::make_shared<PixelShader>(m_deviceResources, L"PhongTextureSpecularPixelShader.cso"));
 
+	ObjectStore::AddBindable("phong-instanced-vertex-shader-IA", phongInstancedLayout);
+	ObjectStore::AddBindable("phong-instanced-vertex-shader", std::make_shared<VertexShader>(m_deviceResources, phongInstancedLayout->GetVertexShaderFileBlob()));
+
+	ObjectStore::AddBindable("phong-texture-instanced-vertex-shader-IA", phongTextureInstancedLayout);
+	ObjectStore::AddBindable("phong-texture-instanced-vertex-shader", std::make_shared<VertexShader>(m_deviceResources, phongTextureInstancedLayout->GetVertexShaderFileBlob()));
+
 
 	// Sky Dome ======================================================================================================
 	std::shared_ptr<InputLayout> skyDomeLayout = std::make_shared<InputLayout>(m_deviceResources, L"SkyDomeVertexShader.cso");
@@ -494,14 +555,7 @@ void ContentWindow::ObjectStoreAddMeshes()
 	ObjectStore::AddMesh("box-outline-mesh", std::make_shared<BoxMesh>(m_deviceResources, false));
 	ObjectStore::AddMesh("sky-dome-mesh", std::make_shared<SkyDomeMesh>(m_deviceResources));
 
-	// Add terrain cell meshes sequentially
-	std::shared_ptr<TerrainMesh> terrain = ObjectStore::GetTerrainMesh("terrain-mesh");
-	for (int iii = 0; iii < terrain->TerrainCellCount(); ++iii)
-	{
-		std::ostringstream oss;
-		oss << "terrain_" << iii;
-		ObjectStore::AddMesh(oss.str(), terrain->GetTerrainCell(iii));
-	}
+	// Terrain cell meshes are not added here - they are streamed in and out by Terrain as the player moves
 }
 void ContentWindow::ObjectStoreAddConstantBuffers()
 {
@@ -541,6 +595,24 @@ void ContentWindow::ObjectStoreAddConstantBuffers()
 	//ba3->AddBuffer("terrain-constant-buffer");
 	//ObjectStore::AddBindable("terrain-buffers-VS", ba3);
 
+	// Sphere Field - PS
+	//		A single immutable material for every sphere of the field - a material of their own would give each
+	//		sphere a different bindable and keep them from being drawn as instances of one draw call
+	PhongMaterialProperties sphereFieldMaterial;
+	sphereFieldMaterial.Material.Emissive = XMFLOAT4(0.05f, 0.05f, 0.1f, 1.0f);
+	sphereFieldMaterial.Material.Ambient = XMFLOAT4(0.3f, 0.3f, 0.6f, 1.0f);
+	sphereFieldMaterial.Material.Diffuse = XMFLOAT4(0.4f, 0.5f, 1.0f, 1.0f);
+	sphereFieldMaterial.Material.Specular = XMFLOAT4(0.5f, 0.5f, 0.5f, 1.0f);
+	sphereFieldMaterial.Material.SpecularPower = 16.0f;
+
+	std::shared_ptr<ConstantBuffer> sphereFieldMaterialBuffer = std::make_shared<ConstantBuffer>(m_deviceResources);
+	sphereFieldMaterialBuffer->CreateBuffer<PhongMaterialProperties>(D3D11_USAGE_IMMUTABLE, 0, 0, 0, static_cast<void*>(&sphereFieldMaterial));
+	ObjectStore::AddConstantBuffer("sphere-field-material-buffer", sphereFieldMaterialBuffer);
+
+	std::shared_ptr<ConstantBufferArray> sphereFieldBuffers = std::make_shared<ConstantBufferArray>(m_deviceResources, ConstantBufferBindingLocation::PIXEL_SHADER);
+	sphereFieldBuffers->AddBuffer("sphere-field-material-buffer");
+	ObjectStore::AddBindable("sphere-field-buffers-PS", sphereFieldBuffers);
+
 	// Terrain - PS
 	std::shared_ptr<ConstantBufferArray> ba4 = std::make_shared<ConstantBufferArray>(m_deviceResources, ConstantBufferBindingLocation::PIXEL_SHADER);
 	ba4->AddBuffer("terrain-light-buffer");
@@ -583,12 +655,13 @@ void ContentWindow::ObjectStoreAddTextures()
 {
 	// MAKE SURE TO MODIFY THE TEXTURE DESCRIPTION STRUCT COMPLETELY PRIOR TO CALLING A LOAD* FUNCTION
 
-	std::shared_ptr<Texture> dirt = std::make_shared<Texture>(m_deviceResources);
-	dirt->Create("dirt01d.tga");
+	// Textures are decoded in the background by AssetLoader and show up once they have been uploaded. They are
+	// also added under a name of their own so the texture arrays below can refer to them
+
+	std::shared_ptr<Texture> dirt = AssetLoader::LoadTexture("dirt01d.tga");
 	ObjectStore::AddTexture("terrain-texture", dirt);
 
-	std::shared_ptr<Texture> dirtNormals = std::make_shared<Texture>(m_deviceResources);
-	dirtNormals->Create("dirt01n.tga");
+	std::shared_ptr<Texture> dirtNormals = AssetLoader::LoadTexture("dirt01n.tga");
 	ObjectStore::AddTexture("terrain-normal-map-texture", dirtNormals);
 
 
@@ -601,12 +674,10 @@ void ContentWindow::ObjectStoreAddTextures()
 
 
 	// Brick Wall
-	std::shared_ptr<Texture> brickWall = std::make_shared<Texture>(m_deviceResources);
-	brickWall->Create("images/brickwall.jpg");
+	std::shared_ptr<Texture> brickWall = AssetLoader::LoadTexture("images/brickwall.jpg");
 	ObjectStore::AddTexture("brick-wall-texture", brickWall);
 
-	std::shared_ptr<Texture> brickWallNormals = std::make_shared<Texture>(m_deviceResources);
-	brickWallNormals->Create("images/brickwall_normal.jpg");
+	std::shared_ptr<Texture> brickWallNormals = AssetLoader::LoadTexture("images/brickwall_normal.jpg");
 	ObjectStore::AddTexture("brick-wall-normals-texture", brickWallNormals);
 
 	std::shared_ptr<TextureArray> brickWallTextureArray = std::make_shared<TextureArray>(m_deviceResources, TextureBindingLocation::PIXEL_SHADER);
@@ -646,6 +717,10 @@ void ContentWindow::Update()
 	SetWindowText(m_hWnd, oss.str().c_str());
 	*/
 
+	// Upload any textures that finished decoding since the last frame and evict whatever no longer fits
+	AssetLoader::Update();
+	ObjectStore::Update();
+
 	m_timer->Tick([&]()
 		{
 			m_cpu->Update();
@@ -715,6 +790,10 @@ bool ContentWindow::Render()
 {
 	ID3D11DeviceContext4* context = m_deviceResources->D3DDeviceContext();
 
+	// Anything may have been bound directly on the context since the last frame (ImGui, activating a scene)
+	PipelineState::BeginFrame();
+	ConstantRingBuffer::BeginFrame();
+
 	context->ClearDepthStencilView(m_deviceResources->GetDepthStencilView(), D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
 
 	ID3D11RenderTargetView* const targets[1] = { m_deviceResources->GetBackBufferRenderTargetView() };
@@ -740,6 +819,8 @@ bool ContentWindow::Render()
 	// Render Stats ================================================================================================
 	ImGui::Begin("Render Stats");
 	ImGui::Checkbox("Enable all other ImGui windows", &m_enableImGuiWindows);
+	if (ImGui::Checkbox("Sphere field (instancing)", &m_showSphereField))
+		ShowSphereField(m_showSphereField);
 
 	if (ImGui::RadioButton("Normal Scene", !m_useCenterOnOriginScene))
 	{
@@ -754,6 +835,19 @@ bool ContentWindow::Render()
 	}
 
 	ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / m_io.Framerate, m_io.Framerate);
+
+	auto ResidencyText = [](const char* type, const ResidencyStatistics& statistics)
+	{
+		ImGui::Text("%s: %.1f / %.1f MB, %zu resident, %zu evicted, %llu hits, %llu misses, %llu evictions", type,
+			statistics.residentBytes / (1024.0 * 1024.0), statistics.budgetBytes / (1024.0 * 1024.0), statistics.residentCount, statistics.evictedCount,
+			statistics.hits, statistics.misses, statistics.evictions);
+	};
+	ResidencyText("Textures", ObjectStore::GetTextureStatistics());
+	ResidencyText("Meshes", ObjectStore::GetMeshStatistics());
+
+	const PipelineState::Statistics& bindStatistics = PipelineState::GetFrameStatistics();
+	ImGui::Text("Binds: %llu issued, %llu skipped", bindStatistics.issued, bindStatistics.skipped);
+	ImGui::Text("Constant buffer maps: %u", ConstantRingBuffer::GetFrameMapCount());
 	ImGui::End();
 
 	// Have the scene draw the necessary ImGui controls ==============================================================
@@ -9,12 +9,17 @@
 
 #include <memory>
 #include <map>
+#include <vector>
 #include <string>
 
 
 // Global objects
 #include "CharacterState.h"
 #include "ObjectStore.h"
+#include "AssetLoader.h"
+#include "PipelineState.h"
+#include "ConstantRingBuffer.h"
+#include "InstanceBuffer.h"
 
 // System objects
 #include "CPU.h"
@@ -142,6 +147,12 @@ private:
 	std::shared_ptr<CenterOnOriginScene> m_centerOnOriginScene;
 	bool m_useCenterOnOriginScene;
 	bool m_enableImGuiWindows;
+
+	// A 16 x 16 field of spheres that the render queue draws with one instanced draw call. It is only there to
+	// check instancing, so it is off unless it is turned on in the Render Stats window
+	void ShowSphereField(bool show);
+	std::vector<std::shared_ptr<Drawable>> m_sphereField;
+	bool m_showSphereField;
 #endif
 
 	
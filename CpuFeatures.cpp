@@ -0,0 +1,33 @@
+#include "CpuFeatures.h"
+
+CpuFeatures::CpuFeatures() :
+	m_ssse3(false),
+	m_avx2(false)
+{
+	int info[4];
+	__cpuid(info, 0);
+	int maxLeaf = info[0];
+
+	if (maxLeaf < 1)
+		return;
+
+	__cpuid(info, 1);
+	m_ssse3 = (info[2] & (1 << 9)) != 0;
+
+	// AVX2 also needs the operating system to save the upper halves of the ymm registers (OSXSAVE + XCR0)
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avx = (info[2] & (1 << 28)) != 0;
+	if (!osxsave || !avx || maxLeaf < 7)
+		return;
+
+	bool ymmEnabled = (_xgetbv(0) & 0x6) == 0x6;
+
+	__cpuidex(info, 7, 0);
+	m_avx2 = ymmEnabled && (info[1] & (1 << 5)) != 0;
+}
+
+const CpuFeatures& CpuFeatures::Get()
+{
+	static const CpuFeatures features;
+	return features;
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include "pch.h"
+
+#include <intrin.h>
+
+// CpuFeatures reports which optional instruction sets the processor (and operating system) support, so code
+// with hand written SIMD paths can pick one at runtime. The processor is only queried once.
+class CpuFeatures
+{
+public:
+	static bool HasSsse3() { return Get().m_ssse3; }
+	static bool HasAvx2() { return Get().m_avx2; }
+
+private:
+	CpuFeatures();
+	static const CpuFeatures& Get();
+
+	bool m_ssse3;
+	bool m_avx2;
+};
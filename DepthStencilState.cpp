@@ -42,6 +42,9 @@ void DepthStencilState::LoadChanges()
 
 void DepthStencilState::Bind()
 {
+	if (!PipelineState::SetDepthStencilState(m_depthStencilState.Get(), m_stencilReferenceNumber))
+		return;
+
 	INFOMAN(m_deviceResources);
 	GFX_THROW_INFO_ONLY(
 		m_deviceResources->D3DDeviceContext()->OMSetDepthStencilState(m_depthStencilState.Get(), m_stencilReferenceNumber)
@@ -33,6 +33,7 @@ public:
 	void BackFaceStencilFunc(D3D11_COMPARISON_FUNC func) { m_desc.BackFace.StencilFunc = func; LoadChanges(); }
 
 	void Bind() override;
+	BindableSlot Slot() const override { return { BindableSlot::Type::DEPTH_STENCIL_STATE }; }
 
 	void ResetState();
 
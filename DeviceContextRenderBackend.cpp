@@ -0,0 +1,53 @@
+#include "DeviceContextRenderBackend.h"
+#include "Drawable.h"
+#include "ConstantRingBuffer.h"
+#include "InstanceBuffer.h"
+#include "HLSLStructures.h"
+
+void DeviceContextRenderBackend::Prepare(Drawable* const* drawables, size_t count)
+{
+	size_t instancedCount = 0;
+	for (size_t iii = 0; iii < count; ++iii)
+	{
+		if (drawables[iii]->IsInstanced())
+			++instancedCount;
+	}
+
+	// Instances are written in draw order, so the instances of each DrawInstanced end up next to each other
+	if (instancedCount > 0)
+	{
+		InstanceBuffer::Map(static_cast<unsigned int>(instancedCount));
+		for (size_t iii = 0; iii < count; ++iii)
+		{
+			if (drawables[iii]->IsInstanced())
+				drawables[iii]->WriteInstance();
+		}
+		InstanceBuffer::Unmap();
+	}
+
+	if (count > instancedCount)
+	{
+		ConstantRingBuffer::Map((count - instancedCount) * ConstantRingBuffer::AlignedSize(sizeof(ModelViewProjectionConstantBuffer)));
+		for (size_t iii = 0; iii < count; ++iii)
+		{
+			if (!drawables[iii]->IsInstanced())
+				drawables[iii]->WriteModelViewProjection();
+		}
+		ConstantRingBuffer::Unmap();
+	}
+}
+
+void DeviceContextRenderBackend::Bind(Bindable& bindable)
+{
+	bindable.Bind();
+}
+
+void DeviceContextRenderBackend::Draw(Drawable& drawable)
+{
+	drawable.DrawMesh();
+}
+
+void DeviceContextRenderBackend::DrawInstanced(Drawable* const* drawables, size_t count)
+{
+	Drawable::DrawMeshInstanced(drawables, count);
+}
@@ -0,0 +1,14 @@
+#pragma once
+#include "pch.h"
+#include "RenderBackend.h"
+
+// Writes the model/view/projection constants of the whole queue to the ConstantRingBuffer under a single Map, and
+// the instance data of every instanced drawable to the InstanceBuffer under another
+class DeviceContextRenderBackend : public RenderBackend
+{
+public:
+	void Prepare(Drawable* const* drawables, size_t count) override;
+	void Bind(Bindable& bindable) override;
+	void Draw(Drawable& drawable) override;
+	void DrawInstanced(Drawable* const* drawables, size_t count) override;
+};
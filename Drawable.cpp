@@ -115,40 +115,11 @@ Drawable::Drawable(std::shared_ptr<DeviceResources> deviceResources, std::shared
 	// Getting the stem gets just the filename without the extension
 	m_name = std::filesystem::path(filename).stem().string();
 
-	Assimp::Importer imp;
-	const aiScene* scene = imp.ReadFile(filename.c_str(), aiProcess_Triangulate | aiProcess_JoinIdenticalVertices);
-	if (scene == nullptr)
-	{
-		throw DrawableException(__LINE__, __FILE__, "AssImp ReadFile Error:\n" + std::string(imp.GetErrorString()));
-	}
-
-	// When loading a scene/model via assimp, the meshes are just stored in a flat
-	// array. The hierarchy of drawables just have an index into that array. So, 
-	// for our purpose, the drawable we are building needs to first create a vector
-	// of shared pointers to these meshes and then as we build the hierarchy, we
-	// assign out the meshes to the corresponding nodes
-	std::vector<std::shared_ptr<Mesh>> allMeshes;
-
-	// Build up the vector of all meshes for this model
-	std::string meshLookupName;
-	for (unsigned int iii = 0; iii < scene->mNumMeshes; ++iii)
-	{
-		// Create a unique lookup name for the mesh
-		meshLookupName = filename + "-" + std::string(scene->mMeshes[iii]->mName.C_Str());
-
-		// If the mesh already exists in ObjectStore, just get it from there
-		if (ObjectStore::MeshExists(meshLookupName))
-			allMeshes.push_back(ObjectStore::GetMesh(meshLookupName));
-		else
-		{
-			// Mesh does not exist in object store, so load it from assimp and add it to ObjectStore
-			LoadMesh(*scene->mMeshes[iii], scene->mMaterials, allMeshes);
-			ObjectStore::AddMesh(meshLookupName, allMeshes.back());
-		}
-	}
-
-	// This constructor is only used for the root node, so just get the root node and if there are any children, a different constructor will be used
-	ConstructFromAiNode(*scene->mRootNode, allMeshes, scene->mMaterials);
+	// glTF files are read natively - Assimp is only used for every other format
+	if (std::filesystem::path(filename).extension() == ".gltf")
+		ConstructFromGltfFile(filename);
+	else
+		ConstructFromAssimpFile(filename);
 
 	// Once the rootNode is created, all meshes will have a BoundingBox, so gather each one and
 	// use those values to establish an all encapsulating BoundingBox
@@ -187,6 +158,210 @@ Drawable::Drawable(std::shared_ptr<DeviceResources> deviceResources, std::shared
 	ConstructFromAiNode(node, meshes, materials);
 }
 
+Drawable::Drawable(std::shared_ptr<DeviceResources> deviceResources, std::shared_ptr<MoveLookController> moveLookController, std::string name, const GltfModel& model, int nodeIndex, const std::vector<std::shared_ptr<Mesh>>& meshes) :
+	m_deviceResources(deviceResources),
+	m_moveLookController(moveLookController),
+	m_projectionMatrix(DirectX::XMMatrixIdentity()),
+	m_translation(XMFLOAT3(0.0f, 0.0f, 0.0f)),
+	m_rotation(XMFLOAT3(0.0f, 0.0f, 0.0f)),
+	m_scaling(XMFLOAT3(1.0f, 1.0f, 1.0f)),
+	m_accumulatedModelMatrix(DirectX::XMMatrixIdentity()),
+	m_roll(0.0f),
+	m_pitch(0.0f),
+	m_yaw(0.0f),
+	PreDrawUpdate([]() {}),
+	OnMouseHover([]() {}),
+	OnMouseNotHover([]() {}),
+	OnMouseClick([]() {}),
+	OnRightMouseClick([]() {}),
+	m_material(nullptr),
+	m_name(name),
+	m_nodeName("Unnamed Drawable Node"),
+	m_boundingBox(nullptr)
+#ifndef NDEBUG
+	, m_drawBoundingBox(false),
+	m_drawWholeBoundingBox(false)
+#endif
+{
+	InitializePipelineConfiguration();
+
+	ConstructFromGltfNode(model, nodeIndex, meshes);
+}
+
+Drawable::Drawable(std::shared_ptr<DeviceResources> deviceResources, std::shared_ptr<MoveLookController> moveLookController, std::string name, const ModelCache& cache, int nodeIndex, const std::vector<std::shared_ptr<Mesh>>& meshes) :
+	m_deviceResources(deviceResources),
+	m_moveLookController(moveLookController),
+	m_projectionMatrix(DirectX::XMMatrixIdentity()),
+	m_translation(XMFLOAT3(0.0f, 0.0f, 0.0f)),
+	m_rotation(XMFLOAT3(0.0f, 0.0f, 0.0f)),
+	m_scaling(XMFLOAT3(1.0f, 1.0f, 1.0f)),
+	m_accumulatedModelMatrix(DirectX::XMMatrixIdentity()),
+	m_roll(0.0f),
+	m_pitch(0.0f),
+	m_yaw(0.0f),
+	PreDrawUpdate([]() {}),
+	OnMouseHover([]() {}),
+	OnMouseNotHover([]() {}),
+	OnMouseClick([]() {}),
+	OnRightMouseClick([]() {}),
+	m_material(nullptr),
+	m_name(name),
+	m_nodeName("Unnamed Drawable Node"),
+	m_boundingBox(nullptr)
+#ifndef NDEBUG
+	, m_drawBoundingBox(false),
+	m_drawWholeBoundingBox(false)
+#endif
+{
+	InitializePipelineConfiguration();
+
+	ConstructFromCookedNode(cache, nodeIndex, meshes);
+}
+
+void Drawable::ConstructFromAssimpFile(const std::string& filename)
+{
+	// If the model has already been imported from the exact same source file, everything can be loaded straight
+	// from the cooked file and Assimp is not needed at all
+	std::string cookedFilename = filename + ".cooked";
+	ModelCacheKey key = {};
+	if (std::filesystem::exists(filename))
+	{
+		key = ModelCache::CreateKey(filename);
+		std::unique_ptr<ModelCache> cache = OpenCookedModel(cookedFilename, key);
+		if (cache != nullptr)
+		{
+			ConstructFromCookedModel(filename, *cache);
+			return;
+		}
+	}
+
+	Assimp::Importer imp;
+	const aiScene* scene = imp.ReadFile(filename.c_str(), aiProcess_Triangulate | aiProcess_JoinIdenticalVertices);
+	if (scene == nullptr)
+	{
+		throw DrawableException(__LINE__, __FILE__, "AssImp ReadFile Error:\n" + std::string(imp.GetErrorString()));
+	}
+
+	// When loading a scene/model via assimp, the meshes are just stored in a flat
+	// array. The hierarchy of drawables just have an index into that array. So, 
+	// for our purpose, the drawable we are building needs to first create a vector
+	// of shared pointers to these meshes and then as we build the hierarchy, we
+	// assign out the meshes to the corresponding nodes
+	std::vector<std::shared_ptr<Mesh>> allMeshes;
+
+	// Build up the vector of all meshes for this model
+	std::string meshLookupName;
+	for (unsigned int iii = 0; iii < scene->mNumMeshes; ++iii)
+	{
+		// Create a unique lookup name for the mesh
+		meshLookupName = filename + "-" + std::string(scene->mMeshes[iii]->mName.C_Str());
+
+		// If the mesh already exists in ObjectStore, just get it from there
+		MeshHandle existingMesh = ObjectStore::FindMesh(meshLookupName);
+		if (existingMesh.IsValid())
+			allMeshes.push_back(ObjectStore::GetMesh(existingMesh));
+		else
+		{
+			// Mesh does not exist in object store, so load it from assimp and add it to ObjectStore
+			LoadMesh(*scene->mMeshes[iii], scene->mMaterials, allMeshes);
+			ObjectStore::AddMesh(meshLookupName, allMeshes.back());
+		}
+	}
+
+	// This is only used for the root node, so just get the root node and if there are any children, a different constructor will be used
+	ConstructFromAiNode(*scene->mRootNode, allMeshes, scene->mMaterials);
+
+	// Only models that were imported successfully are cooked, so the cooked file never needs the checks above
+	WriteCookedModel(cookedFilename, key, *scene);
+}
+
+std::unique_ptr<ModelCache> Drawable::OpenCookedModel(const std::string& filename, const ModelCacheKey& key)
+{
+	if (!std::filesystem::exists(filename))
+		return nullptr;
+
+	// A cooked file that cannot be read is not an error - the model is just imported with Assimp again
+	std::unique_ptr<ModelCache> cache;
+	try
+	{
+		cache = std::make_unique<ModelCache>(filename);
+	}
+	catch (const ChameleonException&)
+	{
+		return nullptr;
+	}
+
+	if (!cache->Matches(key))
+		return nullptr;
+
+	return cache;
+}
+
+void Drawable::WriteCookedModel(const std::string& filename, const ModelCacheKey& key, const aiScene& scene)
+{
+	// The cooked file only speeds up the next launch, so failing to write it (read-only install directory, full
+	// disk, ...) must not stop the model from loading
+	try
+	{
+		ModelCache::Write(filename, key, scene);
+	}
+	catch (const ChameleonException& e)
+	{
+		OutputDebugStringA(e.what());
+	}
+}
+
+void Drawable::ConstructFromCookedModel(const std::string& filename, const ModelCache& cache)
+{
+	// Same as for an Assimp import, except that the vertex and index buffers are created directly from the
+	// mapped file and the bounding boxes do not have to be computed
+	std::vector<std::shared_ptr<Mesh>> allMeshes;
+	allMeshes.reserve(cache.MeshCount());
+
+	std::string meshLookupName;
+	for (int iii = 0; iii < cache.MeshCount(); ++iii)
+	{
+		const ModelCache::MeshType& mesh = cache.GetMesh(iii);
+		meshLookupName = filename + "-" + std::string(cache.GetString(mesh.name));
+
+		MeshHandle existingMesh = ObjectStore::FindMesh(meshLookupName);
+		if (existingMesh.IsValid())
+			allMeshes.push_back(ObjectStore::GetMesh(existingMesh));
+		else
+		{
+			allMeshes.push_back(LoadCookedMesh(m_deviceResources, cache, iii));
+
+			// An evicted mesh is reloaded from the cooked file, which only has to be mapped again
+			ObjectStore::AddMesh(meshLookupName, allMeshes.back(),
+				[deviceResources = m_deviceResources, cookedFilename = filename + ".cooked", iii]()
+				{
+					ModelCache cookedModel(cookedFilename);
+					if (iii >= cookedModel.MeshCount())
+						throw DrawableException(__LINE__, __FILE__, "Cooked model file changed since it was loaded: " + cookedFilename);
+					return LoadCookedMesh(deviceResources, cookedModel, iii);
+				}
+			);
+		}
+	}
+
+	// Node 0 is always the root node
+	ConstructFromCookedNode(cache, 0, allMeshes);
+}
+
+std::shared_ptr<Mesh> Drawable::LoadCookedMesh(std::shared_ptr<DeviceResources> deviceResources, const ModelCache& cache, int meshIndex)
+{
+	const ModelCache::MeshType& mesh = cache.GetMesh(meshIndex);
+
+	std::shared_ptr<Mesh> result = std::make_shared<Mesh>(deviceResources);
+	if (mesh.indexSize == sizeof(unsigned short))
+		result->LoadBuffers<OBJVertex>(cache.GetVertices(mesh), mesh.vertexCount, cache.GetIndices<unsigned short>(mesh), mesh.indexCount, &mesh.boundsMin, &mesh.boundsMax);
+	else
+		result->LoadBuffers<OBJVertex>(cache.GetVertices(mesh), mesh.vertexCount, cache.GetIndices<unsigned int>(mesh), mesh.indexCount, &mesh.boundsMin, &mesh.boundsMax);
+	result->SetMaterialIndex(mesh.materialIndex);
+
+	return result;
+}
+
 void Drawable::InitializePipelineConfiguration()
 {
 	// XMMatrix to hold the model-view-projection of the previous frame to allow us to test
@@ -268,16 +443,14 @@ void Drawable::ConstructFromAiNode(const aiNode& node, const std::vector<std::sh
 		material.GetTexture(aiTextureType_DIFFUSE, 0, &textureFileName);
 
 		// Create the texture
-		std::shared_ptr<Texture> texture = std::make_shared<Texture>(m_deviceResources);
-		texture->Create(std::string("models/nanosuit-textured/") + textureFileName.C_Str());
+		std::shared_ptr<Texture> texture = AssetLoader::LoadTexture(std::string("models/nanosuit-textured/") + textureFileName.C_Str());
 
 		AddTexture(TextureBindingLocation::PIXEL_SHADER, texture, false);
 
 		// Determine if the material has a specular map. If not, just use the shininess value
 		if (material.GetTexture(aiTextureType_SPECULAR, 0, &textureFileName) == aiReturn_SUCCESS)
 		{
-			std::shared_ptr<Texture> specular = std::make_shared<Texture>(m_deviceResources);
-			specular->Create(std::string("models/nanosuit-textured/") + textureFileName.C_Str());
+			std::shared_ptr<Texture> specular = AssetLoader::LoadTexture(std::string("models/nanosuit-textured/") + textureFileName.C_Str());
 
 			AddTexture(TextureBindingLocation::PIXEL_SHADER, specular, false);
 
@@ -293,8 +466,7 @@ void Drawable::ConstructFromAiNode(const aiNode& node, const std::vector<std::sh
 		// even though there is an aiTextureType_NORMALS option
 		if (material.GetTexture(aiTextureType_HEIGHT, 0, &textureFileName) == aiReturn_SUCCESS)
 		{
-			std::shared_ptr<Texture> normals = std::make_shared<Texture>(m_deviceResources);
-			normals->Create(std::string("models/nanosuit-textured/") + textureFileName.C_Str());
+			std::shared_ptr<Texture> normals = AssetLoader::LoadTexture(std::string("models/nanosuit-textured/") + textureFileName.C_Str());
 
 			AddTexture(TextureBindingLocation::PIXEL_SHADER, normals, false);
 
@@ -365,6 +537,198 @@ void Drawable::ConstructFromAiNode(const aiNode& node, const std::vector<std::sh
 		m_children.push_back(std::make_unique<Drawable>(m_deviceResources, m_moveLookController, m_name, *node.mChildren[iii], meshes, materials));
 }
 
+void Drawable::ConstructFromCookedNode(const ModelCache& cache, int nodeIndex, const std::vector<std::shared_ptr<Mesh>>& meshes)
+{
+	const ModelCache::NodeType& node = cache.GetNode(nodeIndex);
+
+	// The transform was decomposed (and checked) when the model was cooked
+	m_nodeName = std::string(cache.GetString(node.name));
+	m_scaling = node.scaling;
+	m_rotation = node.rotation;
+	m_translation = node.translation;
+
+	if (node.mesh != -1)
+	{
+		m_mesh = meshes[node.mesh];
+
+		// Same textures as ConstructFromAiNode would have loaded for the material
+		const ModelCache::MaterialType& material = cache.GetMaterial(cache.GetMesh(node.mesh).materialIndex);
+
+		std::shared_ptr<Texture> texture = AssetLoader::LoadTexture(std::string("models/nanosuit-textured/") + std::string(cache.GetString(material.diffuseTexture)));
+
+		AddTexture(TextureBindingLocation::PIXEL_SHADER, texture, false);
+
+		if (material.specularTexture.length > 0)
+		{
+			std::shared_ptr<Texture> specular = AssetLoader::LoadTexture(std::string("models/nanosuit-textured/") + std::string(cache.GetString(material.specularTexture)));
+
+			AddTexture(TextureBindingLocation::PIXEL_SHADER, specular, false);
+		}
+
+		if (material.normalTexture.length > 0)
+		{
+			std::shared_ptr<Texture> normals = AssetLoader::LoadTexture(std::string("models/nanosuit-textured/") + std::string(cache.GetString(material.normalTexture)));
+
+			AddTexture(TextureBindingLocation::PIXEL_SHADER, normals, false);
+		}
+	}
+
+	for (uint32_t iii = 0; iii < node.childCount; ++iii)
+		m_children.push_back(std::make_unique<Drawable>(m_deviceResources, m_moveLookController, m_name, cache, cache.GetChild(node, iii), meshes));
+}
+
+void Drawable::ConstructFromGltfFile(const std::string& filename)
+{
+	GltfModel model(filename);
+
+	// Same as for Assimp: load (or look up) every mesh of the file first, then hand them out while building the
+	// node hierarchy. Meshes use the same lookup names as the Assimp path so both share ObjectStore entries
+	const std::vector<GltfModel::MeshDescription>& meshDescriptions = model.GetMeshes();
+	std::vector<std::shared_ptr<Mesh>> allMeshes;
+	allMeshes.reserve(meshDescriptions.size());
+
+	std::vector<OBJVertex> vertices;		// Reused for every mesh
+	std::vector<unsigned int> indices;
+
+	std::string meshLookupName;
+	for (int iii = 0; iii < static_cast<int>(meshDescriptions.size()); ++iii)
+	{
+		const GltfModel::MeshDescription& description = meshDescriptions[iii];
+
+		// A glTF mesh is a list of primitives, each with its own material. Assimp would turn each one into a mesh
+		// of its own, but a Drawable node can only hold a single mesh
+		if (description.primitives.size() != 1)
+		{
+			std::ostringstream oss;
+			oss << "Drawable: '" << m_name << "' Mesh: '" << description.name << "' has " << description.primitives.size() << " primitives" << std::endl;
+			oss << "We currently only support glTF meshes with exactly one primitive";
+			throw DrawableException(__LINE__, __FILE__, oss.str());
+		}
+
+		meshLookupName = filename + "-" + description.name;
+
+		MeshHandle existingMesh = ObjectStore::FindMesh(meshLookupName);
+		if (existingMesh.IsValid())
+			allMeshes.push_back(ObjectStore::GetMesh(existingMesh));
+		else
+		{
+			allMeshes.push_back(LoadGltfMesh(m_deviceResources, model, iii, vertices, indices));
+
+			// An evicted mesh is reloaded by parsing the file again
+			ObjectStore::AddMesh(meshLookupName, allMeshes.back(),
+				[deviceResources = m_deviceResources, filename, iii]()
+				{
+					GltfModel gltfModel(filename);
+					if (iii >= static_cast<int>(gltfModel.GetMeshes().size()))
+						throw DrawableException(__LINE__, __FILE__, "glTF file changed since it was loaded: " + filename);
+
+					std::vector<OBJVertex> meshVertices;
+					std::vector<unsigned int> meshIndices;
+					return LoadGltfMesh(deviceResources, gltfModel, iii, meshVertices, meshIndices);
+				}
+			);
+		}
+	}
+
+	// A scene with a single root node becomes this drawable. Otherwise this drawable is an empty node that holds
+	// each of the root nodes, which is also what Assimp does
+	const std::vector<int>& sceneNodes = model.GetSceneNodes();
+	if (sceneNodes.size() == 1)
+		ConstructFromGltfNode(model, sceneNodes[0], allMeshes);
+	else
+	{
+		m_nodeName = "ROOT";
+		for (int nodeIndex : sceneNodes)
+			m_children.push_back(std::make_unique<Drawable>(m_deviceResources, m_moveLookController, m_name, model, nodeIndex, allMeshes));
+	}
+}
+
+std::shared_ptr<Mesh> Drawable::LoadGltfMesh(std::shared_ptr<DeviceResources> deviceResources, GltfModel& model, int meshIndex,
+	std::vector<OBJVertex>& vertices, std::vector<unsigned int>& indices)
+{
+	const GltfModel::MeshDescription& description = model.GetMeshes()[meshIndex];
+	if (description.primitives.size() != 1)
+		throw DrawableException(__LINE__, __FILE__, "glTF mesh '" + description.name + "' does not have exactly one primitive");
+
+	// glTF models are not cooked, so their meshes are always drawn in the order of the file without going through
+	// MeshOptimizer
+	const GltfModel::Primitive& primitive = description.primitives[0];
+	model.ReadPrimitive(primitive, vertices, indices);
+
+	std::shared_ptr<Mesh> result = std::make_shared<Mesh>(deviceResources);
+	result->LoadBuffersWithSmallestIndices(vertices, indices);
+	if (primitive.material != -1)
+		result->SetMaterialIndex(primitive.material);
+
+	return result;
+}
+
+void Drawable::ConstructFromGltfNode(const GltfModel& model, int nodeIndex, const std::vector<std::shared_ptr<Mesh>>& meshes)
+{
+	const GltfModel::Node& node = model.GetNodes()[nodeIndex];
+
+	// glTF does not require node names
+	m_nodeName = node.name.empty() ? "node_" + std::to_string(nodeIndex) : node.name;
+
+	// Nodes give either a matrix, which has to be decomposed, or the components themselves
+	XMFLOAT4 rotation = node.rotation;
+	if (node.hasMatrix)
+	{
+		XMVECTOR scale, rotationQuaternion, translation;
+		DirectX::XMMatrixDecompose(&scale, &rotationQuaternion, &translation, DirectX::XMLoadFloat4x4(&node.matrix));
+
+		DirectX::XMStoreFloat3(&m_scaling, scale);
+		DirectX::XMStoreFloat4(&rotation, rotationQuaternion);
+		DirectX::XMStoreFloat3(&m_translation, translation);
+	}
+	else
+	{
+		m_scaling = node.scale;
+		m_translation = node.translation;
+	}
+
+	m_rotation = XMFLOAT3(rotation.x, rotation.y, rotation.z);
+	if (m_rotation.x != 0.0f || m_rotation.y != 0.0f || m_rotation.z != 0.0f)
+	{
+		std::ostringstream oss;
+		oss << "Drawable: '" << m_name << "' Node: '" << m_nodeName << "' has non - unity rotation transform : " << std::endl;
+		oss << "   " << m_rotation.x << ", " << m_rotation.y << ", " << m_rotation.z << std::endl;
+		oss << "This is not yet supported";
+		throw DrawableException(__LINE__, __FILE__, oss.str());
+	}
+
+	// The node is not required to have a mesh
+	if (node.mesh != -1)
+	{
+		m_mesh = meshes[node.mesh];
+
+		// Textures are optional in glTF - materials without any just use the Phong material of the drawable
+		const GltfModel::Primitive& primitive = model.GetMeshes()[node.mesh].primitives[0];
+		if (primitive.material != -1)
+		{
+			const GltfModel::Material& material = model.GetMaterials()[primitive.material];
+
+			if (!material.baseColorTexture.empty())
+			{
+				std::shared_ptr<Texture> texture = AssetLoader::LoadTexture(material.baseColorTexture);
+
+				AddTexture(TextureBindingLocation::PIXEL_SHADER, texture, false);
+			}
+
+			if (!material.normalTexture.empty())
+			{
+				std::shared_ptr<Texture> normals = AssetLoader::LoadTexture(material.normalTexture);
+
+				AddTexture(TextureBindingLocation::PIXEL_SHADER, normals, false);
+			}
+		}
+	}
+
+	// GltfModel has already checked that the nodes form trees, so the recursion always ends
+	for (int child : node.children)
+		m_children.push_back(std::make_unique<Drawable>(m_deviceResources, m_moveLookController, m_name, model, child, meshes));
+}
+
 void Drawable::GetBoundingBoxPositionsWithTransformation(const XMMATRIX& parentModelMatrix, std::vector<XMVECTOR>& positions)
 {
 	// Right now, we force there to be at most one mesh per drawable
@@ -379,35 +743,14 @@ void Drawable::GetBoundingBoxPositionsWithTransformation(const XMMATRIX& parentM
 void Drawable::LoadMesh(const aiMesh& mesh, const aiMaterial* const* materials, std::vector<std::shared_ptr<Mesh>>& meshes)
 {
 	std::vector<OBJVertex> vertices;		// vertices for the vertex buffer
-	std::vector<unsigned short> indices;	// indices for the index buffer
-
-	vertices.reserve(mesh.mNumVertices);
-	for (unsigned int iii = 0; iii < mesh.mNumVertices; iii++)
-	{
-		vertices.push_back(
-			{
-				*reinterpret_cast<XMFLOAT3*>(&mesh.mVertices[iii]),
-				*reinterpret_cast<XMFLOAT2*>(&mesh.mTextureCoords[0][iii]), // Use texture at index 0, but there can be >1 texture
-				*reinterpret_cast<XMFLOAT3*>(&mesh.mNormals[iii])
-			}
-		);
-
-		// The V coordinate is stupidly flipped - Not sure how to tell when this is needed
-		vertices.back().texture.y = 1 - vertices.back().texture.y;
-	}
+	std::vector<unsigned int> indices;		// indices for the index buffer
+	ModelCache::ConvertMesh(mesh, vertices, indices);
 
-	indices.reserve(mesh.mNumFaces * 3);
-	for (unsigned int i = 0; i < mesh.mNumFaces; i++)
-	{
-		const aiFace& face = mesh.mFaces[i];
-		assert(face.mNumIndices == 3);
-		indices.push_back(face.mIndices[0]);
-		indices.push_back(face.mIndices[1]);
-		indices.push_back(face.mIndices[2]);
-	}
+	// The mesh is drawn exactly as Assimp imported it - MeshOptimizer only runs when the model is cooked (see
+	// WriteCookedModel), so the optimized order is first used the next time the model is loaded
 
 	meshes.push_back(std::make_shared<Mesh>(m_deviceResources));
-	meshes.back()->LoadBuffers<OBJVertex>(vertices, indices);
+	meshes.back()->LoadBuffersWithSmallestIndices(vertices, indices);
 	meshes.back()->SetMaterialIndex(mesh.mMaterialIndex);
 }
 
@@ -557,28 +900,53 @@ void Drawable::CreateAndAddPSBufferArray()
 
 void Drawable::UpdateRenderData()
 {
-	// This Update function is public and will be called by the Scene. In order to recursively
-	// update the drawable hierarchy, we must call the other Update function (which is protected)
-	// Because this is the root node in the hierarchy, we can pass in the identity matrix and the
-	// next Update function will correctly compute the accumulated model matrix
-	UpdateRenderData(DirectX::XMMatrixIdentity());
-}
+	// This Update function is called by the Scene on the root of a hierarchy. Children are only ever added while
+	// a hierarchy is being constructed, so it is flattened into a TransformHierarchy the first time
+	if (m_transforms == nullptr)
+	{
+		m_transforms = std::make_unique<TransformHierarchy>();
+		m_transformNodes.clear();
+		FlattenTransforms(*m_transforms, m_transformNodes, TransformHierarchy::NO_PARENT);
+	}
 
-void Drawable::UpdateRenderData(const XMMATRIX& parentModelMatrix)
-{
-	// Update the model matrix for this node and then update all children
-	m_accumulatedModelMatrix = this->GetPreParentTransformModelMatrix() * parentModelMatrix;
+	// Nodes are moved by writing their members directly (ImGui, physics, PreDrawUpdate functions), so the local
+	// transforms are copied over every frame. Only the matrices of nodes that actually moved, and of the nodes
+	// below them, are rebuilt
+	const int nodeCount = static_cast<int>(m_transformNodes.size());
+	for (int iii = 0; iii < nodeCount; ++iii)
+	{
+		Drawable* node = m_transformNodes[iii];
+		m_transforms->SetTranslation(iii, node->m_translation);
+		m_transforms->SetRotation(iii, node->m_pitch, node->m_yaw, node->m_roll);
+		m_transforms->SetScale(iii, node->m_scaling);
+	}
 
-	// Update the constant buffers that need updating
-	for (std::tuple<std::shared_ptr<ConstantBuffer>, std::function<void(std::shared_ptr<ConstantBuffer>)>> tup : m_updateFunctions)
+	m_transforms->Update();
+
+	// The nodes are in hierarchy order, so the update functions run in the same order as they always have
+	for (int iii = 0; iii < nodeCount; ++iii)
 	{
-		// Pass the constant buffer to the update functional
-		std::get<1>(tup)(std::get<0>(tup));
+		Drawable* node = m_transformNodes[iii];
+		if (m_transforms->WorldChanged(iii))
+			node->m_accumulatedModelMatrix = m_transforms->GetWorldMatrix(iii);
+
+		// Update the constant buffers that need updating
+		for (const std::tuple<std::shared_ptr<ConstantBuffer>, std::function<void(std::shared_ptr<ConstantBuffer>)>>& tup : node->m_updateFunctions)
+		{
+			// Pass the constant buffer to the update functional
+			std::get<1>(tup)(std::get<0>(tup));
+		}
 	}
+}
 
+void Drawable::FlattenTransforms(TransformHierarchy& transforms, std::vector<Drawable*>& nodes, int parent)
+{
+	// Pre-order, so every parent is added before its children
+	int node = transforms.AddNode(parent);
+	nodes.push_back(this);
 
 	for (std::unique_ptr<Drawable>& child : m_children)
-		child->UpdateRenderData(m_accumulatedModelMatrix);
+		child->FlattenTransforms(transforms, nodes, node);
 }
 
 void Drawable::UpdateModelViewProjectionBuffer(std::shared_ptr<ConstantBuffer> constantBuffer)
@@ -620,8 +988,6 @@ void Drawable::UpdateModelViewProjectionBuffer(std::shared_ptr<ConstantBuffer> c
 
 void Drawable::Draw()
 {
-	INFOMAN(m_deviceResources);
-
 	// Bind all bindables and then draw the model
 	for (std::shared_ptr<Bindable> bindable : m_bindables)
 		bindable->Bind();
@@ -631,29 +997,9 @@ void Drawable::Draw()
 	// before submitting the vertices to be rendered
 	PreDrawUpdate();
 
-	// Bind the mesh (vertex and index buffers) 
 	// NOTE: Only allowing a single mesh per Drawable at most
 	if (m_mesh != nullptr)
-	{
-		m_mesh->Bind();
-
-		// Update the Model-view-projection constant buffer with the aggregated model matrix
-		UpdateModelViewProjectionConstantBuffer();
-
-		// Determine the type of draw call from the mesh
-		if (m_mesh->DrawIndexed())
-		{
-			GFX_THROW_INFO_ONLY(
-				m_deviceResources->D3DDeviceContext()->DrawIndexed(m_mesh->IndexCount(), 0u, 0u)
-			);
-		}
-		else
-		{
-			GFX_THROW_INFO_ONLY(
-				m_deviceResources->D3DDeviceContext()->Draw(m_mesh->VertexCount(), 0u)
-			);
-		}
-	}
+		DrawMesh();
 
 	// Draw all children
 	for (std::unique_ptr<Drawable>& child : m_children)
@@ -664,54 +1010,153 @@ void Drawable::Draw()
 
 
 #ifndef NDEBUG
-	// Determine if any bounding boxes need to be draw for any of the nodes
-	if (NeedDrawBoundingBox())
+	DrawBoundingBoxes();
+#endif
+}
+
+void Drawable::DrawMesh()
+{
+	if (m_instanced)
 	{
-		// Bind necessary bindables for drawing box lines
+		Drawable* self = this;
+		DrawMeshInstanced(&self, 1);
+		return;
+	}
 
-		ObjectStore::GetBindable("solid-vertex-shader")->Bind();				// Vertex Shader
-		ObjectStore::GetBindable("solid-vertex-shader-IA")->Bind();				// Input Layout
-		ObjectStore::GetBindable("solid-pixel-shader")->Bind();					// Pixel Shader
+	INFOMAN(m_deviceResources);
 
-		ObjectStore::GetBindable("solidfill")->Bind();							// Rasterizer State
-		ObjectStore::GetBindable("depth-enabled-depth-stencil-state")->Bind();	// Depth Stencil State
+	// Bind the mesh (vertex and index buffers) 
+	m_mesh->Bind();
 
-		// Recursively draw any visible bounding boxes
-		DrawBoundingBox();
+	// The constants are normally written for the whole batch before it is drawn (see DeviceContextRenderBackend).
+	// A node drawn on its own writes them here
+	if (!m_modelViewProjectionWritten)
+	{
+		ConstantRingBuffer::Map(ConstantRingBuffer::AlignedSize(sizeof(ModelViewProjectionConstantBuffer)));
+		WriteModelViewProjection();
+		ConstantRingBuffer::Unmap();
+	}
+	ConstantRingBuffer::BindVS(0u, m_modelViewProjectionConstant, sizeof(ModelViewProjectionConstantBuffer));
+	m_modelViewProjectionWritten = false;
+
+	// Determine the type of draw call from the mesh
+	if (m_mesh->DrawIndexed())
+	{
+		GFX_THROW_INFO_ONLY(
+			m_deviceResources->D3DDeviceContext()->DrawIndexed(m_mesh->IndexCount(), m_mesh->StartIndex(), 0u)
+		);
+	}
+	else
+	{
+		GFX_THROW_INFO_ONLY(
+			m_deviceResources->D3DDeviceContext()->Draw(m_mesh->VertexCount(), 0u)
+		);
 	}
-#endif
 }
 
+void Drawable::DrawMeshInstanced(Drawable* const* drawables, size_t count)
+{
+	Drawable* first = drawables[0];
+	INFOMAN(first->m_deviceResources);
+
+	first->m_mesh->Bind();
+
+	// Instances are normally written for the whole queue before it is drawn (see DeviceContextRenderBackend)
+	if (!first->m_instanceWritten)
+	{
+		InstanceBuffer::Map(static_cast<unsigned int>(count));
+		for (size_t iii = 0; iii < count; ++iii)
+			drawables[iii]->WriteInstance();
+		InstanceBuffer::Unmap();
+	}
+	InstanceBuffer::Bind();
 
+	for (size_t iii = 0; iii < count; ++iii)
+		drawables[iii]->m_instanceWritten = false;
 
-void Drawable::UpdateModelViewProjectionConstantBuffer()
+	const UINT instanceCount = static_cast<UINT>(count);
+	if (first->m_mesh->DrawIndexed())
+	{
+		GFX_THROW_INFO_ONLY(
+			first->m_deviceResources->D3DDeviceContext()->DrawIndexedInstanced(first->m_mesh->IndexCount(), instanceCount, first->m_mesh->StartIndex(), 0, first->m_instance)
+		);
+	}
+	else
+	{
+		GFX_THROW_INFO_ONLY(
+			first->m_deviceResources->D3DDeviceContext()->DrawInstanced(first->m_mesh->VertexCount(), instanceCount, 0u, first->m_instance)
+		);
+	}
+}
+
+void Drawable::Submit(RenderQueue& queue)
 {
-	INFOMAN(m_deviceResources);
+	std::vector<Bindable*> bindables;
+	Submit(queue, bindables);
+}
 
-	ID3D11DeviceContext4* context = m_deviceResources->D3DDeviceContext();
-	D3D11_MAPPED_SUBRESOURCE ms;
-	ZeroMemory(&ms, sizeof(D3D11_MAPPED_SUBRESOURCE));
+void Drawable::Submit(RenderQueue& queue, std::vector<Bindable*>& bindables)
+{
+	// bindables holds what the ancestors bind - in hierarchy order that would still be bound when this node is
+	// drawn, so it goes into the packet ahead of this node's own bindables
+	const size_t inheritedCount = bindables.size();
+	for (const std::shared_ptr<Bindable>& bindable : m_bindables)
+		bindables.push_back(bindable.get());
 
-	// Update VS constant buffer with model/view/projection info
-	Microsoft::WRL::ComPtr<ID3D11Buffer> vsBuffer;
-	GFX_THROW_INFO_ONLY(
-		context->VSGetConstantBuffers(0, 1, vsBuffer.ReleaseAndGetAddressOf())
-	);
+	PreDrawUpdate();
 
-	GFX_THROW_INFO(
-		context->Map(vsBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &ms)
-	);
+	if (m_mesh != nullptr)
+	{
+		// Distance from the camera to the origin of the node
+		float depth = DirectX::XMVectorGetX(
+			DirectX::XMVector3Length(DirectX::XMVectorSubtract(m_accumulatedModelMatrix.r[3], m_moveLookController->Position()))
+		);
+		queue.Submit(this, m_renderPass, depth, bindables.data(), bindables.size(), m_instanced ? m_mesh.get() : nullptr);
+	}
+
+	for (std::unique_ptr<Drawable>& child : m_children)
+		child->Submit(queue, bindables);
+
+	// Update the previous frame model-view-projection matrix
+	m_previousModelViewProjection = m_accumulatedModelMatrix * m_moveLookController->ViewMatrix() * m_moveLookController->ProjectionMatrix();
+
+	bindables.resize(inheritedCount);
+}
+
+
+
+void Drawable::WriteModelViewProjection()
+{
+	ModelViewProjectionConstantBuffer constants;
+	ComputeModelViewProjection(constants);
+
+	m_modelViewProjectionConstant = ConstantRingBuffer::Write(constants);
+	m_modelViewProjectionWritten = true;
+}
+
+void Drawable::WriteInstance()
+{
+	InstanceData instance;
+	ComputeModelViewProjection(instance);
+
+	m_instance = InstanceBuffer::Write(instance);
+	m_instanceWritten = true;
+}
 
-	ModelViewProjectionConstantBuffer* mappedBuffer = (ModelViewProjectionConstantBuffer*)ms.pData;
+void Drawable::ComputeModelViewProjection(ModelViewProjectionConstantBuffer& constants)
+{
 	XMMATRIX model = m_accumulatedModelMatrix;
 	XMMATRIX viewProjection = m_moveLookController->ViewMatrix() * m_projectionMatrix;
-	DirectX::XMStoreFloat4x4(&(mappedBuffer->model), model);
-	DirectX::XMStoreFloat4x4(&(mappedBuffer->modelViewProjection), model * viewProjection);
-	DirectX::XMStoreFloat4x4(&(mappedBuffer->inverseTransposeModel), DirectX::XMMatrixTranspose(DirectX::XMMatrixInverse(nullptr, model)));
+	DirectX::XMStoreFloat4x4(&constants.model, model);
+	DirectX::XMStoreFloat4x4(&constants.modelViewProjection, model * viewProjection);
 
-	GFX_THROW_INFO_ONLY(
-		context->Unmap(vsBuffer.Get(), 0)
-	);
+	// The model matrix of most nodes only changes when they are moved, so the inverse is only redone then
+	if (memcmp(&constants.model, &m_inverseTransposeSource, sizeof(DirectX::XMFLOAT4X4)) != 0)
+	{
+		m_inverseTransposeSource = constants.model;
+		DirectX::XMStoreFloat4x4(&m_inverseTransposeModel, DirectX::XMMatrixTranspose(DirectX::XMMatrixInverse(nullptr, model)));
+	}
+	constants.inverseTransposeModel = m_inverseTransposeModel;
 }
 
 XMMATRIX Drawable::GetPreParentTransformModelMatrix()
@@ -721,6 +1166,29 @@ XMMATRIX Drawable::GetPreParentTransformModelMatrix()
 		DirectX::XMMatrixTranslation(m_translation.x, m_translation.y, m_translation.z);
 }
 
+bool Drawable::GetWorldBounds(XMFLOAT3& minimum, XMFLOAT3& maximum)
+{
+	if (m_boundingBox == nullptr)
+		return false;
+
+	// Same transformation the bounding box is drawn with
+	std::vector<XMVECTOR> corners;
+	corners.reserve(8);
+	m_boundingBox->GetBoundingBoxPositionsWithTransformation(m_accumulatedModelMatrix, corners);
+
+	XMVECTOR lower = corners[0];
+	XMVECTOR upper = corners[0];
+	for (const XMVECTOR& corner : corners)
+	{
+		lower = DirectX::XMVectorMin(lower, corner);
+		upper = DirectX::XMVectorMax(upper, corner);
+	}
+
+	DirectX::XMStoreFloat3(&minimum, lower);
+	DirectX::XMStoreFloat3(&maximum, upper);
+	return true;
+}
+
 bool Drawable::IsMouseHovered(float mouseX, float mouseY, float& distance)
 {
 	// Compute the ray origin and ray direction vector
@@ -988,6 +1456,36 @@ bool Drawable::NeedDrawBoundingBox()
 	return false;
 }
 
+void Drawable::DrawBoundingBoxes()
+{
+	// Determine if any bounding boxes need to be draw for any of the nodes
+	if (!NeedDrawBoundingBox())
+		return;
+
+	// Bind necessary bindables for drawing box lines. The handles are kept between calls and only looked up by name
+	// again once they stop resolving - ObjectStore::DestructObjects clears them and the next window adds them again
+	// under new handles
+	static const char* const names[] = {
+		"solid-vertex-shader",					// Vertex Shader
+		"solid-vertex-shader-IA",				// Input Layout
+		"solid-pixel-shader",					// Pixel Shader
+		"solidfill",							// Rasterizer State
+		"depth-enabled-depth-stencil-state"		// Depth Stencil State
+	};
+	static BindableHandle handles[std::size(names)];
+
+	for (size_t iii = 0; iii < std::size(names); ++iii)
+	{
+		if (!ObjectStore::BindableExists(handles[iii]))
+			handles[iii] = ObjectStore::FindBindable(names[iii]);
+
+		ObjectStore::GetBindable(handles[iii])->Bind();
+	}
+
+	// Recursively draw any visible bounding boxes
+	DrawBoundingBox();
+}
+
 void Drawable::DrawBoundingBox()
 {
 	// Draw the bounding box for the drawable as a whole if necessary
@@ -2,11 +2,18 @@
 #include "pch.h"
 #include "Bindable.h"
 #include "ObjectStore.h"
+#include "AssetLoader.h"
 #include "BoundingBox.h"
 #include "StepTimer.h"
 #include "MoveLookController.h"
 #include "DrawableException.h"
 #include "SamplerStateArray.h"
+#include "GltfModel.h"
+#include "ModelCache.h"
+#include "RenderQueue.h"
+#include "ConstantRingBuffer.h"
+#include "InstanceBuffer.h"
+#include "TransformHierarchy.h"
 
 #include <vector>
 #include <memory>
@@ -41,6 +48,8 @@ public:
 	Drawable(std::shared_ptr<DeviceResources> deviceResources, std::shared_ptr<MoveLookController> moveLookController, std::string filename);
 	Drawable(std::shared_ptr<DeviceResources> deviceResources, std::shared_ptr<MoveLookController> moveLookController, std::shared_ptr<Mesh> mesh);
 	Drawable(std::shared_ptr<DeviceResources> deviceResources, std::shared_ptr<MoveLookController> moveLookController, std::string name, const aiNode& node, const std::vector<std::shared_ptr<Mesh>>& meshes, const aiMaterial* const* materials);
+	Drawable(std::shared_ptr<DeviceResources> deviceResources, std::shared_ptr<MoveLookController> moveLookController, std::string name, const ModelCache& cache, int nodeIndex, const std::vector<std::shared_ptr<Mesh>>& meshes);
+	Drawable(std::shared_ptr<DeviceResources> deviceResources, std::shared_ptr<MoveLookController> moveLookController, std::string name, const GltfModel& model, int nodeIndex, const std::vector<std::shared_ptr<Mesh>>& meshes);
 
 	void AddBindable(std::string lookupName);
 	void AddBindable(std::shared_ptr<Bindable> bindable);
@@ -48,6 +57,36 @@ public:
 
 	void Draw();
 
+	// Adds a packet for every node with a mesh to the queue instead of drawing the hierarchy straight away. The
+	// PreDrawUpdate functions run here, in hierarchy order, so they are all done before the queue is executed
+	void Submit(RenderQueue& queue);
+
+	// Binds the mesh, binds this node's model/view/projection constants and issues the draw call - everything else
+	// must already be bound
+	void DrawMesh();
+
+	// Writes the model/view/projection constants for the next DrawMesh into the ConstantRingBuffer, which must be
+	// mapped. Lets a batch of nodes share a single Map
+	void WriteModelViewProjection();
+
+	// An instanced node is drawn with an instanced vertex shader (e.g. "phong-instanced-vertex-shader" and its
+	// input layout), reading its matrices from the InstanceBuffer instead of the constant buffer. The render queue
+	// draws instanced nodes that share a mesh and every bindable with a single draw call, so they also have to share
+	// their material - add one from the ObjectStore (e.g. "sphere-field-buffers-PS") rather than calling
+	// CreateAndAddPSBufferArray. Submit throws if the shader and the node do not agree on being instanced
+	void SetInstanced(bool instanced) { m_instanced = instanced; }
+	bool IsInstanced() const { return m_instanced; }
+
+	// Same as WriteModelViewProjection, for instanced nodes - the InstanceBuffer must be mapped
+	void WriteInstance();
+
+	// Draws the meshes of count instanced nodes with one draw call. The nodes must share a mesh and all their
+	// bindables must already be bound. If the first node's instance was written, those of the others have to follow
+	// it in the InstanceBuffer
+	static void DrawMeshInstanced(Drawable* const* drawables, size_t count);
+
+	void SetRenderPass(RenderPass pass) { m_renderPass = pass; }
+
 	// Every object should provide how to scale itself
 	DirectX::XMMATRIX GetScaleMatrix() { return DirectX::XMMatrixScaling(m_scaling.x, m_scaling.y, m_scaling.z); }
 	DirectX::XMMATRIX GetPreParentTransformModelMatrix();
@@ -75,7 +114,12 @@ public:
 
 	bool IsMouseHovered(float mouseX, float mouseY, float& distance);
 
-	// Functional used for updating buffers, etc., after all bindings and before issuing the draw call
+	// World space axis aligned bounds of the whole hierarchy as of the last UpdateRenderData. Only drawables loaded
+	// from a model file have bounds - returns false for every other drawable
+	bool GetWorldBounds(DirectX::XMFLOAT3& minimum, DirectX::XMFLOAT3& maximum);
+
+	// Functional used for updating buffers, etc., before issuing the draw call. When the drawable is submitted to a
+	// RenderQueue it runs at submission, so it must not rely on anything being bound
 	std::function<void()> PreDrawUpdate;
 
 	// Functional for user interaction events
@@ -105,12 +149,24 @@ public:
 	void AddConstantBuffer(ConstantBufferBindingLocation bindingLocation, void* initialData, void (Drawable::* updateFunc)(std::shared_ptr<ConstantBuffer>), bool recursive = true);
 
 protected:
-	// This Update function is designed to be called during the recursive Update of a Drawable hierarchy.
-	void UpdateRenderData(const DirectX::XMMATRIX& parentModelMatrix);
-	void UpdateModelViewProjectionConstantBuffer();
+	void FlattenTransforms(TransformHierarchy& transforms, std::vector<Drawable*>& nodes, int parent);
+	void Submit(RenderQueue& queue, std::vector<Bindable*>& bindables);
+	void ComputeModelViewProjection(ModelViewProjectionConstantBuffer& constants);
 	void InitializePipelineConfiguration();
 	void LoadMesh(const aiMesh& mesh, const aiMaterial* const* materials, std::vector<std::shared_ptr<Mesh>>& meshes);
+	void ConstructFromAssimpFile(const std::string& filename);
 	void ConstructFromAiNode(const aiNode& node, const std::vector<std::shared_ptr<Mesh>>& meshes, const aiMaterial* const* materials);
+	std::unique_ptr<ModelCache> OpenCookedModel(const std::string& filename, const ModelCacheKey& key);
+	void WriteCookedModel(const std::string& filename, const ModelCacheKey& key, const aiScene& scene);
+	void ConstructFromCookedModel(const std::string& filename, const ModelCache& cache);
+	void ConstructFromCookedNode(const ModelCache& cache, int nodeIndex, const std::vector<std::shared_ptr<Mesh>>& meshes);
+	void ConstructFromGltfFile(const std::string& filename);
+
+	// Build a single mesh of a model file. Static so ObjectStore can use them to reload a mesh it has evicted
+	static std::shared_ptr<Mesh> LoadCookedMesh(std::shared_ptr<DeviceResources> deviceResources, const ModelCache& cache, int meshIndex);
+	static std::shared_ptr<Mesh> LoadGltfMesh(std::shared_ptr<DeviceResources> deviceResources, GltfModel& model, int meshIndex,
+		std::vector<OBJVertex>& vertices, std::vector<unsigned int>& indices);
+	void ConstructFromGltfNode(const GltfModel& model, int nodeIndex, const std::vector<std::shared_ptr<Mesh>>& meshes);
 	void GetBoundingBoxPositionsWithTransformation(const DirectX::XMMATRIX& parentModelMatrix, std::vector<DirectX::XMVECTOR>& positions);
 	bool IsMouseHovered(const DirectX::XMVECTOR& clickPointNear,
 		const DirectX::XMVECTOR& clickPointFar,
@@ -131,6 +187,7 @@ protected:
 	DirectX::XMMATRIX m_projectionMatrix;
 
 	std::vector<std::shared_ptr<Bindable>> m_bindables;
+	RenderPass m_renderPass = RenderPass::SOLID;
 
 	// Rotation about the internal center point
 	float m_roll;
@@ -141,6 +198,17 @@ protected:
 	// -------------------------------------------------------------
 	DirectX::XMMATRIX m_previousModelViewProjection;
 
+	// Where WriteModelViewProjection put this node's constants in the ConstantRingBuffer. The inverse transpose is
+	// kept along with the model matrix it was computed from
+	unsigned int m_modelViewProjectionConstant = 0;
+	bool m_modelViewProjectionWritten = false;
+
+	bool m_instanced = false;
+	unsigned int m_instance = 0;	// Where WriteInstance put this node's matrices in the InstanceBuffer
+	bool m_instanceWritten = false;
+	DirectX::XMFLOAT4X4 m_inverseTransposeSource = {};
+	DirectX::XMFLOAT4X4 m_inverseTransposeModel = {};
+
 	std::shared_ptr<InputLayout>			m_inputLayout;
 	std::shared_ptr<VertexShader>			m_vertexShader;
 	std::shared_ptr<PixelShader>			m_pixelShader;
@@ -163,6 +231,11 @@ protected:
 	DirectX::XMFLOAT3 m_scaling;
 	DirectX::XMMATRIX m_accumulatedModelMatrix;
 
+	// Only set on the root of a hierarchy - UpdateRenderData builds the world matrix of every node through it.
+	// m_transformNodes holds the node for each index of the TransformHierarchy
+	std::unique_ptr<TransformHierarchy> m_transforms;
+	std::vector<Drawable*> m_transformNodes;
+
 	// BoundingBox to excapsulate the entire Model
 	std::unique_ptr<::BoundingBox>	m_boundingBox;
 
@@ -174,6 +247,7 @@ protected:
 #ifndef NDEBUG
 public:
 	void SetMoveLookController(std::shared_ptr<MoveLookController> mlc);
+	void DrawBoundingBoxes();
 	virtual void DrawImGuiCollapsable(std::string id);
 	virtual void DrawImGuiDetails(std::string id);
 	void UpdatePhongMaterial();
@@ -349,4 +349,198 @@ bool Frustum::CheckRectangle2(float maxWidth, float maxHeight, float maxDepth, f
 	}
 
 	return true;
-}
\ No newline at end of file
+}
+
+FrustumContainment Frustum::ClassifyRectangle(float maxWidth, float maxHeight, float maxDepth, float minWidth, float minHeight, float minDepth)
+{
+	FrustumContainment result = FrustumContainment::INSIDE;
+
+	for (int i = 0; i < 6; i++)
+	{
+		// The corner furthest along the plane normal (p-vertex) decides if the box is completely outside,
+		// the corner furthest against it (n-vertex) decides if the box is completely inside
+		float px = m_planes[i][0] >= 0.0f ? maxWidth : minWidth;
+		float py = m_planes[i][1] >= 0.0f ? maxHeight : minHeight;
+		float pz = m_planes[i][2] >= 0.0f ? maxDepth : minDepth;
+		float nx = m_planes[i][0] >= 0.0f ? minWidth : maxWidth;
+		float ny = m_planes[i][1] >= 0.0f ? minHeight : maxHeight;
+		float nz = m_planes[i][2] >= 0.0f ? minDepth : maxDepth;
+
+		if ((m_planes[i][0] * px) + (m_planes[i][1] * py) + (m_planes[i][2] * pz) + m_planes[i][3] < 0.0f)
+			return FrustumContainment::OUTSIDE;
+
+		if ((m_planes[i][0] * nx) + (m_planes[i][1] * ny) + (m_planes[i][2] * nz) + m_planes[i][3] < 0.0f)
+			result = FrustumContainment::INTERSECTS;
+	}
+
+	return result;
+}
+
+Frustum::Implementation Frustum::s_implementation = Frustum::BestImplementation();
+
+Frustum::Implementation Frustum::BestImplementation()
+{
+	// Every x64 processor has SSE2
+	if (CpuFeatures::HasAvx2())
+		return Implementation::AVX2;
+	return Implementation::SSE;
+}
+
+void Frustum::SetImplementation(Implementation implementation)
+{
+	// Like TangentSpace, the order of the enum is also the order of support
+	s_implementation = std::min(implementation, BestImplementation());
+}
+
+void Frustum::CheckRectangles(const float* minX, const float* minY, const float* minZ,
+	const float* maxX, const float* maxY, const float* maxZ,
+	size_t count, uint32_t* visibleMask, uint32_t* insideMask)
+{
+	size_t maskCount = (count + 31) / 32;
+	std::fill(visibleMask, visibleMask + maskCount, 0u);
+	if (insideMask != nullptr)
+		std::fill(insideMask, insideMask + maskCount, 0u);
+
+	size_t iii = 0;
+	switch (s_implementation)
+	{
+	case Implementation::AVX2:
+		CheckRectanglesAvx2(minX, minY, minZ, maxX, maxY, maxZ, iii, count, visibleMask, insideMask);
+		[[fallthrough]];
+	case Implementation::SSE:
+		CheckRectanglesSse(minX, minY, minZ, maxX, maxY, maxZ, iii, count, visibleMask, insideMask);
+		break;
+	default:
+		break;
+	}
+
+	// Remaining boxes
+	for (; iii < count; ++iii)
+	{
+		FrustumContainment containment = ClassifyRectangle(maxX[iii], maxY[iii], maxZ[iii], minX[iii], minY[iii], minZ[iii]);
+		if (containment != FrustumContainment::OUTSIDE)
+			visibleMask[iii / 32] |= 1u << (iii % 32);
+		if (insideMask != nullptr && containment == FrustumContainment::INSIDE)
+			insideMask[iii / 32] |= 1u << (iii % 32);
+	}
+}
+
+void Frustum::CheckRectanglesSse(const float* minX, const float* minY, const float* minZ,
+	const float* maxX, const float* maxY, const float* maxZ,
+	size_t& first, size_t count, uint32_t* visibleMask, uint32_t* insideMask)
+{
+	// Broadcast each plane once. The sign of each normal component decides whether the min or max coordinate
+	// is the p-vertex for that plane, which is the same for every box
+	__m128 planeX[6], planeY[6], planeZ[6], planeD[6];
+	bool positiveX[6], positiveY[6], positiveZ[6];
+	for (int i = 0; i < 6; i++)
+	{
+		planeX[i] = _mm_set1_ps(m_planes[i][0]);
+		planeY[i] = _mm_set1_ps(m_planes[i][1]);
+		planeZ[i] = _mm_set1_ps(m_planes[i][2]);
+		planeD[i] = _mm_set1_ps(m_planes[i][3]);
+		positiveX[i] = m_planes[i][0] >= 0.0f;
+		positiveY[i] = m_planes[i][1] >= 0.0f;
+		positiveZ[i] = m_planes[i][2] >= 0.0f;
+	}
+
+	const __m128 zero = _mm_setzero_ps();
+
+	// Four boxes per iteration - 32 is a multiple of 4, so each group of four bits lands in a single mask value
+	size_t iii = first;
+	for (; iii + 4 <= count; iii += 4)
+	{
+		__m128 x0 = _mm_loadu_ps(minX + iii);
+		__m128 y0 = _mm_loadu_ps(minY + iii);
+		__m128 z0 = _mm_loadu_ps(minZ + iii);
+		__m128 x1 = _mm_loadu_ps(maxX + iii);
+		__m128 y1 = _mm_loadu_ps(maxY + iii);
+		__m128 z1 = _mm_loadu_ps(maxZ + iii);
+
+		__m128 visible = _mm_cmpeq_ps(zero, zero);
+		__m128 inside = visible;
+
+		for (int i = 0; i < 6; i++)
+		{
+			// Same operation order as ClassifyRectangle so both paths agree on boxes that touch a plane
+			__m128 dot = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+				_mm_mul_ps(planeX[i], positiveX[i] ? x1 : x0),
+				_mm_mul_ps(planeY[i], positiveY[i] ? y1 : y0)),
+				_mm_mul_ps(planeZ[i], positiveZ[i] ? z1 : z0)),
+				planeD[i]);
+			visible = _mm_and_ps(visible, _mm_cmpge_ps(dot, zero));
+
+			dot = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+				_mm_mul_ps(planeX[i], positiveX[i] ? x0 : x1),
+				_mm_mul_ps(planeY[i], positiveY[i] ? y0 : y1)),
+				_mm_mul_ps(planeZ[i], positiveZ[i] ? z0 : z1)),
+				planeD[i]);
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(dot, zero));
+		}
+
+		visibleMask[iii / 32] |= static_cast<uint32_t>(_mm_movemask_ps(visible)) << (iii % 32);
+		if (insideMask != nullptr)
+			insideMask[iii / 32] |= static_cast<uint32_t>(_mm_movemask_ps(_mm_and_ps(visible, inside))) << (iii % 32);
+	}
+
+	first = iii;
+}
+
+void Frustum::CheckRectanglesAvx2(const float* minX, const float* minY, const float* minZ,
+	const float* maxX, const float* maxY, const float* maxZ,
+	size_t& first, size_t count, uint32_t* visibleMask, uint32_t* insideMask)
+{
+	// The SSE version eight boxes at a time
+	__m256 planeX[6], planeY[6], planeZ[6], planeD[6];
+	bool positiveX[6], positiveY[6], positiveZ[6];
+	for (int i = 0; i < 6; i++)
+	{
+		planeX[i] = _mm256_set1_ps(m_planes[i][0]);
+		planeY[i] = _mm256_set1_ps(m_planes[i][1]);
+		planeZ[i] = _mm256_set1_ps(m_planes[i][2]);
+		planeD[i] = _mm256_set1_ps(m_planes[i][3]);
+		positiveX[i] = m_planes[i][0] >= 0.0f;
+		positiveY[i] = m_planes[i][1] >= 0.0f;
+		positiveZ[i] = m_planes[i][2] >= 0.0f;
+	}
+
+	const __m256 zero = _mm256_setzero_ps();
+
+	size_t iii = first;
+	for (; iii + 8 <= count; iii += 8)
+	{
+		__m256 x0 = _mm256_loadu_ps(minX + iii);
+		__m256 y0 = _mm256_loadu_ps(minY + iii);
+		__m256 z0 = _mm256_loadu_ps(minZ + iii);
+		__m256 x1 = _mm256_loadu_ps(maxX + iii);
+		__m256 y1 = _mm256_loadu_ps(maxY + iii);
+		__m256 z1 = _mm256_loadu_ps(maxZ + iii);
+
+		__m256 visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+		__m256 inside = visible;
+
+		for (int i = 0; i < 6; i++)
+		{
+			// No fused multiply-adds, so the results match ClassifyRectangle bit for bit
+			__m256 dot = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+				_mm256_mul_ps(planeX[i], positiveX[i] ? x1 : x0),
+				_mm256_mul_ps(planeY[i], positiveY[i] ? y1 : y0)),
+				_mm256_mul_ps(planeZ[i], positiveZ[i] ? z1 : z0)),
+				planeD[i]);
+			visible = _mm256_and_ps(visible, _mm256_cmp_ps(dot, zero, _CMP_GE_OQ));
+
+			dot = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+				_mm256_mul_ps(planeX[i], positiveX[i] ? x0 : x1),
+				_mm256_mul_ps(planeY[i], positiveY[i] ? y0 : y1)),
+				_mm256_mul_ps(planeZ[i], positiveZ[i] ? z0 : z1)),
+				planeD[i]);
+			inside = _mm256_and_ps(inside, _mm256_cmp_ps(dot, zero, _CMP_GE_OQ));
+		}
+
+		visibleMask[iii / 32] |= static_cast<uint32_t>(_mm256_movemask_ps(visible)) << (iii % 32);
+		if (insideMask != nullptr)
+			insideMask[iii / 32] |= static_cast<uint32_t>(_mm256_movemask_ps(_mm256_and_ps(visible, inside))) << (iii % 32);
+	}
+
+	first = iii;
+}
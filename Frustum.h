@@ -1,10 +1,32 @@
 #pragma once
 #include "pch.h"
+#include "CpuFeatures.h"
 
+#include <algorithm>
+
+#include <immintrin.h>
+
+enum class FrustumContainment
+{
+	OUTSIDE,
+	INTERSECTS,
+	INSIDE
+};
 
 class Frustum
 {
 public:
+	// CheckRectangles tests 8 (AVX2) or 4 (SSE) boxes at a time and the remainder one at a time with the scalar
+	// ClassifyRectangle. The implementation is chosen once at runtime from CpuFeatures, and every implementation
+	// gives exactly the same masks. Like TangentSpace.cpp, Frustum.cpp is built with /fp:precise in every
+	// configuration so that the compiler cannot contract the scalar plane tests into fused multiply-adds
+	enum class Implementation
+	{
+		SCALAR,
+		SSE,
+		AVX2
+	};
+
 	Frustum(float screenDepth, DirectX::XMMATRIX viewMatrix, DirectX::XMMATRIX projectionMatrix);
 	Frustum(const Frustum&) = delete;
 	~Frustum();
@@ -17,7 +39,36 @@ public:
 	bool CheckRectangle(float, float, float, float, float, float);
 	bool CheckRectangle2(float maxWidth, float maxHeight, float maxDepth, float minWidth, float minHeight, float minDepth);
 
+	// Same test as CheckRectangle2, but also reports whether the box is entirely inside the frustum so that
+	// hierarchical structures can accept a whole subtree without testing its children
+	FrustumContainment ClassifyRectangle(float maxWidth, float maxHeight, float maxDepth, float minWidth, float minHeight, float minDepth);
+
+	// Batch version of ClassifyRectangle. Boxes are passed as one array per coordinate (structure of arrays)
+	// so that several boxes are tested at once. Bit n of visibleMask is set if box n is at least partially
+	// visible and bit n of insideMask is set if it is entirely inside the frustum. Both masks hold 32 boxes per
+	// value and must have room for (count + 31) / 32 values - insideMask may be nullptr
+	void CheckRectangles(const float* minX, const float* minY, const float* minZ,
+		const float* maxX, const float* maxY, const float* maxZ,
+		size_t count, uint32_t* visibleMask, uint32_t* insideMask = nullptr);
+
+	// Mainly for comparing the implementations - anything the processor does not support falls back to the best
+	// one it does
+	static void SetImplementation(Implementation implementation);
+	static Implementation GetImplementation() { return s_implementation; }
+
 private:
+	static Implementation BestImplementation();
+
+	// The vector paths advance first past the boxes they handled. first must be a multiple of 8 (AVX2) or 4 (SSE)
+	void CheckRectanglesAvx2(const float* minX, const float* minY, const float* minZ,
+		const float* maxX, const float* maxY, const float* maxZ,
+		size_t& first, size_t count, uint32_t* visibleMask, uint32_t* insideMask);
+	void CheckRectanglesSse(const float* minX, const float* minY, const float* minZ,
+		const float* maxX, const float* maxY, const float* maxZ,
+		size_t& first, size_t count, uint32_t* visibleMask, uint32_t* insideMask);
+
+	static Implementation s_implementation;
+
 	float m_screenDepth;
 	float m_planes[6][4];
 };
\ No newline at end of file
@@ -0,0 +1,35 @@
+#include "FrustumBoxBatch.h"
+
+void FrustumBoxBatch::Clear()
+{
+	m_minX.clear();
+	m_minY.clear();
+	m_minZ.clear();
+	m_maxX.clear();
+	m_maxY.clear();
+	m_maxZ.clear();
+}
+
+size_t FrustumBoxBatch::Add(float minX, float minY, float minZ, float maxX, float maxY, float maxZ)
+{
+	m_minX.push_back(minX);
+	m_minY.push_back(minY);
+	m_minZ.push_back(minZ);
+	m_maxX.push_back(maxX);
+	m_maxY.push_back(maxY);
+	m_maxZ.push_back(maxZ);
+	return m_minX.size() - 1;
+}
+
+void FrustumBoxBatch::Check(Frustum* frustum)
+{
+	size_t count = m_minX.size();
+	m_visibleMask.resize((count + 31) / 32);
+	m_insideMask.resize((count + 31) / 32);
+
+	if (count != 0)
+	{
+		frustum->CheckRectangles(m_minX.data(), m_minY.data(), m_minZ.data(), m_maxX.data(), m_maxY.data(), m_maxZ.data(),
+			count, m_visibleMask.data(), m_insideMask.data());
+	}
+}
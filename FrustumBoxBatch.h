@@ -0,0 +1,31 @@
+#pragma once
+#include "pch.h"
+#include "Frustum.h"
+
+#include <vector>
+#include <stdint.h>
+
+// FrustumBoxBatch gathers axis aligned boxes from wherever they are stored so that all of them are tested with a
+// single Frustum::CheckRectangles call. Boxes that arrive a few at a time (the children of every quad tree node at
+// one depth, the drawables of a scene) then still fill the SIMD lanes. Clear it and reuse it every frame - the
+// arrays keep their capacity
+class FrustumBoxBatch
+{
+public:
+	void Clear();
+
+	// Returns the index of the box within the batch
+	size_t Add(float minX, float minY, float minZ, float maxX, float maxY, float maxZ);
+	size_t Size() const { return m_minX.size(); }
+
+	// Tests every box added since the last Clear
+	void Check(Frustum* frustum);
+
+	// Results of the last Check - whether box index is at least partially visible, and whether it is entirely inside
+	bool IsVisible(size_t index) const { return (m_visibleMask[index / 32] & (1u << (index % 32))) != 0; }
+	bool IsInside(size_t index) const { return (m_insideMask[index / 32] & (1u << (index % 32))) != 0; }
+
+private:
+	std::vector<float>		m_minX, m_minY, m_minZ, m_maxX, m_maxY, m_maxZ;
+	std::vector<uint32_t>	m_visibleMask, m_insideMask;
+};
@@ -0,0 +1,27 @@
+#include "GltfException.h"
+
+GltfException::GltfException(int line, const char* file, std::string description) noexcept :
+	ChameleonException(line, file)
+{
+	m_info = description;
+}
+
+const char* GltfException::what() const noexcept
+{
+	std::ostringstream oss;
+	oss << GetType() << std::endl
+		<< "\n[Error Info]\n" << GetErrorInfo() << std::endl << std::endl;
+	oss << GetOriginString();
+	m_whatBuffer = oss.str();
+	return m_whatBuffer.c_str();
+}
+
+const char* GltfException::GetType() const noexcept
+{
+	return "glTF Exception";
+}
+
+std::string GltfException::GetErrorInfo() const noexcept
+{
+	return m_info;
+}
\ No newline at end of file
@@ -0,0 +1,496 @@
+#include "GltfModel.h"
+
+using DirectX::XMFLOAT2;
+using DirectX::XMFLOAT3;
+using DirectX::XMFLOAT4;
+using DirectX::XMFLOAT4X4;
+
+GltfModel::GltfModel(std::string filename) :
+	m_filename(filename),
+	m_directory(std::filesystem::path(filename).parent_path()),
+	m_buffersLoaded(false)
+{
+	m_json = JsonReader::ReadFile(filename);
+
+	Json asset = m_json.Get<Json>("asset");
+	std::string version = asset.Get<std::string>("version");
+	if (version.empty() || version[0] != '2')
+		ThrowError("Only glTF 2.0 is supported, the file is version " + version);
+
+	LoadNodes();
+	LoadMeshes();
+	LoadMaterials();
+}
+
+void GltfModel::LoadNodes()
+{
+	if (m_json.HasKey("nodes"))
+	{
+		JsonArray nodes = m_json.Get<JsonArray>("nodes");
+		m_nodes.resize(nodes.Size());
+		for (size_t iii = 0; iii < nodes.Size(); ++iii)
+		{
+			Json json = nodes.Get<Json>(iii);
+			Node& node = m_nodes[iii];
+
+			if (json.HasKey("name"))
+				node.name = json.Get<std::string>("name");
+			if (json.HasKey("mesh"))
+				node.mesh = json.Get<int>("mesh");
+			if (json.HasKey("children"))
+				node.children = json.Get<std::vector<int>>("children");
+
+			if (json.HasKey("matrix"))
+			{
+				// glTF matrices are column major, which is exactly the row vector layout XMFLOAT4X4 expects
+				std::vector<float> matrix = json.Get<std::vector<float>>("matrix");
+				if (matrix.size() != 16)
+					ThrowError("Node '" + node.name + "' has a matrix that does not have 16 values");
+
+				node.hasMatrix = true;
+				std::memcpy(&node.matrix, matrix.data(), sizeof(XMFLOAT4X4));
+			}
+
+			if (json.HasKey("translation"))
+			{
+				std::vector<float> translation = json.Get<std::vector<float>>("translation");
+				if (translation.size() != 3)
+					ThrowError("Node '" + node.name + "' has a translation that does not have 3 values");
+				node.translation = XMFLOAT3(translation[0], translation[1], translation[2]);
+			}
+
+			if (json.HasKey("rotation"))
+			{
+				std::vector<float> rotation = json.Get<std::vector<float>>("rotation");
+				if (rotation.size() != 4)
+					ThrowError("Node '" + node.name + "' has a rotation that does not have 4 values");
+				node.rotation = XMFLOAT4(rotation[0], rotation[1], rotation[2], rotation[3]);
+			}
+
+			if (json.HasKey("scale"))
+			{
+				std::vector<float> scale = json.Get<std::vector<float>>("scale");
+				if (scale.size() != 3)
+					ThrowError("Node '" + node.name + "' has a scale that does not have 3 values");
+				node.scale = XMFLOAT3(scale[0], scale[1], scale[2]);
+			}
+		}
+	}
+
+	// Validate every reference up front so the hierarchy can be walked without checking again. glTF nodes have to
+	// form strict trees: a node listed under two parents would be built twice, and one that is its own ancestor
+	// would be walked until the stack runs out
+	const int nodeCount = static_cast<int>(m_nodes.size());
+	std::vector<int> parents(m_nodes.size(), -1);
+	for (int iii = 0; iii < nodeCount; ++iii)
+	{
+		for (int child : m_nodes[iii].children)
+		{
+			CheckIndex(child, m_nodes.size(), "node");
+			if (parents[child] != -1)
+				ThrowError("Node " + std::to_string(child) + " is a child of both node " + std::to_string(parents[child]) + " and node " + std::to_string(iii));
+			parents[child] = iii;
+		}
+	}
+
+	// With a single parent each, a cycle is a walk up the parents that comes back to where it started. Nodes already
+	// known to lead up to a root are not walked again, so every node is visited once
+	enum : uint8_t { UNVISITED, ON_WALK, REACHES_ROOT };
+	std::vector<uint8_t> state(m_nodes.size(), UNVISITED);
+	for (int iii = 0; iii < nodeCount; ++iii)
+	{
+		int node = iii;
+		while (node != -1 && state[node] == UNVISITED)
+		{
+			state[node] = ON_WALK;
+			node = parents[node];
+		}
+		if (node != -1 && state[node] == ON_WALK)
+			ThrowError("Node " + std::to_string(node) + " is its own ancestor");
+
+		for (node = iii; node != -1 && state[node] == ON_WALK; node = parents[node])
+			state[node] = REACHES_ROOT;
+	}
+
+	// Use the default scene, or the first one if the file does not name a default. A file without any scene
+	// is only a library of meshes, so treat every node that is not a child of another node as a root
+	if (m_json.HasKey("scenes"))
+	{
+		JsonArray scenes = m_json.Get<JsonArray>("scenes");
+		int sceneIndex = m_json.HasKey("scene") ? m_json.Get<int>("scene") : 0;
+		CheckIndex(sceneIndex, scenes.Size(), "scene");
+
+		Json scene = scenes.Get<Json>(sceneIndex);
+		if (scene.HasKey("nodes"))
+			m_sceneNodes = scene.Get<std::vector<int>>("nodes");
+
+		for (int nodeIndex : m_sceneNodes)
+		{
+			CheckIndex(nodeIndex, m_nodes.size(), "node");
+			if (parents[nodeIndex] != -1)
+				ThrowError("Scene root " + std::to_string(nodeIndex) + " is also a child of node " + std::to_string(parents[nodeIndex]));
+		}
+	}
+	else
+	{
+		for (int iii = 0; iii < nodeCount; ++iii)
+		{
+			if (parents[iii] == -1)
+				m_sceneNodes.push_back(iii);
+		}
+	}
+}
+
+void GltfModel::LoadMeshes()
+{
+	if (!m_json.HasKey("meshes"))
+		return;
+
+	JsonArray meshes = m_json.Get<JsonArray>("meshes");
+	size_t accessorCount = m_json.HasKey("accessors") ? m_json.Get<JsonArray>("accessors").Size() : 0;
+	size_t materialCount = m_json.HasKey("materials") ? m_json.Get<JsonArray>("materials").Size() : 0;
+
+	m_meshes.resize(meshes.Size());
+	for (size_t iii = 0; iii < meshes.Size(); ++iii)
+	{
+		Json json = meshes.Get<Json>(iii);
+		MeshDescription& mesh = m_meshes[iii];
+
+		// Assimp names unnamed meshes after their index, so do the same to keep the ObjectStore lookup names unique
+		mesh.name = json.HasKey("name") ? json.Get<std::string>("name") : "mesh_" + std::to_string(iii);
+
+		JsonArray primitives = json.Get<JsonArray>("primitives");
+		for (size_t jjj = 0; jjj < primitives.Size(); ++jjj)
+		{
+			Json primitiveJson = primitives.Get<Json>(jjj);
+
+			// Mode 4 is a triangle list, which is also the default
+			if (primitiveJson.HasKey("mode") && primitiveJson.Get<int>("mode") != 4)
+				ThrowError("Mesh '" + mesh.name + "' has a primitive that is not a triangle list. This is not yet supported");
+
+			Primitive primitive;
+			Json attributes = primitiveJson.Get<Json>("attributes");
+			primitive.positions = attributes.Get<int>("POSITION");
+			if (attributes.HasKey("NORMAL"))
+				primitive.normals = attributes.Get<int>("NORMAL");
+			if (attributes.HasKey("TEXCOORD_0"))
+				primitive.texcoords = attributes.Get<int>("TEXCOORD_0");
+			if (attributes.HasKey("TANGENT"))
+				primitive.tangents = attributes.Get<int>("TANGENT");
+			if (primitiveJson.HasKey("indices"))
+				primitive.indices = primitiveJson.Get<int>("indices");
+			if (primitiveJson.HasKey("material"))
+				primitive.material = primitiveJson.Get<int>("material");
+
+			CheckIndex(primitive.positions, accessorCount, "accessor");
+			if (primitive.normals != -1)
+				CheckIndex(primitive.normals, accessorCount, "accessor");
+			if (primitive.texcoords != -1)
+				CheckIndex(primitive.texcoords, accessorCount, "accessor");
+			if (primitive.tangents != -1)
+				CheckIndex(primitive.tangents, accessorCount, "accessor");
+			if (primitive.indices != -1)
+				CheckIndex(primitive.indices, accessorCount, "accessor");
+			if (primitive.material != -1)
+				CheckIndex(primitive.material, materialCount, "material");
+
+			mesh.primitives.push_back(primitive);
+		}
+	}
+
+	for (const Node& node : m_nodes)
+	{
+		if (node.mesh != -1)
+			CheckIndex(node.mesh, m_meshes.size(), "mesh");
+	}
+}
+
+void GltfModel::LoadMaterials()
+{
+	if (!m_json.HasKey("materials"))
+		return;
+
+	// Materials refer to textures, which refer to images, which hold the uri of the image file
+	std::vector<std::string> imagePaths;
+	if (m_json.HasKey("images"))
+	{
+		JsonArray images = m_json.Get<JsonArray>("images");
+		for (size_t iii = 0; iii < images.Size(); ++iii)
+		{
+			Json image = images.Get<Json>(iii);
+			if (!image.HasKey("uri"))
+				ThrowError("Image " + std::to_string(iii) + " is stored in a buffer view. This is not yet supported");
+
+			imagePaths.push_back((m_directory / image.Get<std::string>("uri")).string());
+		}
+	}
+
+	std::vector<std::string> texturePaths;
+	if (m_json.HasKey("textures"))
+	{
+		JsonArray textures = m_json.Get<JsonArray>("textures");
+		for (size_t iii = 0; iii < textures.Size(); ++iii)
+		{
+			int source = textures.Get<Json>(iii).Get<int>("source");
+			CheckIndex(source, imagePaths.size(), "image");
+			texturePaths.push_back(imagePaths[source]);
+		}
+	}
+
+	auto TexturePath = [this, &texturePaths](const Json& textureInfo) -> std::string
+	{
+		int index = textureInfo.Get<int>("index");
+		CheckIndex(index, texturePaths.size(), "texture");
+		return texturePaths[index];
+	};
+
+	JsonArray materials = m_json.Get<JsonArray>("materials");
+	m_materials.resize(materials.Size());
+	for (size_t iii = 0; iii < materials.Size(); ++iii)
+	{
+		Json json = materials.Get<Json>(iii);
+		Material& material = m_materials[iii];
+
+		if (json.HasKey("name"))
+			material.name = json.Get<std::string>("name");
+
+		if (json.HasKey("pbrMetallicRoughness"))
+		{
+			Json pbr = json.Get<Json>("pbrMetallicRoughness");
+			if (pbr.HasKey("baseColorTexture"))
+				material.baseColorTexture = TexturePath(pbr.Get<Json>("baseColorTexture"));
+		}
+
+		if (json.HasKey("normalTexture"))
+			material.normalTexture = TexturePath(json.Get<Json>("normalTexture"));
+	}
+}
+
+void GltfModel::LoadBuffers()
+{
+	m_buffersLoaded = true;
+	if (!m_json.HasKey("buffers"))
+		return;
+
+	JsonArray buffers = m_json.Get<JsonArray>("buffers");
+	m_buffers.resize(buffers.Size());
+	for (size_t iii = 0; iii < buffers.Size(); ++iii)
+	{
+		Json json = buffers.Get<Json>(iii);
+		size_t byteLength = json.Get<size_t>("byteLength");
+
+		// A buffer without a uri is the binary chunk of a .glb file
+		if (!json.HasKey("uri"))
+			ThrowError("Buffer " + std::to_string(iii) + " does not have a uri. Binary glTF (.glb) files are not yet supported");
+
+		// The uri points into the text of the Json document, so embedded data is decoded without copying it first
+		std::string_view uri = json.Get<std::string_view>("uri");
+		std::vector<uint8_t>& buffer = m_buffers[iii];
+
+		if (uri.substr(0, 5) == "data:")
+		{
+			size_t comma = uri.find(',');
+			if (comma == std::string_view::npos || uri.substr(0, comma).find(";base64") == std::string_view::npos)
+				ThrowError("Buffer " + std::to_string(iii) + " has a data uri that is not base64 encoded");
+
+			std::string_view data = uri.substr(comma + 1);
+			buffer.resize(Base64::DecodedSize(data.data(), data.size()));
+			buffer.resize(Base64::Decode(data.data(), data.size(), buffer.data()));
+		}
+		else
+		{
+			std::filesystem::path path = m_directory / std::string(uri);
+			std::ifstream file(path, std::ios::binary | std::ios::ate);
+			if (!file.is_open())
+				ThrowError("Could not open buffer file: " + path.string());
+
+			buffer.resize(static_cast<size_t>(file.tellg()));
+			file.seekg(0);
+			file.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+		}
+
+		if (buffer.size() < byteLength)
+		{
+			std::ostringstream oss;
+			oss << "Buffer " << iii << " holds " << buffer.size() << " bytes but is declared as " << byteLength << " bytes";
+			ThrowError(oss.str());
+		}
+	}
+}
+
+GltfModel::AccessorView GltfModel::GetAccessor(int index, std::string_view expectedType) const
+{
+	Json accessor = m_json.Get<JsonArray>("accessors").Get<Json>(index);
+
+	if (accessor.HasKey("sparse"))
+		ThrowError("Accessor " + std::to_string(index) + " is sparse. This is not yet supported");
+
+	std::string_view type = accessor.Get<std::string_view>("type");
+	if (type != expectedType)
+		ThrowError("Accessor " + std::to_string(index) + " is a " + std::string(type) + " but a " + std::string(expectedType) + " was expected");
+
+	AccessorView view;
+	view.count = accessor.Get<size_t>("count");
+	view.componentType = accessor.Get<int>("componentType");
+
+	size_t componentSize = 0;
+	switch (view.componentType)
+	{
+	case UNSIGNED_BYTE:		componentSize = 1; break;
+	case UNSIGNED_SHORT:	componentSize = 2; break;
+	case UNSIGNED_INT:
+	case FLOAT:				componentSize = 4; break;
+	default:
+		ThrowError("Accessor " + std::to_string(index) + " has component type " + std::to_string(view.componentType) + ". This is not yet supported");
+	}
+
+	size_t componentCount = type == "SCALAR" ? 1 : type == "VEC2" ? 2 : type == "VEC3" ? 3 : 4;
+	size_t elementSize = componentSize * componentCount;
+
+	// An accessor without a buffer view is all zeros, which is of no use for anything Drawable can show
+	if (!accessor.HasKey("bufferView"))
+		ThrowError("Accessor " + std::to_string(index) + " does not have a buffer view. This is not yet supported");
+
+	JsonArray bufferViews = m_json.Get<JsonArray>("bufferViews");
+	int bufferViewIndex = accessor.Get<int>("bufferView");
+	CheckIndex(bufferViewIndex, bufferViews.Size(), "buffer view");
+
+	Json bufferView = bufferViews.Get<Json>(bufferViewIndex);
+	int bufferIndex = bufferView.Get<int>("buffer");
+	CheckIndex(bufferIndex, m_buffers.size(), "buffer");
+
+	size_t viewOffset = bufferView.HasKey("byteOffset") ? bufferView.Get<size_t>("byteOffset") : 0;
+	size_t viewLength = bufferView.Get<size_t>("byteLength");
+	size_t accessorOffset = accessor.HasKey("byteOffset") ? accessor.Get<size_t>("byteOffset") : 0;
+	view.stride = bufferView.HasKey("byteStride") ? bufferView.Get<size_t>("byteStride") : elementSize;
+
+	const std::vector<uint8_t>& buffer = m_buffers[bufferIndex];
+	bool inBuffer = viewOffset <= buffer.size() && viewLength <= buffer.size() - viewOffset;
+	bool inView = view.stride >= elementSize && (view.count == 0 ||
+		(accessorOffset <= viewLength && elementSize <= viewLength - accessorOffset &&
+		 (view.count - 1) <= (viewLength - accessorOffset - elementSize) / view.stride));
+	if (!inBuffer || !inView)
+		ThrowError("Accessor " + std::to_string(index) + " reaches past the end of its buffer");
+
+	view.data = buffer.data() + viewOffset + accessorOffset;
+	return view;
+}
+
+void GltfModel::ReadPrimitive(const Primitive& primitive, std::vector<OBJVertex>& vertices, std::vector<unsigned int>& indices)
+{
+	if (!m_buffersLoaded)
+		LoadBuffers();
+
+	AccessorView positions = GetAccessor(primitive.positions, "VEC3");
+	if (positions.componentType != FLOAT)
+		ThrowError("POSITION accessors must be floats");
+
+	// Attributes that are missing are left as zeros
+	vertices.assign(positions.count, OBJVertex{ XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT2(0.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f) });
+	for (size_t iii = 0; iii < positions.count; ++iii)
+		std::memcpy(&vertices[iii].position, positions.data + (iii * positions.stride), sizeof(XMFLOAT3));
+
+	if (primitive.normals != -1)
+	{
+		AccessorView normals = GetAccessor(primitive.normals, "VEC3");
+		if (normals.componentType != FLOAT || normals.count != positions.count)
+			ThrowError("NORMAL accessors must be floats with one normal per position");
+
+		for (size_t iii = 0; iii < normals.count; ++iii)
+			std::memcpy(&vertices[iii].normal, normals.data + (iii * normals.stride), sizeof(XMFLOAT3));
+	}
+
+	// glTF puts the texture origin in the upper left corner just like Direct3D, so unlike the Assimp path (which
+	// flips V on import and then flips it back) the coordinates are used as they are
+	if (primitive.texcoords != -1)
+	{
+		AccessorView texcoords = GetAccessor(primitive.texcoords, "VEC2");
+		if (texcoords.componentType != FLOAT || texcoords.count != positions.count)
+			ThrowError("TEXCOORD_0 accessors must be floats with one coordinate per position");
+
+		for (size_t iii = 0; iii < texcoords.count; ++iii)
+			std::memcpy(&vertices[iii].texture, texcoords.data + (iii * texcoords.stride), sizeof(XMFLOAT2));
+	}
+
+	// Primitives without indices draw their vertices in order
+	if (primitive.indices == -1)
+	{
+		indices.resize(positions.count);
+		for (size_t iii = 0; iii < positions.count; ++iii)
+			indices[iii] = static_cast<unsigned int>(iii);
+	}
+	else
+	{
+		AccessorView view = GetAccessor(primitive.indices, "SCALAR");
+		indices.resize(view.count);
+
+		switch (view.componentType)
+		{
+		case UNSIGNED_INT:
+			if (view.stride == sizeof(uint32_t))
+			{
+				// Tightly packed 32-bit indices are already in the layout we want, so copy them in one go
+				std::memcpy(indices.data(), view.data, view.count * sizeof(uint32_t));
+				break;
+			}
+			for (size_t iii = 0; iii < view.count; ++iii)
+				std::memcpy(&indices[iii], view.data + (iii * view.stride), sizeof(uint32_t));
+			break;
+		case UNSIGNED_SHORT:
+			for (size_t iii = 0; iii < view.count; ++iii)
+			{
+				uint16_t index;
+				std::memcpy(&index, view.data + (iii * view.stride), sizeof(uint16_t));
+				indices[iii] = index;
+			}
+			break;
+		case UNSIGNED_BYTE:
+			for (size_t iii = 0; iii < view.count; ++iii)
+				indices[iii] = view.data[iii * view.stride];
+			break;
+		default:
+			ThrowError("Index accessors must be unsigned bytes, shorts or ints");
+		}
+
+		// Every index must refer to a vertex
+		for (unsigned int index : indices)
+		{
+			if (index >= positions.count)
+				ThrowError("Index " + std::to_string(index) + " is out of range for a primitive with " + std::to_string(positions.count) + " vertices");
+		}
+	}
+
+	if (indices.size() % 3 != 0)
+		ThrowError("Triangle list primitive has " + std::to_string(indices.size()) + " indices, which is not a multiple of 3");
+
+	// The exporter's tangents are what its normal maps were baked against, so they win over generated ones. glTF
+	// stores the handedness in w the same way the shader reads it
+	if (primitive.tangents != -1)
+	{
+		AccessorView tangents = GetAccessor(primitive.tangents, "VEC4");
+		if (tangents.componentType != FLOAT || tangents.count != positions.count)
+			ThrowError("TANGENT accessors must be floats with one tangent per position");
+
+		for (size_t iii = 0; iii < tangents.count; ++iii)
+			std::memcpy(&vertices[iii].tangent, tangents.data + (iii * tangents.stride), sizeof(XMFLOAT4));
+	}
+	else
+	{
+		TangentSpace::Generate(vertices, indices, ThreadPool::Default());
+	}
+}
+
+void GltfModel::CheckIndex(int index, size_t count, const char* what) const
+{
+	if (index < 0 || static_cast<size_t>(index) >= count)
+	{
+		std::ostringstream oss;
+		oss << "Reference to " << what << " " << index << " is out of range (there are " << count << ")";
+		ThrowError(oss.str());
+	}
+}
+
+void GltfModel::ThrowError(const std::string& description) const
+{
+	throw GltfException(__LINE__, __FILE__, "'" + m_filename + "': " + description);
+}
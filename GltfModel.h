@@ -0,0 +1,118 @@
+#pragma once
+#include "pch.h"
+#include "GltfException.h"
+#include "Json.h"
+#include "Base64.h"
+#include "Mesh.h"
+#include "TangentSpace.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <stdint.h>
+
+// GltfModel reads a glTF 2.0 (.gltf) file directly instead of going through Assimp. The Json is parsed once with
+// JsonReader and every buffer is decoded once (embedded base64 data URIs with Base64, anything else is read from
+// the file next to the .gltf). Accessors are not copied out of the buffers - ReadPrimitive walks them in place
+// and writes straight into the vertex and index arrays handed to Mesh::LoadBuffers.
+//
+// Only what Drawable can display is supported: triangle list primitives with float POSITION / NORMAL /
+// TEXCOORD_0 / TANGENT attributes and (optionally) unsigned indices. Sparse accessors, skins and animations are
+// not. Primitives without a TANGENT attribute get theirs from TangentSpace, like Assimp models.
+class GltfModel
+{
+public:
+	struct Primitive
+	{
+		int positions = -1;		// Accessor indices, -1 when the primitive does not have one
+		int normals = -1;
+		int texcoords = -1;
+		int tangents = -1;
+		int indices = -1;
+		int material = -1;
+	};
+
+	struct MeshDescription
+	{
+		std::string name;
+		std::vector<Primitive> primitives;
+	};
+
+	struct Node
+	{
+		std::string name;
+		int mesh = -1;
+		std::vector<int> children;
+
+		// A node either has a matrix or separate translation / rotation (quaternion) / scale
+		bool hasMatrix = false;
+		DirectX::XMFLOAT4X4 matrix;
+		DirectX::XMFLOAT3 translation = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
+		DirectX::XMFLOAT4 rotation = DirectX::XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f);
+		DirectX::XMFLOAT3 scale = DirectX::XMFLOAT3(1.0f, 1.0f, 1.0f);
+	};
+
+	struct Material
+	{
+		std::string name;
+		std::string baseColorTexture;	// Image paths relative to the working directory, empty when not used
+		std::string normalTexture;
+	};
+
+	// Throws GltfException (or JsonException) if the file cannot be read or is not a glTF file this class supports
+	GltfModel(std::string filename);
+
+	const std::vector<int>& GetSceneNodes() const { return m_sceneNodes; }
+	const std::vector<Node>& GetNodes() const { return m_nodes; }
+	const std::vector<MeshDescription>& GetMeshes() const { return m_meshes; }
+	const std::vector<Material>& GetMaterials() const { return m_materials; }
+
+	// Interleaves the attributes of the primitive into vertices and widens its indices to 32 bits (Mesh narrows them
+	// again when the primitive is small enough). The buffers are decoded the first time this is called, so a model
+	// whose meshes are all cached elsewhere never decodes them
+	void ReadPrimitive(const Primitive& primitive, std::vector<OBJVertex>& vertices, std::vector<unsigned int>& indices);
+
+private:
+	// Elements of an accessor as they sit in their buffer. Element n starts at data + (n * stride)
+	struct AccessorView
+	{
+		const uint8_t* data;
+		size_t count;
+		size_t stride;
+		int componentType;
+	};
+
+	enum ComponentType
+	{
+		UNSIGNED_BYTE = 5121,
+		UNSIGNED_SHORT = 5123,
+		UNSIGNED_INT = 5125,
+		FLOAT = 5126
+	};
+
+	void LoadNodes();
+	void LoadMeshes();
+	void LoadMaterials();
+	void LoadBuffers();
+
+	AccessorView GetAccessor(int index, std::string_view expectedType) const;
+	void CheckIndex(int index, size_t count, const char* what) const;
+	[[noreturn]] void ThrowError(const std::string& description) const;
+
+	std::string m_filename;
+	std::filesystem::path m_directory;
+
+	// The Json stays alive so accessors, buffer views and buffer URIs can be read when the buffers are needed
+	Json m_json;
+	std::vector<std::vector<uint8_t>> m_buffers;
+	bool m_buffersLoaded;
+
+	std::vector<int> m_sceneNodes;
+	std::vector<Node> m_nodes;
+	std::vector<MeshDescription> m_meshes;
+	std::vector<Material> m_materials;
+};
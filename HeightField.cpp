@@ -0,0 +1,226 @@
+#include "HeightField.h"
+
+using DirectX::XMFLOAT2;
+using DirectX::XMFLOAT3;
+using DirectX::XMVECTOR;
+using DirectX::FXMVECTOR;
+
+HeightField::HeightField(int width, int height) :
+	m_width(width),
+	m_height(height),
+	m_samples(static_cast<size_t>(width) * height, 0.0f),
+	m_heights(m_samples.data()),
+	m_minHeight(0.0f),
+	m_maxHeight(0.0f)
+{
+}
+
+HeightField::HeightField(int width, int height, const float* heights, float minHeight, float maxHeight, std::shared_ptr<const void> owner) :
+	m_width(width),
+	m_height(height),
+	m_owner(owner),
+	m_heights(heights),
+	m_minHeight(minHeight),
+	m_maxHeight(maxHeight)
+{
+}
+
+void HeightField::SetSample(int i, int j, float height)
+{
+	m_samples[(m_width * j) + i] = height;
+
+	// Bounds only ever grow, which keeps them conservative if a sample is overwritten
+	m_minHeight = std::min(m_minHeight, height);
+	m_maxHeight = std::max(m_maxHeight, height);
+}
+
+void HeightField::SetRow(int j, const float* heights)
+{
+	std::copy(heights, heights + m_width, m_samples.begin() + (static_cast<size_t>(m_width) * j));
+}
+
+void HeightField::UpdateBounds()
+{
+	m_minHeight = 0.0f;
+	m_maxHeight = 0.0f;
+
+	if (m_samples.empty())
+		return;
+
+	auto bounds = std::minmax_element(m_samples.begin(), m_samples.end());
+	m_minHeight = *bounds.first;
+	m_maxHeight = *bounds.second;
+}
+
+bool HeightField::ContainsPoint(float x, float z) const
+{
+	return x >= GetMinX() && x <= GetMaxX() && z >= GetMinZ() && z <= GetMaxZ();
+}
+
+float HeightField::GetHeight(float x, float z) const
+{
+	if (!ContainsPoint(x, z))
+		return 0.0f;
+
+	// Convert the world position into (fractional) grid coordinates
+	float column = x;
+	float row = static_cast<float>(m_height - 1) - z;
+
+	// Clamp to the last quad so that points on the far edges still have a valid quad
+	int i = std::min(static_cast<int>(column), m_width - 2);
+	int j = std::min(static_cast<int>(row), m_height - 2);
+
+	int upperLeft = (m_width * j) + i;
+	int bottomLeft = upperLeft + m_width;
+
+	return InterpolateQuad(
+		m_heights[upperLeft],
+		m_heights[upperLeft + 1],
+		m_heights[bottomLeft],
+		m_heights[bottomLeft + 1],
+		column - static_cast<float>(i),
+		row - static_cast<float>(j)
+	);
+}
+
+void HeightField::GetHeights(const XMFLOAT2* points, float* heights, size_t count) const
+{
+	for (size_t iii = 0; iii < count; ++iii)
+		heights[iii] = GetHeight(points[iii].x, points[iii].y);
+}
+
+float HeightField::InterpolateQuad(float upperLeft, float upperRight, float bottomLeft, float bottomRight, float u, float v)
+{
+	// Triangle 1 - Upper left, upper right, bottom left
+	if (u + v <= 1.0f)
+		return upperLeft + (u * (upperRight - upperLeft)) + (v * (bottomLeft - upperLeft));
+
+	// Triangle 2 - Bottom left, upper right, bottom right
+	return bottomRight + ((1.0f - u) * (bottomLeft - bottomRight)) + ((1.0f - v) * (upperRight - bottomRight));
+}
+
+bool HeightField::Intersects(XMFLOAT3 origin, XMFLOAT3 direction, XMFLOAT3& hitLocation, float& distance) const
+{
+	// Walk the grid in (column, row) space where column = x and row = (height - 1) - z
+	float column = origin.x;
+	float row = static_cast<float>(m_height - 1) - origin.z;
+	float dColumn = direction.x;
+	float dRow = -direction.z;
+
+	// Clip the ray against the bounding box of the field so that the walk only covers quads that exist
+	// and stops once the ray leaves the height range
+	float tEnter = 0.0f;
+	float tExit = FLT_MAX;
+	auto clip = [&tEnter, &tExit](float start, float delta, float min, float max) -> bool
+	{
+		if (delta == 0.0f)
+			return start >= min && start <= max;
+
+		float t0 = (min - start) / delta;
+		float t1 = (max - start) / delta;
+		if (t0 > t1)
+			std::swap(t0, t1);
+
+		tEnter = std::max(tEnter, t0);
+		tExit = std::min(tExit, t1);
+		return tEnter <= tExit;
+	};
+
+	const float epsilon = 0.001f;
+	if (!clip(column, dColumn, 0.0f, GetMaxX()) ||
+		!clip(row, dRow, 0.0f, static_cast<float>(m_height - 1)) ||
+		!clip(origin.y, direction.y, m_minHeight - epsilon, m_maxHeight + epsilon))
+		return false;
+
+	// Starting quad (clamped because the entry point may sit exactly on the far edge)
+	int i = std::clamp(static_cast<int>(std::floor(column + (tEnter * dColumn))), 0, m_width - 2);
+	int j = std::clamp(static_cast<int>(std::floor(row + (tEnter * dRow))), 0, m_height - 2);
+
+	int stepI = dColumn > 0.0f ? 1 : -1;
+	int stepJ = dRow > 0.0f ? 1 : -1;
+
+	// Ray parameter at which the next column / row boundary is crossed
+	float tDeltaI = dColumn != 0.0f ? std::abs(1.0f / dColumn) : FLT_MAX;
+	float tDeltaJ = dRow != 0.0f ? std::abs(1.0f / dRow) : FLT_MAX;
+	float tMaxI = dColumn != 0.0f ? (static_cast<float>(dColumn > 0.0f ? i + 1 : i) - column) / dColumn : FLT_MAX;
+	float tMaxJ = dRow != 0.0f ? (static_cast<float>(dRow > 0.0f ? j + 1 : j) - row) / dRow : FLT_MAX;
+
+	XMVECTOR o = DirectX::XMLoadFloat3(&origin);
+	XMVECTOR d = DirectX::XMLoadFloat3(&direction);
+
+	float tCellEnter = tEnter;
+	while (true)
+	{
+		float tCellExit = std::min(std::min(tMaxI, tMaxJ), tExit);
+
+		// Skip the triangle tests if the ray stays above every corner of the quad while crossing it
+		float lowestRayHeight = origin.y + (direction.y * (direction.y < 0.0f ? tCellExit : tCellEnter));
+		int upperLeft = (m_width * j) + i;
+		int bottomLeft = upperLeft + m_width;
+		float highestCorner = std::max(
+			std::max(m_heights[upperLeft], m_heights[upperLeft + 1]),
+			std::max(m_heights[bottomLeft], m_heights[bottomLeft + 1])
+		);
+
+		// Any hit inside this quad is closer than every hit in the quads that follow, so stop at the first one
+		if (lowestRayHeight <= highestCorner + epsilon && IntersectsQuad(o, d, i, j, distance))
+		{
+			hitLocation.x = origin.x + (distance * direction.x);
+			hitLocation.y = origin.y + (distance * direction.y);
+			hitLocation.z = origin.z + (distance * direction.z);
+			return true;
+		}
+
+		if (tCellExit >= tExit)
+			return false;
+
+		tCellEnter = tCellExit;
+		if (tMaxI < tMaxJ)
+		{
+			i += stepI;
+			if (i < 0 || i > m_width - 2)
+				return false;
+			tMaxI += tDeltaI;
+		}
+		else
+		{
+			j += stepJ;
+			if (j < 0 || j > m_height - 2)
+				return false;
+			tMaxJ += tDeltaJ;
+		}
+	}
+}
+
+bool HeightField::IntersectsQuad(FXMVECTOR origin, FXMVECTOR direction, int i, int j, float& distance) const
+{
+	int upperLeft = (m_width * j) + i;
+	int bottomLeft = upperLeft + m_width;
+
+	float x = static_cast<float>(i);
+	float z = static_cast<float>(m_height - 1 - j);
+
+	XMVECTOR ul = DirectX::XMVectorSet(x, m_heights[upperLeft], z, 0.0f);
+	XMVECTOR ur = DirectX::XMVectorSet(x + 1.0f, m_heights[upperLeft + 1], z, 0.0f);
+	XMVECTOR bl = DirectX::XMVectorSet(x, m_heights[bottomLeft], z - 1.0f, 0.0f);
+	XMVECTOR br = DirectX::XMVectorSet(x + 1.0f, m_heights[bottomLeft + 1], z - 1.0f, 0.0f);
+
+	// Same two triangles as the rendered terrain - the ray can pass through both, so keep the closest
+	float dist;
+	bool found = false;
+	distance = FLT_MAX;
+
+	if (DirectX::TriangleTests::Intersects(origin, direction, ul, ur, bl, dist))
+	{
+		distance = dist;
+		found = true;
+	}
+
+	if (DirectX::TriangleTests::Intersects(origin, direction, bl, ur, br, dist))
+	{
+		distance = std::min(distance, dist);
+		found = true;
+	}
+
+	return found;
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include "pch.h"
+
+#include <DirectXCollision.h>
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+
+// HeightField keeps the scaled height of every height map sample in a dense row-major grid
+// so that terrain heights can be looked up in constant time.
+//
+// The grid either owns its samples or is a read-only view of samples that live elsewhere. TerrainMesh uses a
+// view of the heights in the mapped cooked terrain file, so the whole grid is never read into memory - the
+// operating system pages rows in as they are queried and can drop them again, just like the cell vertices.
+//
+// The grid uses the same coordinate convention as TerrainMesh:
+//		sample (i, j) is located at world x = i, z = (height - 1) - j
+//
+// Heights in between samples are interpolated on the exact triangle the terrain renders for
+// that quad: (upper left, upper right, bottom left) and (bottom left, upper right, bottom right)
+class HeightField
+{
+public:
+	HeightField(int width, int height);
+
+	// A view of (width x height) row-major samples owned by someone else. owner keeps them alive for as long as
+	// the height field exists, and the height bounds are passed in so that finding them does not read (and page
+	// in) every sample. SetSample, SetRow and UpdateBounds must not be called on a view
+	HeightField(int width, int height, const float* heights, float minHeight, float maxHeight, std::shared_ptr<const void> owner);
+	HeightField(const HeightField&) = delete;
+	HeightField& operator=(const HeightField&) = delete;
+
+	int Width() const { return m_width; }
+	int Height() const { return m_height; }
+
+	float GetSample(int i, int j) const { return m_heights[(m_width * j) + i]; }
+	void SetSample(int i, int j, float height);
+	const float* GetRow(int j) const { return m_heights + (static_cast<size_t>(m_width) * j); }
+
+	// Sets a whole row of samples. Unlike SetSample, this does not update the height bounds so that different
+	// rows can be set from different threads - call UpdateBounds once every row has been set
+	void SetRow(int j, const float* heights);
+	void UpdateBounds();
+
+	float GetMinX() const { return 0.0f; }
+	float GetMaxX() const { return static_cast<float>(m_width - 1); }
+	float GetMinZ() const { return 0.0f; }
+	float GetMaxZ() const { return static_cast<float>(m_height - 1); }
+
+	bool ContainsPoint(float x, float z) const;
+
+	// Returns 0.0f for any point that is outside of the height field
+	float GetHeight(float x, float z) const;
+
+	// Batch version of GetHeight - points are (x, z) pairs and heights must hold count values
+	void GetHeights(const DirectX::XMFLOAT2* points, float* heights, size_t count) const;
+
+	// Casts a ray against the height field and returns the closest intersection. The direction MUST be
+	// normalized. Only the quads whose footprint the ray actually crosses are tested (2D DDA walk over the
+	// grid), and the walk stops at the first quad that is hit
+	bool Intersects(DirectX::XMFLOAT3 origin, DirectX::XMFLOAT3 direction, DirectX::XMFLOAT3& hitLocation, float& distance) const;
+
+	// Interpolates a single quad. u runs from the left edge to the right edge, v from the upper
+	// edge to the bottom edge (both in [0, 1])
+	static float InterpolateQuad(float upperLeft, float upperRight, float bottomLeft, float bottomRight, float u, float v);
+
+private:
+	bool IntersectsQuad(DirectX::FXMVECTOR origin, DirectX::FXMVECTOR direction, int i, int j, float& distance) const;
+
+	int m_width, m_height;
+
+	// Every read goes through m_heights, which points either at m_samples or at the memory owner keeps alive
+	std::vector<float> m_samples;
+	std::shared_ptr<const void> m_owner;
+	const float* m_heights;
+
+	// Bounds of all samples - used to clip rays before walking the grid
+	float m_minHeight, m_maxHeight;
+};
@@ -29,6 +29,9 @@ void InputLayout::AddDescription(
 	desc.InstanceDataStepRate	= instanceDataStepRate;
 
 	m_descriptions.push_back(desc);
+
+	if (inputSlotClass == D3D11_INPUT_PER_INSTANCE_DATA)
+		m_readsInstanceData = true;
 }
 
 void InputLayout::CreateLayout()
@@ -55,6 +58,9 @@ void InputLayout::CreateLayout()
 
 void InputLayout::Bind()
 {
+	if (!PipelineState::SetInputLayout(m_inputLayout.Get()))
+		return;
+
 	INFOMAN(m_deviceResources);
 	GFX_THROW_INFO_ONLY(
 		m_deviceResources->D3DDeviceContext()->IASetInputLayout(m_inputLayout.Get())
@@ -21,12 +21,15 @@ public:
 	void CreateLayout();
 
 	void Bind() override;
+	BindableSlot Slot() const override { return { BindableSlot::Type::INPUT_LAYOUT }; }
+	bool ReadsInstanceData() const override { return m_readsInstanceData; }
 
 	Microsoft::WRL::ComPtr<ID3DBlob> GetVertexShaderFileBlob() { return m_blob; }
 
 private:
 	std::vector<std::string> m_semanticNames;
 	std::vector<D3D11_INPUT_ELEMENT_DESC> m_descriptions;
+	bool m_readsInstanceData = false;	// Set once any element is per instance
 
 	Microsoft::WRL::ComPtr<ID3DBlob> m_blob;
 	Microsoft::WRL::ComPtr<ID3D11InputLayout> m_inputLayout;
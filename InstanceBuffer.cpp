@@ -0,0 +1,120 @@
+#include "InstanceBuffer.h"
+
+std::shared_ptr<DeviceResources> InstanceBuffer::m_deviceResources = nullptr;
+Microsoft::WRL::ComPtr<ID3D11Buffer> InstanceBuffer::m_buffer = nullptr;
+unsigned int InstanceBuffer::m_capacity = 0;
+unsigned int InstanceBuffer::m_next = 0;
+InstanceData* InstanceBuffer::m_mapped = nullptr;
+bool InstanceBuffer::m_discardOnNextMap = true;
+
+void InstanceBuffer::Initialize(std::shared_ptr<DeviceResources> deviceResources, unsigned int capacity)
+{
+	m_deviceResources = deviceResources;
+	CreateBuffer(capacity);
+}
+
+void InstanceBuffer::Shutdown()
+{
+	m_buffer = nullptr;
+	m_mapped = nullptr;
+	m_capacity = 0;
+	m_next = 0;
+	m_deviceResources = nullptr;
+}
+
+void InstanceBuffer::Map(unsigned int instanceCount)
+{
+	INFOMAN(m_deviceResources);
+
+	// Draws that were already issued keep the old buffer alive, so it can simply be replaced
+	if (instanceCount > m_capacity)
+		CreateBuffer(std::max(instanceCount, m_capacity * 2));
+
+	D3D11_MAP mapType = D3D11_MAP_WRITE_NO_OVERWRITE;
+	if (m_discardOnNextMap || instanceCount > m_capacity - m_next)
+	{
+		mapType = D3D11_MAP_WRITE_DISCARD;
+		m_next = 0;
+		m_discardOnNextMap = false;
+	}
+
+	D3D11_MAPPED_SUBRESOURCE ms;
+	ZeroMemory(&ms, sizeof(D3D11_MAPPED_SUBRESOURCE));
+	GFX_THROW_INFO(
+		m_deviceResources->D3DDeviceContext()->Map(m_buffer.Get(), 0, mapType, 0, &ms)
+	);
+
+	m_mapped = static_cast<InstanceData*>(ms.pData);
+}
+
+void InstanceBuffer::Unmap()
+{
+	INFOMAN(m_deviceResources);
+	GFX_THROW_INFO_ONLY(
+		m_deviceResources->D3DDeviceContext()->Unmap(m_buffer.Get(), 0)
+	);
+
+	m_mapped = nullptr;
+}
+
+unsigned int InstanceBuffer::Write(const InstanceData& instance)
+{
+	if (m_mapped == nullptr)
+		throw DeviceResourcesException(__LINE__, __FILE__, E_ILLEGAL_METHOD_CALL);
+	if (m_next >= m_capacity)
+		throw DeviceResourcesException(__LINE__, __FILE__, E_BOUNDS);
+
+	m_mapped[m_next] = instance;
+	return m_next++;
+}
+
+void InstanceBuffer::Bind()
+{
+	const UINT stride = sizeof(InstanceData);
+	const UINT offset = 0u;
+	if (!PipelineState::SetInstanceBuffer(m_buffer.Get(), stride, offset))
+		return;
+
+	INFOMAN(m_deviceResources);
+	GFX_THROW_INFO_ONLY(
+		m_deviceResources->D3DDeviceContext()->IASetVertexBuffers(SLOT, 1u, m_buffer.GetAddressOf(), &stride, &offset)
+	);
+}
+
+void InstanceBuffer::AddInputElements(InputLayout& layout)
+{
+	// One element per matrix row - the normal matrix only needs the upper 3x3
+	const UINT model = offsetof(InstanceData, model);
+	const UINT modelViewProjection = offsetof(InstanceData, modelViewProjection);
+	const UINT inverseTransposeModel = offsetof(InstanceData, inverseTransposeModel);
+	const UINT row = sizeof(DirectX::XMFLOAT4);
+
+	for (unsigned int iii = 0; iii < 4; ++iii)
+		layout.AddDescription(MODEL_SEMANTIC, iii, DXGI_FORMAT_R32G32B32A32_FLOAT, SLOT, model + iii * row, D3D11_INPUT_PER_INSTANCE_DATA, 1);
+	for (unsigned int iii = 0; iii < 4; ++iii)
+		layout.AddDescription("MODELVIEWPROJECTION", iii, DXGI_FORMAT_R32G32B32A32_FLOAT, SLOT, modelViewProjection + iii * row, D3D11_INPUT_PER_INSTANCE_DATA, 1);
+	for (unsigned int iii = 0; iii < 3; ++iii)
+		layout.AddDescription("INVERSETRANSPOSEMODEL", iii, DXGI_FORMAT_R32G32B32_FLOAT, SLOT, inverseTransposeModel + iii * row, D3D11_INPUT_PER_INSTANCE_DATA, 1);
+}
+
+void InstanceBuffer::CreateBuffer(unsigned int capacity)
+{
+	INFOMAN(m_deviceResources);
+
+	D3D11_BUFFER_DESC desc;
+	desc.ByteWidth = capacity * sizeof(InstanceData);
+	desc.Usage = D3D11_USAGE_DYNAMIC;
+	desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+	desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	desc.MiscFlags = 0;
+	desc.StructureByteStride = 0;
+
+	GFX_THROW_INFO(
+		m_deviceResources->D3DDevice()->CreateBuffer(&desc, nullptr, m_buffer.ReleaseAndGetAddressOf())
+	);
+
+	// The first Map of a dynamic buffer has to discard
+	m_capacity = capacity;
+	m_next = 0;
+	m_discardOnNextMap = true;
+}
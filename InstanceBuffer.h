@@ -0,0 +1,63 @@
+#pragma once
+#include "pch.h"
+#include "DeviceResources.h"
+#include "DeviceResourcesException.h"
+#include "PipelineState.h"
+#include "HLSLStructures.h"
+#include "InputLayout.h"
+
+#include <memory>
+#include <algorithm>
+
+// Per instance data read by the instanced vertex shaders - the same matrices as the ModelViewProjectionConstantBuffer
+// of a single draw. Each row is a separate element of the input layout (see AddInputElements)
+using InstanceData = ModelViewProjectionConstantBuffer;
+
+// InstanceBuffer is intended to be a static class
+//
+// InstanceBuffer is a dynamic vertex buffer bound to input slot 1 that holds the InstanceData of every instanced draw
+// of a frame. The instances of a draw are written one after the other under a single Map, and the draw call picks
+// them out with its StartInstanceLocation, so the buffer itself only ever has to be bound once:
+//
+//		InstanceBuffer::Map(count);
+//		first = InstanceBuffer::Write(instances[0]);	// then Write each of the others
+//		InstanceBuffer::Unmap();
+//		InstanceBuffer::Bind();
+//		context->DrawIndexedInstanced(indexCount, count, startIndex, 0, first);
+//
+// Maps append with NO_OVERWRITE behind the instances already written, which may still be in use by the GPU. Once a
+// batch does not fit, the buffer is discarded and writing starts over at the beginning.
+class InstanceBuffer
+{
+public:
+	static constexpr unsigned int SLOT = 1;
+	static constexpr const char* MODEL_SEMANTIC = "MODEL";
+
+	static void Initialize(std::shared_ptr<DeviceResources> deviceResources, unsigned int capacity = 4096);
+	static void Shutdown();
+
+	// Maps the buffer with room for at least instanceCount more instances. The buffer grows if instanceCount is more
+	// than its capacity
+	static void Map(unsigned int instanceCount);
+	static void Unmap();
+
+	// Copies the instance into the buffer and returns its index. Only valid between Map and Unmap
+	static unsigned int Write(const InstanceData& instance);
+
+	static void Bind();
+
+	// Adds the per instance elements that the instanced vertex shaders expect to a layout, before CreateLayout
+	static void AddInputElements(InputLayout& layout);
+
+private:
+	InstanceBuffer() {} // Disallow creation of an InstanceBuffer object
+
+	static void CreateBuffer(unsigned int capacity);
+
+	static std::shared_ptr<DeviceResources> m_deviceResources;
+	static Microsoft::WRL::ComPtr<ID3D11Buffer> m_buffer;
+	static unsigned int m_capacity;		// In instances
+	static unsigned int m_next;			// Index the next Write goes to
+	static InstanceData* m_mapped;		// nullptr when the buffer is not mapped
+	static bool m_discardOnNextMap;
+};
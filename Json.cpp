@@ -1,396 +1,487 @@
 #include "Json.h"
 
-Json::Json()
+const char* JsonValue::TypeName() const
 {
-
+	switch (m_type)
+	{
+	case JsonType::NUL:		return "null";
+	case JsonType::BOOLEAN:	return "boolean";
+	case JsonType::INTEGER:	return "integer";
+	case JsonType::FLOAT:	return "float";
+	case JsonType::STRING:	return "string";
+	case JsonType::ARRAY:	return "array";
+	case JsonType::OBJECT:	return "object";
+	}
+	return "unknown";
 }
 
-std::any& Json::operator[](std::string key)
+const JsonValue* JsonValue::Find(std::string_view key) const
 {
-	// If the key does not currently exist in the map, create an empty entry (so the key can be assigned to)
-	if (m_map.find(key) == m_map.end()) 
-		m_map.insert(std::pair(key, std::any()));
+	if (m_type != JsonType::OBJECT)
+		return nullptr;
 
-	return m_map[key];
+	const JsonMember* end = m_members + m_size;
+	const JsonMember* member = std::lower_bound(m_members, end, key,
+		[](const JsonMember& member, std::string_view key) { return member.key < key; });
+
+	if (member == end || member->key != key)
+		return nullptr;
+
+	return &member->value;
 }
 
-std::vector<std::string> Json::GetKeys()
+// ======================================================================================================
+
+namespace
 {
-	std::vector<std::string> keys;
-	for (std::map<std::string, std::any>::iterator it = m_map.begin(); it != m_map.end(); ++it) {
-		keys.push_back(it->first);
-		// value.push_back(it->second);
-	}
-	return keys;
+	// Arena blocks are at least this large - big arrays and strings get a block of their own
+	constexpr size_t ARENA_BLOCK_SIZE = 64 * 1024;
+
+	// Deeper nesting than this is treated as an error instead of running out of stack
+	constexpr int MAX_DEPTH = 256;
 }
 
-// ======================================================================================================
+JsonDocument::JsonDocument(std::string text) :
+	m_text(std::move(text)),
+	m_depth(0),
+	m_blockPosition(nullptr),
+	m_blockRemaining(0)
+{
+	m_position = m_text.data();
+	m_end = m_text.data() + m_text.size();
 
-Json JsonReader::ReadFile(std::string filename)
+	ParseValue(m_root);
+
+	SkipWhitespace();
+	if (m_position != m_end)
+		ThrowError("Unexpected text after the end of the Json value");
+
+	// The scratch space is only needed while parsing
+	m_itemStack = std::vector<JsonValue>();
+	m_memberStack = std::vector<JsonMember>();
+}
+
+void* JsonDocument::Allocate(size_t size)
 {
-	// Open the file -------------------------------------------------
-	std::ifstream file(filename);
-	if (!file.is_open())
-	{
-		std::ostringstream oss;
-		oss << "Could not open file: " << filename;
-		throw JsonException(__LINE__, __FILE__, oss.str());
-	}
+	// Keep every allocation 8 byte aligned (JsonValue holds 64-bit members)
+	size = (size + 7) & ~static_cast<size_t>(7);
 
-	// Loop over each line in the file and join them into a single string -------------------------------
-	std::string line;
-	std::string all;
-	while (std::getline(file, line))
+	if (size > m_blockRemaining)
 	{
-		all += line;
+		size_t blockSize = std::max(size, ARENA_BLOCK_SIZE);
+		m_blocks.push_back(std::make_unique<char[]>(blockSize));
+		m_blockPosition = m_blocks.back().get();
+		m_blockRemaining = blockSize;
 	}
 
-	file.close();
-
-	// Getting the next Json object should parse the entire json file
-	unsigned int iii = 0u;
-	return JsonReader::GetNextJson(all, iii);
+	void* memory = m_blockPosition;
+	m_blockPosition += size;
+	m_blockRemaining -= size;
+	return memory;
 }
 
-void JsonReader::MoveToNextNonSpace(std::string& fileText, unsigned int& index)
+void JsonDocument::SkipWhitespace()
 {
-	// Iterate the index until you find a non-space character
-	for (; index < fileText.size(); ++index)
-		if (fileText[index] != ' ')
-			break;
+	while (m_position != m_end && (*m_position == ' ' || *m_position == '\n' || *m_position == '\r' || *m_position == '\t'))
+		++m_position;
 }
 
-Json JsonReader::GetNextJson(std::string& fileText, unsigned int& index)
+char JsonDocument::Peek()
 {
-	JsonReader::MoveToNextNonSpace(fileText, index);
+	SkipWhitespace();
+	if (m_position == m_end)
+		ThrowError("Unexpected end of the Json text");
 
-	int startIndex = index;
+	return *m_position;
+}
 
-	// first character for the next json object should always be '{'
+void JsonDocument::ThrowError(const std::string& description)
+{
 	std::ostringstream oss;
-	if (fileText[index] != '{')
-	{		
-		oss << "No Json object starting at index: " << index;
-		throw JsonException(__LINE__, __FILE__, oss.str());
+	oss << description << " at index " << (m_position - m_text.data());
+	throw JsonException(__LINE__, __FILE__, oss.str());
+}
+
+void JsonDocument::ParseValue(JsonValue& value)
+{
+	switch (Peek())
+	{
+	case '{':
+		ParseObject(value);
+		return;
+
+	case '[':
+		ParseArray(value);
+		return;
+
+	case '\"':
+	{
+		std::string_view s = ParseString();
+		value.m_type = JsonType::STRING;
+		value.m_string = s.data();
+		value.m_size = static_cast<uint32_t>(s.size());
+		return;
 	}
 
-	// Initialize a new Json object
-	Json json;
+	case 't':
+		ParseLiteral("true", 4);
+		value.m_type = JsonType::BOOLEAN;
+		value.m_bool = true;
+		return;
+
+	case 'f':
+		ParseLiteral("false", 5);
+		value.m_type = JsonType::BOOLEAN;
+		value.m_bool = false;
+		return;
+
+	case 'n':
+		ParseLiteral("null", 4);
+		value.m_type = JsonType::NUL;
+		return;
+
+	default:
+		ParseNumber(value);
+		return;
+	}
+}
 
-	// bool for whether we are getting a key or getting a value
-	bool gettingKey = true;
+void JsonDocument::ParseObject(JsonValue& value)
+{
+	if (++m_depth > MAX_DEPTH)
+		ThrowError("Json values are nested too deeply");
 
-	std::string key;
-	std::string number;
+	// Skip the '{'
+	++m_position;
 
-	++index;
-	for (; index < fileText.size(); ++index)
+	// Members are collected on top of the members of the objects that are still open
+	size_t firstMember = m_memberStack.size();
+
+	if (Peek() == '}')
 	{
-		// If you find an end bracket, the Json object is complete
-		switch (fileText[index])
+		++m_position;
+	}
+	else
+	{
+		while (true)
 		{
-		case '}':
-			// If we are trying to get a value for a key, then throw an error
-			if (!gettingKey)
-			{
-				oss << "No value for key '" << key << "'";
-				throw JsonException(__LINE__, __FILE__, oss.str());
-			}
-			return json;	// NOTE: when a json object is returned, the index will be the index of the closing end bracket
-		
-		case ' ': continue;
-		
-		case '\"': 
-			// If we are looking for a key, get the next string value as the key
-			// NOTE: When this returns, the index will be the index of the closing
-			//		 quote. This is actually good, because the for-loop will increment
-			//		 to the next character in the next iteration
-			if (gettingKey)
-			{
-				key = JsonReader::GetNextString(fileText, index);
-				gettingKey = false;
+			if (Peek() != '\"')
+				ThrowError("Expected a string as the key of a Json object member");
 
-				if (key == "buffers")
-					int iii = 0;
-			}
-			else
-			{
-				// We already have the key, so get the next string as the value for the key
-				json[key] = JsonReader::GetNextString(fileText, index);
-				gettingKey = true;
-			}
-			continue;
-		
-		case ':':
-			if (gettingKey)
-			{
-				oss << "Found ':' at index " << index << " but was looking for a key";
-				throw JsonException(__LINE__, __FILE__, oss.str());
-			}
-			continue;
+			JsonMember member;
+			member.key = ParseString();
 
-		case '{':
-			if (gettingKey)
-			{
-				oss << "Found '{' at index " << index << " but was looking for a key";
-				throw JsonException(__LINE__, __FILE__, oss.str());
-			}
+			if (Peek() != ':')
+				ThrowError("Expected ':' after the key of a Json object member");
+			++m_position;
 
-			// Get the next Json object as the value for the current key
-			// NOTE: This will increment the index to the closing bracket for the Json object
-			//		 This is good because the for-loop will increment the index in the next
-			//		 loop iteration
-			json[key] = JsonReader::GetNextJson(fileText, index);
-			gettingKey = true;
-			continue;
+			ParseValue(member.value);
+			m_memberStack.push_back(member);
 
-		case '.':
-		case '-':
-		case '0':
-		case '1':
-		case '2':
-		case '3':
-		case '4':
-		case '5':
-		case '6':
-		case '7':
-		case '8':
-		case '9':
-			if (gettingKey)
-			{
-				oss << "Found the number " << fileText[index] << " at index " << index << " but was looking for a key";
-				throw JsonException(__LINE__, __FILE__, oss.str());
-			}
+			char next = Peek();
+			if (next != ',' && next != '}')
+				ThrowError("Expected ',' or '}' after a Json object member");
 
-			// Get the number as a string. If it contains a decimal, then cast to a float, otherwise int
-			number = JsonReader::GetNextNumber(fileText, index);
-
-			// For some BAT SHIT stupid reason, json[key] can NOT be assigned to using a ternary operator
-			// If you try to use the following commented line, you will get a "bad any_cast" when trying to
-			// correctly cast the value to an int (not sure about float)
-			//
-			// json[key] = number.contains('.') ? std::stof(number) : std::stoi(number);		<-- do NOT use
-			// 
-			if (number.contains('.'))
-				json[key] = std::stof(number);
-			else
-				json[key] = std::stoi(number);
+			++m_position;
+			if (next == '}')
+				break;
+		}
+	}
 
-			gettingKey = true;
-			continue;
+	// Sort the members so keys can be found with a binary search. If a key appears more than once, the last
+	// value wins
+	JsonMember* begin = m_memberStack.data() + firstMember;
+	JsonMember* end = m_memberStack.data() + m_memberStack.size();
+	std::stable_sort(begin, end, [](const JsonMember& a, const JsonMember& b) { return a.key < b.key; });
 
-		case 't':
-		case 'f':
-			if (gettingKey)
-			{
-				oss << "Found the letter '" << fileText[index] << "' at index " << index << " but was looking for a key";
-				throw JsonException(__LINE__, __FILE__, oss.str());
-			}
-			json[key] = JsonReader::GetNextBoolean(fileText, index);
-			gettingKey = true;
+	JsonMember* last = begin;
+	for (JsonMember* member = begin; member != end; ++member)
+	{
+		if (member + 1 != end && member[1].key == member->key)
 			continue;
+		*last++ = *member;
+	}
 
-		case '[':
-			if (gettingKey)
-			{
-				oss << "Found '[' at index " << index << " but was looking for a key";
-				throw JsonException(__LINE__, __FILE__, oss.str());
-			}
+	size_t count = static_cast<size_t>(last - begin);
+	JsonMember* members = static_cast<JsonMember*>(Allocate(sizeof(JsonMember) * count));
+	std::uninitialized_copy(begin, last, members);
+	m_memberStack.resize(firstMember);
 
-			// Get the next array object as the value for the current key
-			// NOTE: This will increment the index to the closing bracket for the array object
-			//		 This is good because the for-loop will increment the index in the next
-			//		 loop iteration
-			json[key] = JsonReader::GetNextVector(fileText, index);
-			gettingKey = true;
-			continue;
+	value.m_type = JsonType::OBJECT;
+	value.m_members = members;
+	value.m_size = static_cast<uint32_t>(count);
 
-		case ',':
-			// In the case of a comma, make sure that we have finished getting the previous value and
-			// are again searching for the next key
-			if (!gettingKey)
-			{
-				oss << "Found ',' at index " << index << " but was looking for a value";
-				throw JsonException(__LINE__, __FILE__, oss.str());
-			}
-			continue;
+	--m_depth;
+}
 
-		default:
-			oss << "Invalid character '" << fileText[index] << "' while parsing Json object at index " << index;
-			throw JsonException(__LINE__, __FILE__, oss.str());
+void JsonDocument::ParseArray(JsonValue& value)
+{
+	if (++m_depth > MAX_DEPTH)
+		ThrowError("Json values are nested too deeply");
+
+	// Skip the '['
+	++m_position;
+
+	size_t firstItem = m_itemStack.size();
+
+	if (Peek() == ']')
+	{
+		++m_position;
+	}
+	else
+	{
+		while (true)
+		{
+			// Parse into a local - nested arrays push onto the same stack, which may reallocate it
+			JsonValue item;
+			ParseValue(item);
+			m_itemStack.push_back(item);
+
+			char next = Peek();
+			if (next != ',' && next != ']')
+				ThrowError("Expected ',' or ']' after a Json array item");
+
+			++m_position;
+			if (next == ']')
+				break;
 		}
 	}
 
-	oss << "Did not find closing bracket for Json object starting at index: " << startIndex;
-	throw JsonException(__LINE__, __FILE__, oss.str());
+	size_t count = m_itemStack.size() - firstItem;
+	JsonValue* items = static_cast<JsonValue*>(Allocate(sizeof(JsonValue) * count));
+	std::uninitialized_copy(m_itemStack.begin() + firstItem, m_itemStack.end(), items);
+	m_itemStack.resize(firstItem);
+
+	value.m_type = JsonType::ARRAY;
+	value.m_items = items;
+	value.m_size = static_cast<uint32_t>(count);
+
+	--m_depth;
 }
 
-std::string JsonReader::GetNextString(std::string& fileText, unsigned int& index)
+std::string_view JsonDocument::ParseString()
 {
-	JsonReader::MoveToNextNonSpace(fileText, index);
+	// Skip the opening quote
+	++m_position;
+	const char* start = m_position;
 
-	int startIndex = index;
+	// Most strings have no escape sequences, in which case the string is just a view into the source text
+	const char* quote = m_position;
+	while (quote != m_end && *quote != '\"' && *quote != '\\')
+		++quote;
 
-	// first character for the next string should always be '\"'
-	if (fileText[index] != '\"')
-	{
-		std::ostringstream oss;
-		oss << "No string object starting at index: " << index;
-		throw JsonException(__LINE__, __FILE__, oss.str());
-	}
+	if (quote == m_end)
+		ThrowError("Did not find the closing quote of a Json string");
 
-	// Iterate until you find the end of the quote
-	std::string s;
-	++index;
-	for (; index < fileText.size(); ++index)
+	if (*quote == '\"')
 	{
-		if (fileText[index] == '\"')
-			return s;		// NOTE: the index when returning is the index for the closing quote
-
-		s += fileText[index];
+		m_position = quote + 1;
+		return std::string_view(start, quote - start);
 	}
 
-	std::ostringstream oss;
-	oss << "Did not find closing quote for string starting at index: " << startIndex;
-	throw JsonException(__LINE__, __FILE__, oss.str());
-}
+	// Otherwise decode the string into the arena. The decoded string is never longer than the source
+	const char* close = quote;
+	while (close != m_end && *close != '\"')
+		close += (*close == '\\' && close + 1 != m_end) ? 2 : 1;
 
-std::string JsonReader::GetNextNumber(std::string& fileText, unsigned int& index)
-{
-	JsonReader::MoveToNextNonSpace(fileText, index);
+	if (close == m_end)
+		ThrowError("Did not find the closing quote of a Json string");
 
-	int startIndex = index;
+	char* decoded = static_cast<char*>(Allocate(close - start));
+	char* out = decoded;
+	std::memcpy(out, start, quote - start);
+	out += quote - start;
 
-	// Iterate until you find the end of the quote
-	std::string validChars = ".-0123456789";
-	std::string s;
-	for (; index < fileText.size(); ++index)
+	auto ReadHex = [this](const char* digits) -> uint32_t
+	{
+		uint32_t codePoint = 0;
+		if (m_end - digits < 4 || std::from_chars(digits, digits + 4, codePoint, 16).ptr != digits + 4)
+			ThrowError("Invalid \\u escape sequence in a Json string");
+		return codePoint;
+	};
+
+	m_position = quote;
+	while (m_position != close)
 	{
-		// If the next character is not a valid number character, decrement the index to be
-		// the value of the last valid char and return the string
-		if (!validChars.contains(fileText[index]))
-		{	
-			--index;
-			return s;
+		if (*m_position != '\\')
+		{
+			*out++ = *m_position++;
+			continue;
 		}
 
-		s += fileText[index];
+		char escaped = m_position[1];
+		m_position += 2;
+		switch (escaped)
+		{
+		case '\"': *out++ = '\"'; break;
+		case '\\': *out++ = '\\'; break;
+		case '/':  *out++ = '/'; break;
+		case 'b':  *out++ = '\b'; break;
+		case 'f':  *out++ = '\f'; break;
+		case 'n':  *out++ = '\n'; break;
+		case 'r':  *out++ = '\r'; break;
+		case 't':  *out++ = '\t'; break;
+		case 'u':
+		{
+			uint32_t codePoint = ReadHex(m_position);
+			m_position += 4;
+
+			// Characters outside of the basic multilingual plane are written as a surrogate pair
+			if (codePoint >= 0xD800 && codePoint <= 0xDBFF && m_end - m_position >= 6 && m_position[0] == '\\' && m_position[1] == 'u')
+			{
+				uint32_t low = ReadHex(m_position + 2);
+				if (low >= 0xDC00 && low <= 0xDFFF)
+				{
+					codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+					m_position += 6;
+				}
+			}
+
+			// Encode as UTF-8 (at most 4 bytes, never more than the 6 or 12 characters of the escape sequence)
+			if (codePoint < 0x80)
+			{
+				*out++ = static_cast<char>(codePoint);
+			}
+			else if (codePoint < 0x800)
+			{
+				*out++ = static_cast<char>(0xC0 | (codePoint >> 6));
+				*out++ = static_cast<char>(0x80 | (codePoint & 0x3F));
+			}
+			else if (codePoint < 0x10000)
+			{
+				*out++ = static_cast<char>(0xE0 | (codePoint >> 12));
+				*out++ = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+				*out++ = static_cast<char>(0x80 | (codePoint & 0x3F));
+			}
+			else
+			{
+				*out++ = static_cast<char>(0xF0 | (codePoint >> 18));
+				*out++ = static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+				*out++ = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+				*out++ = static_cast<char>(0x80 | (codePoint & 0x3F));
+			}
+			break;
+		}
+		default:
+			ThrowError("Invalid escape sequence in a Json string");
+		}
 	}
 
-	std::ostringstream oss;
-	oss << "Did not find an invalid numerical character for the number starting at index: " << startIndex;
-	throw JsonException(__LINE__, __FILE__, oss.str());
+	// Skip the closing quote
+	++m_position;
+	return std::string_view(decoded, out - decoded);
 }
 
-std::vector<std::any> JsonReader::GetNextVector(std::string& fileText, unsigned int& index)
+void JsonDocument::ParseNumber(JsonValue& value)
 {
-	JsonReader::MoveToNextNonSpace(fileText, index);
+	// Find the extent of the number first so it can be classified as an integer or a float. Only numbers with a
+	// fraction or an exponent are floats
+	const char* start = m_position;
+	const char* end = m_position;
+	bool isFloat = false;
+	for (; end != m_end; ++end)
+	{
+		char c = *end;
+		if (c == '.' || c == 'e' || c == 'E')
+			isFloat = true;
+		else if ((c < '0' || c > '9') && c != '-' && c != '+')
+			break;
+	}
 
-	int startIndex = index;
-	std::ostringstream oss;
+	if (end == start)
+		ThrowError(std::string("Invalid character '") + *start + "' in Json text");
 
-	// first character for the array should always be '['
-	if (fileText[index] != '[')
+	std::from_chars_result result;
+	if (!isFloat)
 	{
-		oss << "No vector object starting at index: " << index;
-		throw JsonException(__LINE__, __FILE__, oss.str());
+		value.m_type = JsonType::INTEGER;
+		result = std::from_chars(start, end, value.m_integer);
 	}
 
-	std::vector<std::any> v;
-	std::string number;
-
-	++index;
-	for (; index < fileText.size(); ++index)
+	// Integers too large for 64 bits are kept as floats rather than rejected
+	if (isFloat || result.ec == std::errc::result_out_of_range)
 	{
-		// If you find an end bracket, the vector object is complete
-		switch (fileText[index])
-		{
-		case ']':
-			return v;	// NOTE: when a vector object is returned, the index will be the index of the closing end bracket
+		value.m_type = JsonType::FLOAT;
+		result = std::from_chars(start, end, value.m_float);
+	}
 
-		case ' ': continue;
+	if (result.ec != std::errc() || result.ptr != end)
+		ThrowError("Invalid Json number '" + std::string(start, end) + "'");
 
-		case '\"':
-			// Get the next string object
-			v.push_back(JsonReader::GetNextString(fileText, index));
-			continue;
+	m_position = end;
+}
 
-		case '{':
-			// Get the next Json object
-			v.push_back(JsonReader::GetNextJson(fileText, index));
-			continue;
+void JsonDocument::ParseLiteral(const char* literal, size_t length)
+{
+	if (static_cast<size_t>(m_end - m_position) < length || std::memcmp(m_position, literal, length) != 0)
+		ThrowError(std::string("Expected '") + literal + "'");
 
-		case '.':
-		case '-':
-		case '0':
-		case '1':
-		case '2':
-		case '3':
-		case '4':
-		case '5':
-		case '6':
-		case '7':
-		case '8':
-		case '9':
-			// Get the number as a string. If it contains a decimal, then cast to a float, otherwise int
-			number = JsonReader::GetNextNumber(fileText, index);
-			if (number.contains("."))
-				v.push_back(std::stof(number));
-			else
-				v.push_back(std::stoi(number));
-			continue;
+	m_position += length;
+}
 
-		case 't':
-		case 'f':
-			// Get the next boolean value
-			v.push_back(JsonReader::GetNextBoolean(fileText, index));
-			continue;
+// ======================================================================================================
 
-		case '[':
-			// Get the next Json object
-			v.push_back(JsonReader::GetNextVector(fileText, index));
-			continue;
+Json::Json() :
+	m_document(std::make_shared<const JsonDocument>("{}")),
+	m_value(&m_document->Root())
+{
+	// A default constructed Json is an empty object
+}
 
-		// In the case of a comma, just continue to get the next value
-		case ',': continue;
+Json::Json(std::shared_ptr<const JsonDocument> document, const JsonValue* value) :
+	m_document(document),
+	m_value(value)
+{
+}
 
-		default:
-			oss << "Invalid character '" << fileText[index] << "' while parsing vector object at index " << index;
-			throw JsonException(__LINE__, __FILE__, oss.str());
-		}
+const JsonValue& Json::GetMemberValue(std::string_view key) const
+{
+	const JsonValue* value = m_value->Find(key);
+	if (value == nullptr)
+	{
+		std::ostringstream oss;
+		oss << "Json::Get -> Could not find key: " << key;
+		throw JsonException(__LINE__, __FILE__, oss.str());
 	}
 
-	oss << "Did not find closing square bracket for vector starting at index: " << startIndex;
-	throw JsonException(__LINE__, __FILE__, oss.str());
+	return *value;
 }
 
-bool JsonReader::GetNextBoolean(std::string& fileText, unsigned int& index)
+std::vector<std::string> Json::GetKeys() const
 {
-	std::ostringstream oss;
+	std::vector<std::string> keys;
+	keys.reserve(m_value->MemberCount());
+	for (size_t iii = 0; iii < m_value->MemberCount(); ++iii)
+		keys.push_back(std::string(m_value->GetMember(iii).key));
+	return keys;
+}
 
-	if (fileText[index] == 't')
-	{
-		if (fileText.substr(index, 4) == "true")
-		{
-			index += 3;
-			return true;
-		}
-		oss << "Unrecognized substring '" << fileText.substr(index, 4) << "' at index " << index << " when looking for a boolean";
-		throw JsonException(__LINE__, __FILE__, oss.str());
-	}
-	else if (fileText[index] == 'f')
-	{
-		if (fileText.substr(index, 5) == "false")
-		{
-			index += 4;
-			return false;
-		}
-		oss << "Unrecognized substring '" << fileText.substr(index, 5) << "' at index " << index << " when looking for a boolean";
-		throw JsonException(__LINE__, __FILE__, oss.str());
-	}
-	else
+// ======================================================================================================
+
+Json JsonReader::ReadFile(std::string filename)
+{
+	// Read the whole file with a single read - the document keeps the text so its strings can point into it
+	std::ifstream file(filename, std::ios::binary | std::ios::ate);
+	if (!file.is_open())
 	{
-		oss << "Invalid starting character '" << fileText[index] << "' at index " << index << " when looking for a boolean";
+		std::ostringstream oss;
+		oss << "Could not open file: " << filename;
 		throw JsonException(__LINE__, __FILE__, oss.str());
 	}
-}
\ No newline at end of file
+
+	std::string text(static_cast<size_t>(file.tellg()), '\0');
+	file.seekg(0);
+	file.read(text.data(), static_cast<std::streamsize>(text.size()));
+	file.close();
+
+	return JsonReader::Parse(std::move(text));
+}
+
+Json JsonReader::Parse(std::string text)
+{
+	std::shared_ptr<const JsonDocument> document = std::make_shared<const JsonDocument>(std::move(text));
+	if (document->Root().Type() != JsonType::OBJECT)
+		throw JsonException(__LINE__, __FILE__, "The top level Json value must be an object");
+
+	return Json(document, &document->Root());
+}
@@ -3,54 +3,260 @@
 #include "JsonException.h"
 
 #include <string>
-#include <map>
-#include <any>
+#include <string_view>
 #include <memory>
 #include <fstream>
+#include <sstream>
 #include <vector>
 #include <type_traits>
+#include <charconv>
+#include <algorithm>
+#include <cstring>
+#include <stdint.h>
 
+class JsonDocument;
+
+enum class JsonType : uint8_t
+{
+	NUL,
+	BOOLEAN,
+	INTEGER,
+	FLOAT,
+	STRING,
+	ARRAY,
+	OBJECT
+};
+
+struct JsonMember;
+
+// JsonValue is a tagged union of every kind of Json value. Strings, arrays and objects only point at their
+// contents, which live in the JsonDocument that parsed them (strings without escape sequences point straight
+// into the source text). A JsonValue is therefore only valid for as long as its JsonDocument.
+class JsonValue
+{
+public:
+	JsonType Type() const { return m_type; }
+	const char* TypeName() const;
+
+	bool GetBool() const { return m_bool; }
+	int64_t GetInteger() const { return m_integer; }
+	double GetFloat() const { return m_float; }
+	std::string_view GetString() const { return std::string_view(m_string, m_size); }
+
+	// Arrays
+	size_t Size() const { return m_size; }
+	const JsonValue& operator[](size_t index) const { return m_items[index]; }
+
+	// Objects - members are sorted by key. Returns nullptr if the key does not exist
+	size_t MemberCount() const { return m_size; }
+	const JsonMember& GetMember(size_t index) const;
+	const JsonValue* Find(std::string_view key) const;
+
+private:
+	friend class JsonDocument;
+
+	JsonType m_type = JsonType::NUL;
+	uint32_t m_size = 0;		// Length of a string, number of items in an array / members of an object
+	union
+	{
+		bool				m_bool;
+		int64_t				m_integer = 0;
+		double				m_float;
+		const char*			m_string;
+		const JsonValue*	m_items;
+		const JsonMember*	m_members;
+	};
+};
+
+struct JsonMember
+{
+	std::string_view key;
+	JsonValue value;
+};
+
+inline const JsonMember& JsonValue::GetMember(size_t index) const { return m_members[index]; }
+
+// JsonDocument owns the source text and an arena that every array, object and unescaped string of the
+// document is allocated from, so parsing a file costs a handful of large allocations instead of one (or
+// more) per value. The text is parsed in a single pass. Values of an array or object are collected on a
+// scratch stack and only copied into the arena once the closing bracket is found and their count is known.
+class JsonDocument
+{
+public:
+	// Throws JsonException if the text is not valid Json
+	JsonDocument(std::string text);
+	JsonDocument(const JsonDocument&) = delete;
+	JsonDocument& operator=(const JsonDocument&) = delete;
+
+	const JsonValue& Root() const { return m_root; }
+
+private:
+	void* Allocate(size_t size);
+
+	void SkipWhitespace();
+	char Peek();
+	[[noreturn]] void ThrowError(const std::string& description);
+
+	void ParseValue(JsonValue& value);
+	void ParseObject(JsonValue& value);
+	void ParseArray(JsonValue& value);
+	std::string_view ParseString();
+	void ParseNumber(JsonValue& value);
+	void ParseLiteral(const char* literal, size_t length);
+
+	std::string m_text;
+	const char* m_position;
+	const char* m_end;
+	int m_depth;
+
+	// Arena blocks - values are never freed individually
+	std::vector<std::unique_ptr<char[]>> m_blocks;
+	char* m_blockPosition;
+	size_t m_blockRemaining;
+
+	// Values of the arrays and objects that are still open
+	std::vector<JsonValue> m_itemStack;
+	std::vector<JsonMember> m_memberStack;
+
+	JsonValue m_root;
+};
+
+// =======================================================================
+
+class JsonArray;
+
+// Json is a read-only view of a Json object. It shares ownership of the document it came from, so values
+// taken out of it stay valid after the Json that produced them is gone.
+//
+// Get converts a member to:
+//		bool, any integer or floating point type (integers can be read as floats but not the other way around),
+//		std::string, std::string_view, Json, JsonArray, or std::vector of any of the types above
 class Json
 {
 public:
 	Json();
-	std::any& operator[](std::string key);
+	Json(std::shared_ptr<const JsonDocument> document, const JsonValue* value);
+
+	template <typename T>
+	T Get(std::string_view key) const;
+	std::vector<std::string> GetKeys() const;
+	bool HasKey(std::string_view key) const { return m_value->Find(key) != nullptr; }
+
+	const JsonValue& GetValue() const { return *m_value; }
+
+private:
+	const JsonValue& GetMemberValue(std::string_view key) const;
+
+	std::shared_ptr<const JsonDocument> m_document;
+	const JsonValue* m_value;
+};
+
+// Read-only view of a Json array (see Json for the types Get can convert to)
+class JsonArray
+{
+public:
+	JsonArray(std::shared_ptr<const JsonDocument> document, const JsonValue* value) : m_document(document), m_value(value) {}
+
+	size_t Size() const { return m_value->Size(); }
 
 	template <typename T>
-	T Get(std::string key);
-	std::vector<std::string> GetKeys();
-	bool HasKey(std::string key) { return m_map.find(key) != m_map.end(); }
+	T Get(size_t index) const;
+
+	const JsonValue& GetValue() const { return *m_value; }
 
 private:
-	std::map<std::string, std::any> m_map;
+	std::shared_ptr<const JsonDocument> m_document;
+	const JsonValue* m_value;
 };
 
 template <typename T>
-T Json::Get(std::string key)
+struct IsStdVector : std::false_type {};
+template <typename T, typename A>
+struct IsStdVector<std::vector<T, A>> : std::true_type {};
+
+template <typename T>
+T JsonConvert(const std::shared_ptr<const JsonDocument>& document, const JsonValue& value)
 {
-	if (m_map.find(key) == m_map.end())
+	auto ThrowTypeError = [&value](const char* expected)
 	{
 		std::ostringstream oss;
-		oss << "Json::Get -> Could not find key: " << key;
+		oss << "Cannot read a Json " << value.TypeName() << " as " << expected;
 		throw JsonException(__LINE__, __FILE__, oss.str());
+	};
+
+	if constexpr (std::is_same_v<T, bool>)
+	{
+		if (value.Type() != JsonType::BOOLEAN)
+			ThrowTypeError("a boolean");
+		return value.GetBool();
+	}
+	else if constexpr (std::is_integral_v<T>)
+	{
+		if (value.Type() != JsonType::INTEGER)
+			ThrowTypeError("an integer");
+		return static_cast<T>(value.GetInteger());
+	}
+	else if constexpr (std::is_floating_point_v<T>)
+	{
+		// Numbers without a decimal point are stored as integers, but are just as valid where a float is expected
+		if (value.Type() == JsonType::INTEGER)
+			return static_cast<T>(value.GetInteger());
+		if (value.Type() != JsonType::FLOAT)
+			ThrowTypeError("a float");
+		return static_cast<T>(value.GetFloat());
+	}
+	else if constexpr (std::is_same_v<T, std::string_view> || std::is_same_v<T, std::string>)
+	{
+		if (value.Type() != JsonType::STRING)
+			ThrowTypeError("a string");
+		return T(value.GetString());
+	}
+	else if constexpr (std::is_same_v<T, Json>)
+	{
+		if (value.Type() != JsonType::OBJECT)
+			ThrowTypeError("an object");
+		return Json(document, &value);
 	}
+	else if constexpr (std::is_same_v<T, JsonArray>)
+	{
+		if (value.Type() != JsonType::ARRAY)
+			ThrowTypeError("an array");
+		return JsonArray(document, &value);
+	}
+	else if constexpr (IsStdVector<T>::value)
+	{
+		if (value.Type() != JsonType::ARRAY)
+			ThrowTypeError("an array");
+
+		T items;
+		items.reserve(value.Size());
+		for (size_t iii = 0; iii < value.Size(); ++iii)
+			items.push_back(JsonConvert<typename T::value_type>(document, value[iii]));
+		return items;
+	}
+	else
+	{
+		static_assert(!sizeof(T), "Json values cannot be converted to this type");
+	}
+}
+
+template <typename T>
+T Json::Get(std::string_view key) const
+{
+	return JsonConvert<T>(m_document, GetMemberValue(key));
+}
 
-	// In the case of a float, it is possible that when parsing the file,
-	// the value was actually stored as in int. Therefore, we want to try to get
-	// it as a float first and if that doesn't work, try to get it as an int
-	if constexpr (std::is_same_v<float, T>)
+template <typename T>
+T JsonArray::Get(size_t index) const
+{
+	if (index >= m_value->Size())
 	{
-		try
-		{
-			return std::any_cast<float>(m_map[key]);
-		}
-		catch (const std::bad_any_cast& e)
-		{
-			return static_cast<float>(std::any_cast<int>(m_map[key]));
-		}
+		std::ostringstream oss;
+		oss << "JsonArray::Get -> Index " << index << " is out of range for an array of size " << m_value->Size();
+		throw JsonException(__LINE__, __FILE__, oss.str());
 	}
 
-	return std::any_cast<T>(m_map[key]);
+	return JsonConvert<T>(m_document, (*m_value)[index]);
 }
 
 // =======================================================================
@@ -58,17 +264,10 @@ T Json::Get(std::string key)
 class JsonReader
 {
 public:
+	// The top level value must be a Json object
 	static Json ReadFile(std::string filename);
+	static Json Parse(std::string text);
 
 private:
 	JsonReader() {} // Disallow creation of an JsonReader object
-
-	static void MoveToNextNonSpace(std::string& fileText, unsigned int& index);
-
-	static Json GetNextJson(std::string& fileText, unsigned int& index);
-	static std::string GetNextString(std::string& fileText, unsigned int& index);
-	static std::string GetNextNumber(std::string& fileText, unsigned int& index);
-	static std::vector<std::any> GetNextVector(std::string& fileText, unsigned int& index);
-	static bool GetNextBoolean(std::string& fileText, unsigned int& index);
-
-};
\ No newline at end of file
+};
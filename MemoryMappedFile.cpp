@@ -0,0 +1,152 @@
+#include "MemoryMappedFile.h"
+
+MemoryMappedFile::MemoryMappedFile(const std::string& filename) :
+	m_file(INVALID_HANDLE_VALUE),
+	m_mapping(nullptr),
+	m_data(nullptr),
+	m_size(0),
+	m_writable(false)
+{
+	std::ostringstream oss;
+
+	m_file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (m_file == INVALID_HANDLE_VALUE)
+	{
+		oss << "Failed to open file: " << filename;
+		throw MemoryMappedFileException(__LINE__, __FILE__, oss.str());
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(m_file, &size))
+	{
+		CloseHandle(m_file);
+		oss << "Failed to get the size of file: " << filename;
+		throw MemoryMappedFileException(__LINE__, __FILE__, oss.str());
+	}
+	m_size = static_cast<size_t>(size.QuadPart);
+
+	// Empty files cannot be mapped - leave Data() as nullptr
+	if (m_size == 0)
+		return;
+
+	m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (m_mapping == nullptr)
+	{
+		CloseHandle(m_file);
+		oss << "Failed to create file mapping for file: " << filename;
+		throw MemoryMappedFileException(__LINE__, __FILE__, oss.str());
+	}
+
+	m_data = static_cast<const uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+	if (m_data == nullptr)
+	{
+		CloseHandle(m_mapping);
+		CloseHandle(m_file);
+		oss << "Failed to map view of file: " << filename;
+		throw MemoryMappedFileException(__LINE__, __FILE__, oss.str());
+	}
+}
+
+MemoryMappedFile::MemoryMappedFile(const std::string& filename, size_t size) :
+	m_file(INVALID_HANDLE_VALUE),
+	m_mapping(nullptr),
+	m_data(nullptr),
+	m_size(size),
+	m_writable(true)
+{
+	std::ostringstream oss;
+
+	m_file = CreateFileA(filename.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (m_file == INVALID_HANDLE_VALUE)
+	{
+		oss << "Failed to create file: " << filename;
+		throw MemoryMappedFileException(__LINE__, __FILE__, oss.str());
+	}
+
+	if (m_size == 0)
+		return;
+
+	// Creating the mapping with an explicit size extends the file to that size
+	LARGE_INTEGER mappingSize;
+	mappingSize.QuadPart = static_cast<long long>(m_size);
+	m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READWRITE, static_cast<DWORD>(mappingSize.HighPart), mappingSize.LowPart, nullptr);
+	if (m_mapping == nullptr)
+	{
+		CloseHandle(m_file);
+		oss << "Failed to create file mapping for file: " << filename << " (" << m_size << " bytes)";
+		throw MemoryMappedFileException(__LINE__, __FILE__, oss.str());
+	}
+
+	m_data = static_cast<const uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_WRITE, 0, 0, 0));
+	if (m_data == nullptr)
+	{
+		CloseHandle(m_mapping);
+		CloseHandle(m_file);
+		oss << "Failed to map view of file: " << filename;
+		throw MemoryMappedFileException(__LINE__, __FILE__, oss.str());
+	}
+}
+
+MemoryMappedFile::~MemoryMappedFile()
+{
+	if (m_data != nullptr)
+		UnmapViewOfFile(m_data);
+
+	if (m_mapping != nullptr)
+		CloseHandle(m_mapping);
+
+	if (m_file != INVALID_HANDLE_VALUE)
+		CloseHandle(m_file);
+}
+
+void MemoryMappedFile::Release(size_t offset, size_t size) const
+{
+	if (m_data == nullptr || offset >= m_size)
+		return;
+
+	size = std::min(size, m_size - offset);
+
+	// Only whole pages that lie inside the range are released so that neighbouring data is left alone
+	SYSTEM_INFO systemInfo;
+	GetSystemInfo(&systemInfo);
+	size_t pageSize = systemInfo.dwPageSize;
+
+	size_t first = ((offset + pageSize - 1) / pageSize) * pageSize;
+	size_t last = ((offset + size) / pageSize) * pageSize;
+	if (offset + size == m_size)
+		last = offset + size;
+	if (last <= first)
+		return;
+
+	// Unlocking pages that were never locked fails with ERROR_NOT_LOCKED but still removes them from the
+	// working set, which is all that is wanted here
+	VirtualUnlock(const_cast<uint8_t*>(m_data + first), last - first);
+}
+
+void MemoryMappedFile::Flush() const
+{
+	if (m_data == nullptr || !m_writable)
+		return;
+
+	if (!FlushViewOfFile(m_data, 0) || !FlushFileBuffers(m_file))
+		throw MemoryMappedFileException(__LINE__, __FILE__, "Failed to write a mapped file back to disk");
+}
+
+uint64_t MemoryMappedFile::Hash() const
+{
+	// Hash in chunks so that hashing a file larger than memory does not keep all of it resident
+	constexpr size_t chunkSize = 16 * 1024 * 1024;
+
+	uint64_t hash = 14695981039346656037ull;
+	for (size_t chunk = 0; chunk < m_size; chunk += chunkSize)
+	{
+		size_t chunkEnd = std::min(chunk + chunkSize, m_size);
+		for (size_t iii = chunk; iii < chunkEnd; ++iii)
+		{
+			hash ^= m_data[iii];
+			hash *= 1099511628211ull;
+		}
+		Release(chunk, chunkEnd - chunk);
+	}
+	return hash;
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include "pch.h"
+#include "MemoryMappedFileException.h"
+
+#include <string>
+#include <sstream>
+#include <stdint.h>
+#include <algorithm>
+
+// MemoryMappedFile maps an entire file into the address space of the process - an existing file read-only, or a
+// new file of a given size read-write. The mapping stays valid for the lifetime of the object. Pages are only
+// read from disk when they are first touched.
+class MemoryMappedFile
+{
+public:
+	MemoryMappedFile(const std::string& filename);
+
+	// Creates (or truncates) filename, sets its size and maps it for writing. The contents start out as zeros
+	MemoryMappedFile(const std::string& filename, size_t size);
+	MemoryMappedFile(const MemoryMappedFile&) = delete;
+	MemoryMappedFile& operator=(const MemoryMappedFile&) = delete;
+	~MemoryMappedFile();
+
+	const uint8_t* Data() const { return m_data; }
+
+	// Only for files created for writing - nullptr otherwise
+	uint8_t* MutableData() { return m_writable ? const_cast<uint8_t*>(m_data) : nullptr; }
+	size_t Size() const { return m_size; }
+
+	// Removes the pages covering [offset, offset + size) from the working set of the process. The data stays
+	// mapped and is read back from disk if it is touched again, so this only bounds how much of a large file
+	// stays resident while it is walked
+	void Release(size_t offset, size_t size) const;
+
+	// Writes every modified page back to the file. Throws MemoryMappedFileException on failure
+	void Flush() const;
+
+	// 64-bit FNV-1a hash of the file contents - pages are released as they are hashed
+	uint64_t Hash() const;
+
+private:
+	HANDLE m_file;
+	HANDLE m_mapping;
+	const uint8_t* m_data;
+	size_t m_size;
+	bool m_writable;
+};
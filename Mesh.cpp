@@ -10,6 +10,7 @@ Mesh::Mesh(std::shared_ptr<DeviceResources> deviceResources) :
 	m_vertexBuffer(nullptr),
 	m_indexBuffer(nullptr),
 	m_indexCount(0),
+	m_startIndex(0),
 	m_vertexCount(0),
 	m_sizeOfVertex(0),
 	m_indexFormat(DXGI_FORMAT_R16_UINT),
@@ -26,18 +27,34 @@ void Mesh::Bind()
 	// Next, bind the vertex and index buffers
 	ID3D11DeviceContext4* context = m_deviceResources->D3DDeviceContext();
 
-	GFX_THROW_INFO_ONLY(
-		context->IASetPrimitiveTopology(m_topology)
-	);
+	if (PipelineState::SetPrimitiveTopology(m_topology))
+	{
+		GFX_THROW_INFO_ONLY(
+			context->IASetPrimitiveTopology(m_topology)
+		);
+	}
 
 	const UINT stride = m_sizeOfVertex;
 	const UINT offset = 0u;
-	GFX_THROW_INFO_ONLY(
-		context->IASetVertexBuffers(0u, 1u, m_vertexBuffer.GetAddressOf(), &stride, &offset)
-	);
-	GFX_THROW_INFO_ONLY(
-		context->IASetIndexBuffer(m_indexBuffer.Get(), m_indexFormat, 0u)
-	);
+	if (PipelineState::SetVertexBuffer(m_vertexBuffer.Get(), stride, offset))
+	{
+		GFX_THROW_INFO_ONLY(
+			context->IASetVertexBuffers(0u, 1u, m_vertexBuffer.GetAddressOf(), &stride, &offset)
+		);
+	}
+	if (PipelineState::SetIndexBuffer(m_indexBuffer.Get(), m_indexFormat, 0u))
+	{
+		GFX_THROW_INFO_ONLY(
+			context->IASetIndexBuffer(m_indexBuffer.Get(), m_indexFormat, 0u)
+		);
+	}
+}
+
+size_t Mesh::SizeInBytes() const
+{
+	size_t indexSize = m_indexFormat == DXGI_FORMAT_R32_UINT ? sizeof(unsigned int) : sizeof(unsigned short);
+	return (static_cast<size_t>(m_vertexCount) * m_sizeOfVertex) + (static_cast<size_t>(m_indexCount) * indexSize) +
+		(m_positions.size() * sizeof(DirectX::XMVECTOR)) + (m_indices.size() * sizeof(unsigned int));
 }
 
 bool Mesh::RayIntersectionTest(const XMVECTOR& rayOrigin, const XMVECTOR& rayDirection, float& distance)
@@ -4,12 +4,14 @@
 #include "BoundingBox.h"
 
 #include <vector>
+#include <type_traits>
 
 struct OBJVertex
 {
 	DirectX::XMFLOAT3 position;
 	DirectX::XMFLOAT2 texture;
 	DirectX::XMFLOAT3 normal;
+	DirectX::XMFLOAT4 tangent;		// w is the handedness of the bitangent - see TangentSpace
 };
 
 class Mesh : public Bindable
@@ -17,15 +19,33 @@ class Mesh : public Bindable
 public:
 	Mesh(std::shared_ptr<DeviceResources> deviceResources);
 
+	// I is the index type - unsigned short (16-bit indices) or unsigned int (32-bit indices, for meshes with more
+	// than 65536 vertices)
+	template <typename T, typename A, typename I>
+	void LoadBuffers(std::vector<T, A>& vertices, std::vector<I>& indices);
+
+	// Creates the buffers straight from memory that is not owned by a vector (e.g. a memory mapped cooked model).
+	// When the min / max corners of the positions are already known they are used instead of being computed
+	template <typename T, typename I>
+	void LoadBuffers(const T* vertices, size_t vertexCount, const I* indices, size_t indexCount,
+		const DirectX::XMFLOAT3* boundsMin = nullptr, const DirectX::XMFLOAT3* boundsMax = nullptr);
+
+	// Picks the index size for the mesh: 16-bit indices whenever every vertex can be addressed with them (half the
+	// index buffer memory and bandwidth), 32-bit otherwise
 	template <typename T, typename A>
-	void LoadBuffers(std::vector<T, A>& vertices, std::vector<unsigned short>& indices);
+	void LoadBuffersWithSmallestIndices(std::vector<T, A>& vertices, std::vector<unsigned int>& indices);
 
 	virtual void Bind() override;
+	BindableSlot Slot() const override { return { BindableSlot::Type::MESH }; }
 	unsigned int IndexCount() { return m_indexCount; }
+	unsigned int StartIndex() { return m_startIndex; }
 	unsigned int VertexCount() { return m_vertexCount; }
 
 	bool DrawIndexed() { return m_drawIndexed; }
 
+	// Vertex and index buffers plus the copies kept for collision detection
+	size_t SizeInBytes() const;
+
 	bool RayIntersectionTest(const DirectX::XMVECTOR& rayOrigin, const DirectX::XMVECTOR& rayDirection, float& distance);
 	void GetBoundingBoxPositionsWithTransformation(const DirectX::XMMATRIX& tranformation, std::vector<DirectX::XMVECTOR>& positions);
 
@@ -42,6 +62,7 @@ protected:
 	Microsoft::WRL::ComPtr<ID3D11Buffer> m_vertexBuffer;
 	Microsoft::WRL::ComPtr<ID3D11Buffer> m_indexBuffer;
 	unsigned int m_indexCount;
+	unsigned int m_startIndex;	// First index to draw - lets several meshes share one index buffer
 	unsigned int m_vertexCount;
 
 	unsigned int m_sizeOfVertex;
@@ -51,7 +72,7 @@ protected:
 	// Data used for collision detection
 	std::unique_ptr<::BoundingBox>	m_boundingBox;
 	std::vector<DirectX::XMVECTOR>	m_positions;
-	std::vector<unsigned short>		m_indices;
+	std::vector<unsigned int>		m_indices;
 
 	// DEBUG SPECIFIC --------------------------------------------------------
 #ifndef NDEBUG
@@ -61,13 +82,39 @@ public:
 #endif
 };
 
+template <typename T, typename A, typename I>
+void Mesh::LoadBuffers(std::vector<T, A>& vertices, std::vector<I>& indices)
+{
+	LoadBuffers<T, I>(vertices.data(), vertices.size(), indices.data(), indices.size());
+}
+
 template <typename T, typename A>
-void Mesh::LoadBuffers(std::vector<T, A>& vertices, std::vector<unsigned short>& indices)
+void Mesh::LoadBuffersWithSmallestIndices(std::vector<T, A>& vertices, std::vector<unsigned int>& indices)
+{
+	if (vertices.size() > 0x10000)
+	{
+		LoadBuffers<T, A, unsigned int>(vertices, indices);
+		return;
+	}
+
+	std::vector<unsigned short> narrowIndices(indices.size());
+	for (size_t iii = 0; iii < indices.size(); ++iii)
+		narrowIndices[iii] = static_cast<unsigned short>(indices[iii]);
+
+	LoadBuffers<T, A, unsigned short>(vertices, narrowIndices);
+}
+
+template <typename T, typename I>
+void Mesh::LoadBuffers(const T* vertices, size_t vertexCount, const I* indices, size_t indexCount,
+	const DirectX::XMFLOAT3* boundsMin, const DirectX::XMFLOAT3* boundsMax)
 {
+	static_assert(std::is_same_v<I, unsigned short> || std::is_same_v<I, unsigned int>, "Index buffers must be 16 or 32-bit");
+
 	INFOMAN(m_deviceResources);
 
 	m_sizeOfVertex = sizeof(T);
-	m_vertexCount = static_cast<unsigned int>(vertices.size());
+	m_indexFormat = sizeof(I) == sizeof(unsigned short) ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+	m_vertexCount = static_cast<unsigned int>(vertexCount);
 
 	// Vertex Buffer
 	D3D11_BUFFER_DESC bd = {};
@@ -75,10 +122,10 @@ void Mesh::LoadBuffers(std::vector<T, A>& vertices, std::vector<unsigned short>&
 	bd.Usage = D3D11_USAGE_DEFAULT;
 	bd.CPUAccessFlags = 0u;
 	bd.MiscFlags = 0u;
-	bd.ByteWidth = static_cast<UINT>(vertices.size() * m_sizeOfVertex);
+	bd.ByteWidth = static_cast<UINT>(vertexCount * m_sizeOfVertex);
 	bd.StructureByteStride = m_sizeOfVertex;
 	D3D11_SUBRESOURCE_DATA sd = {};
-	sd.pSysMem = vertices.data();
+	sd.pSysMem = vertices;
 	GFX_THROW_INFO(m_deviceResources->D3DDevice()->CreateBuffer(&bd, &sd, &m_vertexBuffer));
 
 	// Index Buffer
@@ -87,21 +134,24 @@ void Mesh::LoadBuffers(std::vector<T, A>& vertices, std::vector<unsigned short>&
 	ibd.Usage = D3D11_USAGE_DEFAULT;
 	ibd.CPUAccessFlags = 0u;
 	ibd.MiscFlags = 0u;
-	ibd.ByteWidth = static_cast<UINT>(indices.size() * sizeof(unsigned short));
-	ibd.StructureByteStride = sizeof(unsigned short);
+	ibd.ByteWidth = static_cast<UINT>(indexCount * sizeof(I));
+	ibd.StructureByteStride = sizeof(I);
 	D3D11_SUBRESOURCE_DATA isd = {};
-	isd.pSysMem = indices.data();
+	isd.pSysMem = indices;
 	GFX_THROW_INFO(m_deviceResources->D3DDevice()->CreateBuffer(&ibd, &isd, &m_indexBuffer));
 
-	m_indexCount = static_cast<unsigned int>(indices.size());
+	m_indexCount = static_cast<unsigned int>(indexCount);
 
 	// If this worked, copy over the position data and create the BoundingBox
 	// NOTE: HUGE ASSUMPTION that the vertex has a XMFLOAT3 position member variable
-	for (T vertex : vertices)
-		m_positions.push_back(DirectX::XMLoadFloat3(&vertex.position));
+	m_positions.reserve(m_positions.size() + vertexCount);
+	for (size_t iii = 0; iii < vertexCount; ++iii)
+		m_positions.push_back(DirectX::XMLoadFloat3(&vertices[iii].position));
 
-	for (unsigned short index : indices)
-		m_indices.push_back(index);
+	m_indices.insert(m_indices.end(), indices, indices + indexCount);
 
-	m_boundingBox = std::make_unique<BoundingBox>(m_deviceResources, m_positions);
-}
\ No newline at end of file
+	if (boundsMin != nullptr && boundsMax != nullptr)
+		m_boundingBox = std::make_unique<BoundingBox>(m_deviceResources, *boundsMin, *boundsMax);
+	else
+		m_boundingBox = std::make_unique<BoundingBox>(m_deviceResources, m_positions);
+}
@@ -0,0 +1,322 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	// Tuning values from Forsyth's paper. The simulated cache is larger than any real one on purpose - the scores
+	// only need to fall off smoothly with the age of a vertex
+	constexpr int FORSYTH_CACHE_SIZE = 32;
+	constexpr float CACHE_DECAY_POWER = 1.5f;
+	constexpr float LAST_TRIANGLE_SCORE = 0.75f;
+	constexpr float VALENCE_BOOST_SCALE = 2.0f;
+	constexpr float VALENCE_BOOST_POWER = 0.5f;
+
+	float VertexScore(int cachePosition, unsigned int remainingValence)
+	{
+		// Vertices without any triangles left to draw can never help
+		if (remainingValence == 0)
+			return -1.0f;
+
+		float score = 0.0f;
+		if (cachePosition >= 0)
+		{
+			// The vertices of the triangle that was just drawn get a fixed score so the next triangle does not
+			// simply use the same edge again (which would be bad for strips of triangles)
+			if (cachePosition < 3)
+				score = LAST_TRIANGLE_SCORE;
+			else
+			{
+				float scaler = 1.0f / (FORSYTH_CACHE_SIZE - 3);
+				score = std::pow(1.0f - ((cachePosition - 3) * scaler), CACHE_DECAY_POWER);
+			}
+		}
+
+		// Favour vertices with few triangles left so they are finished off instead of left to go stale
+		score += VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remainingValence), -VALENCE_BOOST_POWER);
+		return score;
+	}
+}
+
+void MeshOptimizer::OptimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount)
+{
+	size_t triangleCount = indices.size() / 3;
+	if (triangleCount == 0)
+		return;
+
+	// Triangles using each vertex. The triangles of vertex v that are not drawn yet are always the first
+	// remainingValence[v] entries of its range
+	std::vector<unsigned int> remainingValence(vertexCount, 0);
+	for (unsigned int index : indices)
+		++remainingValence[index];
+
+	std::vector<unsigned int> adjacencyOffsets(vertexCount + 1, 0);
+	for (size_t iii = 0; iii < vertexCount; ++iii)
+		adjacencyOffsets[iii + 1] = adjacencyOffsets[iii] + remainingValence[iii];
+
+	std::vector<unsigned int> adjacency(indices.size());
+	std::vector<unsigned int> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+	for (size_t iii = 0; iii < indices.size(); ++iii)
+		adjacency[fill[indices[iii]]++] = static_cast<unsigned int>(iii / 3);
+
+	std::vector<int> cachePosition(vertexCount, -1);
+	std::vector<float> vertexScore(vertexCount);
+	for (size_t iii = 0; iii < vertexCount; ++iii)
+		vertexScore[iii] = VertexScore(-1, remainingValence[iii]);
+
+	std::vector<float> triangleScore(triangleCount);
+	std::vector<bool> triangleAdded(triangleCount, false);
+	for (size_t iii = 0; iii < triangleCount; ++iii)
+		triangleScore[iii] = vertexScore[indices[iii * 3]] + vertexScore[indices[(iii * 3) + 1]] + vertexScore[indices[(iii * 3) + 2]];
+
+	std::vector<unsigned int> output;
+	output.reserve(indices.size());
+
+	std::vector<unsigned int> cache;
+	std::vector<unsigned int> newCache;
+	cache.reserve(FORSYTH_CACHE_SIZE + 3);
+	newCache.reserve(FORSYTH_CACHE_SIZE + 3);
+
+	int bestTriangle = static_cast<int>(std::max_element(triangleScore.begin(), triangleScore.end()) - triangleScore.begin());
+	size_t scanPosition = 0;
+
+	while (bestTriangle >= 0)
+	{
+		triangleAdded[bestTriangle] = true;
+		const unsigned int* triangle = &indices[static_cast<size_t>(bestTriangle) * 3];
+		output.insert(output.end(), triangle, triangle + 3);
+
+		// The vertices of the new triangle go to the front of the cache, everything else moves back
+		newCache.assign(triangle, triangle + 3);
+		for (unsigned int vertex : cache)
+		{
+			if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2])
+				newCache.push_back(vertex);
+		}
+
+		// Take the triangle out of the list of triangles still to draw for each of its vertices
+		for (int iii = 0; iii < 3; ++iii)
+		{
+			unsigned int vertex = triangle[iii];
+			unsigned int* begin = &adjacency[adjacencyOffsets[vertex]];
+			unsigned int* end = begin + remainingValence[vertex];
+			std::swap(*std::find(begin, end, static_cast<unsigned int>(bestTriangle)), *(end - 1));
+			--remainingValence[vertex];
+		}
+
+		// Rescore every vertex that is in the cache or just fell out of it, then every triangle that uses one of
+		// them. The best of those is almost always the best triangle overall
+		for (size_t iii = 0; iii < newCache.size(); ++iii)
+		{
+			unsigned int vertex = newCache[iii];
+			cachePosition[vertex] = iii < FORSYTH_CACHE_SIZE ? static_cast<int>(iii) : -1;
+			vertexScore[vertex] = VertexScore(cachePosition[vertex], remainingValence[vertex]);
+		}
+
+		bestTriangle = -1;
+		float bestScore = -1.0f;
+		for (unsigned int vertex : newCache)
+		{
+			const unsigned int* begin = &adjacency[adjacencyOffsets[vertex]];
+			for (const unsigned int* t = begin; t != begin + remainingValence[vertex]; ++t)
+			{
+				const unsigned int* other = &indices[static_cast<size_t>(*t) * 3];
+				triangleScore[*t] = vertexScore[other[0]] + vertexScore[other[1]] + vertexScore[other[2]];
+				if (triangleScore[*t] > bestScore)
+				{
+					bestScore = triangleScore[*t];
+					bestTriangle = static_cast<int>(*t);
+				}
+			}
+		}
+
+		if (newCache.size() > FORSYTH_CACHE_SIZE)
+			newCache.resize(FORSYTH_CACHE_SIZE);
+		cache.swap(newCache);
+
+		// Nothing in the cache has a triangle left - carry on with the next triangle that has not been drawn
+		if (bestTriangle < 0)
+		{
+			while (scanPosition < triangleCount && triangleAdded[scanPosition])
+				++scanPosition;
+			if (scanPosition < triangleCount)
+				bestTriangle = static_cast<int>(scanPosition);
+		}
+	}
+
+	indices.swap(output);
+}
+
+void MeshOptimizer::OptimizeOverdraw(std::vector<unsigned int>& indices, const DirectX::XMFLOAT3* positions, size_t positionStride,
+	size_t vertexCount, float threshold)
+{
+	size_t triangleCount = indices.size() / 3;
+	if (triangleCount == 0)
+		return;
+
+	auto Position = [positions, positionStride](unsigned int index) -> const DirectX::XMFLOAT3&
+	{
+		return *reinterpret_cast<const DirectX::XMFLOAT3*>(reinterpret_cast<const uint8_t*>(positions) + (index * positionStride));
+	};
+
+	// Split the triangles into clusters wherever the cache starts from scratch (all three vertices of a triangle
+	// are misses). Reordering whole clusters then costs almost nothing in cache efficiency
+	const unsigned int cacheSize = 16;
+	std::vector<unsigned int> cacheTimestamps(vertexCount, 0);
+	unsigned int timestamp = cacheSize + 1;
+
+	std::vector<size_t> clusterStarts;
+	for (size_t iii = 0; iii < triangleCount; ++iii)
+	{
+		int misses = 0;
+		for (int jjj = 0; jjj < 3; ++jjj)
+		{
+			unsigned int vertex = indices[(iii * 3) + jjj];
+			if (timestamp - cacheTimestamps[vertex] > cacheSize)
+			{
+				cacheTimestamps[vertex] = timestamp++;
+				++misses;
+			}
+		}
+
+		if (iii == 0 || misses == 3)
+			clusterStarts.push_back(iii);
+	}
+
+	if (clusterStarts.size() < 2)
+		return;
+
+	// Area weighted centroid of the mesh
+	auto TriangleArea = [&indices, &Position](size_t triangle, DirectX::XMFLOAT3& centroid, DirectX::XMFLOAT3& normal) -> float
+	{
+		const DirectX::XMFLOAT3& a = Position(indices[triangle * 3]);
+		const DirectX::XMFLOAT3& b = Position(indices[(triangle * 3) + 1]);
+		const DirectX::XMFLOAT3& c = Position(indices[(triangle * 3) + 2]);
+
+		float e1x = b.x - a.x, e1y = b.y - a.y, e1z = b.z - a.z;
+		float e2x = c.x - a.x, e2y = c.y - a.y, e2z = c.z - a.z;
+
+		// The cross product points along the normal and its length is twice the area
+		normal = DirectX::XMFLOAT3((e1y * e2z) - (e1z * e2y), (e1z * e2x) - (e1x * e2z), (e1x * e2y) - (e1y * e2x));
+		centroid = DirectX::XMFLOAT3((a.x + b.x + c.x) / 3.0f, (a.y + b.y + c.y) / 3.0f, (a.z + b.z + c.z) / 3.0f);
+		return std::sqrt((normal.x * normal.x) + (normal.y * normal.y) + (normal.z * normal.z)) * 0.5f;
+	};
+
+	DirectX::XMFLOAT3 meshCentroid(0.0f, 0.0f, 0.0f);
+	float meshArea = 0.0f;
+	DirectX::XMFLOAT3 centroid, normal;
+	for (size_t iii = 0; iii < triangleCount; ++iii)
+	{
+		float area = TriangleArea(iii, centroid, normal);
+		meshCentroid.x += centroid.x * area;
+		meshCentroid.y += centroid.y * area;
+		meshCentroid.z += centroid.z * area;
+		meshArea += area;
+	}
+
+	if (meshArea > 0.0f)
+	{
+		meshCentroid.x /= meshArea;
+		meshCentroid.y /= meshArea;
+		meshCentroid.z /= meshArea;
+	}
+
+	// Clusters that face away from the center of the mesh are the ones most likely to be in front, so they are
+	// drawn first
+	size_t clusterCount = clusterStarts.size();
+	clusterStarts.push_back(triangleCount);
+
+	std::vector<std::pair<float, size_t>> sortKeys(clusterCount);
+	for (size_t iii = 0; iii < clusterCount; ++iii)
+	{
+		DirectX::XMFLOAT3 clusterCentroid(0.0f, 0.0f, 0.0f);
+		DirectX::XMFLOAT3 clusterNormal(0.0f, 0.0f, 0.0f);
+		float clusterArea = 0.0f;
+
+		for (size_t triangle = clusterStarts[iii]; triangle < clusterStarts[iii + 1]; ++triangle)
+		{
+			float area = TriangleArea(triangle, centroid, normal);
+			clusterCentroid.x += centroid.x * area;
+			clusterCentroid.y += centroid.y * area;
+			clusterCentroid.z += centroid.z * area;
+			clusterNormal.x += normal.x;	// Already weighted by the area
+			clusterNormal.y += normal.y;
+			clusterNormal.z += normal.z;
+			clusterArea += area;
+		}
+
+		float key = 0.0f;
+		if (clusterArea > 0.0f)
+		{
+			float dx = (clusterCentroid.x / clusterArea) - meshCentroid.x;
+			float dy = (clusterCentroid.y / clusterArea) - meshCentroid.y;
+			float dz = (clusterCentroid.z / clusterArea) - meshCentroid.z;
+			float normalLength = std::sqrt((clusterNormal.x * clusterNormal.x) + (clusterNormal.y * clusterNormal.y) + (clusterNormal.z * clusterNormal.z));
+			if (normalLength > 0.0f)
+				key = ((dx * clusterNormal.x) + (dy * clusterNormal.y) + (dz * clusterNormal.z)) / normalLength;
+		}
+
+		sortKeys[iii] = { -key, iii };
+	}
+
+	std::stable_sort(sortKeys.begin(), sortKeys.end(),
+		[](const std::pair<float, size_t>& a, const std::pair<float, size_t>& b) { return a.first < b.first; });
+
+	std::vector<unsigned int> reordered;
+	reordered.reserve(indices.size());
+	for (const std::pair<float, size_t>& sortKey : sortKeys)
+	{
+		size_t cluster = sortKey.second;
+		reordered.insert(reordered.end(), indices.begin() + (clusterStarts[cluster] * 3), indices.begin() + (clusterStarts[cluster + 1] * 3));
+	}
+
+	// Keep the new order only if the vertex cache does not suffer too much for it
+	float currentAcmr = AnalyzeVertexCache(indices, vertexCount).acmr;
+	float reorderedAcmr = AnalyzeVertexCache(reordered, vertexCount).acmr;
+	if (reorderedAcmr <= currentAcmr * threshold)
+		indices.swap(reordered);
+}
+
+std::vector<unsigned int> MeshOptimizer::OptimizeVertexFetch(std::vector<unsigned int>& indices, size_t vertexCount)
+{
+	const unsigned int UNUSED = ~0u;
+	std::vector<unsigned int> newIndex(vertexCount, UNUSED);
+	std::vector<unsigned int> remap;
+	remap.reserve(vertexCount);
+
+	for (unsigned int& index : indices)
+	{
+		if (newIndex[index] == UNUSED)
+		{
+			newIndex[index] = static_cast<unsigned int>(remap.size());
+			remap.push_back(index);
+		}
+
+		index = newIndex[index];
+	}
+
+	return remap;
+}
+
+VertexCacheStatistics MeshOptimizer::AnalyzeVertexCache(const std::vector<unsigned int>& indices, size_t vertexCount, unsigned int cacheSize)
+{
+	// A vertex is in the FIFO cache if fewer than cacheSize vertices have been transformed since it was
+	std::vector<unsigned int> cacheTimestamps(vertexCount, 0);
+	unsigned int timestamp = cacheSize + 1;
+
+	VertexCacheStatistics statistics = {};
+	for (unsigned int index : indices)
+	{
+		if (timestamp - cacheTimestamps[index] > cacheSize)
+		{
+			cacheTimestamps[index] = timestamp++;
+			++statistics.transformedVertexCount;
+		}
+	}
+
+	size_t triangleCount = indices.size() / 3;
+	statistics.acmr = triangleCount > 0 ? static_cast<float>(statistics.transformedVertexCount) / triangleCount : 0.0f;
+	statistics.atvr = vertexCount > 0 ? static_cast<float>(statistics.transformedVertexCount) / vertexCount : 0.0f;
+	return statistics;
+}
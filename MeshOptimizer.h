@@ -0,0 +1,65 @@
+#pragma once
+#include "pch.h"
+
+#include <vector>
+#include <stdint.h>
+
+// Post-transform vertex cache statistics of an index buffer, measured with a FIFO cache
+struct VertexCacheStatistics
+{
+	unsigned int transformedVertexCount;	// Number of cache misses
+	float acmr;		// Average cache miss ratio - transformed vertices per triangle (0.5 is the best possible, 3 the worst)
+	float atvr;		// Average transformed vertex ratio - transformed vertices per vertex (1 is the best possible)
+};
+
+// MeshOptimizer reorders triangle lists so the GPU does less work drawing them. The passes are meant to be run
+// offline (see ModelCache) and in this order:
+//
+//		OptimizeVertexCache		Reorders triangles so vertices are reused while they are still in the post-transform
+//								cache (Tom Forsyth's "Linear-Speed Vertex Cache Optimisation")
+//		OptimizeOverdraw		Reorders clusters of triangles so the ones facing away from the center of the mesh are
+//								drawn first and occlude the rest, without giving up more than a little cache efficiency
+//								(after Sander, Nehab & Barczak, "Fast Triangle Reordering for Vertex Locality and
+//								Reduced Overdraw")
+//		OptimizeVertexFetch		Reorders the vertices into the order they are first used, so the vertex fetch reads
+//								memory sequentially, and drops vertices that are never used
+//
+// The vertex cache pass is Forsyth's rather than Tipsify (from the same paper as the overdraw pass) even though
+// Tipsify is faster. Tipsify optimizes for one given cache size and falls off quickly on hardware whose cache
+// differs from it, while Forsyth's scores only depend on how recently a vertex was used and hold up across cache
+// sizes - the passes run offline, so the cache of the GPU the model is drawn on is not known. tools/MeshStatistics
+// reports the ACMR / ATVR of every mesh of a model after each pass for any cache size.
+class MeshOptimizer
+{
+public:
+	static void OptimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount);
+
+	// positions points at the first position, positionStride is the distance in bytes between two positions. The
+	// new order is only kept if it has an ACMR no higher than threshold times the ACMR of the current order
+	static void OptimizeOverdraw(std::vector<unsigned int>& indices, const DirectX::XMFLOAT3* positions, size_t positionStride,
+		size_t vertexCount, float threshold = 1.05f);
+
+	// Remaps the indices and returns the new vertex order: new vertex n is old vertex remap[n]
+	static std::vector<unsigned int> OptimizeVertexFetch(std::vector<unsigned int>& indices, size_t vertexCount);
+
+	template <typename T>
+	static void OptimizeVertexFetch(std::vector<T>& vertices, std::vector<unsigned int>& indices);
+
+	static VertexCacheStatistics AnalyzeVertexCache(const std::vector<unsigned int>& indices, size_t vertexCount, unsigned int cacheSize = 16);
+
+private:
+	MeshOptimizer() {} // Disallow creation of a MeshOptimizer object
+};
+
+template <typename T>
+void MeshOptimizer::OptimizeVertexFetch(std::vector<T>& vertices, std::vector<unsigned int>& indices)
+{
+	std::vector<unsigned int> remap = OptimizeVertexFetch(indices, vertices.size());
+
+	std::vector<T> reordered;
+	reordered.reserve(remap.size());
+	for (unsigned int oldIndex : remap)
+		reordered.push_back(vertices[oldIndex]);
+
+	vertices.swap(reordered);
+}
@@ -0,0 +1,370 @@
+#include "ModelCache.h"
+
+using DirectX::XMFLOAT2;
+using DirectX::XMFLOAT3;
+using DirectX::XMFLOAT4;
+using DirectX::XMFLOAT4X4;
+using DirectX::XMMATRIX;
+using DirectX::XMVECTOR;
+
+ModelCache::ModelCache(const std::string& filename) :
+	m_header(nullptr)
+{
+	std::ostringstream oss;
+
+	m_file = std::make_unique<MemoryMappedFile>(filename);
+
+	if (m_file->Size() < sizeof(HeaderType))
+	{
+		oss << "File is too small to be a cooked model file: " << filename;
+		throw ModelCacheException(__LINE__, __FILE__, oss.str());
+	}
+
+	m_header = reinterpret_cast<const HeaderType*>(m_file->Data());
+
+	if (std::string(m_header->magic, 4) != "CMDL" || m_header->version != VERSION || m_header->vertexSize != sizeof(OBJVertex))
+	{
+		oss << "File is not a cooked model file of the current version: " << filename;
+		throw ModelCacheException(__LINE__, __FILE__, oss.str());
+	}
+
+	// Make sure every section lies inside the file before anything is read from it
+	auto SectionFits = [this](uint64_t offset, uint64_t count, uint64_t elementSize)
+	{
+		return offset <= m_file->Size() && count <= (m_file->Size() - offset) / elementSize;
+	};
+
+	if (m_header->fileSize != m_file->Size() || m_header->nodeCount == 0 ||
+		!SectionFits(m_header->nodesOffset, m_header->nodeCount, sizeof(NodeType)) ||
+		!SectionFits(m_header->childrenOffset, m_header->childCount, sizeof(uint32_t)) ||
+		!SectionFits(m_header->meshesOffset, m_header->meshCount, sizeof(MeshType)) ||
+		!SectionFits(m_header->materialsOffset, m_header->materialCount, sizeof(MaterialType)) ||
+		!SectionFits(m_header->verticesOffset, m_header->vertexCount, sizeof(OBJVertex)) ||
+		!SectionFits(m_header->indicesOffset, m_header->indicesSize, 1) ||
+		!SectionFits(m_header->stringsOffset, m_header->stringsSize, 1))
+	{
+		oss << "Cooked model file is truncated or corrupt: " << filename;
+		throw ModelCacheException(__LINE__, __FILE__, oss.str());
+	}
+
+	// Drawable walks the hierarchy and the meshes without checking anything, so every reference has to be valid.
+	// Children always come after their parent, which also rules out cycles
+	auto StringFits = [this](const StringType& string)
+	{
+		return string.offset <= m_header->stringsSize && string.length <= m_header->stringsSize - string.offset;
+	};
+
+	bool valid = true;
+	for (int iii = 0; valid && iii < NodeCount(); ++iii)
+	{
+		const NodeType& node = GetNode(iii);
+		valid = StringFits(node.name) && node.mesh >= -1 && node.mesh < MeshCount() &&
+			node.firstChild <= m_header->childCount && node.childCount <= m_header->childCount - node.firstChild;
+
+		for (uint32_t jjj = 0; valid && jjj < node.childCount; ++jjj)
+		{
+			int child = GetChild(node, jjj);
+			valid = child > iii && child < NodeCount();
+		}
+	}
+
+	for (int iii = 0; valid && iii < MeshCount(); ++iii)
+	{
+		const MeshType& mesh = GetMesh(iii);
+		valid = StringFits(mesh.name) && mesh.materialIndex < m_header->materialCount &&
+			mesh.firstVertex <= m_header->vertexCount && mesh.vertexCount <= m_header->vertexCount - mesh.firstVertex &&
+			(mesh.indexSize == sizeof(uint16_t) || mesh.indexSize == sizeof(uint32_t)) && (mesh.indexOffset % mesh.indexSize) == 0 &&
+			mesh.indexOffset <= m_header->indicesSize && mesh.indexCount <= (m_header->indicesSize - mesh.indexOffset) / mesh.indexSize;
+
+		if (valid && mesh.indexSize == sizeof(uint16_t))
+		{
+			const uint16_t* indices = GetIndices<uint16_t>(mesh);
+			for (uint32_t jjj = 0; valid && jjj < mesh.indexCount; ++jjj)
+				valid = indices[jjj] < mesh.vertexCount;
+		}
+		else if (valid)
+		{
+			const uint32_t* indices = GetIndices<uint32_t>(mesh);
+			for (uint32_t jjj = 0; valid && jjj < mesh.indexCount; ++jjj)
+				valid = indices[jjj] < mesh.vertexCount;
+		}
+	}
+
+	for (int iii = 0; valid && iii < MaterialCount(); ++iii)
+	{
+		const MaterialType& material = GetMaterial(iii);
+		valid = StringFits(material.diffuseTexture) && StringFits(material.specularTexture) && StringFits(material.normalTexture);
+	}
+
+	if (!valid)
+	{
+		oss << "Cooked model file is corrupt: " << filename;
+		throw ModelCacheException(__LINE__, __FILE__, oss.str());
+	}
+}
+
+ModelCacheKey ModelCache::CreateKey(const std::string& sourceFilename)
+{
+	ModelCacheKey key = {};
+	key.sourceSize = static_cast<uint64_t>(std::filesystem::file_size(sourceFilename));
+	key.sourceWriteTime = static_cast<int64_t>(std::filesystem::last_write_time(sourceFilename).time_since_epoch().count());
+	return key;
+}
+
+bool ModelCache::Matches(const ModelCacheKey& key) const
+{
+	const ModelCacheKey& cooked = m_header->key;
+	return cooked.sourceSize == key.sourceSize &&
+		cooked.sourceWriteTime == key.sourceWriteTime;
+}
+
+int ModelCache::GetChild(const NodeType& node, int index) const
+{
+	const uint32_t* children = reinterpret_cast<const uint32_t*>(m_file->Data() + m_header->childrenOffset);
+	return static_cast<int>(children[node.firstChild + index]);
+}
+
+const OBJVertex* ModelCache::GetVertices(const MeshType& mesh) const
+{
+	return reinterpret_cast<const OBJVertex*>(m_file->Data() + m_header->verticesOffset) + mesh.firstVertex;
+}
+
+std::string_view ModelCache::GetString(const StringType& string) const
+{
+	return std::string_view(reinterpret_cast<const char*>(m_file->Data() + m_header->stringsOffset) + string.offset, string.length);
+}
+
+void ModelCache::ConvertMesh(const aiMesh& mesh, std::vector<OBJVertex>& vertices, std::vector<unsigned int>& indices)
+{
+	vertices.clear();
+	vertices.reserve(mesh.mNumVertices);
+	for (unsigned int iii = 0; iii < mesh.mNumVertices; iii++)
+	{
+		vertices.push_back(
+			{
+				*reinterpret_cast<XMFLOAT3*>(&mesh.mVertices[iii]),
+				*reinterpret_cast<XMFLOAT2*>(&mesh.mTextureCoords[0][iii]), // Use texture at index 0, but there can be >1 texture
+				*reinterpret_cast<XMFLOAT3*>(&mesh.mNormals[iii]),
+				XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f)
+			}
+		);
+
+		// The V coordinate is stupidly flipped - Not sure how to tell when this is needed
+		vertices.back().texture.y = 1 - vertices.back().texture.y;
+	}
+
+	indices.clear();
+	indices.reserve(mesh.mNumFaces * 3);
+	for (unsigned int i = 0; i < mesh.mNumFaces; i++)
+	{
+		const aiFace& face = mesh.mFaces[i];
+		assert(face.mNumIndices == 3);
+		indices.push_back(face.mIndices[0]);
+		indices.push_back(face.mIndices[1]);
+		indices.push_back(face.mIndices[2]);
+	}
+
+	// Computed here rather than by Assimp's aiProcess_CalcTangentSpace so that Assimp and glTF models get the
+	// same tangents
+	TangentSpace::Generate(vertices, indices, ThreadPool::Default());
+}
+
+void ModelCache::Write(const std::string& filename, const ModelCacheKey& key, const aiScene& scene, bool optimizeMeshes)
+{
+	std::ostringstream oss;
+
+	std::vector<NodeType> nodes;
+	std::vector<uint32_t> children;
+	std::vector<MeshType> meshes;
+	std::vector<MaterialType> materials;
+	std::vector<OBJVertex> vertices;
+	std::vector<uint8_t> indices;
+	std::string strings;
+
+	auto AddString = [&strings](const char* string, size_t length) -> StringType
+	{
+		StringType result = { static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(length) };
+		strings.append(string, length);
+		return result;
+	};
+
+	// Depth first, so the root is node 0 and children always come after their parent. A node's children are only
+	// added to the children table once all of their own descendants have been added, so each run stays contiguous
+	std::function<uint32_t(const aiNode&)> AddNode = [&](const aiNode& node) -> uint32_t
+	{
+		uint32_t index = static_cast<uint32_t>(nodes.size());
+		nodes.push_back({});
+
+		NodeType& cooked = nodes.back();
+		cooked.name = AddString(node.mName.C_Str(), node.mName.length);
+		cooked.mesh = node.mNumMeshes > 0 ? static_cast<int32_t>(node.mMeshes[0]) : -1;
+
+		// Stored exactly as Drawable::ConstructFromAiNode decomposes it
+		XMMATRIX transform = DirectX::XMMatrixTranspose(
+			DirectX::XMLoadFloat4x4(reinterpret_cast<const XMFLOAT4X4*>(&node.mTransformation))
+		);
+		XMVECTOR scale, rotation, translation;
+		DirectX::XMMatrixDecompose(&scale, &rotation, &translation, transform);
+
+		DirectX::XMStoreFloat3(&cooked.scaling, scale);
+		DirectX::XMStoreFloat3(&cooked.rotation, rotation);
+		DirectX::XMStoreFloat3(&cooked.translation, translation);
+
+		std::vector<uint32_t> childIndices;
+		for (unsigned int iii = 0; iii < node.mNumChildren; ++iii)
+			childIndices.push_back(AddNode(*node.mChildren[iii]));
+
+		nodes[index].firstChild = static_cast<uint32_t>(children.size());
+		nodes[index].childCount = static_cast<uint32_t>(childIndices.size());
+		children.insert(children.end(), childIndices.begin(), childIndices.end());
+
+		return index;
+	};
+
+	AddNode(*scene.mRootNode);
+
+#ifndef NDEBUG
+	std::ostringstream statistics;
+	statistics << "Cooking " << filename << " (ACMR / ATVR with a 16 entry FIFO cache):" << std::endl;
+#endif
+
+	std::vector<OBJVertex> meshVertices;
+	std::vector<unsigned int> meshIndices;
+	for (unsigned int iii = 0; iii < scene.mNumMeshes; ++iii)
+	{
+		const aiMesh& mesh = *scene.mMeshes[iii];
+		ConvertMesh(mesh, meshVertices, meshIndices);
+
+#ifndef NDEBUG
+		VertexCacheStatistics before = MeshOptimizer::AnalyzeVertexCache(meshIndices, meshVertices.size());
+#endif
+
+		if (optimizeMeshes && !meshVertices.empty())
+		{
+			MeshOptimizer::OptimizeVertexCache(meshIndices, meshVertices.size());
+			MeshOptimizer::OptimizeOverdraw(meshIndices, &meshVertices[0].position, sizeof(OBJVertex), meshVertices.size());
+			MeshOptimizer::OptimizeVertexFetch(meshVertices, meshIndices);
+		}
+
+#ifndef NDEBUG
+		VertexCacheStatistics after = MeshOptimizer::AnalyzeVertexCache(meshIndices, meshVertices.size());
+		statistics << "    " << mesh.mName.C_Str() << ": " << meshVertices.size() << " vertices, " << meshIndices.size() / 3 << " triangles, "
+			<< before.acmr << " / " << before.atvr << " -> " << after.acmr << " / " << after.atvr << std::endl;
+#endif
+
+		MeshType cooked = {};
+		cooked.name = AddString(mesh.mName.C_Str(), mesh.mName.length);
+		cooked.materialIndex = mesh.mMaterialIndex;
+		cooked.firstVertex = static_cast<uint32_t>(vertices.size());
+		cooked.vertexCount = static_cast<uint32_t>(meshVertices.size());
+		cooked.indexSize = meshVertices.size() <= 0x10000 ? sizeof(uint16_t) : sizeof(uint32_t);
+		cooked.indexOffset = static_cast<uint32_t>(indices.size());
+		cooked.indexCount = static_cast<uint32_t>(meshIndices.size());
+
+		cooked.boundsMin = XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX);
+		cooked.boundsMax = XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+		for (const OBJVertex& vertex : meshVertices)
+		{
+			cooked.boundsMin.x = std::min(cooked.boundsMin.x, vertex.position.x);
+			cooked.boundsMin.y = std::min(cooked.boundsMin.y, vertex.position.y);
+			cooked.boundsMin.z = std::min(cooked.boundsMin.z, vertex.position.z);
+			cooked.boundsMax.x = std::max(cooked.boundsMax.x, vertex.position.x);
+			cooked.boundsMax.y = std::max(cooked.boundsMax.y, vertex.position.y);
+			cooked.boundsMax.z = std::max(cooked.boundsMax.z, vertex.position.z);
+		}
+
+		meshes.push_back(cooked);
+		vertices.insert(vertices.end(), meshVertices.begin(), meshVertices.end());
+
+		// Every block starts 4-byte aligned so 32-bit indices can be read in place
+		indices.resize(cooked.indexOffset + (static_cast<size_t>(cooked.indexCount) * cooked.indexSize));
+		if (cooked.indexSize == sizeof(uint16_t))
+		{
+			uint16_t* out = reinterpret_cast<uint16_t*>(&indices[cooked.indexOffset]);
+			for (unsigned int index : meshIndices)
+				*out++ = static_cast<uint16_t>(index);
+		}
+		else
+			memcpy(&indices[cooked.indexOffset], meshIndices.data(), meshIndices.size() * sizeof(uint32_t));
+
+		indices.resize((indices.size() + 3) & ~static_cast<size_t>(3));
+	}
+
+#ifndef NDEBUG
+	OutputDebugStringA(statistics.str().c_str());
+#endif
+
+	// Only the texture types Drawable::ConstructFromAiNode supports are stored - a model that uses any other type
+	// fails to load before it is ever cooked
+	auto AddTexture = [&AddString](const aiMaterial& material, aiTextureType type) -> StringType
+	{
+		aiString textureFileName;
+		if (material.GetTexture(type, 0, &textureFileName) != aiReturn_SUCCESS)
+			return { 0, 0 };
+		return AddString(textureFileName.C_Str(), textureFileName.length);
+	};
+
+	for (unsigned int iii = 0; iii < scene.mNumMaterials; ++iii)
+	{
+		const aiMaterial& material = *scene.mMaterials[iii];
+
+		MaterialType cooked = {};
+		cooked.diffuseTexture = AddTexture(material, aiTextureType_DIFFUSE);
+		cooked.specularTexture = AddTexture(material, aiTextureType_SPECULAR);
+		cooked.normalTexture = AddTexture(material, aiTextureType_HEIGHT);
+		materials.push_back(cooked);
+	}
+
+	// Zero the whole header so that padding bytes are deterministic
+	HeaderType header;
+	ZeroMemory(&header, sizeof(HeaderType));
+	memcpy(header.magic, "CMDL", 4);
+	header.version = VERSION;
+	header.vertexSize = sizeof(OBJVertex);
+	header.nodeCount = static_cast<uint32_t>(nodes.size());
+	header.childCount = static_cast<uint32_t>(children.size());
+	header.meshCount = static_cast<uint32_t>(meshes.size());
+	header.materialCount = static_cast<uint32_t>(materials.size());
+	header.vertexCount = static_cast<uint32_t>(vertices.size());
+	header.indicesSize = static_cast<uint32_t>(indices.size());
+	header.stringsSize = static_cast<uint32_t>(strings.size());
+	header.key = key;
+	header.nodesOffset = sizeof(HeaderType);
+	header.childrenOffset = header.nodesOffset + (nodes.size() * sizeof(NodeType));
+	header.meshesOffset = header.childrenOffset + (children.size() * sizeof(uint32_t));
+	header.materialsOffset = header.meshesOffset + (meshes.size() * sizeof(MeshType));
+	header.verticesOffset = header.materialsOffset + (materials.size() * sizeof(MaterialType));
+	header.indicesOffset = header.verticesOffset + (vertices.size() * sizeof(OBJVertex));
+	header.stringsOffset = header.indicesOffset + indices.size();
+	header.fileSize = header.stringsOffset + strings.size();
+
+	std::string temporaryFilename = filename + ".tmp";
+	std::ofstream fout(temporaryFilename, std::ios::binary | std::ios::trunc);
+	if (!fout)
+	{
+		oss << "Failed to open file for writing: " << temporaryFilename;
+		throw ModelCacheException(__LINE__, __FILE__, oss.str());
+	}
+
+	fout.write(reinterpret_cast<const char*>(&header), sizeof(HeaderType));
+	fout.write(reinterpret_cast<const char*>(nodes.data()), sizeof(NodeType) * nodes.size());
+	fout.write(reinterpret_cast<const char*>(children.data()), sizeof(uint32_t) * children.size());
+	fout.write(reinterpret_cast<const char*>(meshes.data()), sizeof(MeshType) * meshes.size());
+	fout.write(reinterpret_cast<const char*>(materials.data()), sizeof(MaterialType) * materials.size());
+	fout.write(reinterpret_cast<const char*>(vertices.data()), sizeof(OBJVertex) * vertices.size());
+	fout.write(reinterpret_cast<const char*>(indices.data()), indices.size());
+	fout.write(strings.data(), strings.size());
+	fout.close();
+
+	if (!fout)
+	{
+		oss << "Failed to write cooked model file: " << temporaryFilename;
+		throw ModelCacheException(__LINE__, __FILE__, oss.str());
+	}
+
+	if (!MoveFileExA(temporaryFilename.c_str(), filename.c_str(), MOVEFILE_REPLACE_EXISTING))
+	{
+		oss << "Failed to move cooked model file into place: " << filename;
+		throw ModelCacheException(__LINE__, __FILE__, oss.str());
+	}
+}
@@ -0,0 +1,152 @@
+#pragma once
+#include "pch.h"
+#include "ModelCacheException.h"
+#include "MemoryMappedFile.h"
+#include "Mesh.h"
+#include "MeshOptimizer.h"
+#include "TangentSpace.h"
+
+#include <memory>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <functional>
+#include <algorithm>
+#include <stdint.h>
+
+// Assimp
+#include <assimp/scene.h>
+
+// Everything a cooked model depends on. A cooked file is only used if all of it matches. The source file is
+// identified by its size and last write time rather than a hash of its contents, so checking a warm start does
+// not have to read the (much larger) source file at all
+struct ModelCacheKey
+{
+	uint64_t sourceSize;
+	int64_t sourceWriteTime;
+};
+
+// ModelCache reads and writes "cooked" models - everything Drawable builds from an Assimp import, laid out so
+// that it can be memory mapped and handed straight to the GPU without running Assimp again:
+//
+//		HeaderType
+//		NodeType		nodes[nodeCount]			(depth first, the root node is node 0)
+//		uint32_t		children[childCount]		(node indices - each node owns a contiguous run)
+//		MeshType		meshes[meshCount]
+//		MaterialType	materials[materialCount]
+//		OBJVertex		vertices[vertexCount]		(one contiguous block per mesh)
+//		uint8_t			indices[indicesSize]		(one 4-byte aligned block of 16 or 32-bit indices per mesh)
+//		char			strings[stringsSize]		(node, mesh and texture names - not null terminated)
+//
+// Meshes are run through MeshOptimizer when they are cooked, and use 16-bit indices whenever they have few enough
+// vertices. Drawable draws the meshes of the import that produced the cooked file as they are, so a model is only
+// drawn optimized from its second load on. The vertex tangents come from TangentSpace. Bump VERSION whenever the
+// layout, any of the stored structures, the optimization passes or the tangent generation change.
+class ModelCache
+{
+public:
+	// 4 - tangents generated with TangentSpace built with /fp:precise
+	// 5 - vertices on mirrored texture seams split before the tangents are generated
+	static constexpr uint32_t VERSION = 5;
+
+	// Offset and length of a name in the string table
+	struct StringType
+	{
+		uint32_t offset;
+		uint32_t length;
+	};
+
+	struct NodeType
+	{
+		StringType name;
+		int32_t mesh;				// -1 if the node does not have a mesh
+		uint32_t firstChild;		// Index into the children table
+		uint32_t childCount;
+		DirectX::XMFLOAT3 scaling;
+		DirectX::XMFLOAT3 rotation;
+		DirectX::XMFLOAT3 translation;
+	};
+
+	struct MeshType
+	{
+		StringType name;
+		uint32_t materialIndex;
+		uint32_t firstVertex;
+		uint32_t vertexCount;
+		uint32_t indexSize;			// 2 or 4 bytes
+		uint32_t indexOffset;		// Byte offset into the indices section
+		uint32_t indexCount;
+		DirectX::XMFLOAT3 boundsMin;
+		DirectX::XMFLOAT3 boundsMax;
+	};
+
+	// Texture names as Assimp reported them. A length of 0 means the material does not have that texture
+	struct MaterialType
+	{
+		StringType diffuseTexture;
+		StringType specularTexture;
+		StringType normalTexture;
+	};
+
+private:
+	struct HeaderType
+	{
+		char magic[4];
+		uint32_t version;
+		uint32_t vertexSize;
+		uint32_t nodeCount;
+		uint32_t childCount;
+		uint32_t meshCount;
+		uint32_t materialCount;
+		uint32_t vertexCount;
+		uint32_t indicesSize;
+		uint32_t stringsSize;
+		ModelCacheKey key;
+		uint64_t nodesOffset;
+		uint64_t childrenOffset;
+		uint64_t meshesOffset;
+		uint64_t materialsOffset;
+		uint64_t verticesOffset;
+		uint64_t indicesOffset;
+		uint64_t stringsOffset;
+		uint64_t fileSize;
+	};
+
+public:
+	// Maps an existing cooked file. Throws ModelCacheException if it is not a valid cooked model file
+	ModelCache(const std::string& filename);
+	ModelCache(const ModelCache&) = delete;
+	ModelCache& operator=(const ModelCache&) = delete;
+
+	static ModelCacheKey CreateKey(const std::string& sourceFilename);
+	bool Matches(const ModelCacheKey& key) const;
+
+	int NodeCount() const { return static_cast<int>(m_header->nodeCount); }
+	int MeshCount() const { return static_cast<int>(m_header->meshCount); }
+	int MaterialCount() const { return static_cast<int>(m_header->materialCount); }
+
+	const NodeType& GetNode(int index) const { return reinterpret_cast<const NodeType*>(m_file->Data() + m_header->nodesOffset)[index]; }
+	int GetChild(const NodeType& node, int index) const;
+	const MeshType& GetMesh(int index) const { return reinterpret_cast<const MeshType*>(m_file->Data() + m_header->meshesOffset)[index]; }
+	const MaterialType& GetMaterial(int index) const { return reinterpret_cast<const MaterialType*>(m_file->Data() + m_header->materialsOffset)[index]; }
+	const OBJVertex* GetVertices(const MeshType& mesh) const;
+	template <typename I>
+	const I* GetIndices(const MeshType& mesh) const { return reinterpret_cast<const I*>(m_file->Data() + m_header->indicesOffset + mesh.indexOffset); }
+	std::string_view GetString(const StringType& string) const;
+
+	// Builds the vertices and indices Drawable uses for an Assimp mesh. Shared with Drawable::LoadMesh so a
+	// cooked mesh has the same triangles as a direct import
+	static void ConvertMesh(const aiMesh& mesh, std::vector<OBJVertex>& vertices, std::vector<unsigned int>& indices);
+
+	// Writes a cooked file for the imported scene. The file is written under a temporary name first and then
+	// moved into place so a partially written file is never picked up. Debug builds report the vertex cache
+	// statistics of every mesh before and after optimization to the debugger output
+	static void Write(const std::string& filename, const ModelCacheKey& key, const aiScene& scene, bool optimizeMeshes = true);
+
+private:
+	std::unique_ptr<MemoryMappedFile> m_file;
+	const HeaderType* m_header;
+};
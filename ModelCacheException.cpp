@@ -0,0 +1,28 @@
+#include "ModelCacheException.h"
+
+ModelCacheException::ModelCacheException(int line, const char* file, std::string description) noexcept :
+	ChameleonException(line, file)
+{
+	m_info = description;
+}
+
+
+const char* ModelCacheException::what() const noexcept
+{
+	std::ostringstream oss;
+	oss << GetType() << std::endl
+		<< "\n[Error Info]\n" << GetErrorInfo() << std::endl << std::endl;
+	oss << GetOriginString();
+	m_whatBuffer = oss.str();
+	return m_whatBuffer.c_str();
+}
+
+const char* ModelCacheException::GetType() const noexcept
+{
+	return "Model Cache Exception";
+}
+
+std::string ModelCacheException::GetErrorInfo() const noexcept
+{
+	return m_info;
+}
\ No newline at end of file
@@ -37,6 +37,7 @@ public:
 	DirectX::XMVECTOR Position() { return m_eyeVec; }
 
 	void SetPlayer(std::shared_ptr<Player> player);
+	std::shared_ptr<Player> GetPlayer() { return m_player; }
 	void SetTerrain(std::shared_ptr<Terrain> terrain) { m_terrain = terrain; }
 
 	// Allow Player to be manually released so as to not leak resources on shutdown
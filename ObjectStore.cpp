@@ -1,29 +1,40 @@
 #include "ObjectStore.h"
 
 std::shared_ptr<DeviceResources> ObjectStore::m_deviceResources = nullptr;
+uint64_t ObjectStore::m_frame = 0;
 
-std::map<std::string, std::shared_ptr<ConstantBuffer>>		ObjectStore::m_constantBufferMap;
-std::map<std::string, std::shared_ptr<SamplerState>>		ObjectStore::m_sampleStateMap;
-std::map<std::string, std::shared_ptr<TerrainMesh>>			ObjectStore::m_terrainMeshMap;
-std::map<std::string, std::shared_ptr<Mesh>>				ObjectStore::m_meshMap;
-std::map<std::string, std::shared_ptr<Texture>>				ObjectStore::m_textureMap;
-std::map<std::string, std::shared_ptr<Bindable>>			ObjectStore::m_bindablesMap;
+ResourceRegistry<ConstantBuffer>	ObjectStore::m_constantBuffers("constant buffers");
+ResourceRegistry<SamplerState>		ObjectStore::m_samplerStates("sampler states");
+ResourceRegistry<TerrainMesh>		ObjectStore::m_terrainMeshes("terrain meshes");
+ResourceRegistry<Mesh>				ObjectStore::m_meshes("meshes");
+ResourceRegistry<Texture>			ObjectStore::m_textures("textures");
+ResourceRegistry<Bindable>			ObjectStore::m_bindables("bindables");
 
 
 
 void ObjectStore::Initialize(std::shared_ptr<DeviceResources> deviceResources)
 {
 	m_deviceResources = deviceResources;
+
+	m_textures.SetSizeFunction([](const Texture& texture) { return texture.SizeInBytes(); });
+	m_meshes.SetSizeFunction([](const Mesh& mesh) { return mesh.SizeInBytes(); });
+}
+
+void ObjectStore::Update()
+{
+	++m_frame;
+	m_textures.Update(m_frame);
+	m_meshes.Update(m_frame);
 }
 
 void ObjectStore::DestructObjects()
 {
 	m_deviceResources = nullptr;
 
-	m_terrainMeshMap.clear();
-	m_meshMap.clear();
-	m_textureMap.clear();
-	m_constantBufferMap.clear();
-	m_bindablesMap.clear();
-	m_sampleStateMap.clear();
+	m_terrainMeshes.Clear();
+	m_meshes.Clear();
+	m_textures.Clear();
+	m_constantBuffers.Clear();
+	m_bindables.Clear();
+	m_samplerStates.Clear();
 }
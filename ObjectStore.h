@@ -18,18 +18,29 @@
 #include "TextureArray.h"
 #include "Bindable.h"
 
+#include "ResourceRegistry.h"
+
 #include <memory>
 #include <string>
-#include <map>
-
-#ifndef NDEBUG
-#define MAP_LOOKUP(map, key) if (map.find(key) != map.end()) {return map[key];} else {throw ObjectStoreInvalidKeyException(__LINE__, __FILE__, #map, key);} 
-#else
-#define MAP_LOOKUP(map, key) return map[key];
-#endif
+#include <string_view>
 
 
 // ObjectStore is intended to be a static class
+//
+// Every kind of resource lives in its own ResourceRegistry. The string functions are kept for loading and setup
+// code - anything that runs every frame should look the name up once with one of the Find functions and hold on
+// to the handle instead.
+//
+// Textures and meshes added with a reload function are counted against a memory budget. Update (called once per
+// frame) evicts the least recently used ones that no Drawable holds on to any more, and Get transparently reloads
+// them from their source file the next time they are asked for.
+
+using MeshHandle = ResourceHandle<Mesh>;
+using TerrainMeshHandle = ResourceHandle<TerrainMesh>;
+using TextureHandle = ResourceHandle<Texture>;
+using ConstantBufferHandle = ResourceHandle<ConstantBuffer>;
+using SamplerStateHandle = ResourceHandle<SamplerState>;
+using BindableHandle = ResourceHandle<Bindable>;
 
 class ObjectStore
 {
@@ -37,34 +48,62 @@ public:
 	static void Initialize(std::shared_ptr<DeviceResources> deviceResources);
 	static void DestructObjects();
 
+	// Stamps the start of a new frame and evicts whatever does not fit in the budgets
+	static void Update();
+
+	static void SetTextureBudget(size_t bytes) { m_textures.SetBudget(bytes); }
+	static void SetMeshBudget(size_t bytes) { m_meshes.SetBudget(bytes); }
+	static const ResidencyStatistics& GetTextureStatistics() { return m_textures.Statistics(); }
+	static const ResidencyStatistics& GetMeshStatistics() { return m_meshes.Statistics(); }
+
+
+	static TextureHandle AddTexture(std::string_view lookupName, std::shared_ptr<Texture> texture, ResourceRegistry<Texture>::ReloadFunction reload = nullptr) { return m_textures.Add(lookupName, texture, reload); }
+	static ConstantBufferHandle AddConstantBuffer(std::string_view lookupName, std::shared_ptr<ConstantBuffer> constantBuffer) { return m_constantBuffers.Add(lookupName, constantBuffer); }
+	static SamplerStateHandle AddSamplerState(std::string_view lookupName, std::shared_ptr<SamplerState> samplerState) { return m_samplerStates.Add(lookupName, samplerState); }
+	static MeshHandle AddMesh(std::string_view lookupName, std::shared_ptr<Mesh> mesh, ResourceRegistry<Mesh>::ReloadFunction reload = nullptr) { return m_meshes.Add(lookupName, mesh, reload); }
+	static TerrainMeshHandle AddTerrainMesh(std::shared_ptr<TerrainMesh> terrainMesh, std::string_view lookupName) { return m_terrainMeshes.Add(lookupName, terrainMesh); }
+	static BindableHandle AddBindable(std::string_view lookupName, std::shared_ptr<Bindable> bindable) { return m_bindables.Add(lookupName, bindable); }
+
+
+	static MeshHandle FindMesh(std::string_view lookupName) { return m_meshes.Find(lookupName); }
+	static ConstantBufferHandle FindConstantBuffer(std::string_view lookupName) { return m_constantBuffers.Find(lookupName); }
+	static SamplerStateHandle FindSamplerState(std::string_view lookupName) { return m_samplerStates.Find(lookupName); }
+	static TextureHandle FindTexture(std::string_view lookupName) { return m_textures.Find(lookupName); }
+	static TerrainMeshHandle FindTerrainMesh(std::string_view lookupName) { return m_terrainMeshes.Find(lookupName); }
+	static BindableHandle FindBindable(std::string_view lookupName) { return m_bindables.Find(lookupName); }
+
 
-	static void AddTexture(std::string lookupName, std::shared_ptr<Texture> texture) { m_textureMap.insert(std::pair(lookupName, texture)); }
-	static void AddConstantBuffer(std::string lookupName, std::shared_ptr<ConstantBuffer> constantBuffer) { m_constantBufferMap.insert(std::pair(lookupName, constantBuffer)); }
-	static void AddSamplerState(std::string lookupName, std::shared_ptr<SamplerState> samplerState) { m_sampleStateMap.insert(std::pair(lookupName, samplerState)); }
-	static void AddMesh(std::string lookupName, std::shared_ptr<Mesh> mesh) { m_meshMap.insert(std::pair(lookupName, mesh)); }
-	static void AddTerrainMesh(std::shared_ptr<TerrainMesh> terrainMesh, std::string lookupName) { m_terrainMeshMap.insert(std::pair(lookupName, terrainMesh)); }
-	static void AddBindable(std::string lookupName, std::shared_ptr<Bindable> bindable) { m_bindablesMap.insert(std::pair(lookupName, bindable)); }
+	static const std::shared_ptr<Mesh>& GetMesh(MeshHandle handle) { return m_meshes.Get(handle); }
+	static const std::shared_ptr<ConstantBuffer>& GetConstantBuffer(ConstantBufferHandle handle) { return m_constantBuffers.Get(handle); }
+	static const std::shared_ptr<SamplerState>& GetSamplerState(SamplerStateHandle handle) { return m_samplerStates.Get(handle); }
+	static const std::shared_ptr<Texture>& GetTexture(TextureHandle handle) { return m_textures.Get(handle); }
+	static const std::shared_ptr<TerrainMesh>& GetTerrainMesh(TerrainMeshHandle handle) { return m_terrainMeshes.Get(handle); }
+	static const std::shared_ptr<Bindable>& GetBindable(BindableHandle handle) { return m_bindables.Get(handle); }
 
+	static std::shared_ptr<Mesh> GetMesh(std::string_view lookupName) { return m_meshes.Get(lookupName); }
+	static std::shared_ptr<ConstantBuffer> GetConstantBuffer(std::string_view lookupName) { return m_constantBuffers.Get(lookupName); }
+	static std::shared_ptr<SamplerState> GetSamplerState(std::string_view lookupName) { return m_samplerStates.Get(lookupName); }
+	static std::shared_ptr<Texture> GetTexture(std::string_view lookupName) { return m_textures.Get(lookupName); }
+	static std::shared_ptr<TerrainMesh> GetTerrainMesh(std::string_view lookupName) { return m_terrainMeshes.Get(lookupName); }
+	static std::shared_ptr<Bindable> GetBindable(std::string_view lookupName) { return m_bindables.Get(lookupName); }
 
-	static std::shared_ptr<Mesh> GetMesh(std::string lookupName) { MAP_LOOKUP(m_meshMap, lookupName); }
-	static std::shared_ptr<ConstantBuffer> GetConstantBuffer(std::string lookupName) { MAP_LOOKUP(m_constantBufferMap, lookupName); }
-	static std::shared_ptr<SamplerState> GetSamplerState(std::string lookupName) { MAP_LOOKUP(m_sampleStateMap, lookupName); }
-	static std::shared_ptr<Texture> GetTexture(std::string lookupName) { MAP_LOOKUP(m_textureMap, lookupName); }
-	static std::shared_ptr<TerrainMesh> GetTerrainMesh(std::string lookupName) { MAP_LOOKUP(m_terrainMeshMap, lookupName); }
-	static std::shared_ptr<Bindable> GetBindable(std::string lookupName) { MAP_LOOKUP(m_bindablesMap, lookupName); }
+	static bool MeshExists(std::string_view lookupName) { return m_meshes.Exists(lookupName); }
+	static bool BindableExists(BindableHandle handle) { return m_bindables.Exists(handle); }
 
-	static bool MeshExists(std::string lookupName) { return m_meshMap.find(lookupName) != m_meshMap.end(); }
+	// For AssetLoader, which adds the textures it loads with itself as their reload source
+	static ResourceRegistry<Texture>& GetTextureRegistry() { return m_textures; }
 
 private:
 	ObjectStore() {} // Disallow creation of an ObjectStore object
 
 	static std::shared_ptr<DeviceResources> m_deviceResources;
+	static uint64_t m_frame;
 	
-	static std::map<std::string, std::shared_ptr<ConstantBuffer>>	m_constantBufferMap;
-	static std::map<std::string, std::shared_ptr<Texture>>			m_textureMap;
-	static std::map<std::string, std::shared_ptr<SamplerState>>		m_sampleStateMap;
-	static std::map<std::string, std::shared_ptr<TerrainMesh>>		m_terrainMeshMap;
-	static std::map<std::string, std::shared_ptr<Mesh>>				m_meshMap;
-	static std::map<std::string, std::shared_ptr<Bindable>>			m_bindablesMap;
+	static ResourceRegistry<ConstantBuffer>	m_constantBuffers;
+	static ResourceRegistry<Texture>		m_textures;
+	static ResourceRegistry<SamplerState>	m_samplerStates;
+	static ResourceRegistry<TerrainMesh>	m_terrainMeshes;
+	static ResourceRegistry<Mesh>			m_meshes;
+	static ResourceRegistry<Bindable>		m_bindables;
 
 };
@@ -0,0 +1,47 @@
+// Instanced variant of PhongVertexShader. The model/view/projection matrices come from the instance buffer in
+// input slot 1 instead of the constant buffer at slot 0 - each row of a matrix is its own element (see
+// InstanceBuffer), so the matrices are rebuilt from rows and multiplied on the right
+
+
+struct VertexShaderInput
+{
+	float3 position : POSITION;
+	float3 normal : NORMAL;
+
+	// Per instance
+	float4 model0 : MODEL0;
+	float4 model1 : MODEL1;
+	float4 model2 : MODEL2;
+	float4 model3 : MODEL3;
+	float4 modelViewProjection0 : MODELVIEWPROJECTION0;
+	float4 modelViewProjection1 : MODELVIEWPROJECTION1;
+	float4 modelViewProjection2 : MODELVIEWPROJECTION2;
+	float4 modelViewProjection3 : MODELVIEWPROJECTION3;
+	float3 inverseTransposeModel0 : INVERSETRANSPOSEMODEL0;
+	float3 inverseTransposeModel1 : INVERSETRANSPOSEMODEL1;
+	float3 inverseTransposeModel2 : INVERSETRANSPOSEMODEL2;
+};
+
+struct PixelShaderInput
+{
+	float4 position : SV_POSITION;
+	float4 positionWS : POS_WS;
+	float3 normalWS : NORM_WS;
+};
+
+
+PixelShaderInput main(VertexShaderInput input)
+{
+	float4x4 model = float4x4(input.model0, input.model1, input.model2, input.model3);
+	float4x4 modelViewProjection = float4x4(input.modelViewProjection0, input.modelViewProjection1, input.modelViewProjection2, input.modelViewProjection3);
+	float3x3 inverseTransposeModel = float3x3(input.inverseTransposeModel0, input.inverseTransposeModel1, input.inverseTransposeModel2);
+
+	PixelShaderInput output;
+	float4 position = float4(input.position, 1.0f);
+
+	output.position = mul(position, modelViewProjection);                 // Screen position
+	output.positionWS = mul(position, model);                               // World space position
+	output.normalWS = mul(input.normal, inverseTransposeModel);             // compute the world space normal
+
+	return output;
+}
@@ -13,6 +13,7 @@ struct PixelShaderInput
     float4 positionWS : POS_WS;
     float3 normalWS : NORM_WS;
     float2 tex : TEXCOORD0;
+    float4 tangentWS : TAN_WS;
 };
 
 // Constant Buffer ===========================================================================================
@@ -170,15 +171,22 @@ float4 main(PixelShaderInput input) : SV_TARGET
     
     if (normalMapEnabled)
     {
-        const float3 normalSample = normalTexture.Sample(splr, input.tex).xyz;
-        //input.normalWS = normalSample;
-        
-        input.normalWS.x = normalSample.x * 2.0f - 1.0f;
-        input.normalWS.y = -normalSample.y * 2.0f + 1.0f;
-        input.normalWS.z = normalSample.z * 2.0f - 1.0f;       
-        
-        float3 normal = mul((float3x3) inverseTransposeModel, input.normalWS);
-        
+        // Only x and y are read - cooked normal maps are BC5 compressed and do not store z. The normals point
+        // out of the surface, so z is always the positive root
+        const float2 normalSample = normalTexture.Sample(splr, input.tex).xy;
+
+        float3 tangentSpaceNormal;
+        tangentSpaceNormal.x = normalSample.x * 2.0f - 1.0f;
+        tangentSpaceNormal.y = -normalSample.y * 2.0f + 1.0f;
+        tangentSpaceNormal.z = sqrt(saturate(1.0f - dot(tangentSpaceNormal.xy, tangentSpaceNormal.xy)));
+
+        // Rebuild the tangent frame - the bitangent points along increasing v, which is why y is flipped above
+        const float3 normalWS = normalize(input.normalWS);
+        const float3 tangentWS = normalize(input.tangentWS.xyz - normalWS * dot(input.tangentWS.xyz, normalWS));
+        const float3 bitangentWS = cross(normalWS, tangentWS) * input.tangentWS.w;
+
+        float3 normal = tangentSpaceNormal.x * tangentWS + tangentSpaceNormal.y * bitangentWS + tangentSpaceNormal.z * normalWS;
+
         lit = ComputeLighting(input.positionWS, normalize(normal), input.tex);
     }
     else
@@ -6,6 +6,7 @@ struct VertexShaderInput
     float3 position : POSITION;
     float2 tex : TEXCOORD0;
     float3 normal : NORMAL;
+    float4 tangent : TANGENT;   // w is the handedness of the bitangent
 };
 
 struct PixelShaderInput
@@ -14,6 +15,7 @@ struct PixelShaderInput
     float4 positionWS : POS_WS;
     float3 normalWS : NORM_WS;
     float2 tex : TEXCOORD0;
+    float4 tangentWS : TAN_WS;  // Last, so pixel shaders that do not normal map can leave it out
 };
 
 
@@ -27,5 +29,6 @@ PixelShaderInput main(VertexShaderInput input)
     output.positionWS = mul(model, position); // World space position
     output.normalWS = mul((float3x3) inverseTransposeModel, input.normal); // compute the world space normal
     output.tex = input.tex;
+    output.tangentWS = float4(mul((float3x3) model, input.tangent.xyz), input.tangent.w); // tangents follow the surface, so they use the model matrix
     return output;
 }
\ No newline at end of file
@@ -0,0 +1,160 @@
+#include "PipelineState.h"
+
+std::array<uint64_t, PipelineState::SLOT_COUNT> PipelineState::m_slots = [] { std::array<uint64_t, SLOT_COUNT> slots; slots.fill(UNKNOWN); return slots; }();
+PipelineState::ArraySlots PipelineState::m_constantBuffers = [] { ArraySlots slots; for (auto& stage : slots) stage.fill(UNKNOWN); return slots; }();
+PipelineState::ArraySlots PipelineState::m_constantBufferRanges = m_constantBuffers;
+PipelineState::ArraySlots PipelineState::m_shaderResources = m_constantBuffers;
+PipelineState::ArraySlots PipelineState::m_samplers = m_constantBuffers;
+
+PipelineState::Statistics PipelineState::m_current = {};
+PipelineState::Statistics PipelineState::m_lastFrame = {};
+
+void PipelineState::BeginFrame()
+{
+	Invalidate();
+
+	m_lastFrame = m_current;
+	m_current = {};
+}
+
+void PipelineState::Invalidate()
+{
+	m_slots.fill(UNKNOWN);
+	for (ArraySlots* slots : { &m_constantBuffers, &m_constantBufferRanges, &m_shaderResources, &m_samplers })
+	{
+		for (auto& stage : *slots)
+			stage.fill(UNKNOWN);
+	}
+}
+
+bool PipelineState::SetVertexShader(ID3D11VertexShader* shader)
+{
+	return Count(Update(m_slots[VERTEX_SHADER], reinterpret_cast<uintptr_t>(shader)));
+}
+
+bool PipelineState::SetPixelShader(ID3D11PixelShader* shader)
+{
+	return Count(Update(m_slots[PIXEL_SHADER], reinterpret_cast<uintptr_t>(shader)));
+}
+
+bool PipelineState::SetInputLayout(ID3D11InputLayout* inputLayout)
+{
+	return Count(Update(m_slots[INPUT_LAYOUT], reinterpret_cast<uintptr_t>(inputLayout)));
+}
+
+bool PipelineState::SetRasterizerState(ID3D11RasterizerState* state)
+{
+	return Count(Update(m_slots[RASTERIZER_STATE], reinterpret_cast<uintptr_t>(state)));
+}
+
+bool PipelineState::SetDepthStencilState(ID3D11DepthStencilState* state, unsigned int stencilReference)
+{
+	// Both have to be updated, so no short circuiting
+	bool changed = Update(m_slots[DEPTH_STENCIL_STATE], reinterpret_cast<uintptr_t>(state));
+	changed |= Update(m_slots[STENCIL_REFERENCE], stencilReference);
+	return Count(changed);
+}
+
+bool PipelineState::SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology)
+{
+	return Count(Update(m_slots[PRIMITIVE_TOPOLOGY], static_cast<uintptr_t>(topology)));
+}
+
+bool PipelineState::SetVertexBuffer(ID3D11Buffer* buffer, unsigned int stride, unsigned int offset)
+{
+	bool changed = Update(m_slots[VERTEX_BUFFER], reinterpret_cast<uintptr_t>(buffer));
+	changed |= Update(m_slots[VERTEX_STRIDE], stride);
+	changed |= Update(m_slots[VERTEX_OFFSET], offset);
+	return Count(changed);
+}
+
+bool PipelineState::SetInstanceBuffer(ID3D11Buffer* buffer, unsigned int stride, unsigned int offset)
+{
+	bool changed = Update(m_slots[INSTANCE_BUFFER], reinterpret_cast<uintptr_t>(buffer));
+	changed |= Update(m_slots[INSTANCE_STRIDE], stride);
+	changed |= Update(m_slots[INSTANCE_OFFSET], offset);
+	return Count(changed);
+}
+
+bool PipelineState::SetIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format, unsigned int offset)
+{
+	bool changed = Update(m_slots[INDEX_BUFFER], reinterpret_cast<uintptr_t>(buffer));
+	changed |= Update(m_slots[INDEX_FORMAT], static_cast<uintptr_t>(format));
+	changed |= Update(m_slots[INDEX_OFFSET], offset);
+	return Count(changed);
+}
+
+bool PipelineState::SetConstantBuffers(int stage, unsigned int startSlot, unsigned int count, ID3D11Buffer* const* buffers)
+{
+	// Binding without offsets goes back to binding the whole buffer
+	bool changed = UpdateRange(m_constantBuffers, stage, startSlot, count, reinterpret_cast<const void* const*>(buffers));
+	changed |= UpdateRange(m_constantBufferRanges, stage, startSlot, count, nullptr);
+	return Count(changed);
+}
+
+bool PipelineState::SetConstantBufferRange(int stage, unsigned int slot, ID3D11Buffer* buffer, unsigned int firstConstant, unsigned int constantCount)
+{
+	ID3D11Buffer* const buffers[1] = { buffer };
+	bool changed = UpdateRange(m_constantBuffers, stage, slot, 1, reinterpret_cast<const void* const*>(buffers));
+
+	// UpdateRange has already returned true for a slot that is not tracked
+	if (stage >= 0 && stage < STAGE_COUNT && slot < TRACKED_ARRAY_SLOTS)
+		changed |= Update(m_constantBufferRanges[stage][slot], (static_cast<uint64_t>(firstConstant) << 32) | constantCount);
+
+	return Count(changed);
+}
+
+bool PipelineState::SetShaderResources(int stage, unsigned int startSlot, unsigned int count, ID3D11ShaderResourceView* const* views)
+{
+	return Count(UpdateRange(m_shaderResources, stage, startSlot, count, reinterpret_cast<const void* const*>(views)));
+}
+
+bool PipelineState::SetSamplers(int stage, unsigned int startSlot, unsigned int count, ID3D11SamplerState* const* samplers)
+{
+	return Count(UpdateRange(m_samplers, stage, startSlot, count, reinterpret_cast<const void* const*>(samplers)));
+}
+
+bool PipelineState::Update(uint64_t& slot, uint64_t value)
+{
+	if (slot == value)
+		return false;
+
+	slot = value;
+	return true;
+}
+
+bool PipelineState::UpdateRange(ArraySlots& slots, int stage, unsigned int startSlot, unsigned int count, const void* const* values)
+{
+	// An empty array is a no-op on the context as well
+	if (count == 0)
+		return false;
+
+	if (stage < 0 || stage >= STAGE_COUNT)
+		return true;
+
+	auto& stageSlots = slots[stage];
+
+	// Part of the range is not tracked - forget the part that is, since the call below changes it
+	if (startSlot >= TRACKED_ARRAY_SLOTS || count > TRACKED_ARRAY_SLOTS - startSlot)
+	{
+		for (unsigned int slot = startSlot; slot < TRACKED_ARRAY_SLOTS; ++slot)
+			stageSlots[slot] = UNKNOWN;
+		return true;
+	}
+
+	bool changed = false;
+	for (unsigned int iii = 0; iii < count; ++iii)
+		changed |= Update(stageSlots[startSlot + iii], values != nullptr ? reinterpret_cast<uintptr_t>(values[iii]) : 0);
+
+	return changed;
+}
+
+bool PipelineState::Count(bool issue)
+{
+	if (issue)
+		++m_current.issued;
+	else
+		++m_current.skipped;
+
+	return issue;
+}
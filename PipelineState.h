@@ -0,0 +1,110 @@
+#pragma once
+#include "pch.h"
+
+#include <array>
+#include <stdint.h>
+
+// PipelineState is intended to be a static class
+//
+// PipelineState remembers what is bound to each slot of the device context so that Bindable::Bind can skip calls
+// that would set a slot to the object it already holds. Drawable::Draw binds every bindable of every node (and the
+// texture/sampler/constant buffer arrays are shared all the way down the hierarchy), so most of those calls are
+// redundant. Each Set* function records the binding and returns true if the call still has to be made on the
+// context, false if the slot already holds exactly that. Every call is counted as issued or skipped.
+//
+// The tracked state is only correct as long as everything that binds goes through here. BeginFrame forgets all of
+// it, so whatever binds straight on the context between frames (ImGui, scene activation) is safe; code that does so
+// in the middle of a frame has to call Invalidate. Comparing raw pointers is safe because the context holds a
+// reference to everything bound to it, so a bound object's address cannot be reused while the slot still holds it.
+class PipelineState
+{
+public:
+	struct Statistics
+	{
+		uint64_t issued;
+		uint64_t skipped;
+	};
+
+	// Forgets the tracked state and starts counting a new frame
+	static void BeginFrame();
+
+	// Forgets the tracked state, e.g. after something bound directly on the context
+	static void Invalidate();
+
+	// Counts for the last complete frame, and for the frame so far
+	static const Statistics& GetFrameStatistics() { return m_lastFrame; }
+	static const Statistics& GetCurrentStatistics() { return m_current; }
+
+	static bool SetVertexShader(ID3D11VertexShader* shader);
+	static bool SetPixelShader(ID3D11PixelShader* shader);
+	static bool SetInputLayout(ID3D11InputLayout* inputLayout);
+	static bool SetRasterizerState(ID3D11RasterizerState* state);
+	static bool SetDepthStencilState(ID3D11DepthStencilState* state, unsigned int stencilReference);
+	static bool SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology);
+
+	// Vertex buffer slot 0 (the mesh) and slot 1 (InstanceBuffer) are tracked - nothing binds any other slot
+	static bool SetVertexBuffer(ID3D11Buffer* buffer, unsigned int stride, unsigned int offset);
+	static bool SetInstanceBuffer(ID3D11Buffer* buffer, unsigned int stride, unsigned int offset);
+	static bool SetIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format, unsigned int offset);
+
+	// stage uses the numbering shared by ConstantBufferBindingLocation, TextureBindingLocation and
+	// SamplerStateBindingLocation (COMPUTE_SHADER = 0 ... PIXEL_SHADER = 5)
+	static bool SetConstantBuffers(int stage, unsigned int startSlot, unsigned int count, ID3D11Buffer* const* buffers);
+
+	// A part of a constant buffer, as bound by *SetConstantBuffers1. firstConstant and constantCount are in 16 byte
+	// constants
+	static bool SetConstantBufferRange(int stage, unsigned int slot, ID3D11Buffer* buffer, unsigned int firstConstant, unsigned int constantCount);
+
+	static bool SetShaderResources(int stage, unsigned int startSlot, unsigned int count, ID3D11ShaderResourceView* const* views);
+	static bool SetSamplers(int stage, unsigned int startSlot, unsigned int count, ID3D11SamplerState* const* samplers);
+
+private:
+	PipelineState() {} // Disallow creation of a PipelineState object
+
+	enum Slot
+	{
+		VERTEX_SHADER,
+		PIXEL_SHADER,
+		INPUT_LAYOUT,
+		RASTERIZER_STATE,
+		DEPTH_STENCIL_STATE,
+		STENCIL_REFERENCE,
+		PRIMITIVE_TOPOLOGY,
+		VERTEX_BUFFER,
+		VERTEX_STRIDE,
+		VERTEX_OFFSET,
+		INSTANCE_BUFFER,
+		INSTANCE_STRIDE,
+		INSTANCE_OFFSET,
+		INDEX_BUFFER,
+		INDEX_FORMAT,
+		INDEX_OFFSET,
+		SLOT_COUNT
+	};
+
+	static constexpr int STAGE_COUNT = 6;
+
+	// Slots past this are not tracked, binds that touch them are always issued
+	static constexpr unsigned int TRACKED_ARRAY_SLOTS = 16;
+
+	// Never the value of a real binding, so the first bind of every slot is issued
+	static constexpr uint64_t UNKNOWN = ~static_cast<uint64_t>(0);
+
+	using ArraySlots = std::array<std::array<uint64_t, TRACKED_ARRAY_SLOTS>, STAGE_COUNT>;
+
+	// Stores value in slot and returns true if it was different
+	static bool Update(uint64_t& slot, uint64_t value);
+
+	// values may be nullptr to store 0 in every slot of the range
+	static bool UpdateRange(ArraySlots& slots, int stage, unsigned int startSlot, unsigned int count, const void* const* values);
+	static bool Count(bool issue);
+
+	static std::array<uint64_t, SLOT_COUNT> m_slots;
+	static ArraySlots m_constantBuffers;
+	static ArraySlots m_constantBufferRanges;	// 0 for the whole buffer, otherwise first constant << 32 | constant count
+	static ArraySlots m_shaderResources;
+	static ArraySlots m_samplers;
+
+	static Statistics m_current;
+	static Statistics m_lastFrame;
+};
@@ -20,6 +20,9 @@ PixelShader::PixelShader(std::shared_ptr<DeviceResources> deviceResources, std::
 
 void PixelShader::Bind()
 {
+	if (!PipelineState::SetPixelShader(m_pixelShader.Get()))
+		return;
+
 	INFOMAN(m_deviceResources);
 	GFX_THROW_INFO_ONLY(
 		m_deviceResources->D3DDeviceContext()->PSSetShader(m_pixelShader.Get(), nullptr, 0u)
@@ -8,6 +8,7 @@ public:
 	PixelShader(std::shared_ptr<DeviceResources> deviceResources, std::wstring pixelShaderFile);
 
 	void Bind() override;
+	BindableSlot Slot() const override { return { BindableSlot::Type::PIXEL_SHADER }; }
 
 private:
 	Microsoft::WRL::ComPtr<ID3D11PixelShader> m_pixelShader;
@@ -33,6 +33,9 @@ void RasterizerState::LoadChanges()
 
 void RasterizerState::Bind()
 {
+	if (!PipelineState::SetRasterizerState(m_rasterizerState.Get()))
+		return;
+
 	INFOMAN(m_deviceResources);
 	GFX_THROW_INFO_ONLY(
 		m_deviceResources->D3DDeviceContext()->RSSetState(m_rasterizerState.Get())
@@ -21,6 +21,7 @@ public:
 	void AntialiasedLineEnable(bool enable) { m_desc.AntialiasedLineEnable = enable; LoadChanges(); }
 
 	void Bind() override;
+	BindableSlot Slot() const override { return { BindableSlot::Type::RASTERIZER_STATE }; }
 
 	void ResetState();
 
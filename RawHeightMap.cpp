@@ -0,0 +1,37 @@
+#include "RawHeightMap.h"
+
+RawHeightMap::RawHeightMap(const std::string& filename, int width, int height) :
+	m_file(filename),
+	m_width(width),
+	m_height(height),
+	m_samples(reinterpret_cast<const uint16_t*>(m_file.Data()))
+{
+	// The file must hold exactly one 16 bit sample for every point of the terrain
+	size_t expectedSize = static_cast<size_t>(width) * height * sizeof(uint16_t);
+	if (m_file.Size() != expectedSize)
+	{
+		std::ostringstream oss;
+		oss << "Raw height map size does not match the terrain dimensions for file: " << filename << std::endl;
+		oss << "    Expected: " << expectedSize << " bytes" << std::endl;
+		oss << "    Actual:   " << m_file.Size() << " bytes" << std::endl;
+		throw TerrainMeshException(__LINE__, __FILE__, oss.str());
+	}
+}
+
+void RawHeightMap::ReadTile(int x, int y, int tileWidth, int tileHeight, float* heights) const
+{
+	for (int j = 0; j < tileHeight; j++)
+	{
+		const uint16_t* source = m_samples + (static_cast<size_t>(m_width) * (y + j)) + x;
+		float* destination = heights + (static_cast<size_t>(tileWidth) * j);
+
+		for (int i = 0; i < tileWidth; i++)
+			destination[i] = static_cast<float>(source[i]);
+	}
+}
+
+void RawHeightMap::Release(int firstRow, int rowCount) const
+{
+	size_t rowSize = static_cast<size_t>(m_width) * sizeof(uint16_t);
+	m_file.Release(rowSize * firstRow, rowSize * rowCount);
+}
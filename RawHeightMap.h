@@ -0,0 +1,42 @@
+#pragma once
+#include "pch.h"
+#include "MemoryMappedFile.h"
+#include "TerrainMeshException.h"
+
+#include <string>
+#include <sstream>
+#include <stdint.h>
+
+// RawHeightMap is a read-only view of a 16 bit RAW height map (one little endian unsigned short per sample,
+// row major). The file is memory mapped instead of read into memory, and samples are only converted to float
+// when a tile of them is asked for. Callers walk the map tile by tile (or band by band) and call Release once
+// they are done with a tile, so the resident memory stays bounded by the tiles in flight no matter how large
+// the map is.
+class RawHeightMap
+{
+public:
+	RawHeightMap(const std::string& filename, int width, int height);
+	RawHeightMap(const RawHeightMap&) = delete;
+	RawHeightMap& operator=(const RawHeightMap&) = delete;
+
+	int Width() const { return m_width; }
+	int Height() const { return m_height; }
+
+	// Raw (unscaled) height of a single sample
+	float GetSample(int i, int j) const { return static_cast<float>(m_samples[(static_cast<size_t>(m_width) * j) + i]); }
+
+	// Converts the tile [x, x + tileWidth) x [y, y + tileHeight) into heights, which is filled row major and
+	// must hold tileWidth * tileHeight values
+	void ReadTile(int x, int y, int tileWidth, int tileHeight, float* heights) const;
+	void ReadRows(int firstRow, int rowCount, float* heights) const { ReadTile(0, firstRow, m_width, rowCount, heights); }
+
+	// Lets the rows go from the working set once they are no longer needed
+	void Release(int firstRow, int rowCount) const;
+
+	uint64_t Hash() const { return m_file.Hash(); }
+
+private:
+	MemoryMappedFile m_file;
+	int m_width, m_height;
+	const uint16_t* m_samples;
+};
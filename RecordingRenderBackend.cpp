@@ -0,0 +1,37 @@
+#include "RecordingRenderBackend.h"
+
+void RecordingRenderBackend::Bind(Bindable& bindable)
+{
+	m_commands.push_back({ CommandType::BIND, &bindable, 0 });
+	++m_bindCount;
+
+	const Bindable*& bound = m_bound[bindable.Slot()];
+	if (bound != &bindable)
+	{
+		bound = &bindable;
+		++m_bindChanges;
+	}
+}
+
+void RecordingRenderBackend::Draw(Drawable& drawable)
+{
+	m_commands.push_back({ CommandType::DRAW, &drawable, 0 });
+	++m_drawCount;
+}
+
+void RecordingRenderBackend::DrawInstanced(Drawable* const* drawables, size_t count)
+{
+	m_commands.push_back({ CommandType::DRAW_INSTANCED, drawables[0], count });
+	++m_drawCount;
+	m_instanceCount += count;
+}
+
+void RecordingRenderBackend::Reset()
+{
+	m_commands.clear();
+	m_bound.clear();
+	m_bindCount = 0;
+	m_bindChanges = 0;
+	m_drawCount = 0;
+	m_instanceCount = 0;
+}
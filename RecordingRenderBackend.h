@@ -0,0 +1,47 @@
+#pragma once
+#include "pch.h"
+#include "RenderBackend.h"
+#include "Bindable.h"
+
+#include <vector>
+#include <map>
+
+// Records the command stream so that the order of a queue, and how often it changes state, can be checked without a
+// device. A bind is a change when the bindable is not the one last bound to the same BindableSlot
+class RecordingRenderBackend : public RenderBackend
+{
+public:
+	enum class CommandType
+	{
+		BIND,
+		DRAW,
+		DRAW_INSTANCED
+	};
+
+	struct Command
+	{
+		CommandType type;
+		const void* object;		// The Bindable or the Drawable (the first one for DRAW_INSTANCED)
+		size_t instanceCount;	// Only for DRAW_INSTANCED
+	};
+
+	void Bind(Bindable& bindable) override;
+	void Draw(Drawable& drawable) override;
+	void DrawInstanced(Drawable* const* drawables, size_t count) override;
+
+	void Reset();
+
+	const std::vector<Command>& Commands() const { return m_commands; }
+	size_t BindCount() const { return m_bindCount; }
+	size_t BindChanges() const { return m_bindChanges; }
+	size_t DrawCount() const { return m_drawCount; }			// Draw calls, an instanced draw is one
+	size_t InstanceCount() const { return m_instanceCount; }	// Drawables drawn by instanced draws
+
+private:
+	std::vector<Command> m_commands;
+	std::map<BindableSlot, const Bindable*> m_bound;
+	size_t m_bindCount = 0;
+	size_t m_bindChanges = 0;
+	size_t m_drawCount = 0;
+	size_t m_instanceCount = 0;
+};
@@ -0,0 +1,22 @@
+#pragma once
+#include "pch.h"
+
+#include <stddef.h>
+
+class Bindable;
+class Drawable;
+
+// RenderBackend is what a RenderQueue is executed against. DeviceContextRenderBackend issues the binds and draw
+// calls on the device context, RecordingRenderBackend only records them. Prepare is given every drawable of the
+// queue, in the order they will be drawn, before the first bind. DrawInstanced draws drawables that share a mesh and
+// every bindable with a single instanced draw call
+class RenderBackend
+{
+public:
+	virtual ~RenderBackend() {}
+
+	virtual void Prepare(Drawable* const* drawables, size_t count) {}
+	virtual void Bind(Bindable& bindable) = 0;
+	virtual void Draw(Drawable& drawable) = 0;
+	virtual void DrawInstanced(Drawable* const* drawables, size_t count) = 0;
+};
@@ -0,0 +1,181 @@
+#include "RenderQueue.h"
+#include "TextureArray.h"
+#include "DrawableException.h"
+
+uint64_t RenderQueue::MakeKey(RenderPass pass, uint32_t shader, uint32_t material, float depth)
+{
+	// The bits of a non-negative float sort in the same order as its value, the top 24 (below the sign) are plenty
+	if (!(depth >= 0.0f))
+		depth = 0.0f;
+	uint64_t depthBits = (std::bit_cast<uint32_t>(depth) >> 7) & DEPTH_MASK;
+
+	return (static_cast<uint64_t>(pass) << PASS_SHIFT) |
+		((shader & SHADER_MASK) << SHADER_SHIFT) |
+		((material & MATERIAL_MASK) << MATERIAL_SHIFT) |
+		depthBits;
+}
+
+void RenderQueue::Clear()
+{
+	m_packets.clear();
+	m_bindables.clear();
+	m_order.clear();
+	m_drawables.clear();
+	m_sorted = true;
+
+	// The ids are keyed by the addresses of the bindables, which are free to be reused once the frame is over
+	m_shaderIds.clear();
+	m_materialIds.clear();
+	m_instanceGroupIds.clear();
+}
+
+void RenderQueue::Submit(Drawable* drawable, RenderPass pass, float depth, Bindable* const* bindables, size_t count,
+	const Bindable* instancedMesh)
+{
+	// Later bindables override earlier ones, the same as when they are bound in order
+	const Bindable* vertexShader = nullptr;
+	const Bindable* pixelShader = nullptr;
+	const Bindable* inputLayout = nullptr;
+	m_textures.clear();
+	for (size_t iii = 0; iii < count; ++iii)
+	{
+		Bindable* bindable = bindables[iii];
+		BindableSlot::Type type = bindable->Slot().type;
+		if (type == BindableSlot::Type::VERTEX_SHADER)
+			vertexShader = bindable;
+		else if (type == BindableSlot::Type::PIXEL_SHADER)
+			pixelShader = bindable;
+		else if (type == BindableSlot::Type::INPUT_LAYOUT)
+			inputLayout = bindable;
+		else if (TextureArray* textureArray = dynamic_cast<TextureArray*>(bindable))
+		{
+			for (const std::shared_ptr<Texture>& texture : textureArray->GetTextures())
+				m_textures.push_back(texture.get());
+		}
+	}
+
+	// An instanced draw with a shader that reads its matrices from the constant buffer, or the other way around,
+	// would draw every instance with the wrong matrices (or none at all) without any error from the device
+	const bool instanced = instancedMesh != nullptr;
+	if (vertexShader == nullptr || inputLayout == nullptr)
+	{
+		if (instanced)
+			throw DrawableException(__LINE__, __FILE__, "Instanced drawable has no vertex shader or input layout");
+	}
+	else if (vertexShader->ReadsInstanceData() != instanced || inputLayout->ReadsInstanceData() != instanced)
+	{
+		throw DrawableException(__LINE__, __FILE__, instanced ?
+			"Instanced drawable must use an instanced vertex shader and input layout (e.g. \"phong-instanced-vertex-shader\")" :
+			"Drawable uses an instanced vertex shader or input layout but was not made instanced with SetInstanced");
+	}
+
+	uint64_t key = MakeKey(pass, ShaderId(vertexShader, pixelShader), MaterialId(m_textures), depth);
+	if (!instanced)
+	{
+		Submit(key, drawable, bindables, count);
+		return;
+	}
+
+	uint32_t instanceGroup = InstanceGroupId(instancedMesh, bindables, count);
+	key = (key & ~DEPTH_MASK) | (instanceGroup & DEPTH_MASK);
+
+	Submit(key, drawable, bindables, count);
+	m_packets.back().instanceGroup = instanceGroup;
+}
+
+void RenderQueue::Submit(uint64_t key, Drawable* drawable, Bindable* const* bindables, size_t count)
+{
+	m_packets.push_back({ key, drawable, m_bindables.size(), count, NO_INSTANCE_GROUP });
+	m_bindables.insert(m_bindables.end(), bindables, bindables + count);
+	m_sorted = false;
+}
+
+void RenderQueue::Sort()
+{
+	const size_t count = m_packets.size();
+	m_order.resize(count);
+	m_scratch.resize(count);
+	for (size_t iii = 0; iii < count; ++iii)
+		m_order[iii] = { m_packets[iii].key, static_cast<uint32_t>(iii) };
+
+	// Least significant byte first. Bytes that are the same for every key (most of them in a small scene) are skipped
+	for (int shift = 0; shift < 64; shift += 8)
+	{
+		std::array<size_t, 256> offsets = {};
+		for (const SortEntry& entry : m_order)
+			++offsets[(entry.key >> shift) & 0xFF];
+
+		if (offsets[m_order.empty() ? 0 : (m_order[0].key >> shift) & 0xFF] == count)
+			continue;
+
+		size_t total = 0;
+		for (size_t& offset : offsets)
+		{
+			size_t bucketSize = offset;
+			offset = total;
+			total += bucketSize;
+		}
+
+		for (const SortEntry& entry : m_order)
+			m_scratch[offsets[(entry.key >> shift) & 0xFF]++] = entry;
+
+		m_order.swap(m_scratch);
+	}
+
+	m_sorted = true;
+}
+
+void RenderQueue::Execute(RenderBackend& backend)
+{
+	if (!m_sorted || m_order.size() != m_packets.size())
+		Sort();
+
+	m_drawables.clear();
+	for (const SortEntry& entry : m_order)
+		m_drawables.push_back(m_packets[entry.packet].drawable);
+	backend.Prepare(m_drawables.data(), m_drawables.size());
+
+	size_t next = 0;
+	while (next < m_order.size())
+	{
+		const Packet& packet = m_packets[m_order[next].packet];
+		for (size_t iii = 0; iii < packet.bindableCount; ++iii)
+			backend.Bind(*m_bindables[packet.firstBindable + iii]);
+
+		if (packet.instanceGroup == NO_INSTANCE_GROUP)
+		{
+			backend.Draw(*packet.drawable);
+			++next;
+			continue;
+		}
+
+		// The rest of the run binds exactly the same, so only the first packet's bindables are needed
+		size_t runEnd = next + 1;
+		while (runEnd < m_order.size() && m_packets[m_order[runEnd].packet].instanceGroup == packet.instanceGroup)
+			++runEnd;
+
+		backend.DrawInstanced(&m_drawables[next], runEnd - next);
+		next = runEnd;
+	}
+}
+
+uint32_t RenderQueue::ShaderId(const Bindable* vertexShader, const Bindable* pixelShader)
+{
+	auto [iterator, inserted] = m_shaderIds.try_emplace({ vertexShader, pixelShader }, static_cast<uint32_t>(m_shaderIds.size()));
+	return iterator->second;
+}
+
+uint32_t RenderQueue::MaterialId(const std::vector<const void*>& textures)
+{
+	auto [iterator, inserted] = m_materialIds.try_emplace(textures, static_cast<uint32_t>(m_materialIds.size()));
+	return iterator->second;
+}
+
+uint32_t RenderQueue::InstanceGroupId(const Bindable* mesh, Bindable* const* bindables, size_t count)
+{
+	m_instanceGroupKey.assign(1, mesh);
+	m_instanceGroupKey.insert(m_instanceGroupKey.end(), bindables, bindables + count);
+
+	auto [iterator, inserted] = m_instanceGroupIds.try_emplace(m_instanceGroupKey, static_cast<uint32_t>(m_instanceGroupIds.size()));
+	return iterator->second;
+}
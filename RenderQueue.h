@@ -0,0 +1,103 @@
+#pragma once
+#include "pch.h"
+#include "RenderBackend.h"
+
+#include <vector>
+#include <map>
+#include <array>
+#include <utility>
+#include <bit>
+#include <stdint.h>
+
+class Bindable;
+class Drawable;
+
+// Passes are drawn in this order, whatever the rest of the sort key says
+enum class RenderPass
+{
+	BACKGROUND = 0,		// Sky dome - drawn first without depth
+	SOLID = 1
+};
+
+// RenderQueue collects a frame's draws as packets and executes them in sort key order instead of hierarchy order,
+// so that draws sharing shaders and textures end up next to each other:
+//
+//		bits 60 - 63	pass
+//		bits 44 - 59	shader (vertex + pixel shader pair)
+//		bits 24 - 43	material (the set of textures)
+//		bits  0 - 23	depth (distance to the camera, near to far)
+//
+// A packet carries every bindable that would have been bound before its draw in hierarchy order - the ones
+// inherited from its ancestors followed by its own - so it does not depend on what was drawn before it. Binds
+// that repeat the current state are filtered out by PipelineState.
+//
+// Shader, material and instance group ids are handed out in the order combinations are first submitted, and Clear
+// starts over, so nothing refers to a bindable after the frame that submitted it. A scene that submits in the same order every
+// frame gets the same ids every frame. They only group packets; ids past the width of their field wrap around.
+//
+// Instanced packets (those submitted with their mesh) put an instance group id in place of the depth - one id per
+// mesh and list of bindables. Every packet of a group therefore sorts next to the others and Execute draws each run
+// of them with a single DrawInstanced. Instances are not sorted by depth.
+class RenderQueue
+{
+public:
+	static constexpr int PASS_SHIFT = 60;
+	static constexpr int SHADER_SHIFT = 44;
+	static constexpr int MATERIAL_SHIFT = 24;
+	static constexpr uint64_t SHADER_MASK = (1ull << 16) - 1;
+	static constexpr uint64_t MATERIAL_MASK = (1ull << 20) - 1;
+	static constexpr uint64_t DEPTH_MASK = (1ull << 24) - 1;
+
+	static uint64_t MakeKey(RenderPass pass, uint32_t shader, uint32_t material, float depth);
+
+	void Clear();
+
+	// Works out the shader and material ids from the bindables. instancedMesh is given for drawables that use an
+	// instanced vertex shader, packets with the same mesh and bindables are then drawn together. Throws a
+	// DrawableException if the vertex shader and input layout do not read the InstanceBuffer exactly when
+	// instancedMesh is given
+	void Submit(Drawable* drawable, RenderPass pass, float depth, Bindable* const* bindables, size_t count,
+		const Bindable* instancedMesh = nullptr);
+	void Submit(uint64_t key, Drawable* drawable, Bindable* const* bindables, size_t count);
+
+	// Stable radix sort on the keys. Execute sorts first if anything was submitted since the last Sort
+	void Sort();
+	void Execute(RenderBackend& backend);
+
+	size_t PacketCount() const { return m_packets.size(); }
+
+private:
+	static constexpr uint32_t NO_INSTANCE_GROUP = ~static_cast<uint32_t>(0);
+
+	struct Packet
+	{
+		uint64_t key;
+		Drawable* drawable;
+		size_t firstBindable;
+		size_t bindableCount;
+		uint32_t instanceGroup;
+	};
+
+	struct SortEntry
+	{
+		uint64_t key;
+		uint32_t packet;
+	};
+
+	uint32_t ShaderId(const Bindable* vertexShader, const Bindable* pixelShader);
+	uint32_t MaterialId(const std::vector<const void*>& textures);
+	uint32_t InstanceGroupId(const Bindable* mesh, Bindable* const* bindables, size_t count);
+
+	std::vector<Packet> m_packets;
+	std::vector<Bindable*> m_bindables;
+	std::vector<SortEntry> m_order;
+	std::vector<SortEntry> m_scratch;
+	std::vector<Drawable*> m_drawables;
+	std::vector<const void*> m_textures;
+	std::vector<const void*> m_instanceGroupKey;
+	bool m_sorted = true;
+
+	std::map<std::pair<const Bindable*, const Bindable*>, uint32_t> m_shaderIds;
+	std::map<std::vector<const void*>, uint32_t> m_materialIds;
+	std::map<std::vector<const void*>, uint32_t> m_instanceGroupIds;
+};
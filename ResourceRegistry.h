@@ -0,0 +1,295 @@
+#pragma once
+#include "pch.h"
+#include "ObjectStoreException.h"
+
+#include <memory>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <functional>
+#include <algorithm>
+#include <stdint.h>
+
+// Handle to a resource in a ResourceRegistry<T>. The handle stays valid until the resource is removed - the
+// generation is bumped every time a slot is freed, so a handle to a removed resource never resolves to whatever
+// reuses its slot. A default constructed handle is invalid.
+template <typename T>
+struct ResourceHandle
+{
+	static constexpr uint32_t INVALID_INDEX = 0xFFFFFFFF;
+
+	uint32_t index = INVALID_INDEX;
+	uint32_t generation = 0;
+
+	bool IsValid() const { return index != INVALID_INDEX; }
+	bool operator==(const ResourceHandle& other) const { return index == other.index && generation == other.generation; }
+};
+
+struct ResidencyStatistics
+{
+	size_t residentCount = 0;
+	size_t evictedCount = 0;
+	size_t residentBytes = 0;		// As of the last Update
+	size_t budgetBytes = SIZE_MAX;
+	uint64_t hits = 0;				// Get found the resource resident
+	uint64_t misses = 0;			// Get had to reload an evicted resource
+	uint64_t evictions = 0;
+};
+
+// ResourceRegistry stores resources in a dense array of slots and hands out integer handles to them. A name is
+// hashed once when it is looked up with Find - after that, resolving the handle is a bounds check, a generation
+// check and an array access. Freed slots are kept on a free list and reused by the next Add.
+//
+// Resources added with a reload function can be evicted to stay within a memory budget. Update evicts the least
+// recently used ones that nothing outside the registry holds on to, and keeps their name and handle - the next Get
+// reloads them through the reload function. Sizes come from the size function, so a registry without one never
+// goes over budget.
+template <typename T>
+class ResourceRegistry
+{
+public:
+	using Handle = ResourceHandle<T>;
+	using SizeFunction = std::function<size_t(const T&)>;
+	using ReloadFunction = std::function<std::shared_ptr<T>()>;
+
+	// registryName is only used in error messages
+	ResourceRegistry(const char* registryName) : m_registryName(registryName) {}
+	ResourceRegistry(const ResourceRegistry&) = delete;
+	ResourceRegistry& operator=(const ResourceRegistry&) = delete;
+
+	// Adding a name that already exists does not replace the resource - the existing handle is returned instead
+	Handle Add(std::string_view name, std::shared_ptr<T> resource, ReloadFunction reload = nullptr);
+	void Remove(Handle handle);
+	void Clear();
+
+	// Returns an invalid handle if there is no resource with that name
+	Handle Find(std::string_view name) const;
+	bool Exists(std::string_view name) const { return m_names.find(name) != m_names.end(); }
+	bool Exists(Handle handle) const { return handle.index < m_slots.size() && m_slots[handle.index].generation == handle.generation && m_slots[handle.index].occupied; }
+
+	// Throws ObjectStoreInvalidKeyException if the handle or the name does not refer to a resource - that includes
+	// invalid handles and handles to removed resources. Reloads the resource if it was evicted
+	const std::shared_ptr<T>& Get(Handle handle);
+	const std::shared_ptr<T>& Get(std::string_view name);
+
+	size_t Size() const { return m_names.size(); }
+
+	void SetSizeFunction(SizeFunction sizeFunction) { m_sizeFunction = sizeFunction; }
+	void SetBudget(size_t bytes) { m_statistics.budgetBytes = bytes; }
+
+	// Call once per frame. Recounts the resident bytes and evicts resources until they fit in the budget
+	void Update(uint64_t frame);
+	const ResidencyStatistics& Statistics() const { return m_statistics; }
+
+private:
+	struct Slot
+	{
+		std::shared_ptr<T> resource;	// nullptr while evicted
+		ReloadFunction reload;
+		std::string name;
+		uint32_t generation = 0;
+		bool occupied = false;
+		uint64_t lastUsedFrame = 0;
+	};
+
+	const std::shared_ptr<T>& Use(Slot& slot);
+
+	// Lets m_names be searched with a string_view without building a std::string first
+	struct NameHash
+	{
+		using is_transparent = void;
+		size_t operator()(std::string_view name) const { return std::hash<std::string_view>()(name); }
+	};
+
+	std::string HandleDescription(Handle handle) const { return "handle " + std::to_string(handle.index) + " (generation " + std::to_string(handle.generation) + ")"; }
+
+	const char* m_registryName;
+	std::vector<Slot> m_slots;
+	std::vector<uint32_t> m_freeSlots;
+	std::unordered_map<std::string, uint32_t, NameHash, std::equal_to<>> m_names;
+
+	SizeFunction m_sizeFunction;
+	uint64_t m_frame = 0;
+	ResidencyStatistics m_statistics;
+};
+
+template <typename T>
+typename ResourceRegistry<T>::Handle ResourceRegistry<T>::Add(std::string_view name, std::shared_ptr<T> resource, ReloadFunction reload)
+{
+	Handle existing = Find(name);
+	if (existing.IsValid())
+		return existing;
+
+	uint32_t index;
+	if (!m_freeSlots.empty())
+	{
+		index = m_freeSlots.back();
+		m_freeSlots.pop_back();
+	}
+	else
+	{
+		index = static_cast<uint32_t>(m_slots.size());
+		m_slots.emplace_back();
+	}
+
+	Slot& slot = m_slots[index];
+	slot.resource = std::move(resource);
+	slot.reload = std::move(reload);
+	slot.name = name;
+	slot.occupied = true;
+	slot.lastUsedFrame = m_frame;
+	m_names.emplace(slot.name, index);
+	++m_statistics.residentCount;
+
+	return { index, slot.generation };
+}
+
+template <typename T>
+void ResourceRegistry<T>::Remove(Handle handle)
+{
+	if (!Exists(handle))
+		return;
+
+	Slot& slot = m_slots[handle.index];
+	if (slot.resource != nullptr)
+		--m_statistics.residentCount;
+	else
+		--m_statistics.evictedCount;
+
+	m_names.erase(slot.name);
+	slot.resource = nullptr;
+	slot.reload = nullptr;
+	slot.name.clear();
+	slot.occupied = false;
+	++slot.generation;
+	m_freeSlots.push_back(handle.index);
+}
+
+template <typename T>
+void ResourceRegistry<T>::Clear()
+{
+	// Slots are freed one by one rather than dropped so that handles from before the clear stay invalid
+	m_freeSlots.clear();
+	for (uint32_t iii = static_cast<uint32_t>(m_slots.size()); iii-- > 0; )
+	{
+		Slot& slot = m_slots[iii];
+		if (slot.occupied)
+		{
+			slot.resource = nullptr;
+			slot.reload = nullptr;
+			slot.name.clear();
+			slot.occupied = false;
+			++slot.generation;
+		}
+		m_freeSlots.push_back(iii);
+	}
+	m_names.clear();
+
+	m_statistics.residentCount = 0;
+	m_statistics.evictedCount = 0;
+	m_statistics.residentBytes = 0;
+}
+
+template <typename T>
+typename ResourceRegistry<T>::Handle ResourceRegistry<T>::Find(std::string_view name) const
+{
+	auto iterator = m_names.find(name);
+	if (iterator == m_names.end())
+		return Handle();
+
+	return { iterator->second, m_slots[iterator->second].generation };
+}
+
+template <typename T>
+const std::shared_ptr<T>& ResourceRegistry<T>::Get(Handle handle)
+{
+	if (!Exists(handle))
+		throw ObjectStoreInvalidKeyException(__LINE__, __FILE__, m_registryName, HandleDescription(handle));
+
+	return Use(m_slots[handle.index]);
+}
+
+template <typename T>
+const std::shared_ptr<T>& ResourceRegistry<T>::Get(std::string_view name)
+{
+	auto iterator = m_names.find(name);
+	if (iterator == m_names.end())
+		throw ObjectStoreInvalidKeyException(__LINE__, __FILE__, m_registryName, std::string(name));
+
+	return Use(m_slots[iterator->second]);
+}
+
+template <typename T>
+const std::shared_ptr<T>& ResourceRegistry<T>::Use(Slot& slot)
+{
+	slot.lastUsedFrame = m_frame;
+
+	if (slot.resource != nullptr)
+	{
+		++m_statistics.hits;
+		return slot.resource;
+	}
+
+	// Only resources with a reload function are ever evicted
+	++m_statistics.misses;
+	slot.resource = slot.reload();
+	--m_statistics.evictedCount;
+	++m_statistics.residentCount;
+	return slot.resource;
+}
+
+template <typename T>
+void ResourceRegistry<T>::Update(uint64_t frame)
+{
+	m_frame = frame;
+
+	if (!m_sizeFunction)
+		return;
+
+	// Sizes are counted again every frame rather than once on Add - a texture that is still being decoded
+	// does not know its size yet
+	struct Candidate
+	{
+		uint64_t lastUsedFrame;
+		uint32_t index;
+		size_t size;
+	};
+	std::vector<Candidate> candidates;
+
+	size_t residentBytes = 0;
+	for (uint32_t iii = 0; iii < m_slots.size(); ++iii)
+	{
+		Slot& slot = m_slots[iii];
+		if (slot.resource == nullptr)
+			continue;
+
+		size_t size = m_sizeFunction(*slot.resource);
+		residentBytes += size;
+
+		// Anything still referenced outside the registry would not actually be freed. Resources used this frame
+		// are kept as well, or they would just be reloaded again next frame
+		if (slot.reload && slot.resource.use_count() == 1 && slot.lastUsedFrame < m_frame)
+			candidates.push_back({ slot.lastUsedFrame, iii, size });
+	}
+
+	if (residentBytes > m_statistics.budgetBytes)
+	{
+		std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) { return a.lastUsedFrame < b.lastUsedFrame; });
+
+		for (const Candidate& candidate : candidates)
+		{
+			if (residentBytes <= m_statistics.budgetBytes)
+				break;
+
+			m_slots[candidate.index].resource = nullptr;
+			residentBytes -= candidate.size;
+
+			--m_statistics.residentCount;
+			++m_statistics.evictedCount;
+			++m_statistics.evictions;
+		}
+	}
+
+	m_statistics.residentBytes = residentBytes;
+}
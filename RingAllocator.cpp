@@ -0,0 +1,42 @@
+#include "RingAllocator.h"
+
+#include <algorithm>
+
+RingAllocator::RingAllocator(size_t alignment) :
+	m_alignment(alignment)
+{
+}
+
+void RingAllocator::Reset(size_t capacity)
+{
+	m_capacity = capacity;
+	m_offset = 0;
+	m_discardOnNextBegin = true;
+}
+
+size_t RingAllocator::GrownCapacity(size_t size) const
+{
+	// Doubling keeps the number of times a growing scene replaces the buffer down to a handful
+	return std::max(AlignedSize(size), m_capacity * 2);
+}
+
+bool RingAllocator::Begin(size_t size)
+{
+	if (!m_discardOnNextBegin && m_noOverwriteSupported && size <= m_capacity - m_offset)
+		return false;
+
+	m_offset = 0;
+	m_discardOnNextBegin = false;
+	return true;
+}
+
+bool RingAllocator::Allocate(size_t size, size_t& offset)
+{
+	const size_t alignedSize = AlignedSize(size);
+	if (alignedSize > m_capacity - m_offset)
+		return false;
+
+	offset = m_offset;
+	m_offset += alignedSize;
+	return true;
+}
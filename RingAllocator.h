@@ -0,0 +1,49 @@
+#pragma once
+#include "pch.h"
+
+#include <stddef.h>
+
+// RingAllocator is the bookkeeping of a dynamic buffer that batches of writes are appended to, without the buffer
+// itself - where each write goes, and whether a Map can use NO_OVERWRITE or has to DISCARD. ConstantRingBuffer owns
+// one for its constant buffer:
+//
+//		if (size > ring.Capacity())
+//			create a buffer of ring.GrownCapacity(size) bytes, then ring.Reset(capacity)
+//		discard = ring.Begin(size);			// Map with DISCARD if true, NO_OVERWRITE otherwise
+//		ring.Allocate(size, offset);		// for each write of the batch
+//
+// A batch never overwrites a range that an earlier batch was given since the last discard - those may still be in
+// use by draws the GPU has not run yet. The first batch of a frame always discards, as does any batch that does not
+// fit behind the previous one or that is mapped without NO_OVERWRITE support.
+class RingAllocator
+{
+public:
+	// Every range starts at a multiple of alignment and is a multiple of it long
+	RingAllocator(size_t alignment);
+
+	// A new, empty buffer of capacity bytes. The first Begin on it discards
+	void Reset(size_t capacity);
+
+	void BeginFrame() { m_discardOnNextBegin = true; }
+	void SetNoOverwriteSupported(bool supported) { m_noOverwriteSupported = supported; }
+
+	// The capacity to replace the buffer with when a batch of size bytes is more than it can hold
+	size_t GrownCapacity(size_t size) const;
+
+	// Starts a batch of at most size bytes and returns true if the buffer has to be mapped with DISCARD
+	bool Begin(size_t size);
+
+	// Gives the next size bytes of the batch. Returns false, and leaves offset alone, if they do not fit
+	bool Allocate(size_t size, size_t& offset);
+
+	size_t AlignedSize(size_t size) const { return (size + m_alignment - 1) / m_alignment * m_alignment; }
+	size_t Capacity() const { return m_capacity; }
+	size_t Offset() const { return m_offset; }
+
+private:
+	size_t m_alignment;
+	size_t m_capacity = 0;
+	size_t m_offset = 0;				// Where the next Allocate goes
+	bool m_discardOnNextBegin = true;
+	bool m_noOverwriteSupported = true;	// Without it every Begin discards
+};
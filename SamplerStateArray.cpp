@@ -2,7 +2,8 @@
 #include "ObjectStore.h"
 
 SamplerStateArray::SamplerStateArray(std::shared_ptr<DeviceResources> deviceResources, SamplerStateBindingLocation bindToStage) :
-	Bindable(deviceResources)
+	Bindable(deviceResources),
+	m_slot({ BindableSlot::Type::SAMPLERS, static_cast<int>(bindToStage) })
 {
 	switch (bindToStage)
 	{
@@ -38,6 +39,9 @@ void SamplerStateArray::Bind()
 
 void SamplerStateArray::BindCS()
 {
+	if (!PipelineState::SetSamplers(static_cast<int>(SamplerStateBindingLocation::COMPUTE_SHADER), 0u, static_cast<unsigned int>(m_rawSamplerStatePointers.size()), m_rawSamplerStatePointers.data()))
+		return;
+
 	INFOMAN(m_deviceResources);
 	GFX_THROW_INFO_ONLY(
 		m_deviceResources->D3DDeviceContext()->CSSetSamplers(0u, static_cast<unsigned int>(m_rawSamplerStatePointers.size()), m_rawSamplerStatePointers.data())
@@ -46,6 +50,9 @@ void SamplerStateArray::BindCS()
 
 void SamplerStateArray::BindVS()
 {
+	if (!PipelineState::SetSamplers(static_cast<int>(SamplerStateBindingLocation::VERTEX_SHADER), 0u, static_cast<unsigned int>(m_rawSamplerStatePointers.size()), m_rawSamplerStatePointers.data()))
+		return;
+
 	INFOMAN(m_deviceResources);
 	GFX_THROW_INFO_ONLY(
 		m_deviceResources->D3DDeviceContext()->VSSetSamplers(0u, static_cast<unsigned int>(m_rawSamplerStatePointers.size()), m_rawSamplerStatePointers.data())
@@ -54,6 +61,9 @@ void SamplerStateArray::BindVS()
 
 void SamplerStateArray::BindHS()
 {
+	if (!PipelineState::SetSamplers(static_cast<int>(SamplerStateBindingLocation::HULL_SHADER), 0u, static_cast<unsigned int>(m_rawSamplerStatePointers.size()), m_rawSamplerStatePointers.data()))
+		return;
+
 	INFOMAN(m_deviceResources);
 	GFX_THROW_INFO_ONLY(
 		m_deviceResources->D3DDeviceContext()->HSSetSamplers(0u, static_cast<unsigned int>(m_rawSamplerStatePointers.size()), m_rawSamplerStatePointers.data())
@@ -62,6 +72,9 @@ void SamplerStateArray::BindHS()
 
 void SamplerStateArray::BindDS()
 {
+	if (!PipelineState::SetSamplers(static_cast<int>(SamplerStateBindingLocation::DOMAIN_SHADER), 0u, static_cast<unsigned int>(m_rawSamplerStatePointers.size()), m_rawSamplerStatePointers.data()))
+		return;
+
 	INFOMAN(m_deviceResources);
 	GFX_THROW_INFO_ONLY(
 		m_deviceResources->D3DDeviceContext()->DSSetSamplers(0u, static_cast<unsigned int>(m_rawSamplerStatePointers.size()), m_rawSamplerStatePointers.data())
@@ -70,6 +83,9 @@ void SamplerStateArray::BindDS()
 
 void SamplerStateArray::BindGS()
 {
+	if (!PipelineState::SetSamplers(static_cast<int>(SamplerStateBindingLocation::GEOMETRY_SHADER), 0u, static_cast<unsigned int>(m_rawSamplerStatePointers.size()), m_rawSamplerStatePointers.data()))
+		return;
+
 	INFOMAN(m_deviceResources);
 	GFX_THROW_INFO_ONLY(
 		m_deviceResources->D3DDeviceContext()->GSSetSamplers(0u, static_cast<unsigned int>(m_rawSamplerStatePointers.size()), m_rawSamplerStatePointers.data())
@@ -78,6 +94,9 @@ void SamplerStateArray::BindGS()
 
 void SamplerStateArray::BindPS()
 {
+	if (!PipelineState::SetSamplers(static_cast<int>(SamplerStateBindingLocation::PIXEL_SHADER), 0u, static_cast<unsigned int>(m_rawSamplerStatePointers.size()), m_rawSamplerStatePointers.data()))
+		return;
+
 	INFOMAN(m_deviceResources);
 	GFX_THROW_INFO_ONLY(
 		m_deviceResources->D3DDeviceContext()->PSSetSamplers(0u, static_cast<unsigned int>(m_rawSamplerStatePointers.size()), m_rawSamplerStatePointers.data())
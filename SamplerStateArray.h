@@ -27,12 +27,14 @@ public:
 	void ClearSamplerStates();
 	
 	void Bind() override;
+	BindableSlot Slot() const override { return m_slot; }
 
 	ID3D11SamplerState* GetRawPointer(int index) { return m_samplerStates[index]->GetRawPointer(); }
 
 
 private:
 	std::function<void()> BindFunc;
+	BindableSlot m_slot;
 
 	void BindCS();
 	void BindVS();
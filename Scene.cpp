@@ -28,7 +28,8 @@ Scene::Scene(std::shared_ptr<DeviceResources> deviceResources, HWND hWnd) :
 	m_clickedObject = nullptr;
 #endif
 
-	CreateAndBindModelViewProjectionBuffer();
+	// Create the frustum (will have bad values to start but will get updated every frame)
+	m_frustum = std::make_unique<Frustum>(1500.0f, DirectX::XMMatrixIdentity(), DirectX::XMMatrixIdentity());
 
 	// Terrain
 	m_terrain = std::make_shared<Terrain>(m_deviceResources, m_moveLookController);
@@ -70,29 +71,16 @@ std::shared_ptr<Player> Scene::CreatePlayer(std::string modelFilename)
 	return player;
 }
 
-void Scene::CreateAndBindModelViewProjectionBuffer()
+void Scene::RemoveDrawable(std::shared_ptr<Drawable> drawable)
 {
-	// Basically all objects that get rendered need to bind model/view/projection matrices
-	// to the vertex shader. Instead of each object attempting to bind the same constant buffer,
-	// the scene can set this buffer once at the start of the program and each update simply needs 
-	// to update the members of the constant buffer that its vertex shader program will use
-
-	INFOMAN(m_deviceResources);
-
-	// Create a dynamic usage constant buffer that can be updated from the CPU
-	std::shared_ptr<ConstantBuffer> modelViewProjectionConstantBuffer = std::make_shared<ConstantBuffer>(m_deviceResources);
-	modelViewProjectionConstantBuffer->CreateBuffer<ModelViewProjectionConstantBuffer>(
-		D3D11_USAGE_DYNAMIC,			// Usage: Dynamic
-		D3D11_CPU_ACCESS_WRITE,			// CPU Access: CPU will be able to write using Map
-		0,								// Misc Flags: No miscellaneous flags
-		0								// Structured Byte Stride: Not totally sure, but I don't think this needs to be set because even though it is a structured buffer, there is only a single element
-		// Not supplying any initial data
-	);
-
-	ID3D11Buffer* buffer[1] = { modelViewProjectionConstantBuffer->GetRawBufferPointer() };
-	GFX_THROW_INFO_ONLY(
-		m_deviceResources->D3DDeviceContext()->VSSetConstantBuffers(0u, 1u, buffer)
-	);
+	// The culling boxes are rebuilt from m_drawables every frame, so nothing else refers to its position
+	m_drawables.erase(std::remove(m_drawables.begin(), m_drawables.end(), drawable), m_drawables.end());
+	if (m_mouseHoveredDrawable == drawable)
+		m_mouseHoveredDrawable = nullptr;
+#ifndef NDEBUG
+	if (m_clickedObject == drawable)
+		m_clickedObject = nullptr;
+#endif
 }
 
 void Scene::WindowResized()
@@ -270,11 +258,49 @@ void Scene::ProcessKeyboardEvents(std::shared_ptr<StepTimer> timer, std::shared_
 	}
 }
 
+void Scene::CullDrawables()
+{
+#ifndef NDEBUG
+	std::shared_ptr<MoveLookController> mlc = (m_useFlyMoveLookController) ? m_flyMoveLookController : m_moveLookController;
+#else
+	std::shared_ptr<MoveLookController> mlc = m_moveLookController;
+#endif
+	m_frustum->UpdateFrustum(mlc->ViewMatrix(), m_moveLookController->ProjectionMatrix());
+
+	// The bounds of every drawable go into one batch, so they are all tested with a single frustum call
+	m_drawableBatch.Clear();
+	m_drawableBoxes.clear();
+	for (std::shared_ptr<Drawable> drawable : m_drawables)
+	{
+		XMFLOAT3 minimum, maximum;
+		if (drawable->GetWorldBounds(minimum, maximum))
+			m_drawableBoxes.push_back(static_cast<int>(m_drawableBatch.Add(minimum.x, minimum.y, minimum.z, maximum.x, maximum.y, maximum.z)));
+		else
+			m_drawableBoxes.push_back(-1);
+	}
+
+	m_drawableBatch.Check(m_frustum.get());
+}
+
 void Scene::Draw()
 {
-	// Draw all drawables - NOTE: If using a SkyDome, it MUST be the first drawable
+	// Every drawable submits its nodes to the queue, which then draws them grouped by pass, shader and material.
+	// The SkyDome is in the BACKGROUND pass, so it is drawn first no matter where it is in m_drawables
+	m_renderQueue.Clear();
+	CullDrawables();
+	for (size_t iii = 0; iii < m_drawables.size(); ++iii)
+	{
+		if (m_drawableBoxes[iii] == -1 || m_drawableBatch.IsVisible(m_drawableBoxes[iii]))
+			m_drawables[iii]->Submit(m_renderQueue);
+	}
+
+	m_renderQueue.Sort();
+	m_renderQueue.Execute(m_renderBackend);
+
+#ifndef NDEBUG
 	for (std::shared_ptr<Drawable> drawable : m_drawables)
-		drawable->Draw();
+		drawable->DrawBoundingBoxes();
+#endif
 
 	m_terrain->Draw();
 }
@@ -13,9 +13,12 @@
 #include "SkyDomeMesh.h"
 #include "TerrainMesh.h"
 #include "Frustum.h"
+#include "FrustumBoxBatch.h"
 #include "FlyMoveLookController.h"
 #include "CenterOnOriginMoveLookController.h"
 #include "BoundingBox.h"
+#include "RenderQueue.h"
+#include "DeviceContextRenderBackend.h"
 
 #include "Drawable.h"
 #include "Box.h"
@@ -29,6 +32,7 @@
 #include <vector>
 #include <type_traits>
 #include <string>
+#include <algorithm>
 
 
 
@@ -49,6 +53,7 @@ public:
 	std::shared_ptr<Drawable> CreateDrawable(BasicModelType modelType);
 	std::shared_ptr<Drawable> CreateDrawable(std::string modelFilename);
 	std::shared_ptr<Player> CreatePlayer(std::string modelFilename);
+	void RemoveDrawable(std::shared_ptr<Drawable> drawable);
 
 	std::shared_ptr<MoveLookController> GetMoveLookController() { return m_moveLookController; }
 
@@ -60,9 +65,9 @@ public:
 	void Activate();
 
 private:
-	void CreateAndBindModelViewProjectionBuffer();
 	void ProcessMouseEvents(std::shared_ptr<StepTimer> timer, std::shared_ptr<Mouse> mouse);
 	void ProcessKeyboardEvents(std::shared_ptr<StepTimer> timer, std::shared_ptr<Keyboard> keyboard);
+	void CullDrawables();
 
 	HWND												m_hWnd;
 	std::shared_ptr<DeviceResources>					m_deviceResources;
@@ -78,6 +83,16 @@ private:
 	std::vector<std::shared_ptr<Drawable>>				m_drawables;
 	std::shared_ptr<Terrain>							m_terrain;
 
+	// Frustum culling of the drawables - m_drawableBoxes holds each drawable's index in m_drawableBatch, or -1 for
+	// drawables without bounds, which are always drawn
+	std::unique_ptr<Frustum>							m_frustum;
+	FrustumBoxBatch										m_drawableBatch;
+	std::vector<int>									m_drawableBoxes;
+
+	// Draw submission
+	RenderQueue											m_renderQueue;
+	DeviceContextRenderBackend							m_renderBackend;
+
 	// Mouse Input state variables
 	bool m_LButtonDown, m_RButtonDown, m_MButtonDown;
 	std::shared_ptr<Drawable> m_mouseHoveredDrawable;
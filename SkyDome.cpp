@@ -10,6 +10,7 @@ SkyDome::SkyDome(std::shared_ptr<DeviceResources> deviceResources, std::shared_p
 	AddBindable("sky-dome-vertex-shader");				// Vertex Shader
 	AddBindable("sky-dome-vertex-shader-IA");			// Input Layout
 	AddBindable("sky-dome-pixel-shader");				// Pixel Shader
+	SetRenderPass(RenderPass::BACKGROUND);				// Depth is disabled, so it must be drawn before everything else
 	AddBindable("solidfill"); //"wireframe",			// Rasterizer State
 	AddBindable("depth-disabled-depth-stencil-state");	// Depth Stencil State
 	//AddBindable("sky-dome-buffers-VS");					// VS Constant buffers
@@ -23,15 +24,8 @@ SkyDome::SkyDome(std::shared_ptr<DeviceResources> deviceResources, std::shared_p
 		// Make sure the location of the sky dome is always centered on the camera
 		DirectX::XMStoreFloat3(&m_translation, m_moveLookController->Position());
 
-		// Pretty much every object will need to submit model/view/projection data to the vertex shader
-		// The Scene binds a ModelViewProjectionConstantBuffer object to slot 0 of the vertex shader that
-		// can be mapped and written to by any object. The reason we don't automatically perform this update
-		// for every drawable is that not every drawable actually requires this update. For example, the Terrain
-		// is not a drawable, but instead houses many TerrainCells that are drawable. However, each of these 
-		// TerrainCells do not require this update because Terrain is able to set up the model view projection 
-		// buffer once before trying to draw each TerrainCell
-		UpdateModelViewProjectionConstantBuffer();
-
+		// The model/view/projection constants do not need updating here - they are written to the
+		// ConstantRingBuffer for every node right before it is drawn
 
 		// Updating of any additional constant buffers or other pipeline resources should go here
 	};
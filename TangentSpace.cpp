@@ -0,0 +1,356 @@
+#include "TangentSpace.h"
+
+using DirectX::XMFLOAT4;
+
+// Work sizes of the tasks Generate splits its passes into
+constexpr int TRIANGLES_PER_TASK = 16384;
+constexpr int VERTICES_PER_TASK = 16384;
+
+TangentSpace::Implementation TangentSpace::s_implementation = TangentSpace::BestImplementation();
+
+TangentSpace::Implementation TangentSpace::BestImplementation()
+{
+	// Every x64 processor has SSE2. The AVX path is only taken on processors that also have AVX2, which is all
+	// CpuFeatures checks for
+	if (CpuFeatures::HasAvx2())
+		return Implementation::AVX;
+	return Implementation::SSE;
+}
+
+void TangentSpace::SetImplementation(Implementation implementation)
+{
+	// Like Base64, the order of the enum is also the order of support
+	s_implementation = std::min(implementation, BestImplementation());
+}
+
+void TangentSpace::CalculateFaceVectors(const VertexStreams& vertices, const unsigned int* indices, size_t first, size_t end, const FaceVectors& faces)
+{
+	// The vector paths advance first past the triangles they handled and leave the rest to the scalar code
+	switch (s_implementation)
+	{
+	case Implementation::AVX:
+		CalculateFaceVectorsAvx(vertices, indices, first, end, faces);
+		[[fallthrough]];
+	case Implementation::SSE:
+		CalculateFaceVectorsSse(vertices, indices, first, end, faces);
+		break;
+	default:
+		break;
+	}
+
+	CalculateFaceVectorsScalar(vertices, indices, first, end, faces);
+}
+
+void TangentSpace::CalculateFaceVectorsScalar(const VertexStreams& vertices, const unsigned int* indices, size_t first, size_t end, const FaceVectors& faces)
+{
+	float vector1[3], vector2[3];
+	float tuVector[2], tvVector[2];
+	float tangent[3], binormal[3];
+	float den, length;
+
+	for (size_t t = first; t < end; ++t)
+	{
+		unsigned int index1 = indices[t * 3];
+		unsigned int index2 = indices[(t * 3) + 1];
+		unsigned int index3 = indices[(t * 3) + 2];
+
+		// Calculate the two vectors for this face.
+		vector1[0] = vertices.x[index2] - vertices.x[index1];
+		vector1[1] = vertices.y[index2] - vertices.y[index1];
+		vector1[2] = vertices.z[index2] - vertices.z[index1];
+
+		vector2[0] = vertices.x[index3] - vertices.x[index1];
+		vector2[1] = vertices.y[index3] - vertices.y[index1];
+		vector2[2] = vertices.z[index3] - vertices.z[index1];
+
+		// Calculate the tu and tv texture space vectors.
+		tuVector[0] = vertices.u[index2] - vertices.u[index1];
+		tvVector[0] = vertices.v[index2] - vertices.v[index1];
+
+		tuVector[1] = vertices.u[index3] - vertices.u[index1];
+		tvVector[1] = vertices.v[index3] - vertices.v[index1];
+
+		// Calculate the denominator of the tangent/binormal equation.
+		den = 1.0f / (tuVector[0] * tvVector[1] - tuVector[1] * tvVector[0]);
+
+		// Calculate the cross products and multiply by the coefficient to get the tangent and binormal.
+		tangent[0] = (tvVector[1] * vector1[0] - tvVector[0] * vector2[0]) * den;
+		tangent[1] = (tvVector[1] * vector1[1] - tvVector[0] * vector2[1]) * den;
+		tangent[2] = (tvVector[1] * vector1[2] - tvVector[0] * vector2[2]) * den;
+
+		binormal[0] = (tuVector[0] * vector2[0] - tuVector[1] * vector1[0]) * den;
+		binormal[1] = (tuVector[0] * vector2[1] - tuVector[1] * vector1[1]) * den;
+		binormal[2] = (tuVector[0] * vector2[2] - tuVector[1] * vector1[2]) * den;
+
+		// Normalize the tangent and the binormal and then store them.
+		length = std::sqrt((tangent[0] * tangent[0]) + (tangent[1] * tangent[1]) + (tangent[2] * tangent[2]));
+		faces.tangentX[t] = tangent[0] / length;
+		faces.tangentY[t] = tangent[1] / length;
+		faces.tangentZ[t] = tangent[2] / length;
+
+		length = std::sqrt((binormal[0] * binormal[0]) + (binormal[1] * binormal[1]) + (binormal[2] * binormal[2]));
+		faces.binormalX[t] = binormal[0] / length;
+		faces.binormalY[t] = binormal[1] / length;
+		faces.binormalZ[t] = binormal[2] / length;
+	}
+}
+
+void TangentSpace::CalculateFaceVectorsSse(const VertexStreams& vertices, const unsigned int* indices, size_t& first, size_t end, const FaceVectors& faces)
+{
+	// Same operations as the scalar code, one triangle per lane. The corners are gathered lane by lane - the
+	// indices can point anywhere, so there is no faster way to load them
+	for (; first + 4 <= end; first += 4)
+	{
+		const unsigned int* triangle = indices + (first * 3);
+		auto Gather = [triangle](const float* stream, int corner)
+		{
+			return _mm_setr_ps(stream[triangle[corner]], stream[triangle[3 + corner]], stream[triangle[6 + corner]], stream[triangle[9 + corner]]);
+		};
+
+		__m128 x1 = Gather(vertices.x, 0), y1 = Gather(vertices.y, 0), z1 = Gather(vertices.z, 0);
+		__m128 u1 = Gather(vertices.u, 0), v1 = Gather(vertices.v, 0);
+
+		__m128 vector1X = _mm_sub_ps(Gather(vertices.x, 1), x1);
+		__m128 vector1Y = _mm_sub_ps(Gather(vertices.y, 1), y1);
+		__m128 vector1Z = _mm_sub_ps(Gather(vertices.z, 1), z1);
+		__m128 vector2X = _mm_sub_ps(Gather(vertices.x, 2), x1);
+		__m128 vector2Y = _mm_sub_ps(Gather(vertices.y, 2), y1);
+		__m128 vector2Z = _mm_sub_ps(Gather(vertices.z, 2), z1);
+
+		__m128 tu1 = _mm_sub_ps(Gather(vertices.u, 1), u1);
+		__m128 tv1 = _mm_sub_ps(Gather(vertices.v, 1), v1);
+		__m128 tu2 = _mm_sub_ps(Gather(vertices.u, 2), u1);
+		__m128 tv2 = _mm_sub_ps(Gather(vertices.v, 2), v1);
+
+		__m128 den = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sub_ps(_mm_mul_ps(tu1, tv2), _mm_mul_ps(tu2, tv1)));
+
+		__m128 tangentX = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(tv2, vector1X), _mm_mul_ps(tv1, vector2X)), den);
+		__m128 tangentY = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(tv2, vector1Y), _mm_mul_ps(tv1, vector2Y)), den);
+		__m128 tangentZ = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(tv2, vector1Z), _mm_mul_ps(tv1, vector2Z)), den);
+
+		__m128 binormalX = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(tu1, vector2X), _mm_mul_ps(tu2, vector1X)), den);
+		__m128 binormalY = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(tu1, vector2Y), _mm_mul_ps(tu2, vector1Y)), den);
+		__m128 binormalZ = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(tu1, vector2Z), _mm_mul_ps(tu2, vector1Z)), den);
+
+		__m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(tangentX, tangentX), _mm_mul_ps(tangentY, tangentY)), _mm_mul_ps(tangentZ, tangentZ)));
+		_mm_storeu_ps(faces.tangentX + first, _mm_div_ps(tangentX, length));
+		_mm_storeu_ps(faces.tangentY + first, _mm_div_ps(tangentY, length));
+		_mm_storeu_ps(faces.tangentZ + first, _mm_div_ps(tangentZ, length));
+
+		length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(binormalX, binormalX), _mm_mul_ps(binormalY, binormalY)), _mm_mul_ps(binormalZ, binormalZ)));
+		_mm_storeu_ps(faces.binormalX + first, _mm_div_ps(binormalX, length));
+		_mm_storeu_ps(faces.binormalY + first, _mm_div_ps(binormalY, length));
+		_mm_storeu_ps(faces.binormalZ + first, _mm_div_ps(binormalZ, length));
+	}
+}
+
+void TangentSpace::CalculateFaceVectorsAvx(const VertexStreams& vertices, const unsigned int* indices, size_t& first, size_t end, const FaceVectors& faces)
+{
+	// Same as CalculateFaceVectorsSse, eight triangles at a time
+	for (; first + 8 <= end; first += 8)
+	{
+		const unsigned int* triangle = indices + (first * 3);
+		auto Gather = [triangle](const float* stream, int corner)
+		{
+			return _mm256_setr_ps(
+				stream[triangle[corner]], stream[triangle[3 + corner]], stream[triangle[6 + corner]], stream[triangle[9 + corner]],
+				stream[triangle[12 + corner]], stream[triangle[15 + corner]], stream[triangle[18 + corner]], stream[triangle[21 + corner]]
+			);
+		};
+
+		__m256 x1 = Gather(vertices.x, 0), y1 = Gather(vertices.y, 0), z1 = Gather(vertices.z, 0);
+		__m256 u1 = Gather(vertices.u, 0), v1 = Gather(vertices.v, 0);
+
+		__m256 vector1X = _mm256_sub_ps(Gather(vertices.x, 1), x1);
+		__m256 vector1Y = _mm256_sub_ps(Gather(vertices.y, 1), y1);
+		__m256 vector1Z = _mm256_sub_ps(Gather(vertices.z, 1), z1);
+		__m256 vector2X = _mm256_sub_ps(Gather(vertices.x, 2), x1);
+		__m256 vector2Y = _mm256_sub_ps(Gather(vertices.y, 2), y1);
+		__m256 vector2Z = _mm256_sub_ps(Gather(vertices.z, 2), z1);
+
+		__m256 tu1 = _mm256_sub_ps(Gather(vertices.u, 1), u1);
+		__m256 tv1 = _mm256_sub_ps(Gather(vertices.v, 1), v1);
+		__m256 tu2 = _mm256_sub_ps(Gather(vertices.u, 2), u1);
+		__m256 tv2 = _mm256_sub_ps(Gather(vertices.v, 2), v1);
+
+		__m256 den = _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_sub_ps(_mm256_mul_ps(tu1, tv2), _mm256_mul_ps(tu2, tv1)));
+
+		__m256 tangentX = _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(tv2, vector1X), _mm256_mul_ps(tv1, vector2X)), den);
+		__m256 tangentY = _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(tv2, vector1Y), _mm256_mul_ps(tv1, vector2Y)), den);
+		__m256 tangentZ = _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(tv2, vector1Z), _mm256_mul_ps(tv1, vector2Z)), den);
+
+		__m256 binormalX = _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(tu1, vector2X), _mm256_mul_ps(tu2, vector1X)), den);
+		__m256 binormalY = _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(tu1, vector2Y), _mm256_mul_ps(tu2, vector1Y)), den);
+		__m256 binormalZ = _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(tu1, vector2Z), _mm256_mul_ps(tu2, vector1Z)), den);
+
+		__m256 length = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(tangentX, tangentX), _mm256_mul_ps(tangentY, tangentY)), _mm256_mul_ps(tangentZ, tangentZ)));
+		_mm256_storeu_ps(faces.tangentX + first, _mm256_div_ps(tangentX, length));
+		_mm256_storeu_ps(faces.tangentY + first, _mm256_div_ps(tangentY, length));
+		_mm256_storeu_ps(faces.tangentZ + first, _mm256_div_ps(tangentZ, length));
+
+		length = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(binormalX, binormalX), _mm256_mul_ps(binormalY, binormalY)), _mm256_mul_ps(binormalZ, binormalZ)));
+		_mm256_storeu_ps(faces.binormalX + first, _mm256_div_ps(binormalX, length));
+		_mm256_storeu_ps(faces.binormalY + first, _mm256_div_ps(binormalY, length));
+		_mm256_storeu_ps(faces.binormalZ + first, _mm256_div_ps(binormalZ, length));
+	}
+
+	// Leave the upper halves clean for any SSE code that runs next
+	_mm256_zeroupper();
+}
+
+void TangentSpace::Generate(const VertexStreams& vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount, XMFLOAT4* tangents, ThreadPool& pool)
+{
+	const size_t triangleCount = indexCount / 3;
+
+	std::vector<float> faceData(triangleCount * 6);
+	FaceVectors faces = {
+		faceData.data(),
+		faceData.data() + triangleCount,
+		faceData.data() + (triangleCount * 2),
+		faceData.data() + (triangleCount * 3),
+		faceData.data() + (triangleCount * 4),
+		faceData.data() + (triangleCount * 5)
+	};
+
+	pool.ParallelFor(0, static_cast<int>(triangleCount), TRIANGLES_PER_TASK, [&vertices, indices, &faces](int begin, int end)
+	{
+		CalculateFaceVectors(vertices, indices, begin, end, faces);
+	});
+
+	// List the corners of every vertex (in triangle order, so the sums below come out the same however the work is
+	// split). corners[cornerStart[i] .. cornerStart[i + 1]) are the corners of vertex i
+	std::vector<uint32_t> cornerStart(vertexCount + 1, 0);
+	for (size_t iii = 0; iii < triangleCount * 3; ++iii)
+		++cornerStart[indices[iii] + 1];
+	for (size_t iii = 0; iii < vertexCount; ++iii)
+		cornerStart[iii + 1] += cornerStart[iii];
+
+	std::vector<uint32_t> corners(triangleCount * 3);
+	std::vector<uint32_t> next(cornerStart.begin(), cornerStart.end() - 1);
+	for (size_t iii = 0; iii < triangleCount * 3; ++iii)
+		corners[next[indices[iii]]++] = static_cast<uint32_t>(iii);
+
+	pool.ParallelFor(0, static_cast<int>(vertexCount), VERTICES_PER_TASK, [&](int begin, int end)
+	{
+		for (int vertex = begin; vertex < end; ++vertex)
+		{
+			const float n[3] = { vertices.nx[vertex], vertices.ny[vertex], vertices.nz[vertex] };
+			float tangent[3] = { 0.0f, 0.0f, 0.0f };
+			float binormal[3] = { 0.0f, 0.0f, 0.0f };
+
+			for (uint32_t c = cornerStart[vertex]; c < cornerStart[vertex + 1]; ++c)
+			{
+				uint32_t triangle = corners[c] / 3;
+				uint32_t corner = corners[c] % 3;
+
+				const float t[3] = { faces.tangentX[triangle], faces.tangentY[triangle], faces.tangentZ[triangle] };
+				const float b[3] = { faces.binormalX[triangle], faces.binormalY[triangle], faces.binormalZ[triangle] };
+				if (!std::isfinite(t[0] + t[1] + t[2] + b[0] + b[1] + b[2]))
+					continue;
+
+				// Weight by the angle of the triangle at this vertex
+				unsigned int other1 = indices[(triangle * 3) + ((corner + 1) % 3)];
+				unsigned int other2 = indices[(triangle * 3) + ((corner + 2) % 3)];
+				const float edge1[3] = { vertices.x[other1] - vertices.x[vertex], vertices.y[other1] - vertices.y[vertex], vertices.z[other1] - vertices.z[vertex] };
+				const float edge2[3] = { vertices.x[other2] - vertices.x[vertex], vertices.y[other2] - vertices.y[vertex], vertices.z[other2] - vertices.z[vertex] };
+				float lengths = std::sqrt((edge1[0] * edge1[0] + edge1[1] * edge1[1] + edge1[2] * edge1[2]) * (edge2[0] * edge2[0] + edge2[1] * edge2[1] + edge2[2] * edge2[2]));
+				if (lengths <= 0.0f)
+					continue;
+				float angle = std::acos(std::clamp((edge1[0] * edge2[0] + edge1[1] * edge2[1] + edge1[2] * edge2[2]) / lengths, -1.0f, 1.0f));
+
+				// Only the part of the tangent that lies in the plane of the vertex normal counts
+				float d = n[0] * t[0] + n[1] * t[1] + n[2] * t[2];
+				float projected[3] = { t[0] - n[0] * d, t[1] - n[1] * d, t[2] - n[2] * d };
+				float length = std::sqrt(projected[0] * projected[0] + projected[1] * projected[1] + projected[2] * projected[2]);
+				if (length <= 0.0f)
+					continue;
+
+				for (int iii = 0; iii < 3; ++iii)
+				{
+					tangent[iii] += projected[iii] * (angle / length);
+					binormal[iii] += b[iii] * angle;
+				}
+			}
+
+			float length = std::sqrt(tangent[0] * tangent[0] + tangent[1] * tangent[1] + tangent[2] * tangent[2]);
+			if (length <= 1e-12f)
+			{
+				// No usable texture coordinates - any direction in the plane of the normal will do. Start from the
+				// axis the normal is least aligned with
+				float axis[3] = { 0.0f, 0.0f, 0.0f };
+				axis[std::fabs(n[0]) < 0.9f ? 0 : 1] = 1.0f;
+				float d = n[0] * axis[0] + n[1] * axis[1] + n[2] * axis[2];
+				tangent[0] = axis[0] - n[0] * d;
+				tangent[1] = axis[1] - n[1] * d;
+				tangent[2] = axis[2] - n[2] * d;
+				length = std::sqrt(tangent[0] * tangent[0] + tangent[1] * tangent[1] + tangent[2] * tangent[2]);
+				if (length <= 1e-12f)
+				{
+					tangent[0] = 1.0f;
+					tangent[1] = tangent[2] = 0.0f;
+					length = 1.0f;
+				}
+			}
+
+			tangents[vertex].x = tangent[0] / length;
+			tangents[vertex].y = tangent[1] / length;
+			tangents[vertex].z = tangent[2] / length;
+
+			// Handedness - is the texture's v direction on the side of cross(normal, tangent)?
+			float crossX = n[1] * tangents[vertex].z - n[2] * tangents[vertex].y;
+			float crossY = n[2] * tangents[vertex].x - n[0] * tangents[vertex].z;
+			float crossZ = n[0] * tangents[vertex].y - n[1] * tangents[vertex].x;
+			tangents[vertex].w = (crossX * binormal[0] + crossY * binormal[1] + crossZ * binormal[2]) < 0.0f ? -1.0f : 1.0f;
+		}
+	});
+}
+
+void TangentSpace::SplitMirroredVertices(const VertexStreams& vertices, size_t vertexCount, unsigned int* indices, size_t indexCount, std::vector<uint32_t>& copiedFrom)
+{
+	const size_t triangleCount = indexCount / 3;
+	copiedFrom.clear();
+
+	// +1 for triangles whose texture runs the same way round as their corners, -1 for mirrored ones and 0 for
+	// triangles without any texture space area
+	std::vector<int8_t> handedness(triangleCount);
+	enum : uint8_t { USED_FORWARD = 1, USED_MIRRORED = 2 };
+	std::vector<uint8_t> uses(vertexCount, 0);
+	for (size_t triangle = 0; triangle < triangleCount; ++triangle)
+	{
+		const unsigned int* corners = indices + (triangle * 3);
+		float tu1 = vertices.u[corners[1]] - vertices.u[corners[0]];
+		float tv1 = vertices.v[corners[1]] - vertices.v[corners[0]];
+		float tu2 = vertices.u[corners[2]] - vertices.u[corners[0]];
+		float tv2 = vertices.v[corners[2]] - vertices.v[corners[0]];
+		float area = tu1 * tv2 - tu2 * tv1;
+		handedness[triangle] = area > 0.0f ? 1 : area < 0.0f ? -1 : 0;
+
+		if (handedness[triangle] != 0)
+		{
+			for (int corner = 0; corner < 3; ++corner)
+				uses[corners[corner]] |= handedness[triangle] > 0 ? USED_FORWARD : USED_MIRRORED;
+		}
+	}
+
+	std::vector<uint32_t> copy(vertexCount, UINT32_MAX);
+	for (size_t triangle = 0; triangle < triangleCount; ++triangle)
+	{
+		if (handedness[triangle] >= 0)
+			continue;
+
+		unsigned int* corners = indices + (triangle * 3);
+		for (int corner = 0; corner < 3; ++corner)
+		{
+			unsigned int vertex = corners[corner];
+			if (uses[vertex] != (USED_FORWARD | USED_MIRRORED))
+				continue;
+
+			if (copy[vertex] == UINT32_MAX)
+			{
+				copy[vertex] = static_cast<uint32_t>(vertexCount + copiedFrom.size());
+				copiedFrom.push_back(vertex);
+			}
+			corners[corner] = copy[vertex];
+		}
+	}
+}
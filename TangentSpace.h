@@ -0,0 +1,151 @@
+#pragma once
+#include "pch.h"
+#include "CpuFeatures.h"
+#include "ThreadPool.h"
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <stdint.h>
+
+#include <emmintrin.h>
+#include <immintrin.h>
+
+// TangentSpace computes the tangent frames used for normal mapping. Both the terrain and the meshes go through it.
+//
+// The per triangle part works on structure of arrays vertex data, 4 (SSE) or 8 (AVX) triangles at a time, and
+// falls back to scalar code for the remainder. The implementation is chosen once at runtime from CpuFeatures.
+// Every implementation produces exactly the same bits - the vector code does the same IEEE operations in the same
+// order as the scalar code (no reciprocal estimates, no fused multiply-adds). That only holds as long as the
+// compiler keeps the scalar code as written, so TangentSpace.cpp is built with /fp:precise in every configuration,
+// including the Debug ones that otherwise use /fp:fast.
+//
+// Generate builds per vertex tangents from the triangles that share each vertex: each triangle's tangent is
+// projected into the plane of the vertex normal and weighted by the angle of the triangle at that vertex, and the
+// sign of the summed binormals is stored in w. SplitMirroredVertices gives the triangles on either side of a
+// mirrored texture seam their own vertices first, so no frame averages the two handednesses together. The shader
+// rebuilds the bitangent as cross(normal, tangent.xyz) * tangent.w.
+class TangentSpace
+{
+public:
+	enum class Implementation
+	{
+		SCALAR,
+		SSE,
+		AVX
+	};
+
+	// Structure of arrays view of the vertices - every array has one entry per vertex. The normals are only read
+	// by Generate
+	struct VertexStreams
+	{
+		const float* x;
+		const float* y;
+		const float* z;
+		const float* u;
+		const float* v;
+		const float* nx;
+		const float* ny;
+		const float* nz;
+	};
+
+	// One entry per triangle
+	struct FaceVectors
+	{
+		float* tangentX;
+		float* tangentY;
+		float* tangentZ;
+		float* binormalX;
+		float* binormalY;
+		float* binormalZ;
+	};
+
+	// Unit tangent (direction of increasing u) and binormal (direction of increasing v) of triangles [first, end).
+	// Triangle t is made of the vertices indices[3t], indices[3t + 1] and indices[3t + 2]; its vectors are written
+	// to entry t of faces. A triangle without any texture space area gets non-finite vectors
+	static void CalculateFaceVectors(const VertexStreams& vertices, const unsigned int* indices, size_t first, size_t end, const FaceVectors& faces);
+
+	// Per vertex tangents (xyz unit tangent, w +1 or -1 handedness) for an indexed triangle list. The triangles are
+	// split into ranges that run on the pool. Vertices whose triangles have no usable texture coordinates get an
+	// arbitrary tangent perpendicular to their normal
+	static void Generate(const VertexStreams& vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount, DirectX::XMFLOAT4* tangents, ThreadPool& pool);
+
+	// A triangle's handedness is the sign of its area in texture space. Every vertex used by triangles of both
+	// handednesses gets a copy for the mirrored (negative) ones, and their indices are pointed at it. The copies are
+	// numbered from vertexCount on; copiedFrom gets the vertex each one copies. Triangles without any texture space
+	// area keep the vertices they have
+	static void SplitMirroredVertices(const VertexStreams& vertices, size_t vertexCount, unsigned int* indices, size_t indexCount, std::vector<uint32_t>& copiedFrom);
+
+	// Convenience for vertex types with position, texture, normal and (XMFLOAT4) tangent members. Copies the
+	// vertices into streams, splits the ones on mirrored seams (appending the copies to vertices and rewriting
+	// indices), generates the tangents and writes them back
+	template <typename V, typename A>
+	static void Generate(std::vector<V, A>& vertices, std::vector<unsigned int>& indices, ThreadPool& pool);
+
+	// Mainly for comparing the implementations - anything the processor does not support falls back to the best
+	// one it does
+	static void SetImplementation(Implementation implementation);
+	static Implementation GetImplementation() { return s_implementation; }
+
+private:
+	static Implementation BestImplementation();
+
+	static void CalculateFaceVectorsScalar(const VertexStreams& vertices, const unsigned int* indices, size_t first, size_t end, const FaceVectors& faces);
+	static void CalculateFaceVectorsSse(const VertexStreams& vertices, const unsigned int* indices, size_t& first, size_t end, const FaceVectors& faces);
+	static void CalculateFaceVectorsAvx(const VertexStreams& vertices, const unsigned int* indices, size_t& first, size_t end, const FaceVectors& faces);
+
+	static Implementation s_implementation;
+};
+
+template <typename V, typename A>
+void TangentSpace::Generate(std::vector<V, A>& vertices, std::vector<unsigned int>& indices, ThreadPool& pool)
+{
+	if (vertices.empty() || indices.empty())
+		return;
+
+	std::vector<float> streams;
+	auto Fill = [&vertices, &streams]() -> VertexStreams
+	{
+		const size_t count = vertices.size();
+		streams.resize(count * 8);
+		float* x = streams.data();
+		float* y = x + count;
+		float* z = y + count;
+		float* u = z + count;
+		float* v = u + count;
+		float* nx = v + count;
+		float* ny = nx + count;
+		float* nz = ny + count;
+
+		for (size_t iii = 0; iii < count; ++iii)
+		{
+			x[iii] = vertices[iii].position.x;
+			y[iii] = vertices[iii].position.y;
+			z[iii] = vertices[iii].position.z;
+			u[iii] = vertices[iii].texture.x;
+			v[iii] = vertices[iii].texture.y;
+			nx[iii] = vertices[iii].normal.x;
+			ny[iii] = vertices[iii].normal.y;
+			nz[iii] = vertices[iii].normal.z;
+		}
+		return { x, y, z, u, v, nx, ny, nz };
+	};
+
+	VertexStreams view = Fill();
+	std::vector<uint32_t> copiedFrom;
+	SplitMirroredVertices(view, vertices.size(), indices.data(), indices.size(), copiedFrom);
+	if (!copiedFrom.empty())
+	{
+		vertices.reserve(vertices.size() + copiedFrom.size());
+		for (uint32_t source : copiedFrom)
+			vertices.push_back(vertices[source]);
+		view = Fill();
+	}
+
+	const size_t count = vertices.size();
+	std::vector<DirectX::XMFLOAT4> tangents(count);
+	Generate(view, count, indices.data(), indices.size(), tangents.data(), pool);
+
+	for (size_t iii = 0; iii < count; ++iii)
+		vertices[iii].tangent = tangents[iii];
+}
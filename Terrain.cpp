@@ -1,7 +1,9 @@
 #include "Terrain.h"
+#include "Player.h"
 
 using DirectX::XMFLOAT4;
 using DirectX::XMFLOAT3;
+using DirectX::XMFLOAT2;
 using DirectX::XMMATRIX;
 
 Terrain::Terrain(std::shared_ptr<DeviceResources> deviceResources, std::shared_ptr<MoveLookController> moveLookController) :
@@ -12,35 +14,61 @@ Terrain::Terrain(std::shared_ptr<DeviceResources> deviceResources, std::shared_p
 	m_minY(FLT_MAX),
 	m_maxY(-FLT_MAX),
 	m_minZ(FLT_MAX),
-	m_maxZ(-FLT_MAX)
+	m_maxZ(-FLT_MAX),
+	m_projectionMatrix(DirectX::XMMatrixIdentity()),
+	m_lodPixelTolerance(2.0f),
+	m_lastTriangleCount(0),
+	m_previousFocus(XMFLOAT3(0.0f, 0.0f, 0.0f)),
+	m_streamingStarted(false)
 {
 	// Create the frustum (will have bad values to start but will get updated later)
 	m_frustum = std::make_shared<Frustum>(1500.0f, DirectX::XMMatrixIdentity(), DirectX::XMMatrixIdentity());
 
 	m_terrainMesh = ObjectStore::GetTerrainMesh("terrain-mesh");
-	for (int iii = 0; iii < m_terrainMesh->TerrainCellCount(); ++iii)
+	m_heightField = m_terrainMesh->GetHeightField();
+
+	// The bounds of every cell are known up front, even for cells that are not loaded yet
+	const std::vector<TerrainCellBounds>& cellBounds = m_terrainMesh->GetCellBounds();
+	for (const TerrainCellBounds& bounds : cellBounds)
 	{
-		// Also populate the visibility vector
-		m_terrainCellVisibility.push_back(false);
+		m_minX = std::min(m_minX, bounds.minX);
+		m_maxX = std::max(m_maxX, bounds.maxX);
+		m_minY = std::min(m_minY, bounds.minY);
+		m_maxY = std::max(m_maxY, bounds.maxY);
+		m_minZ = std::min(m_minZ, bounds.minZ);
+		m_maxZ = std::max(m_maxZ, bounds.maxZ);
+	}
 
-		std::ostringstream oss;
-		oss << "terrain_" << iii;
+	// Build the culling hierarchy over the cells and make room for every cell to be visible
+	m_quadTree = std::make_unique<TerrainQuadTree>(cellBounds, m_terrainMesh->TerrainCellRowCount());
+	m_visibleCells.reserve(cellBounds.size());
 
-		m_terrainCells.push_back(std::make_shared<TerrainCell>(deviceResources, moveLookController, oss.str()));
-	
-		// As each new cell is added, update min/max values
-		if (m_terrainCells.back()->GetMaxX() > m_maxX)
-			m_maxX = m_terrainCells.back()->GetMaxX();
-		if (m_terrainCells.back()->GetMinX() < m_minX)
-			m_minX = m_terrainCells.back()->GetMinX();
-		if (m_terrainCells.back()->GetMaxY() > m_maxY)
-			m_maxY = m_terrainCells.back()->GetMaxY();
-		if (m_terrainCells.back()->GetMinY() < m_minY)
-			m_minY = m_terrainCells.back()->GetMinY();
-		if (m_terrainCells.back()->GetMaxZ() > m_maxZ)
-			m_maxZ = m_terrainCells.back()->GetMaxZ();
-		if (m_terrainCells.back()->GetMinZ() < m_minZ)
-			m_minZ = m_terrainCells.back()->GetMinZ();
+	// The error of every level is measured against the height field, which covers cells that are not loaded, the
+	// first time a cell takes part in the selection
+	std::shared_ptr<TerrainLodPatterns> lodPatterns = m_terrainMesh->GetLodPatterns();
+	m_lodSelector = std::make_unique<TerrainLodSelector>(*m_heightField, cellBounds, m_terrainMesh->TerrainCellRowCount(),
+		lodPatterns->CellSize(), lodPatterns->LevelCount(), ThreadPool::Default());
+
+	m_terrainCells.resize(cellBounds.size());
+	if (m_terrainMesh->IsStreaming())
+	{
+		TerrainStreamingSettings settings;
+		settings.loadRadius = 512.0f;					// 16 cells in every direction
+		settings.hysteresis = 64.0f;					// Two cells
+		settings.prefetchTime = 2.0f;
+		settings.memoryBudget = 96 * 1024 * 1024;
+		settings.maxPendingLoads = 2 * (ThreadPool::Default().ThreadCount() + 1);
+
+		m_streamer = std::make_unique<TerrainCellStreamer>(cellBounds, m_terrainMesh->TerrainCellRowCount(), m_terrainMesh->CellMemorySize(),
+			settings, ThreadPool::Default(),
+			[this](int cellIndex) { m_terrainMesh->LoadCell(cellIndex); },
+			[this](int cellIndex) { CreateCell(cellIndex); },
+			[this](int cellIndex) { DestroyCell(cellIndex); });
+	}
+	else
+	{
+		for (int iii = 0; iii < m_terrainMesh->TerrainCellCount(); ++iii)
+			CreateCell(iii);
 	}
 
 
@@ -84,30 +112,93 @@ Terrain::Terrain(std::shared_ptr<DeviceResources> deviceResources, std::shared_p
 	m_bindables.push_back(psConstantBufferArray);
 }
 
+void Terrain::CreateCell(int cellIndex)
+{
+	m_terrainCells[cellIndex] = std::make_shared<TerrainCell>(m_deviceResources, m_moveLookController, m_terrainMesh->GetTerrainCell(cellIndex));
+	m_terrainCells[cellIndex]->SetProjectionMatrix(m_projectionMatrix);
+}
+
+void Terrain::DestroyCell(int cellIndex)
+{
+	m_terrainCells[cellIndex] = nullptr;
+	m_terrainMesh->UnloadCell(cellIndex);
+}
+
 void Terrain::SetProjectionMatrix(DirectX::XMMATRIX matrix)
 {
+	m_projectionMatrix = matrix;
 	m_frustum->UpdateFrustum(m_moveLookController->ViewMatrix(), matrix);
 
 	for (std::shared_ptr<TerrainCell> cell : m_terrainCells)
-		cell->SetProjectionMatrix(matrix);
+	{
+		if (cell != nullptr)
+			cell->SetProjectionMatrix(matrix);
+	}
 }
 
 void Terrain::Update(std::shared_ptr<StepTimer> timer)
 {
-	m_frustum->UpdateFrustum(m_moveLookController->ViewMatrix(), m_terrainCells[0]->GetProjectionMatrix());
+	if (m_streamer != nullptr)
+		UpdateStreaming(timer);
+
+	m_frustum->UpdateFrustum(m_moveLookController->ViewMatrix(), m_projectionMatrix);
+
+	// Whole groups of cells are accepted or rejected at once by walking the quad tree
+	m_quadTree->GetVisibleCells(m_frustum.get(), m_visibleCells);
 
-	std::shared_ptr<TerrainCellMesh> cell;
-	for (int iii = 0; iii < m_terrainMesh->TerrainCellCount(); ++iii)
+	UpdateLevelsOfDetail();
+}
+
+void Terrain::UpdateLevelsOfDetail()
+{
+	// Levels are chosen for every cell that can be drawn (not just the visible ones) so that the stitching along the
+	// edge of the view matches whatever the neighbours will be drawn with once they come into view. While streaming
+	// only the resident cells can be drawn, and the selector adds their neighbours for the stitching
+	DirectX::XMFLOAT4X4 projection;
+	DirectX::XMStoreFloat4x4(&projection, m_projectionMatrix);
+	float projectionScale = TerrainLodSelector::ProjectionScale(projection, m_deviceResources->GetScreenViewport().Height);
+
+	XMFLOAT3 eye;
+	DirectX::XMStoreFloat3(&eye, m_moveLookController->Position());
+
+	if (m_streamer != nullptr)
+		m_lodSelector->SelectLevels(m_streamer->GetResidentCells(), eye, projectionScale, m_lodPixelTolerance);
+	else
+		m_lodSelector->SelectLevels(eye, projectionScale, m_lodPixelTolerance);
+}
+
+void Terrain::UpdateStreaming(std::shared_ptr<StepTimer> timer)
+{
+	// Stream around the player if there is one, otherwise around the camera
+	XMFLOAT3 focus;
+	std::shared_ptr<Player> player = m_moveLookController->GetPlayer();
+	if (player != nullptr)
+		focus = player->CenterOfModel();
+	else
+		DirectX::XMStoreFloat3(&focus, m_moveLookController->Position());
+
+	XMFLOAT3 velocity = XMFLOAT3(0.0f, 0.0f, 0.0f);
+	float elapsed = static_cast<float>(timer->GetElapsedSeconds());
+	if (m_streamingStarted && elapsed > 0.0f)
 	{
-		cell = m_terrainMesh->GetTerrainCell(iii);
-		m_terrainCellVisibility[iii] = m_frustum->CheckRectangle2(
-			cell->GetMaxX(),
-			cell->GetMaxY(),
-			cell->GetMaxZ(),
-			cell->GetMinX(),
-			cell->GetMinY(),
-			cell->GetMinZ()
-		);
+		velocity.x = (focus.x - m_previousFocus.x) / elapsed;
+		velocity.y = (focus.y - m_previousFocus.y) / elapsed;
+		velocity.z = (focus.z - m_previousFocus.z) / elapsed;
+	}
+	m_previousFocus = focus;
+
+	m_streamer->Update(focus, velocity);
+
+	// Block on the very first update so the terrain around the player is there on the first frame instead
+	// of popping in
+	if (!m_streamingStarted)
+	{
+		while (m_streamer->PendingLoadCount() > 0)
+		{
+			m_streamer->WaitForPendingLoads();
+			m_streamer->Update(focus, velocity);
+		}
+		m_streamingStarted = true;
 	}
 }
 
@@ -118,88 +209,63 @@ void Terrain::Draw()
 
 	UpdateBindings();
 
-	for (unsigned int iii = 0; iii < m_terrainCells.size(); ++iii)
+	// Cells that are visible but still loading are skipped
+	std::shared_ptr<TerrainLodPatterns> lodPatterns = m_terrainMesh->GetLodPatterns();
+	m_lastTriangleCount = 0;
+	for (int cellIndex : m_visibleCells)
 	{
-		if (m_terrainCellVisibility[iii])
-			m_terrainCells[iii]->Draw();
+		if (m_terrainCells[cellIndex] == nullptr)
+			continue;
+
+		int level = m_lodSelector->GetLevel(cellIndex);
+		int stitchMask = m_lodSelector->GetStitchMask(cellIndex);
+		m_terrainMesh->GetTerrainCell(cellIndex)->SetLod(level, stitchMask);
+		m_lastTriangleCount += lodPatterns->GetPattern(level, stitchMask).indexCount / 3;
+
+		m_terrainCells[cellIndex]->Draw();
 	}
 }
 
 void Terrain::UpdateBindings()
 {
-	// Update the vertex shader constant buffer
-
-	INFOMAN(m_deviceResources);
-	ID3D11DeviceContext4* context = m_deviceResources->D3DDeviceContext();
-
-	D3D11_MAPPED_SUBRESOURCE ms;
-	ZeroMemory(&ms, sizeof(D3D11_MAPPED_SUBRESOURCE));
-
-	// Update VS constant buffer with model/view/projection info
-	Microsoft::WRL::ComPtr<ID3D11Buffer> vsBuffer;
-	GFX_THROW_INFO_ONLY(
-		context->VSGetConstantBuffers(0, 1, vsBuffer.ReleaseAndGetAddressOf())
-	);
-
-	GFX_THROW_INFO(
-		context->Map(vsBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &ms)
-	);
-
-	ModelViewProjectionConstantBuffer* mappedBuffer = (ModelViewProjectionConstantBuffer*)ms.pData;
-	XMMATRIX model = DirectX::XMMatrixIdentity();
-	XMMATRIX viewProjection = m_moveLookController->ViewMatrix() * m_terrainCells[0]->GetProjectionMatrix();
-	DirectX::XMStoreFloat4x4(&(mappedBuffer->model), model);
-	DirectX::XMStoreFloat4x4(&(mappedBuffer->modelViewProjection), model * viewProjection);
-	DirectX::XMStoreFloat4x4(&(mappedBuffer->inverseTransposeModel), DirectX::XMMatrixTranspose(DirectX::XMMatrixInverse(nullptr, model)));
-
-	GFX_THROW_INFO_ONLY(
-		context->Unmap(vsBuffer.Get(), 0)
-	);
+	// Write the model/view/projection constants of every cell that will be drawn under a single Map, so that each
+	// cell only has to bind its part of the ConstantRingBuffer
+	size_t cellCount = 0;
+	for (int cellIndex : m_visibleCells)
+	{
+		if (m_terrainCells[cellIndex] != nullptr)
+			++cellCount;
+	}
+
+	if (cellCount == 0)
+		return;
+
+	ConstantRingBuffer::Map(cellCount * ConstantRingBuffer::AlignedSize(sizeof(ModelViewProjectionConstantBuffer)));
+	for (int cellIndex : m_visibleCells)
+	{
+		if (m_terrainCells[cellIndex] != nullptr)
+			m_terrainCells[cellIndex]->WriteModelViewProjection();
+	}
+	ConstantRingBuffer::Unmap();
 }
 
 float Terrain::GetHeight(float x, float z)
 {
-	for (std::shared_ptr<TerrainCell> cell : m_terrainCells)
-	{
-		if (cell->ContainsPoint(x, z))
-			return cell->GetHeight(x, z);
-	}
+	// The height field handles points outside of the terrain by returning 0.0f
+	return m_heightField->GetHeight(x, z);
+}
 
-	return 0.0f;
+void Terrain::GetHeights(const std::vector<XMFLOAT2>& points, std::vector<float>& heights)
+{
+	heights.resize(points.size());
+	m_heightField->GetHeights(points.data(), heights.data(), points.size());
 }
 
 bool Terrain::GetClickLocation(XMFLOAT3 origin, XMFLOAT3 direction, XMFLOAT3& clickLocation)
 {
-	// POSSIBLE IMPROVEMENT: Quickly determine which cell the origin parameter is in as this is
-	//						 the most likely cell for the click to be in. A really advanced continuation
-	//						 would be to then check the adjacent cells
-	//		NOTE: this probably won't actually work because the mouse can be over multiple cells, so
-	//			  even if the mouse if over the closest cell, it could also be over a further cell
-
+	// Ray march the height field - only the quads under the ray are tested and the first hit wins
 	float distance;
-	float shortestDistance = FLT_MAX;
-	XMFLOAT3 closestLocation = XMFLOAT3(0.0, 0.0f, 0.0f);
-	bool found = false;
-
-	for (unsigned int iii = 0; iii < m_terrainCells.size(); ++iii)
-	{
-		// Make sure the terrain cell is even visible before checking
-		if (m_terrainCellVisibility[iii])
-		{
-			if (m_terrainCells[iii]->GetClickLocation(origin, direction, clickLocation, distance))
-			{
-				if (distance < shortestDistance)
-				{
-					shortestDistance = distance;
-					closestLocation = clickLocation;
-					found = true;
-				}
-			}
-		}
-	}
-
-	clickLocation = closestLocation;
-	return found;
+	return m_heightField->Intersects(origin, direction, clickLocation, distance);
 }
 
 #ifndef NDEBUG
@@ -208,6 +274,9 @@ void Terrain::SetMoveLookController(std::shared_ptr<MoveLookController> mlc)
 	m_moveLookController = mlc;
 
 	for (std::shared_ptr<TerrainCell> cell : m_terrainCells)
-		cell->SetMoveLookController(mlc);
+	{
+		if (cell != nullptr)
+			cell->SetMoveLookController(mlc);
+	}
 }
 #endif
\ No newline at end of file
@@ -5,6 +5,10 @@
 #include "MoveLookController.h"
 #include "TerrainCell.h"
 #include "TerrainMesh.h"
+#include "TerrainQuadTree.h"
+#include "TerrainCellStreamer.h"
+#include "TerrainLodSelector.h"
+#include "ThreadPool.h"
 #include "Frustum.h"
 #include "Bindable.h"
 #include "SamplerStateArray.h"
@@ -30,6 +34,7 @@ public:
 	void AddBindable(std::string lookupName) { m_bindables.push_back(ObjectStore::GetBindable(lookupName)); }
 
 	float GetHeight(float x, float z);
+	void GetHeights(const std::vector<DirectX::XMFLOAT2>& points, std::vector<float>& heights);
 	float GetMinX() { return m_minX; }
 	float GetMaxX() { return m_maxX; }
 	float GetMinY() { return m_minY; }
@@ -43,8 +48,20 @@ public:
 	void SetMoveLookController(std::shared_ptr<MoveLookController> mlc);
 #endif
 
+	// Null unless the terrain mesh streams its cells
+	TerrainCellStreamer* GetStreamer() { return m_streamer.get(); }
+
+	// Largest screen space error (in pixels) that a cell may have before a more detailed level is drawn
+	float GetLodPixelTolerance() { return m_lodPixelTolerance; }
+	void SetLodPixelTolerance(float pixels) { m_lodPixelTolerance = pixels; }
+	unsigned int GetLastTriangleCount() { return m_lastTriangleCount; }
+
 private:
 	void UpdateBindings();
+	void UpdateStreaming(std::shared_ptr<StepTimer> timer);
+	void UpdateLevelsOfDetail();
+	void CreateCell(int cellIndex);
+	void DestroyCell(int cellIndex);
 
 	// Min max values for storing the min/max coordinate values
 	float m_minX, m_maxX, m_minY, m_maxY, m_minZ, m_maxZ;
@@ -52,12 +69,30 @@ private:
 	std::shared_ptr<DeviceResources>	m_deviceResources;
 	std::shared_ptr<MoveLookController> m_moveLookController;
 
+	// One entry per terrain cell - cells that are not loaded are nullptr
 	std::vector<std::shared_ptr<TerrainCell>>	m_terrainCells;
-	std::vector<bool>							m_terrainCellVisibility;
+
+	// Indices of the cells that passed frustum culling during the last Update
+	std::vector<int>							m_visibleCells;
+	std::unique_ptr<TerrainQuadTree>			m_quadTree;
 
 	std::shared_ptr<TerrainMesh>	m_terrainMesh;
+	std::shared_ptr<HeightField>	m_heightField;
 	std::shared_ptr<Frustum>		m_frustum;
 
+	DirectX::XMMATRIX				m_projectionMatrix;
+
+	// Chooses the level of detail of every cell each Update
+	std::unique_ptr<TerrainLodSelector>	m_lodSelector;
+	float								m_lodPixelTolerance;
+	unsigned int						m_lastTriangleCount;
+
+	// Pages the cells in and out around the player. Declared after the mesh and cells because its destructor
+	// waits for the loads that are still writing to them
+	std::unique_ptr<TerrainCellStreamer>	m_streamer;
+	DirectX::XMFLOAT3						m_previousFocus;
+	bool									m_streamingStarted;
+
 	// Can bind everything once that will be the same for each cell
 	std::vector<std::shared_ptr<Bindable>> m_bindables;
 };
\ No newline at end of file
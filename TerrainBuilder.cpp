@@ -0,0 +1,346 @@
+#include "TerrainBuilder.h"
+
+using DirectX::XMFLOAT3;
+using DirectX::XMFLOAT2;
+
+// Number of rows each task processes - every band also builds the vertex row on either side of it and
+// recomputes one extra row of faces
+constexpr int ROWS_PER_BAND = 16;
+
+TerrainBuilder::TerrainBuilder(int terrainWidth, int terrainHeight, float heightScale) :
+	m_terrainWidth(terrainWidth),
+	m_terrainHeight(terrainHeight),
+	m_heightScale(heightScale)
+{
+}
+
+void TerrainBuilder::Build(const std::vector<float>& rawHeights, const std::vector<XMFLOAT3>& colors, ThreadPool& pool, const BandWriter& writer)
+{
+	ColorReader readColors;
+	if (!colors.empty())
+	{
+		readColors = [this, &colors](int firstRow, int rowCount, XMFLOAT3* colorRows)
+		{
+			const XMFLOAT3* first = colors.data() + (static_cast<size_t>(m_terrainWidth) * firstRow);
+			std::copy(first, first + (static_cast<size_t>(m_terrainWidth) * rowCount), colorRows);
+		};
+	}
+
+	BuildBands([this, &rawHeights](int firstRow, int rowCount, float* rawRows)
+	{
+		const float* first = rawHeights.data() + (static_cast<size_t>(m_terrainWidth) * firstRow);
+		std::copy(first, first + (static_cast<size_t>(m_terrainWidth) * rowCount), rawRows);
+	}, readColors, pool, writer);
+}
+
+void TerrainBuilder::Build(const RawHeightMap& heightMap, const BitmapColorMap* colorMap, ThreadPool& pool, const BandWriter& writer)
+{
+	// Each band converts only the rows of the mapped files it needs and lets them go again straight away, so at
+	// most one band per thread of either map is resident at any time
+	ColorReader readColors;
+	if (colorMap != nullptr)
+	{
+		readColors = [colorMap](int firstRow, int rowCount, XMFLOAT3* colorRows)
+		{
+			colorMap->ReadRows(firstRow, rowCount, colorRows);
+			colorMap->Release(firstRow, rowCount);
+		};
+	}
+
+	BuildBands([&heightMap](int firstRow, int rowCount, float* rawRows)
+	{
+		heightMap.ReadRows(firstRow, rowCount, rawRows);
+		heightMap.Release(firstRow, rowCount);
+	}, readColors, pool, writer);
+}
+
+void TerrainBuilder::BuildBands(const RowReader& readRows, const ColorReader& readColors, ThreadPool& pool, const BandWriter& writer)
+{
+	pool.ParallelFor(0, m_terrainHeight, ROWS_PER_BAND, [this, &readRows, &readColors, &writer](int rowBegin, int rowEnd)
+	{
+		// The faces on either side of the band touch the vertex row just outside of it, so that row is built as
+		// well (and built again by the neighbouring band, which owns it)
+		int haloBegin = std::max(rowBegin - 1, 0);
+		int haloEnd = std::min(rowEnd + 1, m_terrainHeight);
+		size_t haloSize = static_cast<size_t>(m_terrainWidth) * (haloEnd - haloBegin);
+
+		std::vector<float> rawRows(haloSize);
+		std::vector<XMFLOAT3> colorRows(readColors ? haloSize : 0);
+		std::vector<float> heights(haloSize);
+		std::vector<TerrainVertexType> vertices(haloSize);
+
+		readRows(haloBegin, haloEnd - haloBegin, rawRows.data());
+		if (readColors)
+			readColors(haloBegin, haloEnd - haloBegin, colorRows.data());
+
+		// Each height map sample becomes exactly one vertex which is then shared by all of the triangles that touch it.
+		for (int j = haloBegin; j < haloEnd; j++)
+		{
+			size_t local = static_cast<size_t>(m_terrainWidth) * (j - haloBegin);
+			BuildVertexRow(j, rawRows.data() + local, readColors ? colorRows.data() + local : nullptr, heights.data() + local, vertices.data() + local);
+		}
+
+		// Vertex row j is touched by face row j - 1 (below) and face row j (above)
+		std::vector<FaceType> previousFaces(m_terrainWidth - 1);
+		std::vector<FaceType> currentFaces(m_terrainWidth - 1);
+		FaceRowScratch scratch;
+
+		if (rowBegin > 0)
+			CalculateFaceRow(vertices.data(), scratch, previousFaces);
+
+		for (int j = rowBegin; j < rowEnd; j++)
+		{
+			TerrainVertexType* row = vertices.data() + (static_cast<size_t>(m_terrainWidth) * (j - haloBegin));
+
+			if (j < (m_terrainHeight - 1))
+				CalculateFaceRow(row, scratch, currentFaces);
+
+			BuildVectorRow(j, previousFaces, currentFaces, row);
+			std::swap(previousFaces, currentFaces);
+		}
+
+		size_t first = static_cast<size_t>(m_terrainWidth) * (rowBegin - haloBegin);
+		writer(rowBegin, rowEnd - rowBegin, heights.data() + first, vertices.data() + first);
+	});
+}
+
+void TerrainBuilder::BuildVertexRow(int j, const float* rawRow, const XMFLOAT3* colorRow, float* scaledRow, TerrainVertexType* vertices)
+{
+	int i;
+	float x, y, z;
+
+	for (i = 0; i < m_terrainWidth; i++)
+	{
+		// Set the X and Z coordinates. Move the terrain depth into the positive range.  For example from (0, -256) to (256, 0).
+		x = (float)i;
+		z = -(float)j;
+		z += (float)(m_terrainHeight - 1);
+
+		// Scale the height.
+		y = rawRow[i];
+		y /= m_heightScale;
+		scaledRow[i] = y;
+
+		vertices[i].position = XMFLOAT3(x, y, z);
+
+		// The texture coordinates increase by one for every quad. Because the terrain sampler wraps,
+		// this maps the texture across each quad exactly like the old per-quad 0.0 -> 1.0 coordinates
+		vertices[i].texture = XMFLOAT2((float)i, (float)j);
+
+		vertices[i].normal = XMFLOAT3(0.0f, 0.0f, 0.0f);
+		vertices[i].tangent = XMFLOAT3(0.0f, 0.0f, 0.0f);
+		vertices[i].binormal = XMFLOAT3(0.0f, 0.0f, 0.0f);
+		vertices[i].color = colorRow == nullptr ? XMFLOAT3(1.0f, 1.0f, 1.0f) : colorRow[i];
+	}
+}
+
+void TerrainBuilder::BuildVectorRow(int j, const std::vector<FaceType>& previousFaces, const std::vector<FaceType>& currentFaces, TerrainVertexType* vertices)
+{
+	int i;
+	float sum[3], length;
+	VectorType tangent, binormal;
+
+	bool hasRowBelow = (j - 1) >= 0;
+	bool hasRowAbove = j < (m_terrainHeight - 1);
+
+	for (i = 0; i < m_terrainWidth; i++)
+	{
+		bool hasLeft = (i - 1) >= 0;
+		bool hasRight = i < (m_terrainWidth - 1);
+
+		// Take a sum of the face normals that touch this vertex (same order as the old CalculateNormals).
+		sum[0] = 0.0f;
+		sum[1] = 0.0f;
+		sum[2] = 0.0f;
+
+		// Bottom left face.
+		if (hasLeft && hasRowBelow)
+		{
+			sum[0] += previousFaces[i - 1].normal.x;
+			sum[1] += previousFaces[i - 1].normal.y;
+			sum[2] += previousFaces[i - 1].normal.z;
+		}
+
+		// Bottom right face.
+		if (hasRight && hasRowBelow)
+		{
+			sum[0] += previousFaces[i].normal.x;
+			sum[1] += previousFaces[i].normal.y;
+			sum[2] += previousFaces[i].normal.z;
+		}
+
+		// Upper left face.
+		if (hasLeft && hasRowAbove)
+		{
+			sum[0] += currentFaces[i - 1].normal.x;
+			sum[1] += currentFaces[i - 1].normal.y;
+			sum[2] += currentFaces[i - 1].normal.z;
+		}
+
+		// Upper right face.
+		if (hasRight && hasRowAbove)
+		{
+			sum[0] += currentFaces[i].normal.x;
+			sum[1] += currentFaces[i].normal.y;
+			sum[2] += currentFaces[i].normal.z;
+		}
+
+		// Normalize the final shared normal for this vertex.
+		length = (float)sqrt((sum[0] * sum[0]) + (sum[1] * sum[1]) + (sum[2] * sum[2]));
+		vertices[i].normal = XMFLOAT3(sum[0] / length, sum[1] / length, sum[2] / length);
+
+		// Sum the tangents/binormals of every triangle that touches this vertex. The order matches the old
+		// serial pass which walked the faces row by row and added triangle 1 before triangle 2
+		tangent = { 0.0f, 0.0f, 0.0f };
+		binormal = { 0.0f, 0.0f, 0.0f };
+
+		auto Accumulate = [&tangent, &binormal](const VectorType& t, const VectorType& b)
+		{
+			tangent.x += t.x;
+			tangent.y += t.y;
+			tangent.z += t.z;
+			binormal.x += b.x;
+			binormal.y += b.y;
+			binormal.z += b.z;
+		};
+
+		// Face below and to the left - this vertex is its bottom right corner (triangle 2 only)
+		if (hasLeft && hasRowBelow)
+			Accumulate(previousFaces[i - 1].tangent2, previousFaces[i - 1].binormal2);
+
+		// Face below and to the right - this vertex is its bottom left corner (both triangles)
+		if (hasRight && hasRowBelow)
+		{
+			Accumulate(previousFaces[i].tangent1, previousFaces[i].binormal1);
+			Accumulate(previousFaces[i].tangent2, previousFaces[i].binormal2);
+		}
+
+		// Face above and to the left - this vertex is its upper right corner (both triangles)
+		if (hasLeft && hasRowAbove)
+		{
+			Accumulate(currentFaces[i - 1].tangent1, currentFaces[i - 1].binormal1);
+			Accumulate(currentFaces[i - 1].tangent2, currentFaces[i - 1].binormal2);
+		}
+
+		// Face above and to the right - this vertex is its upper left corner (triangle 1 only)
+		if (hasRight && hasRowAbove)
+			Accumulate(currentFaces[i].tangent1, currentFaces[i].binormal1);
+
+		length = (float)sqrt((tangent.x * tangent.x) + (tangent.y * tangent.y) + (tangent.z * tangent.z));
+		vertices[i].tangent = XMFLOAT3(tangent.x / length, tangent.y / length, tangent.z / length);
+
+		length = (float)sqrt((binormal.x * binormal.x) + (binormal.y * binormal.y) + (binormal.z * binormal.z));
+		vertices[i].binormal = XMFLOAT3(binormal.x / length, binormal.y / length, binormal.z / length);
+	}
+}
+
+void TerrainBuilder::CalculateFaceRow(const TerrainVertexType* upperRow, FaceRowScratch& scratch, std::vector<FaceType>& faces)
+{
+	int i, index1, index2, index3;
+	float vertex1[3], vertex2[3], vertex3[3], vector1[3], vector2[3], length;
+
+	const int quadCount = m_terrainWidth - 1;
+	const size_t streamSize = static_cast<size_t>(m_terrainWidth) * 2;
+
+	if (scratch.indices.empty())
+	{
+		// Local vertex i is upper row vertex i and local vertex m_terrainWidth + i is the bottom row vertex below it
+		scratch.streams.resize(streamSize * 5);
+		scratch.vectors.resize(static_cast<size_t>(quadCount) * 2 * 6);
+		scratch.indices.resize(static_cast<size_t>(quadCount) * 6);
+		for (i = 0; i < quadCount; i++)
+		{
+			unsigned int upperLeft = i;
+			unsigned int upperRight = i + 1;
+			unsigned int bottomLeft = m_terrainWidth + i;
+			unsigned int bottomRight = m_terrainWidth + i + 1;
+
+			// Triangle 1 - Upper left, upper right, bottom left.
+			scratch.indices[(i * 6) + 0] = upperLeft;
+			scratch.indices[(i * 6) + 1] = upperRight;
+			scratch.indices[(i * 6) + 2] = bottomLeft;
+
+			// Triangle 2 - Bottom left, upper right, bottom right.
+			scratch.indices[(i * 6) + 3] = bottomLeft;
+			scratch.indices[(i * 6) + 4] = upperRight;
+			scratch.indices[(i * 6) + 5] = bottomRight;
+		}
+	}
+
+	float* x = scratch.streams.data();
+	float* y = x + streamSize;
+	float* z = y + streamSize;
+	float* u = z + streamSize;
+	float* v = u + streamSize;
+	for (size_t local = 0; local < streamSize; local++)
+	{
+		const TerrainVertexType& vertex = upperRow[local];
+		x[local] = vertex.position.x;
+		y[local] = vertex.position.y;
+		z[local] = vertex.position.z;
+		u[local] = vertex.texture.x;
+		v[local] = vertex.texture.y;
+	}
+
+	// Tangent and binormal of both triangles of every quad (triangle 2i is triangle 1 of quad i). Normals are not
+	// needed for them
+	const size_t triangleCount = static_cast<size_t>(quadCount) * 2;
+	float* vectors = scratch.vectors.data();
+	TangentSpace::FaceVectors faceVectors = {
+		vectors,
+		vectors + triangleCount,
+		vectors + (triangleCount * 2),
+		vectors + (triangleCount * 3),
+		vectors + (triangleCount * 4),
+		vectors + (triangleCount * 5)
+	};
+	TangentSpace::CalculateFaceVectors({ x, y, z, u, v, nullptr, nullptr, nullptr }, scratch.indices.data(), 0, triangleCount, faceVectors);
+
+	for (i = 0; i < quadCount; i++)
+	{
+		FaceType& face = faces[i];
+
+		index1 = m_terrainWidth + i;        // Bottom left vertex.
+		index2 = m_terrainWidth + (i + 1);  // Bottom right vertex.
+		index3 = i;                         // Upper left vertex.
+
+		// Get three vertices from the face.
+		vertex1[0] = upperRow[index1].position.x;
+		vertex1[1] = upperRow[index1].position.y;
+		vertex1[2] = upperRow[index1].position.z;
+
+		vertex2[0] = upperRow[index2].position.x;
+		vertex2[1] = upperRow[index2].position.y;
+		vertex2[2] = upperRow[index2].position.z;
+
+		vertex3[0] = upperRow[index3].position.x;
+		vertex3[1] = upperRow[index3].position.y;
+		vertex3[2] = upperRow[index3].position.z;
+
+		// Calculate the two vectors for this face.
+		vector1[0] = vertex1[0] - vertex3[0];
+		vector1[1] = vertex1[1] - vertex3[1];
+		vector1[2] = vertex1[2] - vertex3[2];
+		vector2[0] = vertex3[0] - vertex2[0];
+		vector2[1] = vertex3[1] - vertex2[1];
+		vector2[2] = vertex3[2] - vertex2[2];
+
+		// Calculate the cross product of those two vectors to get the un-normalized value for this face normal.
+		face.normal.x = (vector1[1] * vector2[2]) - (vector1[2] * vector2[1]);
+		face.normal.y = (vector1[2] * vector2[0]) - (vector1[0] * vector2[2]);
+		face.normal.z = (vector1[0] * vector2[1]) - (vector1[1] * vector2[0]);
+
+		// Normalize the final value for this face using the length.
+		length = (float)sqrt((face.normal.x * face.normal.x) + (face.normal.y * face.normal.y) + (face.normal.z * face.normal.z));
+		face.normal.x = (face.normal.x / length);
+		face.normal.y = (face.normal.y / length);
+		face.normal.z = (face.normal.z / length);
+
+		size_t triangle1 = static_cast<size_t>(i) * 2;
+		size_t triangle2 = triangle1 + 1;
+		face.tangent1 = { faceVectors.tangentX[triangle1], faceVectors.tangentY[triangle1], faceVectors.tangentZ[triangle1] };
+		face.binormal1 = { faceVectors.binormalX[triangle1], faceVectors.binormalY[triangle1], faceVectors.binormalZ[triangle1] };
+		face.tangent2 = { faceVectors.tangentX[triangle2], faceVectors.tangentY[triangle2], faceVectors.tangentZ[triangle2] };
+		face.binormal2 = { faceVectors.binormalX[triangle2], faceVectors.binormalY[triangle2], faceVectors.binormalZ[triangle2] };
+	}
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include "pch.h"
+#include "HLSLStructures.h"
+#include "ThreadPool.h"
+#include "TangentSpace.h"
+#include "RawHeightMap.h"
+#include "BitmapColorMap.h"
+
+#include <memory>
+#include <vector>
+#include <functional>
+
+// TerrainBuilder is the CPU side of the terrain build. It turns the raw height map samples and color map into
+// the shared terrain vertices (positions, texture coordinates, normals, tangents, binormals and colors) and the
+// scaled heights. It does not touch the GPU, so it can be run and checked without a device.
+//
+// The work is split into bands of rows that run on a ThreadPool. Every finished band is handed to a BandWriter
+// (TerrainMesh writes them straight into the cooked file with a TerrainCacheWriter) and freed again, so neither
+// the full vertex array nor the full height field is ever held in memory. Each band builds:
+//		1. Vertex stage - positions, texture coordinates, colors and scaled heights of its rows, plus the row on
+//		   either side of it that its edge vertices share faces with
+//		2. Vector stage - normals, tangents and binormals. Each band computes the face vectors of the rows it
+//		   needs on the fly and gathers them per vertex in the same order the old serial passes accumulated them,
+//		   so the results are bit for bit the same as before. The triangle tangents and binormals come from
+//		   TangentSpace::CalculateFaceVectors, which gives the same bits as the old scalar code. Both only hold
+//		   because TerrainBuilder.cpp is built with /fp:precise in every configuration, like TangentSpace.cpp
+class TerrainBuilder
+{
+	struct VectorType
+	{
+		float x, y, z;
+	};
+
+	// Face normal of a quad plus the tangent/binormal of both of its triangles
+	struct FaceType
+	{
+		VectorType normal;
+		VectorType tangent1, binormal1;
+		VectorType tangent2, binormal2;
+	};
+
+	// Working memory for CalculateFaceRow, reused for every row of a band. The two vertex rows a face row touches
+	// are copied into structure of arrays streams for TangentSpace
+	struct FaceRowScratch
+	{
+		std::vector<float> streams;			// x, y, z, u and v of vertex rows j and j + 1
+		std::vector<unsigned int> indices;	// Triangles 1 and 2 of every quad - the same for every row
+		std::vector<float> vectors;			// Tangents and binormals of every triangle
+	};
+
+public:
+	// Receives rows [firstRow, firstRow + rowCount) of a finished band - their scaled heights and their vertices,
+	// both row major with terrainWidth values per row. It is called from the threads of the pool, for different
+	// bands at the same time, and the data is only valid during the call
+	using BandWriter = std::function<void(int firstRow, int rowCount, const float* heights, const TerrainVertexType* vertices)>;
+
+	TerrainBuilder(int terrainWidth, int terrainHeight, float heightScale);
+	TerrainBuilder(const TerrainBuilder&) = delete;
+	TerrainBuilder& operator=(const TerrainBuilder&) = delete;
+
+	// rawHeights holds one unscaled height per sample (row major). colors holds one (r, g, b) per sample and
+	// may be empty, in which case every vertex is white
+	void Build(const std::vector<float>& rawHeights, const std::vector<DirectX::XMFLOAT3>& colors, ThreadPool& pool, const BandWriter& writer);
+
+	// Same as above, but the heights and colors are read band by band straight out of the mapped height map and
+	// color map files instead of from copies of the whole maps. colorMap may be nullptr, in which case every
+	// vertex is white
+	void Build(const RawHeightMap& heightMap, const BitmapColorMap* colorMap, ThreadPool& pool, const BandWriter& writer);
+
+private:
+	// readRows fills rawRows with the unscaled heights of rows [firstRow, firstRow + rowCount), and readColors
+	// fills colorRows with their colors
+	using RowReader = std::function<void(int firstRow, int rowCount, float* rawRows)>;
+	using ColorReader = std::function<void(int firstRow, int rowCount, DirectX::XMFLOAT3* colorRows)>;
+
+	// readColors may be empty, in which case every vertex is white
+	void BuildBands(const RowReader& readRows, const ColorReader& readColors, ThreadPool& pool, const BandWriter& writer);
+	void BuildVertexRow(int j, const float* rawRow, const DirectX::XMFLOAT3* colorRow, float* scaledRow, TerrainVertexType* vertices);
+	void BuildVectorRow(int j, const std::vector<FaceType>& previousFaces, const std::vector<FaceType>& currentFaces, TerrainVertexType* vertices);
+
+	// Face vectors of the quads between the vertex row upperRow points at and the row that follows it
+	void CalculateFaceRow(const TerrainVertexType* upperRow, FaceRowScratch& scratch, std::vector<FaceType>& faces);
+
+	int m_terrainWidth, m_terrainHeight;
+	float m_heightScale;
+};
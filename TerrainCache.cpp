@@ -0,0 +1,59 @@
+#include "TerrainCache.h"
+
+TerrainCache::TerrainCache(const std::string& filename) :
+	m_header(nullptr)
+{
+	std::ostringstream oss;
+
+	m_file = std::make_unique<MemoryMappedFile>(filename);
+
+	if (m_file->Size() < sizeof(HeaderType))
+	{
+		oss << "File is too small to be a cooked terrain file: " << filename;
+		throw TerrainCacheException(__LINE__, __FILE__, oss.str());
+	}
+
+	m_header = reinterpret_cast<const HeaderType*>(m_file->Data());
+
+	if (std::string(m_header->magic, 4) != "CTRN" || m_header->version != VERSION || m_header->vertexSize != sizeof(TerrainVertexType))
+	{
+		oss << "File is not a cooked terrain file of the current version: " << filename;
+		throw TerrainCacheException(__LINE__, __FILE__, oss.str());
+	}
+
+	// Make sure every section lies inside the file before anything is read from it
+	const TerrainCacheKey& key = m_header->key;
+	uint64_t cellCount = static_cast<uint64_t>(m_header->cellRowCount) * m_header->cellRowCount;
+	uint64_t heightsSize = static_cast<uint64_t>(key.terrainWidth) * key.terrainHeight * sizeof(float);
+	uint64_t boundsSize = cellCount * sizeof(TerrainCellBounds);
+	uint64_t verticesSize = cellCount * key.cellWidth * key.cellHeight * sizeof(TerrainVertexType);
+	uint64_t indicesSize = static_cast<uint64_t>(m_header->indexCount) * sizeof(unsigned int);
+
+	if (m_header->fileSize != m_file->Size() ||
+		m_header->heightsOffset + heightsSize > m_file->Size() ||
+		m_header->boundsOffset + boundsSize > m_file->Size() ||
+		m_header->verticesOffset + verticesSize > m_file->Size() ||
+		m_header->indicesOffset + indicesSize > m_file->Size())
+	{
+		oss << "Cooked terrain file is truncated or corrupt: " << filename;
+		throw TerrainCacheException(__LINE__, __FILE__, oss.str());
+	}
+}
+
+bool TerrainCache::Matches(const TerrainCacheKey& key) const
+{
+	const TerrainCacheKey& cooked = m_header->key;
+	return cooked.heightMapHash == key.heightMapHash &&
+		cooked.colorMapHash == key.colorMapHash &&
+		cooked.terrainWidth == key.terrainWidth &&
+		cooked.terrainHeight == key.terrainHeight &&
+		cooked.cellWidth == key.cellWidth &&
+		cooked.cellHeight == key.cellHeight &&
+		cooked.heightScale == key.heightScale;
+}
+
+const TerrainVertexType* TerrainCache::GetCellVertices(int cellIndex) const
+{
+	size_t cellVertexCount = static_cast<size_t>(m_header->key.cellWidth) * m_header->key.cellHeight;
+	return reinterpret_cast<const TerrainVertexType*>(m_file->Data() + m_header->verticesOffset) + (cellVertexCount * cellIndex);
+}
\ No newline at end of file
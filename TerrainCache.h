@@ -0,0 +1,79 @@
+#pragma once
+#include "pch.h"
+#include "TerrainCacheException.h"
+#include "MemoryMappedFile.h"
+#include "HLSLStructures.h"
+#include "HeightField.h"
+#include "TerrainCellBounds.h"
+
+#include <memory>
+#include <vector>
+#include <string>
+#include <stdint.h>
+
+// Everything the cooked terrain data depends on. A cooked file is only used if all of it matches
+struct TerrainCacheKey
+{
+	uint64_t heightMapHash;
+	uint64_t colorMapHash;
+	int32_t terrainWidth, terrainHeight;
+	int32_t cellWidth, cellHeight;
+	float heightScale;
+};
+
+// TerrainCache reads and writes "cooked" terrain files - the fully processed output of the terrain build, laid
+// out so that it can be memory mapped and handed straight to the GPU:
+//
+//		HeaderType
+//		float				heights[terrainHeight * terrainWidth]		(scaled height field, row major)
+//		TerrainCellBounds	bounds[cellCount]
+//		TerrainVertexType	vertices[cellCount][cellHeight * cellWidth]	(one contiguous block per cell)
+//		unsigned int		indices[indexCount]							(every level of detail pattern, see TerrainLodPatterns)
+//
+// Bump VERSION whenever the layout or any of the stored structures change.
+class TerrainCache
+{
+	// Cooked files are written band by band while the terrain is built - see TerrainCacheWriter
+	friend class TerrainCacheWriter;
+
+	struct HeaderType
+	{
+		char magic[4];
+		uint32_t version;
+		uint32_t vertexSize;
+		uint32_t cellRowCount;
+		uint32_t indexCount;
+		uint32_t padding;
+		TerrainCacheKey key;
+		uint64_t heightsOffset;
+		uint64_t boundsOffset;
+		uint64_t verticesOffset;
+		uint64_t indicesOffset;
+		uint64_t fileSize;
+	};
+
+public:
+	// 2 - every level of detail pattern is stored instead of the single full resolution pattern
+	// 3 - vertex vectors from TangentSpace built with /fp:precise
+	// 4 - vertex vectors from TerrainBuilder built with /fp:precise
+	static constexpr uint32_t VERSION = 4;
+
+	// Maps an existing cooked file. Throws TerrainCacheException if it is not a valid cooked terrain file
+	TerrainCache(const std::string& filename);
+	TerrainCache(const TerrainCache&) = delete;
+	TerrainCache& operator=(const TerrainCache&) = delete;
+
+	bool Matches(const TerrainCacheKey& key) const;
+
+	int CellRowCount() const { return static_cast<int>(m_header->cellRowCount); }
+	int IndexCount() const { return static_cast<int>(m_header->indexCount); }
+
+	const float* GetHeights() const { return reinterpret_cast<const float*>(m_file->Data() + m_header->heightsOffset); }
+	const TerrainCellBounds* GetCellBounds() const { return reinterpret_cast<const TerrainCellBounds*>(m_file->Data() + m_header->boundsOffset); }
+	const TerrainVertexType* GetCellVertices(int cellIndex) const;
+	const unsigned int* GetIndices() const { return reinterpret_cast<const unsigned int*>(m_file->Data() + m_header->indicesOffset); }
+
+private:
+	std::unique_ptr<MemoryMappedFile> m_file;
+	const HeaderType* m_header;
+};
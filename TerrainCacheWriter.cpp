@@ -0,0 +1,155 @@
+#include "TerrainCacheWriter.h"
+
+TerrainCacheWriter::TerrainCacheWriter(const std::string& filename, const TerrainCacheKey& key, int cellRowCount, const std::vector<unsigned int>& indices) :
+	m_filename(filename),
+	m_temporaryFilename(filename + ".tmp"),
+	m_cellRowCount(cellRowCount)
+{
+	size_t cellCount = static_cast<size_t>(cellRowCount) * cellRowCount;
+	size_t cellVertexCount = static_cast<size_t>(key.cellWidth) * key.cellHeight;
+
+	// Zero the whole header so that padding bytes are deterministic
+	ZeroMemory(&m_header, sizeof(TerrainCache::HeaderType));
+	memcpy(m_header.magic, "CTRN", 4);
+	m_header.version = TerrainCache::VERSION;
+	m_header.vertexSize = sizeof(TerrainVertexType);
+	m_header.cellRowCount = static_cast<uint32_t>(cellRowCount);
+	m_header.indexCount = static_cast<uint32_t>(indices.size());
+	m_header.key = key;
+	m_header.heightsOffset = sizeof(TerrainCache::HeaderType);
+	m_header.boundsOffset = m_header.heightsOffset + (static_cast<uint64_t>(key.terrainWidth) * key.terrainHeight * sizeof(float));
+	m_header.verticesOffset = m_header.boundsOffset + (cellCount * sizeof(TerrainCellBounds));
+	m_header.indicesOffset = m_header.verticesOffset + (cellCount * cellVertexCount * sizeof(TerrainVertexType));
+	m_header.fileSize = m_header.indicesOffset + (indices.size() * sizeof(unsigned int));
+
+	m_file = std::make_unique<MemoryMappedFile>(m_temporaryFilename, static_cast<size_t>(m_header.fileSize));
+
+	memcpy(m_file->MutableData() + m_header.indicesOffset, indices.data(), indices.size() * sizeof(unsigned int));
+
+	// Cell (i, j) covers samples [i * (cellWidth - 1), i * (cellWidth - 1) + cellWidth) along x, and its rows start
+	// at row j * (cellHeight - 1), which sits at z = (terrainHeight - 1) - row
+	m_bounds.resize(cellCount);
+	for (int cellY = 0; cellY < cellRowCount; ++cellY)
+	{
+		for (int cellX = 0; cellX < cellRowCount; ++cellX)
+		{
+			TerrainCellBounds& bounds = m_bounds[(static_cast<size_t>(cellRowCount) * cellY) + cellX];
+			bounds.minX = static_cast<float>(cellX * (key.cellWidth - 1));
+			bounds.maxX = static_cast<float>((cellX * (key.cellWidth - 1)) + key.cellWidth - 1);
+			bounds.maxZ = static_cast<float>(key.terrainHeight - 1 - (cellY * (key.cellHeight - 1)));
+			bounds.minZ = static_cast<float>(key.terrainHeight - 1 - ((cellY * (key.cellHeight - 1)) + key.cellHeight - 1));
+			bounds.minY = FLT_MAX;
+			bounds.maxY = -FLT_MAX;
+		}
+	}
+
+	SYSTEM_INFO systemInfo;
+	GetSystemInfo(&systemInfo);
+	m_pageSize = systemInfo.dwPageSize;
+}
+
+TerrainCacheWriter::~TerrainCacheWriter()
+{
+	// Commit was never reached - do not leave a partially written file behind
+	if (m_file != nullptr)
+	{
+		m_file.reset();
+		DeleteFileA(m_temporaryFilename.c_str());
+	}
+}
+
+void TerrainCacheWriter::WriteBand(int firstRow, int rowCount, const float* heights, const TerrainVertexType* vertices)
+{
+	const TerrainCacheKey& key = m_header.key;
+	uint8_t* data = m_file->MutableData();
+	size_t terrainWidth = static_cast<size_t>(key.terrainWidth);
+	size_t cellVertexCount = static_cast<size_t>(key.cellWidth) * key.cellHeight;
+	int lastRow = firstRow + rowCount - 1;
+
+	// Height rows are stored exactly as they arrive
+	uint64_t heightsOffset = m_header.heightsOffset + (terrainWidth * firstRow * sizeof(float));
+	uint64_t heightsSize = terrainWidth * rowCount * sizeof(float);
+	memcpy(data + heightsOffset, heights, static_cast<size_t>(heightsSize));
+	Release(heightsOffset, heightsSize);
+
+	// Cell rows share their edge rows - the last row of cell row j is the first row of cell row j + 1 - so a
+	// terrain row can belong to two cells along z (and a sample to two cells along x)
+	int firstCellY = std::max((firstRow - 1) / (key.cellHeight - 1), 0);
+	int lastCellY = std::min(lastRow / (key.cellHeight - 1), m_cellRowCount - 1);
+
+	std::vector<std::pair<float, float>> heightBounds(m_cellRowCount);
+	for (int cellY = firstCellY; cellY <= lastCellY; ++cellY)
+	{
+		int cellFirstRow = cellY * (key.cellHeight - 1);
+		int begin = std::max(firstRow, cellFirstRow);
+		int end = std::min(lastRow, cellFirstRow + key.cellHeight - 1);
+		if (begin > end)
+			continue;
+
+		std::fill(heightBounds.begin(), heightBounds.end(), std::make_pair(FLT_MAX, -FLT_MAX));
+
+		for (int cellX = 0; cellX < m_cellRowCount; ++cellX)
+		{
+			size_t cellIndex = (static_cast<size_t>(m_cellRowCount) * cellY) + cellX;
+			size_t cellColumn = static_cast<size_t>(cellX) * (key.cellWidth - 1);
+
+			// Rows [begin, end] of this cell are one contiguous run of its block
+			uint64_t blockOffset = m_header.verticesOffset + (((cellIndex * cellVertexCount) + (static_cast<size_t>(begin - cellFirstRow) * key.cellWidth)) * sizeof(TerrainVertexType));
+			TerrainVertexType* destination = reinterpret_cast<TerrainVertexType*>(data + blockOffset);
+
+			for (int row = begin; row <= end; ++row)
+			{
+				const TerrainVertexType* source = vertices + (terrainWidth * (row - firstRow)) + cellColumn;
+				std::copy(source, source + key.cellWidth, destination);
+				destination += key.cellWidth;
+
+				for (int i = 0; i < key.cellWidth; ++i)
+				{
+					heightBounds[cellX].first = std::min(heightBounds[cellX].first, source[i].position.y);
+					heightBounds[cellX].second = std::max(heightBounds[cellX].second, source[i].position.y);
+				}
+			}
+
+			Release(blockOffset, static_cast<uint64_t>(end - begin + 1) * key.cellWidth * sizeof(TerrainVertexType));
+		}
+
+		std::lock_guard<std::mutex> lock(m_boundsMutex);
+		for (int cellX = 0; cellX < m_cellRowCount; ++cellX)
+		{
+			TerrainCellBounds& bounds = m_bounds[(static_cast<size_t>(m_cellRowCount) * cellY) + cellX];
+			bounds.minY = std::min(bounds.minY, heightBounds[cellX].first);
+			bounds.maxY = std::max(bounds.maxY, heightBounds[cellX].second);
+		}
+	}
+}
+
+void TerrainCacheWriter::Commit()
+{
+	std::ostringstream oss;
+
+	uint8_t* data = m_file->MutableData();
+	memcpy(data + m_header.boundsOffset, m_bounds.data(), m_bounds.size() * sizeof(TerrainCellBounds));
+	memcpy(data, &m_header, sizeof(TerrainCache::HeaderType));
+
+	m_file->Flush();
+
+	// The file has to be closed before it can be moved
+	m_file.reset();
+
+	if (!MoveFileExA(m_temporaryFilename.c_str(), m_filename.c_str(), MOVEFILE_REPLACE_EXISTING))
+	{
+		DeleteFileA(m_temporaryFilename.c_str());
+		oss << "Failed to move cooked terrain file into place: " << m_filename;
+		throw TerrainCacheException(__LINE__, __FILE__, oss.str());
+	}
+}
+
+void TerrainCacheWriter::Release(uint64_t offset, uint64_t size)
+{
+	// MemoryMappedFile::Release only lets go of whole pages inside the range. Bands write neighbouring parts of the
+	// same pages, so the range is widened to whole pages here - releasing a page another band is still writing to
+	// only means it is paged back in, its contents are kept
+	uint64_t first = (offset / m_pageSize) * m_pageSize;
+	uint64_t last = ((offset + size + m_pageSize - 1) / m_pageSize) * m_pageSize;
+	m_file->Release(static_cast<size_t>(first), static_cast<size_t>(last - first));
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include "pch.h"
+#include "TerrainCache.h"
+#include "TerrainCacheException.h"
+#include "MemoryMappedFile.h"
+#include "HLSLStructures.h"
+#include "TerrainCellBounds.h"
+
+#include <memory>
+#include <vector>
+#include <string>
+#include <mutex>
+
+// TerrainCacheWriter creates a cooked terrain file (see TerrainCache for the layout) and fills it band by band
+// while TerrainBuilder builds the terrain. The file is mapped for writing and every band is copied straight into
+// the height rows and cell blocks it belongs to, after which its pages are let go of again - so cooking a terrain
+// never needs memory for the whole height field or vertex array.
+//
+// Everything is written under a temporary name and only moved into place by Commit, so a partially written file
+// (a crash, a full disk) is never picked up. The temporary file is deleted if Commit is never reached.
+class TerrainCacheWriter
+{
+public:
+	// indices are every level of detail pattern (TerrainLodPatterns::GetIndices)
+	TerrainCacheWriter(const std::string& filename, const TerrainCacheKey& key, int cellRowCount, const std::vector<unsigned int>& indices);
+	TerrainCacheWriter(const TerrainCacheWriter&) = delete;
+	TerrainCacheWriter& operator=(const TerrainCacheWriter&) = delete;
+	~TerrainCacheWriter();
+
+	// Writes rows [firstRow, firstRow + rowCount) of the terrain (see TerrainBuilder::BandWriter). Bands may be
+	// written from several threads at once, as long as every row is only written once
+	void WriteBand(int firstRow, int rowCount, const float* heights, const TerrainVertexType* vertices);
+
+	// Writes the header and the cell bounds, flushes the file and moves it into place. Every row must have been
+	// written. Throws TerrainCacheException (or MemoryMappedFileException) on failure
+	void Commit();
+
+private:
+	// Lets the pages covering [offset, offset + size) of the file go - including pages only partly inside the
+	// range, whose other part is written by a different band
+	void Release(uint64_t offset, uint64_t size);
+
+	std::string m_filename;
+	std::string m_temporaryFilename;
+	std::unique_ptr<MemoryMappedFile> m_file;
+	TerrainCache::HeaderType m_header;
+
+	// The x and z bounds of each cell are known up front, the height bounds are merged in as bands are written
+	std::mutex m_boundsMutex;
+	std::vector<TerrainCellBounds> m_bounds;
+	int m_cellRowCount;
+	size_t m_pageSize;
+};
@@ -5,8 +5,8 @@ using DirectX::XMVECTOR;
 
 TerrainCell::TerrainCell(std::shared_ptr<DeviceResources> deviceResources, 
 	std::shared_ptr<MoveLookController> moveLookController,
-	std::string meshLookupName) :
-		Drawable(deviceResources, moveLookController, ObjectStore::GetMesh(meshLookupName))
+	std::shared_ptr<TerrainCellMesh> cellMesh) :
+		Drawable(deviceResources, moveLookController, cellMesh)
 {
 }
 
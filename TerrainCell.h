@@ -1,6 +1,7 @@
 #pragma once
 #include "pch.h"
 #include "Drawable.h"
+#include "TerrainCellMesh.h"
 
 #include <string>
 
@@ -11,7 +12,7 @@ class TerrainCell : public Drawable
 public:
 	TerrainCell(std::shared_ptr<DeviceResources> deviceResources, 
 				std::shared_ptr<MoveLookController> moveLookController,
-				std::string meshLookupName);
+				std::shared_ptr<TerrainCellMesh> cellMesh);
 
 	bool ContainsPoint(float x, float z);
 	float GetHeight(float x, float z);
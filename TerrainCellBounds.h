@@ -0,0 +1,9 @@
+#pragma once
+
+// Axis aligned bounds of a terrain cell
+struct TerrainCellBounds
+{
+	float minX, maxX;
+	float minY, maxY;
+	float minZ, maxZ;
+};
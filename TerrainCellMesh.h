@@ -4,22 +4,16 @@
 #include "TerrainMeshException.h"
 #include "Mesh.h"
 #include "HLSLStructures.h"
+#include "HeightField.h"
+#include "TerrainCellBounds.h"
+#include "TerrainLodPatterns.h"
 
 #include <memory>
 #include <vector>
+#include <algorithm>
 
 #include <DirectXCollision.h>
 
-struct TerrainModelType
-{
-	float x, y, z;
-	float tu, tv;
-	float nx, ny, nz;
-	float tx, ty, tz;
-	float bx, by, bz;
-	float r, g, b;
-};
-
 class TerrainCellMesh : public Mesh
 {
 private:
@@ -38,8 +32,12 @@ public:
 	TerrainCellMesh(std::shared_ptr<DeviceResources> deviceResources);
 	~TerrainCellMesh();
 
-	void Initialize(TerrainModelType* terrainModel, int nodeIndexX, int nodeIndexY, int cellHeight, int cellWidth, int terrainWidth);
-	
+	// Initialize from the cell's own (cellHeight x cellWidth) block of vertices with already known bounds
+	void Initialize(const TerrainVertexType* cellVertices, const TerrainCellBounds& bounds, int cellHeight, int cellWidth,
+		std::shared_ptr<TerrainLodPatterns> lodPatterns, Microsoft::WRL::ComPtr<ID3D11Buffer> indexBuffer);
+
+	// Selects the range of the shared index buffer that the next Draw uses (see TerrainLodPatterns::GetPattern)
+	void SetLod(int level, int stitchMask);
 
 	DirectX::XMFLOAT3 GetCenter();
 	float GetXLength();
@@ -52,6 +50,7 @@ public:
 	float GetMaxY() { return m_maxY; }
 	float GetMinZ() { return m_minZ; }
 	float GetMaxZ() { return m_maxZ; }
+	TerrainCellBounds GetBounds() { return { m_minX, m_maxX, m_minY, m_maxY, m_minZ, m_maxZ }; }
 
 	bool ContainsPoint(float x, float z);
 	float GetHeight(float x, float z);
@@ -60,14 +59,17 @@ public:
 
 
 	VectorType* m_vertexList;
-	unsigned long* m_indices;
+
+	// Index patterns shared by every terrain cell (index into m_vertexList)
+	std::shared_ptr<TerrainLodPatterns> m_lodPatterns;
 
 private:
-	void InitializeBuffers(int nodeIndexX, int nodeIndexY, int cellHeight, int cellWidth, int terrainWidth, TerrainModelType* terrainModel);
-	void CalculateCellDimensions();
+	void InitializeBuffers(const TerrainVertexType* cellVertices, int cellHeight, int cellWidth);
+	void CalculateCellCenter();
 
 
 	int m_vertexCount;
+	int m_cellHeight, m_cellWidth;
 
 	float m_maxX, m_maxY, m_maxZ, m_minX, m_minY, m_minZ;
 	float m_positionX, m_positionY, m_positionZ;
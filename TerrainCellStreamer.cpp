@@ -0,0 +1,242 @@
+#include "TerrainCellStreamer.h"
+
+using DirectX::XMFLOAT3;
+
+TerrainCellStreamer::TerrainCellStreamer(const std::vector<TerrainCellBounds>& cellBounds, int cellRowCount, size_t bytesPerCell,
+	const TerrainStreamingSettings& settings, ThreadPool& pool,
+	std::function<void(int)> loadCell, std::function<void(int)> cellLoaded, std::function<void(int)> unloadCell) :
+	m_cellBounds(cellBounds),
+	m_cellRowCount(cellRowCount),
+	m_cellSizeX(1.0f),
+	m_cellSizeZ(1.0f),
+	m_originX(0.0f),
+	m_originZ(0.0f),
+	m_bytesPerCell(std::max<size_t>(bytesPerCell, 1)),
+	m_settings(settings),
+	m_pool(pool),
+	m_loadCell(loadCell),
+	m_cellLoaded(cellLoaded),
+	m_unloadCell(unloadCell),
+	m_states(cellBounds.size(), CellState::UNLOADED),
+	m_pendingLoadCount(0),
+	m_rankedInUpdate(cellBounds.size(), 0),
+	m_wanted(cellBounds.size(), 0),
+	m_updateCount(0)
+{
+	// Every cell covers the same x/z footprint, so the cells near a point can be found directly from the grid
+	// instead of measuring the distance to every cell of the map
+	if (!m_cellBounds.empty())
+	{
+		m_originX = m_cellBounds[0].minX;
+		m_originZ = m_cellBounds[0].maxZ;
+		m_cellSizeX = std::max(m_cellBounds[0].maxX - m_cellBounds[0].minX, 1.0f);
+		m_cellSizeZ = std::max(m_cellBounds[0].maxZ - m_cellBounds[0].minZ, 1.0f);
+	}
+}
+
+TerrainCellStreamer::~TerrainCellStreamer()
+{
+	// The load tasks refer back to this object, so they must all be finished before it goes away
+	std::unique_lock<std::mutex> lock(m_finishedMutex);
+	m_finishedCondition.wait(lock, [this]() { return static_cast<int>(m_finishedLoads.size()) == m_pendingLoadCount; });
+}
+
+void TerrainCellStreamer::Update(XMFLOAT3 position, XMFLOAT3 velocity)
+{
+	++m_updateCount;
+
+	// Rank the cells around the player first, then the cells around where the player is heading
+	float predictedX = position.x + (velocity.x * m_settings.prefetchTime);
+	float predictedZ = position.z + (velocity.z * m_settings.prefetchTime);
+
+	m_ranking.clear();
+	RankCellsAround(position.x, position.z, 0.0f);
+	RankCellsAround(predictedX, predictedZ, m_settings.loadRadius);
+	std::sort(m_ranking.begin(), m_ranking.end());
+
+	// Only the closest cells that fit in the budget are wanted
+	int capacity = CellCapacity();
+	if (static_cast<int>(m_ranking.size()) > capacity)
+		m_ranking.resize(capacity);
+
+	for (const std::pair<float, int>& ranked : m_ranking)
+		m_wanted[ranked.second] = 1;
+
+	// Hand over the cells that finished loading since the last update. Anything that is no longer wanted is
+	// dealt with by the eviction below, just like any other resident cell
+	std::exception_ptr loadException;
+	try
+	{
+		ProcessFinishedLoads();
+	}
+	catch (...)
+	{
+		loadException = std::current_exception();
+	}
+
+	// Evict the cells that have moved out of range. The hysteresis keeps cells on the edge of the ring from
+	// being loaded and evicted over and over while the player moves back and forth across a cell boundary
+	float evictDistance = m_settings.loadRadius + m_settings.hysteresis;
+	std::vector<std::pair<float, int>> evictionCandidates;
+	for (int cellIndex : m_residentCells)
+	{
+		if (m_wanted[cellIndex])
+			continue;
+
+		float distance = std::min(DistanceToCell(cellIndex, position.x, position.z), DistanceToCell(cellIndex, predictedX, predictedZ));
+		evictionCandidates.push_back({ distance, cellIndex });
+	}
+
+	// Cells inside the hysteresis band are still evicted if the budget is needed for wanted cells that are not
+	// loaded yet. Farthest first, so the ones closest to the player are kept the longest
+	int missingCount = static_cast<int>(std::count_if(m_ranking.begin(), m_ranking.end(),
+		[this](const std::pair<float, int>& ranked) { return m_states[ranked.second] == CellState::UNLOADED; }));
+
+	std::sort(evictionCandidates.begin(), evictionCandidates.end(), std::greater<std::pair<float, int>>());
+	for (const std::pair<float, int>& candidate : evictionCandidates)
+	{
+		bool overBudget = static_cast<int>(m_residentCells.size()) + m_pendingLoadCount + missingCount > capacity;
+		if (candidate.first > evictDistance || overBudget)
+			EvictCell(candidate.second);
+	}
+
+	// Queue the missing cells, closest first
+	for (const std::pair<float, int>& ranked : m_ranking)
+	{
+		if (m_pendingLoadCount >= m_settings.maxPendingLoads ||
+			static_cast<int>(m_residentCells.size()) + m_pendingLoadCount >= capacity)
+			break;
+
+		if (m_states[ranked.second] == CellState::UNLOADED)
+			QueueLoad(ranked.second);
+	}
+
+	for (const std::pair<float, int>& ranked : m_ranking)
+		m_wanted[ranked.second] = 0;
+
+	if (loadException)
+		std::rethrow_exception(loadException);
+}
+
+void TerrainCellStreamer::WaitForPendingLoads()
+{
+	{
+		std::unique_lock<std::mutex> lock(m_finishedMutex);
+		m_finishedCondition.wait(lock, [this]() { return static_cast<int>(m_finishedLoads.size()) == m_pendingLoadCount; });
+	}
+
+	ProcessFinishedLoads();
+}
+
+float TerrainCellStreamer::DistanceToCell(int cellIndex, float x, float z)
+{
+	// Distance in the x/z plane from the point to the footprint of the cell (0 if the point is over the cell)
+	const TerrainCellBounds& bounds = m_cellBounds[cellIndex];
+	float dx = std::max(std::max(bounds.minX - x, x - bounds.maxX), 0.0f);
+	float dz = std::max(std::max(bounds.minZ - z, z - bounds.maxZ), 0.0f);
+	return std::sqrt((dx * dx) + (dz * dz));
+}
+
+void TerrainCellStreamer::RankCellsAround(float x, float z, float priorityOffset)
+{
+	if (m_cellBounds.empty())
+		return;
+
+	// Range of cells that overlap the square around the point. i increases with x, j increases as z decreases.
+	// A cell whose far edge only touches the square is at exactly the load radius and counts as well, hence the
+	// ceil - 1 on the low side
+	float radius = m_settings.loadRadius;
+	int iMin = std::max(static_cast<int>(std::ceil((x - radius - m_originX) / m_cellSizeX)) - 1, 0);
+	int iMax = std::min(static_cast<int>(std::floor((x + radius - m_originX) / m_cellSizeX)), m_cellRowCount - 1);
+	int jMin = std::max(static_cast<int>(std::ceil((m_originZ - (z + radius)) / m_cellSizeZ)) - 1, 0);
+	int jMax = std::min(static_cast<int>(std::floor((m_originZ - (z - radius)) / m_cellSizeZ)), m_cellRowCount - 1);
+
+	for (int j = jMin; j <= jMax; j++)
+	{
+		for (int i = iMin; i <= iMax; i++)
+		{
+			int cellIndex = (m_cellRowCount * j) + i;
+
+			// A cell that is near both points keeps the (better) priority it was given first
+			if (m_rankedInUpdate[cellIndex] == m_updateCount)
+				continue;
+
+			float distance = DistanceToCell(cellIndex, x, z);
+			if (distance > radius)
+				continue;
+
+			// Loaded cells are favoured by the hysteresis distance so that cells on the edge of the budget do not
+			// keep trading places with each other
+			if (m_states[cellIndex] != CellState::UNLOADED)
+				distance -= m_settings.hysteresis;
+
+			m_rankedInUpdate[cellIndex] = m_updateCount;
+			m_ranking.push_back({ priorityOffset + distance, cellIndex });
+		}
+	}
+}
+
+void TerrainCellStreamer::ProcessFinishedLoads()
+{
+	std::vector<std::pair<int, std::exception_ptr>> finishedLoads;
+	{
+		std::lock_guard<std::mutex> lock(m_finishedMutex);
+		std::swap(finishedLoads, m_finishedLoads);
+		m_pendingLoadCount -= static_cast<int>(finishedLoads.size());
+	}
+
+	// Every finished load is recorded before the first failure is rethrown so no cell is left LOADING forever
+	std::exception_ptr firstException;
+	for (const std::pair<int, std::exception_ptr>& finished : finishedLoads)
+	{
+		if (finished.second)
+		{
+			m_states[finished.first] = CellState::UNLOADED;
+			if (!firstException)
+				firstException = finished.second;
+			continue;
+		}
+
+		m_states[finished.first] = CellState::RESIDENT;
+		m_residentCells.push_back(finished.first);
+		m_cellLoaded(finished.first);
+	}
+
+	if (firstException)
+		std::rethrow_exception(firstException);
+}
+
+void TerrainCellStreamer::EvictCell(int cellIndex)
+{
+	m_states[cellIndex] = CellState::UNLOADED;
+
+	std::vector<int>::iterator position = std::find(m_residentCells.begin(), m_residentCells.end(), cellIndex);
+	*position = m_residentCells.back();
+	m_residentCells.pop_back();
+
+	m_unloadCell(cellIndex);
+}
+
+void TerrainCellStreamer::QueueLoad(int cellIndex)
+{
+	m_states[cellIndex] = CellState::LOADING;
+	++m_pendingLoadCount;
+
+	m_pool.Submit([this, cellIndex]()
+	{
+		std::exception_ptr exception;
+		try
+		{
+			m_loadCell(cellIndex);
+		}
+		catch (...)
+		{
+			exception = std::current_exception();
+		}
+
+		// Notify while still holding the lock - once the last load is recorded the destructor may run
+		std::lock_guard<std::mutex> lock(m_finishedMutex);
+		m_finishedLoads.push_back({ cellIndex, exception });
+		m_finishedCondition.notify_all();
+	});
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include "pch.h"
+#include "TerrainCellBounds.h"
+#include "ThreadPool.h"
+
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+#include <utility>
+#include <algorithm>
+
+struct TerrainStreamingSettings
+{
+	float loadRadius;		// Cells closer than this (in x/z) to the player are loaded
+	float hysteresis;		// Loaded cells are only evicted once they are this much further away than loadRadius
+	float prefetchTime;		// Seconds of player velocity to look ahead - cells around that point are loaded as well
+	size_t memoryBudget;	// Upper bound (in bytes) on the memory of every loaded and loading cell
+	int maxPendingLoads;	// Number of cells that may be loading at the same time
+};
+
+// TerrainCellStreamer decides which terrain cells need to be resident for a given player position and
+// velocity. It does not know what a cell is - loading and unloading are done through the callbacks:
+//		loadCell	- called on a ThreadPool worker, must only touch the data of the cell it is given
+//		cellLoaded	- called on the thread that calls Update once the cell has finished loading
+//		unloadCell	- called on the thread that calls Update
+// This keeps the paging logic free of any GPU work so it can be driven by a scripted path.
+//
+// Each Update ranks the cells around the player (closest first) followed by the cells around the predicted
+// position (position + velocity * prefetchTime), keeps as many of them as fit in the memory budget and
+// queues the ones that are missing. Loaded cells are evicted once they are further than
+// loadRadius + hysteresis from both points, or sooner if the budget is needed for closer cells.
+class TerrainCellStreamer
+{
+	enum class CellState
+	{
+		UNLOADED,
+		LOADING,
+		RESIDENT
+	};
+
+public:
+	// cellBounds must be laid out in a (cellRowCount x cellRowCount) grid where cell (i, j) is stored at
+	// (cellRowCount * j) + i, i increases with x and j decreases with z (the TerrainMesh layout)
+	TerrainCellStreamer(const std::vector<TerrainCellBounds>& cellBounds, int cellRowCount, size_t bytesPerCell,
+		const TerrainStreamingSettings& settings, ThreadPool& pool,
+		std::function<void(int)> loadCell, std::function<void(int)> cellLoaded, std::function<void(int)> unloadCell);
+	TerrainCellStreamer(const TerrainCellStreamer&) = delete;
+	TerrainCellStreamer& operator=(const TerrainCellStreamer&) = delete;
+	~TerrainCellStreamer();
+
+	// Rethrows the first exception thrown by loadCell since the last Update
+	void Update(DirectX::XMFLOAT3 position, DirectX::XMFLOAT3 velocity);
+
+	// Blocks until every queued load has finished and hands the results to cellLoaded
+	void WaitForPendingLoads();
+
+	bool IsResident(int cellIndex) { return m_states[cellIndex] == CellState::RESIDENT; }
+	const std::vector<int>& GetResidentCells() { return m_residentCells; }
+	int PendingLoadCount() { return m_pendingLoadCount; }
+	size_t ResidentMemory() { return m_residentCells.size() * m_bytesPerCell; }
+	int CellCapacity() { return static_cast<int>(std::max<size_t>(m_settings.memoryBudget / m_bytesPerCell, 1)); }
+
+	const TerrainStreamingSettings& GetSettings() { return m_settings; }
+	void SetSettings(const TerrainStreamingSettings& settings) { m_settings = settings; }
+
+private:
+	float DistanceToCell(int cellIndex, float x, float z);
+	void RankCellsAround(float x, float z, float priorityOffset);
+	void ProcessFinishedLoads();
+	void EvictCell(int cellIndex);
+	void QueueLoad(int cellIndex);
+
+	std::vector<TerrainCellBounds>	m_cellBounds;
+	int								m_cellRowCount;
+	float							m_cellSizeX, m_cellSizeZ;
+	float							m_originX, m_originZ;	// Min x / max z of cell (0, 0)
+	size_t							m_bytesPerCell;
+	TerrainStreamingSettings		m_settings;
+	ThreadPool&						m_pool;
+
+	std::function<void(int)>		m_loadCell;
+	std::function<void(int)>		m_cellLoaded;
+	std::function<void(int)>		m_unloadCell;
+
+	// Only touched by the thread that calls Update
+	std::vector<CellState>			m_states;
+	std::vector<int>				m_residentCells;
+	int								m_pendingLoadCount;
+
+	// Scratch space for the ranking - (priority, cell index), and the Update in which a cell was last ranked
+	std::vector<std::pair<float, int>>	m_ranking;
+	std::vector<unsigned int>			m_rankedInUpdate;
+	std::vector<char>					m_wanted;
+	unsigned int						m_updateCount;
+
+	// Loads finished by the workers but not yet handed to cellLoaded
+	std::mutex							m_finishedMutex;
+	std::condition_variable				m_finishedCondition;
+	std::vector<std::pair<int, std::exception_ptr>> m_finishedLoads;
+};
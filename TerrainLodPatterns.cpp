@@ -0,0 +1,94 @@
+#include "TerrainLodPatterns.h"
+
+TerrainLodPatterns::TerrainLodPatterns(int cellSize) :
+	m_cellSize(cellSize),
+	m_levelCount(1)
+{
+	// One level for every halving of the number of quads along a side
+	for (int quads = cellSize - 1; quads > 1 && (quads % 2) == 0; quads /= 2)
+		++m_levelCount;
+
+	// The coarsest level only needs the unstitched pattern
+	for (int level = 0; level < m_levelCount; ++level)
+	{
+		int stitchMaskCount = level < m_levelCount - 1 ? STITCH_MASK_COUNT : 1;
+		for (int stitchMask = 0; stitchMask < stitchMaskCount; ++stitchMask)
+			AppendPattern(level, stitchMask);
+	}
+}
+
+TerrainLodPatterns::PatternRange TerrainLodPatterns::GetPattern(int level, int stitchMask) const
+{
+	if (level == m_levelCount - 1)
+		stitchMask = 0;
+
+	return m_patterns[(level * STITCH_MASK_COUNT) + stitchMask];
+}
+
+void TerrainLodPatterns::AppendPattern(int level, int stitchMask)
+{
+	int step = 1 << level;
+	int coarseStep = step * 2;
+	int last = m_cellSize - 1;
+
+	PatternRange range;
+	range.startIndex = static_cast<unsigned int>(m_indices.size());
+
+	// Returns the index of vertex (i, j) after snapping it onto the edge of a coarser neighbour. Corners are
+	// always shared by both levels, so at most one edge ever applies to a vertex
+	auto Vertex = [this, stitchMask, step, coarseStep, last](int i, int j) -> unsigned int
+	{
+		if (j == 0 && (stitchMask & STITCH_TOP) && (i % coarseStep) != 0)
+			i -= step;
+		else if (j == last && (stitchMask & STITCH_BOTTOM) && (i % coarseStep) != 0)
+			i -= step;
+		else if (i == 0 && (stitchMask & STITCH_LEFT) && (j % coarseStep) != 0)
+			j -= step;
+		else if (i == last && (stitchMask & STITCH_RIGHT) && (j % coarseStep) != 0)
+			j -= step;
+
+		return static_cast<unsigned int>((m_cellSize * j) + i);
+	};
+
+	auto AddTriangle = [this](unsigned int index1, unsigned int index2, unsigned int index3)
+	{
+		// Snapping collapses one triangle on each side of every removed edge vertex
+		if (index1 == index2 || index2 == index3 || index1 == index3)
+			return;
+
+		m_indices.push_back(index1);
+		m_indices.push_back(index2);
+		m_indices.push_back(index3);
+	};
+
+	// Two triangles per quad using the same vertex order as the full resolution terrain
+	for (int j = 0; j < last; j += step)
+	{
+		for (int i = 0; i < last; i += step)
+		{
+			unsigned int upperLeft = Vertex(i, j);
+			unsigned int upperRight = Vertex(i + step, j);
+			unsigned int bottomLeft = Vertex(i, j + step);
+			unsigned int bottomRight = Vertex(i + step, j + step);
+
+			// When both the right and the bottom edge are stitched, the upper right and bottom left vertices of the
+			// corner quad snap onto a line through the upper left vertex. Split that quad along the other diagonal
+			// so it does not end up with a zero area triangle and a T-junction at the upper left vertex
+			if (i == last - step && j == last - step && (stitchMask & STITCH_RIGHT) && (stitchMask & STITCH_BOTTOM))
+			{
+				AddTriangle(upperLeft, upperRight, bottomRight);
+				AddTriangle(upperLeft, bottomRight, bottomLeft);
+				continue;
+			}
+
+			// Triangle 1 - Upper left, upper right, bottom left.
+			AddTriangle(upperLeft, upperRight, bottomLeft);
+
+			// Triangle 2 - Bottom left, upper right, bottom right.
+			AddTriangle(bottomLeft, upperRight, bottomRight);
+		}
+	}
+
+	range.indexCount = static_cast<unsigned int>(m_indices.size()) - range.startIndex;
+	m_patterns.push_back(range);
+}
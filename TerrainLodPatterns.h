@@ -0,0 +1,53 @@
+#pragma once
+#include "pch.h"
+
+#include <vector>
+
+// TerrainLodPatterns builds the index patterns that every terrain cell is drawn with. Level L only uses every
+// (2^L)th vertex of the cell in each direction, so a 33x33 cell has levels with 32x32, 16x16, ... and finally
+// a single quad. All patterns are stored back to back so they can share one index buffer.
+//
+// Neighbouring cells may differ by at most one level. Where a neighbour is one level coarser, the vertices of
+// this cell that the neighbour does not have would leave a T-junction (and a crack) on the shared edge. The
+// stitched variants of each level snap those vertices onto the previous vertex along the edge and drop the
+// triangles that collapse, so the edge is made of exactly the same segments as the coarser neighbour's edge.
+//
+// Vertex (i, j) of a cell is index (cellSize * j) + i, where j = 0 is the edge with the largest z.
+class TerrainLodPatterns
+{
+public:
+	// Edges of a cell whose neighbour is one level coarser
+	static constexpr int STITCH_TOP = 1;		// Neighbour with larger z
+	static constexpr int STITCH_RIGHT = 2;		// Neighbour with larger x
+	static constexpr int STITCH_BOTTOM = 4;		// Neighbour with smaller z
+	static constexpr int STITCH_LEFT = 8;		// Neighbour with smaller x
+	static constexpr int STITCH_MASK_COUNT = 16;
+
+	struct PatternRange
+	{
+		unsigned int startIndex;
+		unsigned int indexCount;
+	};
+
+	// cellSize is the number of vertices along each side of a cell and must be (2^n) + 1
+	TerrainLodPatterns(int cellSize);
+	TerrainLodPatterns(const TerrainLodPatterns&) = delete;
+	TerrainLodPatterns& operator=(const TerrainLodPatterns&) = delete;
+
+	int CellSize() const { return m_cellSize; }
+	int LevelCount() const { return m_levelCount; }
+
+	// Every pattern, back to back
+	const std::vector<unsigned int>& GetIndices() const { return m_indices; }
+
+	// The coarsest level can never have a coarser neighbour, so its stitch mask is ignored
+	PatternRange GetPattern(int level, int stitchMask) const;
+
+private:
+	void AppendPattern(int level, int stitchMask);
+
+	int m_cellSize;
+	int m_levelCount;
+	std::vector<unsigned int> m_indices;
+	std::vector<PatternRange> m_patterns;
+};
@@ -0,0 +1,210 @@
+#include "TerrainLodSelector.h"
+
+using DirectX::XMFLOAT3;
+
+TerrainLodSelector::TerrainLodSelector(const HeightField& heightField, const std::vector<TerrainCellBounds>& cellBounds, int cellRowCount,
+	int cellSize, int levelCount, ThreadPool& pool) :
+	m_heightField(heightField),
+	m_cellBounds(cellBounds),
+	m_cellRowCount(cellRowCount),
+	m_cellSize(cellSize),
+	m_levelCount(levelCount),
+	m_pool(pool),
+	m_errors(cellBounds.size() * levelCount, 0.0f),
+	m_hasErrors(cellBounds.size(), 0),
+	m_levels(cellBounds.size(), 0),
+	m_stitchMasks(cellBounds.size(), 0),
+	m_allCells(cellBounds.size()),
+	m_activeInSelection(cellBounds.size(), 0),
+	m_selectionCount(0)
+{
+	for (int cellIndex = 0; cellIndex < static_cast<int>(cellBounds.size()); ++cellIndex)
+		m_allCells[cellIndex] = cellIndex;
+}
+
+void TerrainLodSelector::ActivateCells(const std::vector<int>& cells)
+{
+	++m_selectionCount;
+	m_activeCells.clear();
+	m_cellsWithoutErrors.clear();
+
+	auto Activate = [this](int cellIndex)
+	{
+		if (IsActive(cellIndex))
+			return;
+
+		m_activeInSelection[cellIndex] = m_selectionCount;
+		m_activeCells.push_back(cellIndex);
+		if (!m_hasErrors[cellIndex])
+			m_cellsWithoutErrors.push_back(cellIndex);
+	};
+
+	for (int cellIndex : cells)
+	{
+		int i = cellIndex % m_cellRowCount;
+		int j = cellIndex / m_cellRowCount;
+
+		Activate(cellIndex);
+		if (j > 0)
+			Activate(cellIndex - m_cellRowCount);
+		if (i < m_cellRowCount - 1)
+			Activate(cellIndex + 1);
+		if (j < m_cellRowCount - 1)
+			Activate(cellIndex + m_cellRowCount);
+		if (i > 0)
+			Activate(cellIndex - 1);
+	}
+
+	// Measure the cells that have not taken part before. That is every cell around the player on the first frame,
+	// and a ring of newly streamed cells now and then after that
+	if (m_cellsWithoutErrors.empty())
+		return;
+
+	m_pool.ParallelFor(0, static_cast<int>(m_cellsWithoutErrors.size()), 16, [this](int begin, int end)
+	{
+		for (int iii = begin; iii < end; ++iii)
+			CalculateErrors(m_cellsWithoutErrors[iii]);
+	});
+
+	for (int cellIndex : m_cellsWithoutErrors)
+		m_hasErrors[cellIndex] = 1;
+}
+
+void TerrainLodSelector::CalculateErrors(int cellIndex)
+{
+	int last = m_cellSize - 1;
+	int originI = (cellIndex % m_cellRowCount) * last;
+	int originJ = (cellIndex / m_cellRowCount) * last;
+	float* errors = &m_errors[static_cast<size_t>(cellIndex) * m_levelCount];
+
+	auto Sample = [this, originI, originJ](int i, int j) { return m_heightField.GetSample(originI + i, originJ + j); };
+
+	errors[0] = 0.0f;
+	for (int level = 1; level < m_levelCount; ++level)
+	{
+		int step = 1 << level;
+		float error = errors[level - 1];
+
+		for (int j = 0; j <= last; j++)
+		{
+			// Quad of this level that the sample lies in (samples on the far edges belong to the last quad)
+			int quadJ = std::min((j / step) * step, last - step);
+			float v = static_cast<float>(j - quadJ) / static_cast<float>(step);
+
+			for (int i = 0; i <= last; i++)
+			{
+				int quadI = std::min((i / step) * step, last - step);
+				float u = static_cast<float>(i - quadI) / static_cast<float>(step);
+
+				float approximation = HeightField::InterpolateQuad(
+					Sample(quadI, quadJ),
+					Sample(quadI + step, quadJ),
+					Sample(quadI, quadJ + step),
+					Sample(quadI + step, quadJ + step),
+					u, v
+				);
+
+				error = std::max(error, std::abs(Sample(i, j) - approximation));
+			}
+		}
+
+		errors[level] = error;
+	}
+}
+
+void TerrainLodSelector::SelectLevels(const std::vector<int>& cells, XMFLOAT3 eye, float projectionScale, float pixelTolerance)
+{
+	ActivateCells(cells);
+
+	for (int cellIndex : m_activeCells)
+	{
+		// Keep the distance away from zero so the cell the eye is in always ends up at full resolution
+		float distance = std::max(DistanceToCell(cellIndex, eye), 0.001f);
+		float pixelsPerUnit = projectionScale / distance;
+
+		int level = 0;
+		for (int candidate = m_levelCount - 1; candidate > 0; --candidate)
+		{
+			if (GetError(cellIndex, candidate) * pixelsPerUnit <= pixelTolerance)
+			{
+				level = candidate;
+				break;
+			}
+		}
+		m_levels[cellIndex] = level;
+	}
+
+	LimitNeighbourLevels();
+	CalculateStitchMasks();
+}
+
+float TerrainLodSelector::DistanceToCell(int cellIndex, XMFLOAT3 eye) const
+{
+	const TerrainCellBounds& bounds = m_cellBounds[cellIndex];
+	float dx = std::max(std::max(bounds.minX - eye.x, eye.x - bounds.maxX), 0.0f);
+	float dy = std::max(std::max(bounds.minY - eye.y, eye.y - bounds.maxY), 0.0f);
+	float dz = std::max(std::max(bounds.minZ - eye.z, eye.z - bounds.maxZ), 0.0f);
+	return std::sqrt((dx * dx) + (dy * dy) + (dz * dz));
+}
+
+void TerrainLodSelector::LimitNeighbourLevels()
+{
+	// Levels are only ever lowered (which only adds detail), so this settles after every cell has been
+	// lowered at most levelCount times. Every active cell starts on the work list, and inactive cells are left
+	// alone - they are not drawn, and neither is anything next to them that is not active itself
+	m_workList = m_activeCells;
+
+	while (!m_workList.empty())
+	{
+		int cellIndex = m_workList.back();
+		m_workList.pop_back();
+
+		int i = cellIndex % m_cellRowCount;
+		int j = cellIndex / m_cellRowCount;
+		int maxNeighbourLevel = m_levels[cellIndex] + 1;
+
+		auto Limit = [this, maxNeighbourLevel](int neighbourIndex)
+		{
+			if (IsActive(neighbourIndex) && m_levels[neighbourIndex] > maxNeighbourLevel)
+			{
+				m_levels[neighbourIndex] = maxNeighbourLevel;
+				m_workList.push_back(neighbourIndex);
+			}
+		};
+
+		if (j > 0)
+			Limit(cellIndex - m_cellRowCount);
+		if (i < m_cellRowCount - 1)
+			Limit(cellIndex + 1);
+		if (j < m_cellRowCount - 1)
+			Limit(cellIndex + m_cellRowCount);
+		if (i > 0)
+			Limit(cellIndex - 1);
+	}
+}
+
+void TerrainLodSelector::CalculateStitchMasks()
+{
+	// A cell stitches every edge whose neighbour is one level coarser. The top neighbour has the larger z,
+	// which is the previous row of cells. An inactive neighbour is never drawn, so there is nothing to stitch to
+	for (int cellIndex : m_activeCells)
+	{
+		int i = cellIndex % m_cellRowCount;
+		int j = cellIndex / m_cellRowCount;
+		int coarser = m_levels[cellIndex] + 1;
+		int stitchMask = 0;
+
+		auto IsCoarser = [this, coarser](int neighbourIndex) { return IsActive(neighbourIndex) && m_levels[neighbourIndex] == coarser; };
+
+		if (j > 0 && IsCoarser(cellIndex - m_cellRowCount))
+			stitchMask |= TerrainLodPatterns::STITCH_TOP;
+		if (i < m_cellRowCount - 1 && IsCoarser(cellIndex + 1))
+			stitchMask |= TerrainLodPatterns::STITCH_RIGHT;
+		if (j < m_cellRowCount - 1 && IsCoarser(cellIndex + m_cellRowCount))
+			stitchMask |= TerrainLodPatterns::STITCH_BOTTOM;
+		if (i > 0 && IsCoarser(cellIndex - 1))
+			stitchMask |= TerrainLodPatterns::STITCH_LEFT;
+
+		m_stitchMasks[cellIndex] = stitchMask;
+	}
+}
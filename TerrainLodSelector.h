@@ -0,0 +1,88 @@
+#pragma once
+#include "pch.h"
+#include "HeightField.h"
+#include "TerrainCellBounds.h"
+#include "TerrainLodPatterns.h"
+#include "ThreadPool.h"
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+// TerrainLodSelector picks the level of detail of every terrain cell from the screen space error of each level.
+//
+// The geometric error of level L of a cell is the largest vertical distance between any of the cell's height
+// samples and the surface of the level L triangles (never less than the error of level L - 1). Projected to the
+// screen, that error covers roughly
+//		error * projectionScale / distance		pixels
+// where distance is measured from the eye to the cell's bounding box and projectionScale is
+// viewportHeight / (2 * tan(fovY / 2)). Every cell gets the coarsest level whose projected error stays within the
+// pixel tolerance, after which levels are lowered until no two neighbours differ by more than one level (which is
+// what the stitched patterns of TerrainLodPatterns can close).
+//
+// Only the cells that can be drawn take part - the cells SelectLevels is given (the resident cells while streaming)
+// plus their direct neighbours, whose levels decide the stitching along the edges of the drawn cells. The errors
+// of a cell are measured the first time it takes part, so cells far away from anywhere the player has been never
+// read the height field.
+//
+// Nothing here touches the GPU - the chosen level and stitch mask of a cell are turned into an index range with
+// TerrainLodPatterns::GetPattern.
+class TerrainLodSelector
+{
+public:
+	// cellBounds and the height field use the TerrainMesh layout: cell (i, j) is stored at (cellRowCount * j) + i and
+	// covers height field samples [i * (cellSize - 1), (i + 1) * (cellSize - 1)] x [j * (cellSize - 1), ...]. The
+	// height field must outlive the selector
+	TerrainLodSelector(const HeightField& heightField, const std::vector<TerrainCellBounds>& cellBounds, int cellRowCount,
+		int cellSize, int levelCount, ThreadPool& pool);
+	TerrainLodSelector(const TerrainLodSelector&) = delete;
+	TerrainLodSelector& operator=(const TerrainLodSelector&) = delete;
+
+	// Chooses the levels of cells and their neighbours. The levels and stitch masks of every other cell are left
+	// as they were and must not be drawn with
+	void SelectLevels(const std::vector<int>& cells, DirectX::XMFLOAT3 eye, float projectionScale, float pixelTolerance);
+
+	// Same as above for every cell of the terrain
+	void SelectLevels(DirectX::XMFLOAT3 eye, float projectionScale, float pixelTolerance) { SelectLevels(m_allCells, eye, projectionScale, pixelTolerance); }
+
+	// The cells that took part in the last SelectLevels - the cells it was given and their neighbours
+	const std::vector<int>& GetActiveCells() const { return m_activeCells; }
+
+	int GetLevel(int cellIndex) const { return m_levels[cellIndex]; }
+	int GetStitchMask(int cellIndex) const { return m_stitchMasks[cellIndex]; }
+
+	// Errors are only known for cells that have taken part in a SelectLevels
+	bool HasErrors(int cellIndex) const { return m_hasErrors[cellIndex] != 0; }
+	float GetError(int cellIndex, int level) const { return m_errors[(static_cast<size_t>(cellIndex) * m_levelCount) + level]; }
+
+	// viewportHeight / (2 * tan(fovY / 2)) for a perspective projection matrix (_22 is 1 / tan(fovY / 2))
+	static float ProjectionScale(const DirectX::XMFLOAT4X4& projection, float viewportHeight) { return 0.5f * viewportHeight * projection._22; }
+
+private:
+	void ActivateCells(const std::vector<int>& cells);
+	void CalculateErrors(int cellIndex);
+	float DistanceToCell(int cellIndex, DirectX::XMFLOAT3 eye) const;
+	bool IsActive(int cellIndex) const { return m_activeInSelection[cellIndex] == m_selectionCount; }
+	void LimitNeighbourLevels();
+	void CalculateStitchMasks();
+
+	const HeightField&				m_heightField;
+	std::vector<TerrainCellBounds>	m_cellBounds;
+	int								m_cellRowCount;
+	int								m_cellSize;
+	int								m_levelCount;
+	ThreadPool&						m_pool;
+
+	std::vector<float>	m_errors;		// levelCount errors per cell
+	std::vector<char>	m_hasErrors;
+	std::vector<int>	m_levels;
+	std::vector<int>	m_stitchMasks;
+	std::vector<int>	m_workList;
+
+	// The cells taking part in the current selection, and the selection in which a cell last took part
+	std::vector<int>			m_allCells;
+	std::vector<int>			m_activeCells;
+	std::vector<int>			m_cellsWithoutErrors;
+	std::vector<unsigned int>	m_activeInSelection;
+	unsigned int				m_selectionCount;
+};
@@ -5,72 +5,78 @@
 #include "TerrainMeshException.h"
 #include "Mesh.h"
 #include "HLSLStructures.h"
+#include "HeightField.h"
+#include "TerrainBuilder.h"
+#include "ThreadPool.h"
+#include "TerrainCache.h"
+#include "TerrainCacheWriter.h"
+#include "MemoryMappedFile.h"
+#include "RawHeightMap.h"
+#include "BitmapColorMap.h"
+#include "ChameleonException.h"
 
 #include "TerrainCellMesh.h"
+#include "TerrainLodPatterns.h"
 
 #include <memory>
+#include <vector>
+#include <string>
+#include <functional>
+#include <chrono>
+#include <algorithm>
 
 #include <fstream>
+#include <filesystem>
 #include <stdio.h>
 
 
 class TerrainMesh
 {
-	struct HeightMapType
-	{
-		float x, y, z;
-		float nx, ny, nz;
-		float r, g, b;
-	};
-	/*
-	struct ModelType
-	{
-		float x, y, z;
-		float tu, tv;
-		float nx, ny, nz;
-		float tx, ty, tz;
-		float bx, by, bz;
-		float r, g, b;
-	};
-	*/
-
-	struct VectorType
-	{
-		float x, y, z;
-	};
-
-	struct TempVertexType
-	{
-		float x, y, z;
-		float tu, tv;
-		float nx, ny, nz;
-	};
-
-
 public:
 	TerrainMesh(std::shared_ptr<DeviceResources> deviceResources);
 	TerrainMesh(const TerrainMesh&) = delete;
 	TerrainMesh& operator=(const TerrainMesh&) = delete;
 
 	int TerrainCellCount() { return static_cast<int>(m_terrainCells.size()); }
+	int TerrainCellRowCount() { return m_cellRowCount; }
+	const std::vector<TerrainCellBounds>& GetCellBounds() { return m_cellBounds; }
+	std::shared_ptr<HeightField> GetHeightField() { return m_heightField; }
+	std::shared_ptr<TerrainLodPatterns> GetLodPatterns() { return m_lodPatterns; }
+
+	// When streaming, only the cells that have been loaded with LoadCell exist - every other entry is nullptr.
+	// Otherwise every cell is loaded up front and stays loaded
+	bool IsStreaming() { return m_cookedTerrain != nullptr; }
 	std::shared_ptr<TerrainCellMesh> GetTerrainCell(int index) { return m_terrainCells[index]; }
+	const std::vector<std::shared_ptr<TerrainCellMesh>>& GetTerrainCells() { return m_terrainCells; }
+
+	// LoadCell may be called from any thread as long as no two threads load the same cell at the same time.
+	// UnloadCell must not be called while that cell is being loaded
+	void LoadCell(int index);
+	void UnloadCell(int index);
+
+	// Approximate memory used by one loaded cell (in bytes)
+	size_t CellMemorySize();
+
+	// Time (in milliseconds) spent in each stage of the terrain load
+	const std::vector<std::pair<std::string, double>>& GetLoadTimings() { return m_loadTimings; }
 private:
 	void Tutorial1Setup();
 	void Tutorial2Setup(std::string setupFilename);
 
 	// void InitializeBuffers();
 
-	void LoadSetupFile(std::string setupFilename);
-	void LoadBitmapHeightMap();
-	void LoadRawHeightMap();
-	void SetTerrainCoordinates();
-	void BuildTerrainModel();
-	void CalculateNormals();
-	void LoadColorMap();
-	void LoadTerrainCells();
+	void TimeStage(std::string name, const std::function<void()>& stage);
 
-	void CalculateTerrainVectors();
-	void CalculateTangentBinormal(TempVertexType, TempVertexType, TempVertexType, VectorType&, VectorType&);
+	TerrainCacheKey CreateCacheKey();
+	std::unique_ptr<TerrainCache> OpenCookedTerrain(const std::string& filename, const TerrainCacheKey& key);
+	bool LoadCookedTerrain(const std::string& filename, const TerrainCacheKey& key, ThreadPool& pool);
+
+	// Builds the terrain and writes it to a cooked file without ever holding the whole terrain in memory. Throws
+	// if the file cannot be written
+	void CookTerrain(const std::string& filename, const TerrainCacheKey& key, const RawHeightMap& heightMap, const BitmapColorMap& colorMap, ThreadPool& pool);
+
+	void LoadSetupFile(std::string setupFilename);
+	void CreateCellIndexBuffer();
 
 	std::shared_ptr<DeviceResources> m_deviceResources;
 
@@ -82,8 +88,23 @@ private:
 	std::string m_terrainFilename;
 	std::string m_colorMapFilename;
 
-	TerrainModelType* m_terrainModel;
-	HeightMapType* m_heightMap;
+	// Scaled heights so the terrain height can be queried in constant time - a view of the heights in the cooked
+	// file, which it keeps mapped even when the cells are not streamed
+	std::shared_ptr<HeightField> m_heightField;
 
+	// Index patterns of every level of detail (and their index buffer) that are shared by every terrain cell
+	std::shared_ptr<TerrainLodPatterns> m_lodPatterns;
+	Microsoft::WRL::ComPtr<ID3D11Buffer> m_cellIndexBuffer;
+
+	// Cells are laid out in a square grid - cell (i, j) is stored at (m_cellRowCount * j) + i
+	int m_cellHeight, m_cellWidth;
+	int m_cellRowCount;
 	std::vector<std::shared_ptr<TerrainCellMesh>> m_terrainCells;
+	std::vector<TerrainCellBounds> m_cellBounds;
+
+	// Cells are paged in from the cooked file, which stays mapped while streaming
+	bool m_streamCells;
+	std::shared_ptr<TerrainCache> m_cookedTerrain;
+
+	std::vector<std::pair<std::string, double>> m_loadTimings;
 };
\ No newline at end of file
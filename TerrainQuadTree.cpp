@@ -0,0 +1,133 @@
+#include "TerrainQuadTree.h"
+
+TerrainQuadTree::TerrainQuadTree(const std::vector<TerrainCellBounds>& cells, int cellRowCount) :
+	m_lastTestCount(0)
+{
+	m_cellOrder.reserve(cells.size());
+
+	// A full quad tree has at most 4/3 as many nodes as it has leaves
+	m_nodes.reserve((cells.size() * 4) / 3 + 1);
+
+	// The root is always node 0
+	if (cellRowCount > 0)
+	{
+		m_nodes.resize(1);
+		m_bounds.resize(1);
+		BuildNode(0, cells, cellRowCount, 0, 0, cellRowCount, cellRowCount);
+	}
+}
+
+void TerrainQuadTree::BuildNode(int nodeIndex, const std::vector<TerrainCellBounds>& cells, int cellRowCount, int x0, int y0, int x1, int y1)
+{
+	NodeType node;
+	TerrainCellBounds bounds = { FLT_MAX, -FLT_MAX, FLT_MAX, -FLT_MAX, FLT_MAX, -FLT_MAX };
+	node.firstChild = -1;
+	node.childCount = 0;
+	node.firstCell = static_cast<int>(m_cellOrder.size());
+	node.cellCount = 0;
+
+	if (x1 - x0 == 1 && y1 - y0 == 1)
+	{
+		// Leaf - a single terrain cell
+		int cellIndex = (cellRowCount * y0) + x0;
+		m_bounds[nodeIndex] = cells[cellIndex];
+
+		m_cellOrder.push_back(cellIndex);
+		node.cellCount = 1;
+
+		m_nodes[nodeIndex] = node;
+		return;
+	}
+
+	// Split the range in half along both axes. The cell grid does not need to be a power of two - if
+	// one side is a single cell wide, the split only produces two children
+	int xMid = x0 + ((x1 - x0 + 1) / 2);
+	int yMid = y0 + ((y1 - y0 + 1) / 2);
+
+	int ranges[4][4] = {
+		{ x0,   y0,   xMid, yMid },
+		{ xMid, y0,   x1,   yMid },
+		{ x0,   yMid, xMid, y1   },
+		{ xMid, yMid, x1,   y1   }
+	};
+
+	// Children are stored consecutively so a node only needs to know where its first child is
+	for (int iii = 0; iii < 4; ++iii)
+	{
+		if (ranges[iii][0] < ranges[iii][2] && ranges[iii][1] < ranges[iii][3])
+			++node.childCount;
+	}
+	node.firstChild = static_cast<int>(m_nodes.size());
+	m_nodes.resize(m_nodes.size() + node.childCount);
+	m_bounds.resize(m_nodes.size());
+
+	int childIndex = node.firstChild;
+	for (int iii = 0; iii < 4; ++iii)
+	{
+		if (ranges[iii][0] >= ranges[iii][2] || ranges[iii][1] >= ranges[iii][3])
+			continue;
+
+		BuildNode(childIndex, cells, cellRowCount, ranges[iii][0], ranges[iii][1], ranges[iii][2], ranges[iii][3]);
+
+		const TerrainCellBounds& child = m_bounds[childIndex];
+		bounds.minX = std::min(bounds.minX, child.minX);
+		bounds.maxX = std::max(bounds.maxX, child.maxX);
+		bounds.minY = std::min(bounds.minY, child.minY);
+		bounds.maxY = std::max(bounds.maxY, child.maxY);
+		bounds.minZ = std::min(bounds.minZ, child.minZ);
+		bounds.maxZ = std::max(bounds.maxZ, child.maxZ);
+
+		++childIndex;
+	}
+
+	// Every cell under this node was appended while building the children, so they form one contiguous range
+	node.cellCount = static_cast<int>(m_cellOrder.size()) - node.firstCell;
+
+	m_nodes[nodeIndex] = node;
+	m_bounds[nodeIndex] = bounds;
+}
+
+void TerrainQuadTree::GetVisibleCells(Frustum* frustum, std::vector<int>& visibleCells)
+{
+	visibleCells.clear();
+	m_lastTestCount = 0;
+
+	if (m_nodes.empty())
+		return;
+
+	// Start with the root. Every node found intersecting the frustum adds its children to the next depth, and the
+	// whole depth is tested in one batch - far fewer, fuller batches than testing the children of each node alone
+	m_testNodes.assign(1, 0);
+	while (!m_testNodes.empty())
+	{
+		m_batch.Clear();
+		for (int nodeIndex : m_testNodes)
+		{
+			const TerrainCellBounds& bounds = m_bounds[nodeIndex];
+			m_batch.Add(bounds.minX, bounds.minY, bounds.minZ, bounds.maxX, bounds.maxY, bounds.maxZ);
+		}
+
+		m_batch.Check(frustum);
+		m_lastTestCount += static_cast<int>(m_testNodes.size());
+
+		m_nextNodes.clear();
+		for (size_t iii = 0; iii < m_testNodes.size(); ++iii)
+		{
+			if (!m_batch.IsVisible(iii))
+				continue;
+
+			// Either the whole subtree is visible or this is a leaf - in both cases take every cell under the node
+			const NodeType& node = m_nodes[m_testNodes[iii]];
+			if (m_batch.IsInside(iii) || node.firstChild == -1)
+			{
+				visibleCells.insert(visibleCells.end(), m_cellOrder.begin() + node.firstCell, m_cellOrder.begin() + node.firstCell + node.cellCount);
+				continue;
+			}
+
+			for (int child = node.firstChild; child < node.firstChild + node.childCount; ++child)
+				m_nextNodes.push_back(child);
+		}
+
+		std::swap(m_testNodes, m_nextNodes);
+	}
+}
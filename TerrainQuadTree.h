@@ -0,0 +1,56 @@
+#pragma once
+#include "pch.h"
+#include "TerrainCellBounds.h"
+#include "Frustum.h"
+#include "FrustumBoxBatch.h"
+
+#include <memory>
+#include <vector>
+#include <algorithm>
+
+// TerrainQuadTree groups the terrain cells into a quad tree where every node stores the min/max
+// bounds (including height) of all the cells beneath it. Culling walks the tree from the root:
+// nodes outside the frustum are rejected together with their whole subtree and nodes entirely
+// inside the frustum accept all of their cells without testing them individually. The tree is
+// walked one depth at a time, so all the nodes tested at a depth go through a single
+// Frustum::CheckRectangles call.
+class TerrainQuadTree
+{
+	struct NodeType
+	{
+		// Index of the first of the four children (children are stored consecutively), -1 for leaves
+		int firstChild;
+		int childCount;
+
+		// Range into m_cellOrder of every cell under this node
+		int firstCell;
+		int cellCount;
+	};
+
+public:
+	// cellRowCount is the number of cells along each side of the terrain. Cell (i, j) must be stored
+	// at index (cellRowCount * j) + i, which is the layout TerrainMesh uses
+	TerrainQuadTree(const std::vector<TerrainCellBounds>& cells, int cellRowCount);
+	TerrainQuadTree(const TerrainQuadTree&) = delete;
+	TerrainQuadTree& operator=(const TerrainQuadTree&) = delete;
+
+	// Clears visibleCells and fills it with the index of every cell that is at least partially visible
+	void GetVisibleCells(Frustum* frustum, std::vector<int>& visibleCells);
+
+	// Number of frustum tests performed during the last call to GetVisibleCells
+	int LastTestCount() { return m_lastTestCount; }
+
+private:
+	void BuildNode(int nodeIndex, const std::vector<TerrainCellBounds>& cells, int cellRowCount, int x0, int y0, int x1, int y1);
+
+	std::vector<NodeType>			m_nodes;
+	std::vector<TerrainCellBounds>	m_bounds;		// Bounds of every node, indexed like m_nodes
+	std::vector<int>				m_cellOrder;
+
+	// Scratch space for GetVisibleCells - the nodes to test at the current and at the next depth
+	std::vector<int>				m_testNodes;
+	std::vector<int>				m_nextNodes;
+	FrustumBoxBatch					m_batch;
+
+	int m_lastTestCount;
+};
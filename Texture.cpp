@@ -31,7 +31,23 @@ void Texture::Reset()
 
 void Texture::Create(std::string filename)
 {
-	INFOMAN(m_deviceResources);
+	Upload(*Decode(filename, m_textureDesc.Format));
+}
+
+std::unique_ptr<ScratchImage> Texture::Decode(const std::string& filename, DXGI_FORMAT format)
+{
+	// Only textures in the default format are cooked - a texture that asks for anything else gets exactly that
+	// format, decoded from the source file
+	const bool cook = format == DXGI_FORMAT_R8G8B8A8_UNORM && std::filesystem::exists(filename);
+	const std::string cookedFilename = filename + ".cooked";
+	TextureCacheKey key = {};
+	if (cook)
+	{
+		key = TextureCache::CreateKey(filename);
+		std::unique_ptr<ScratchImage> cooked = LoadCookedTexture(cookedFilename, key);
+		if (cooked != nullptr)
+			return cooked;
+	}
 
 	std::unique_ptr<DirectX::ScratchImage> scratchImage;
 
@@ -45,41 +61,131 @@ void Texture::Create(std::string filename)
 	{
 		scratchImage = LoadWICImage(filename);
 	}
+	else
+	{
+		std::ostringstream oss;
+		oss << "Unsupported image file type: " << filename;
+		throw TextureException(__LINE__, __FILE__, oss.str());
+	}
 
 
 	const DirectX::Image* img = scratchImage->GetImage(0, 0, 0);
 	assert(img);
 
 	// Make sure the image has the correct format
-	if (img->format != m_textureDesc.Format)
+	if (img->format != format)
 	{
 		DirectX::ScratchImage converted;
-		GFX_THROW_INFO(
+		ThrowIfFailed(
 			DirectX::Convert(
-				*scratchImage->GetImage(0, 0, 0),
-				m_textureDesc.Format,
+				*img,
+				format,
 				DirectX::TEX_FILTER_DEFAULT,
 				DirectX::TEX_THRESHOLD_DEFAULT,
 				converted
-			)
+			),
+			"convert", filename, __LINE__
 		);
 
 		scratchImage = std::make_unique<DirectX::ScratchImage>(std::move(converted));
-		img = scratchImage->GetImage(0, 0, 0);
 	}
 
-	m_textureDesc.Height = img->height;
-	m_textureDesc.Width = img->width;
+	if (cook)
+	{
+		std::unique_ptr<ScratchImage> cooked = CookTexture(cookedFilename, key, filename, *scratchImage);
+		if (cooked != nullptr)
+			return cooked;
+	}
+
+	return scratchImage;
+}
+
+std::unique_ptr<ScratchImage> Texture::LoadCookedTexture(const std::string& filename, const TextureCacheKey& key)
+{
+	if (!std::filesystem::exists(filename))
+		return nullptr;
+
+	// A cooked file that cannot be read is not an error - the source file is just decoded and cooked again
+	try
+	{
+		TextureCache cache(filename);
+		if (!cache.Matches(key))
+			return nullptr;
+
+		return cache.Load();
+	}
+	catch (const ChameleonException&)
+	{
+		return nullptr;
+	}
+}
+
+std::unique_ptr<ScratchImage> Texture::CookTexture(const std::string& filename, const TextureCacheKey& key, const std::string& sourceFilename, const ScratchImage& image)
+{
+	// Cooking only saves work and memory, so it must not stop the texture from loading. If compressing fails the
+	// decoded image is used as is - if only writing the file fails, the next launch simply cooks it again
+	std::unique_ptr<ScratchImage> cooked;
+	try
+	{
+		cooked = TextureCache::Cook(sourceFilename, image);
+		if (cooked != nullptr)
+			TextureCache::Write(filename, key, *cooked);
+	}
+	catch (const ChameleonException& e)
+	{
+		OutputDebugStringA(e.what());
+	}
+
+	return cooked;
+}
+
+void Texture::Upload(const DirectX::ScratchImage& image)
+{
+	INFOMAN(m_deviceResources);
+
+	const DirectX::Image* img = image.GetImage(0, 0, 0);
+	assert(img);
+
+	// A cooked texture already has its whole mip chain (and block compressed textures cannot be render targets, so
+	// the device could not generate the mips anyway). It is created immutable, straight from the image
+	const TexMetadata& metadata = image.GetMetadata();
+	if (metadata.mipLevels > 1 || DirectX::IsCompressed(metadata.format))
+	{
+		TextureFormat(metadata.format);
+		m_textureDesc.Height = static_cast<UINT>(metadata.height);
+		m_textureDesc.Width = static_cast<UINT>(metadata.width);
+		m_textureDesc.MipLevels = static_cast<UINT>(metadata.mipLevels);
+		m_textureDesc.Usage = D3D11_USAGE_IMMUTABLE;
+		m_textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+		m_textureDesc.MiscFlags = 0;
+
+		std::vector<D3D11_SUBRESOURCE_DATA> initialData(metadata.mipLevels);
+		for (size_t mip = 0; mip < metadata.mipLevels; ++mip)
+		{
+			const DirectX::Image* mipImage = image.GetImage(mip, 0, 0);
+			initialData[mip].pSysMem = mipImage->pixels;
+			initialData[mip].SysMemPitch = static_cast<UINT>(mipImage->rowPitch);
+			initialData[mip].SysMemSlicePitch = static_cast<UINT>(mipImage->slicePitch);
+		}
+
+		GFX_THROW_INFO(m_deviceResources->D3DDevice()->CreateTexture2D(&m_textureDesc, initialData.data(), &m_texture));
+		GFX_THROW_INFO(
+			m_deviceResources->D3DDevice()->CreateShaderResourceView(m_texture.Get(), &m_srvDesc, m_textureView.ReleaseAndGetAddressOf())
+		);
+		return;
+	}
+
+	assert(img->format == m_textureDesc.Format);
+
+	m_textureDesc.Height = static_cast<UINT>(img->height);
+	m_textureDesc.Width = static_cast<UINT>(img->width);
 
 	// Create the empty texture.
 	GFX_THROW_INFO(m_deviceResources->D3DDevice()->CreateTexture2D(&m_textureDesc, nullptr, &m_texture));
 
-	// Set the row pitch of the targa image data.
-	unsigned int _rowPitch = (img->width * 4) * sizeof(unsigned char);
-
-	// Copy the targa image data into the texture.
+	// Copy the image data into the texture.
 	GFX_THROW_INFO_ONLY(
-		m_deviceResources->D3DDeviceContext()->UpdateSubresource(m_texture.Get(), 0, NULL, img->pixels, _rowPitch, 0)
+		m_deviceResources->D3DDeviceContext()->UpdateSubresource(m_texture.Get(), 0, NULL, img->pixels, static_cast<UINT>(img->rowPitch), 0)
 	);
 
 	// Create the shader resource view for the texture.
@@ -93,30 +199,66 @@ void Texture::Create(std::string filename)
 	);
 }
 
-std::unique_ptr<ScratchImage> Texture::LoadWICImage(std::string filename)
+size_t Texture::SizeInBytes() const
 {
-	INFOMAN(m_deviceResources);
+	if (!IsLoaded())
+		return 0;
+
+	// A MipLevels of 0 asks for the full chain down to 1x1. Block compressed mips are stored in whole 4x4 blocks
+	size_t bitsPerPixel = DirectX::BitsPerPixel(m_textureDesc.Format);
+	size_t blockSize = DirectX::IsCompressed(m_textureDesc.Format) ? 4 : 1;
+	size_t width = m_textureDesc.Width;
+	size_t height = m_textureDesc.Height;
+	size_t bytes = 0;
+	for (unsigned int level = 0; m_textureDesc.MipLevels == 0 || level < m_textureDesc.MipLevels; ++level)
+	{
+		size_t storedWidth = (width + blockSize - 1) / blockSize * blockSize;
+		size_t storedHeight = (height + blockSize - 1) / blockSize * blockSize;
+		bytes += (storedWidth * storedHeight * bitsPerPixel) / 8;
+		if (width == 1 && height == 1)
+			break;
 
+		width = std::max<size_t>(width / 2, 1);
+		height = std::max<size_t>(height / 2, 1);
+	}
+
+	return bytes * m_textureDesc.ArraySize;
+}
+
+std::unique_ptr<ScratchImage> Texture::LoadWICImage(const std::string& filename)
+{
 	std::unique_ptr<ScratchImage> image = std::make_unique<DirectX::ScratchImage>();
 	DirectX::TexMetadata metadata;
 	std::wstring wideFilename = std::wstring(filename.begin(), filename.end());
-	GFX_THROW_INFO(
-		DirectX::LoadFromWICFile(wideFilename.c_str(), DirectX::WIC_FLAGS::WIC_FLAGS_NONE, &metadata, *image)
+	ThrowIfFailed(
+		DirectX::LoadFromWICFile(wideFilename.c_str(), DirectX::WIC_FLAGS::WIC_FLAGS_NONE, &metadata, *image),
+		"load", filename, __LINE__
 	);
 
-	return std::move(image);
+	return image;
 }
 
-std::unique_ptr<ScratchImage> Texture::LoadTGAImage(std::string filename)
+std::unique_ptr<ScratchImage> Texture::LoadTGAImage(const std::string& filename)
 {
-	INFOMAN(m_deviceResources);
-
 	std::unique_ptr<ScratchImage> image = std::make_unique<DirectX::ScratchImage>();
 	DirectX::TexMetadata metadata;
 	std::wstring wideFilename = std::wstring(filename.begin(), filename.end());
-	GFX_THROW_INFO(
-		DirectX::LoadFromTGAFile(wideFilename.c_str(), DirectX::TGA_FLAGS::TGA_FLAGS_NONE, &metadata, *image)
+	ThrowIfFailed(
+		DirectX::LoadFromTGAFile(wideFilename.c_str(), DirectX::TGA_FLAGS::TGA_FLAGS_NONE, &metadata, *image),
+		"load", filename, __LINE__
 	);
 
-	return std::move(image);
-}
\ No newline at end of file
+	return image;
+}
+
+void Texture::ThrowIfFailed(HRESULT hr, const char* operation, const std::string& filename, int line)
+{
+	// Decoding can run on a worker thread, where the DXGI info queue must not be touched, so failures are
+	// reported without it
+	if (FAILED(hr))
+	{
+		std::ostringstream oss;
+		oss << "Failed to " << operation << " image file: " << filename << " (HRESULT 0x" << std::hex << static_cast<unsigned long>(hr) << ")";
+		throw TextureException(line, __FILE__, oss.str());
+	}
+}
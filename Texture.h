@@ -3,11 +3,14 @@
 #include "DeviceResources.h"
 #include "DeviceResourcesException.h"
 #include "TextureException.h"
+#include "TextureCache.h"
 
 #include <memory>
 #include <string>
+#include <vector>
 #include <stdio.h>
 #include <filesystem>
+#include <algorithm>
 
 #include <DirectXTex.h>
 
@@ -44,14 +47,33 @@ public:
 
 	void Create(std::string filename);
 
+	// Create is split in two so the expensive half can run on a worker thread. Decode reads the image file and
+	// converts it to the given format - it does not touch the device, so it is safe to call from any thread (the
+	// thread needs COM initialized for WIC formats). Upload must be called on the thread that owns the device
+	// context and expects an image already in the texture format.
+	//
+	// Textures in the default R8G8B8A8_UNORM format are cooked through TextureCache: Decode returns the block
+	// compressed mip chain from "<filename>.cooked" if it is up to date, and writes it after decoding the source
+	// otherwise. Upload takes the format and mip count of such an image over instead of generating mips
+	static std::unique_ptr<DirectX::ScratchImage> Decode(const std::string& filename, DXGI_FORMAT format);
+	void Upload(const DirectX::ScratchImage& image);
+
+	// False until the texture has been uploaded. A texture that is not loaded binds as a null view
+	bool IsLoaded() const { return m_textureView != nullptr; }
+	DXGI_FORMAT Format() const { return m_textureDesc.Format; }
+
+	// GPU memory used by the texture and its mip chain (0 until it has been uploaded)
+	size_t SizeInBytes() const;
 
-	
 
 	ID3D11ShaderResourceView* GetRawTextureViewPointer() { return m_textureView.Get(); }
 
 private:
-	std::unique_ptr<DirectX::ScratchImage> LoadTGAImage(std::string filename);
-	std::unique_ptr<DirectX::ScratchImage> LoadWICImage(std::string filename);
+	static std::unique_ptr<DirectX::ScratchImage> LoadTGAImage(const std::string& filename);
+	static std::unique_ptr<DirectX::ScratchImage> LoadWICImage(const std::string& filename);
+	static std::unique_ptr<DirectX::ScratchImage> LoadCookedTexture(const std::string& filename, const TextureCacheKey& key);
+	static std::unique_ptr<DirectX::ScratchImage> CookTexture(const std::string& filename, const TextureCacheKey& key, const std::string& sourceFilename, const DirectX::ScratchImage& image);
+	static void ThrowIfFailed(HRESULT hr, const char* operation, const std::string& filename, int line);
 
 	std::shared_ptr<DeviceResources> m_deviceResources;
 
@@ -2,7 +2,8 @@
 #include "ObjectStore.h"
 
 TextureArray::TextureArray(std::shared_ptr<DeviceResources> deviceResources, TextureBindingLocation bindToStage) :
-	Bindable(deviceResources)
+	Bindable(deviceResources),
+	m_slot({ BindableSlot::Type::SHADER_RESOURCES, static_cast<int>(bindToStage) })
 {
 	switch (bindToStage)
 	{
@@ -31,6 +32,9 @@ void TextureArray::Bind()
 
 void TextureArray::BindCS()
 {
+	if (!PipelineState::SetShaderResources(static_cast<int>(TextureBindingLocation::COMPUTE_SHADER), 0u, static_cast<unsigned int>(m_rawTextureViewPointers.size()), m_rawTextureViewPointers.data()))
+		return;
+
 	INFOMAN(m_deviceResources);
 	GFX_THROW_INFO_ONLY(
 		m_deviceResources->D3DDeviceContext()->CSSetShaderResources(0u, static_cast<unsigned int>(m_rawTextureViewPointers.size()), m_rawTextureViewPointers.data())
@@ -39,6 +43,9 @@ void TextureArray::BindCS()
 
 void TextureArray::BindVS()
 {
+	if (!PipelineState::SetShaderResources(static_cast<int>(TextureBindingLocation::VERTEX_SHADER), 0u, static_cast<unsigned int>(m_rawTextureViewPointers.size()), m_rawTextureViewPointers.data()))
+		return;
+
 	INFOMAN(m_deviceResources);
 	GFX_THROW_INFO_ONLY(
 		m_deviceResources->D3DDeviceContext()->VSSetShaderResources(0u, static_cast<unsigned int>(m_rawTextureViewPointers.size()), m_rawTextureViewPointers.data())
@@ -47,6 +54,9 @@ void TextureArray::BindVS()
 
 void TextureArray::BindHS()
 {
+	if (!PipelineState::SetShaderResources(static_cast<int>(TextureBindingLocation::HULL_SHADER), 0u, static_cast<unsigned int>(m_rawTextureViewPointers.size()), m_rawTextureViewPointers.data()))
+		return;
+
 	INFOMAN(m_deviceResources);
 	GFX_THROW_INFO_ONLY(
 		m_deviceResources->D3DDeviceContext()->HSSetShaderResources(0u, static_cast<unsigned int>(m_rawTextureViewPointers.size()), m_rawTextureViewPointers.data())
@@ -55,6 +65,9 @@ void TextureArray::BindHS()
 
 void TextureArray::BindDS()
 {
+	if (!PipelineState::SetShaderResources(static_cast<int>(TextureBindingLocation::DOMAIN_SHADER), 0u, static_cast<unsigned int>(m_rawTextureViewPointers.size()), m_rawTextureViewPointers.data()))
+		return;
+
 	INFOMAN(m_deviceResources);
 	GFX_THROW_INFO_ONLY(
 		m_deviceResources->D3DDeviceContext()->DSSetShaderResources(0u, static_cast<unsigned int>(m_rawTextureViewPointers.size()), m_rawTextureViewPointers.data())
@@ -63,6 +76,9 @@ void TextureArray::BindDS()
 
 void TextureArray::BindGS()
 {
+	if (!PipelineState::SetShaderResources(static_cast<int>(TextureBindingLocation::GEOMETRY_SHADER), 0u, static_cast<unsigned int>(m_rawTextureViewPointers.size()), m_rawTextureViewPointers.data()))
+		return;
+
 	INFOMAN(m_deviceResources);
 	GFX_THROW_INFO_ONLY(
 		m_deviceResources->D3DDeviceContext()->GSSetShaderResources(0u, static_cast<unsigned int>(m_rawTextureViewPointers.size()), m_rawTextureViewPointers.data())
@@ -71,6 +87,9 @@ void TextureArray::BindGS()
 
 void TextureArray::BindPS()
 {
+	if (!PipelineState::SetShaderResources(static_cast<int>(TextureBindingLocation::PIXEL_SHADER), 0u, static_cast<unsigned int>(m_rawTextureViewPointers.size()), m_rawTextureViewPointers.data()))
+		return;
+
 	INFOMAN(m_deviceResources);
 	GFX_THROW_INFO_ONLY(
 		m_deviceResources->D3DDeviceContext()->PSSetShaderResources(0u, static_cast<unsigned int>(m_rawTextureViewPointers.size()), m_rawTextureViewPointers.data())
@@ -23,11 +23,14 @@ public:
 
 	void AddTexture(std::string lookupName);
 	void AddTexture(std::shared_ptr<Texture> texture) { m_textures.push_back(texture); }
+	const std::vector<std::shared_ptr<Texture>>& GetTextures() const { return m_textures; }
 
 	void Bind() override;
+	BindableSlot Slot() const override { return m_slot; }
 
 private:
 	std::function<void()> BindFunc;
+	BindableSlot m_slot;
 
 	void BindCS();
 	void BindVS();
@@ -0,0 +1,229 @@
+#include "TextureCache.h"
+
+using DirectX::ScratchImage;
+using DirectX::TexMetadata;
+
+TextureCache::TextureCache(const std::string& filename) :
+	m_header(nullptr),
+	m_filename(filename)
+{
+	std::ostringstream oss;
+
+	m_file = std::make_unique<MemoryMappedFile>(filename);
+
+	if (m_file->Size() < sizeof(HeaderType))
+	{
+		oss << "File is too small to be a cooked texture file: " << filename;
+		throw TextureCacheException(__LINE__, __FILE__, oss.str());
+	}
+
+	m_header = reinterpret_cast<const HeaderType*>(m_file->Data());
+
+	if (std::string(m_header->magic, 4) != "CTEX" || m_header->version != VERSION)
+	{
+		oss << "File is not a cooked texture file of the current version: " << filename;
+		throw TextureCacheException(__LINE__, __FILE__, oss.str());
+	}
+
+	// The whole chain has to be in the file before Load copies it. D3D11 textures are at most 16384 texels on a
+	// side, which also keeps the sizes below from overflowing
+	size_t expectedSize = 0;
+	bool valid = BlockSize(Format()) != 0 &&
+		m_header->width > 0 && m_header->width <= D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION && (m_header->width % 4) == 0 &&
+		m_header->height > 0 && m_header->height <= D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION && (m_header->height % 4) == 0 &&
+		m_header->mipLevels > 0;
+
+	// No more mips than it takes to get down to 1x1
+	unsigned int fullChain = 1;
+	for (uint32_t size = std::max(m_header->width, m_header->height); valid && size > 1; size /= 2)
+		++fullChain;
+	valid = valid && m_header->mipLevels <= fullChain;
+
+	for (unsigned int mip = 0; valid && mip < m_header->mipLevels; ++mip)
+		expectedSize += MipSize(Format(), m_header->width, m_header->height, mip);
+
+	if (!valid || m_header->fileSize != m_file->Size() || m_header->pixelsSize != expectedSize ||
+		m_header->pixelsOffset > m_file->Size() || m_header->pixelsSize > m_file->Size() - m_header->pixelsOffset)
+	{
+		oss << "Cooked texture file is truncated or corrupt: " << filename;
+		throw TextureCacheException(__LINE__, __FILE__, oss.str());
+	}
+}
+
+TextureCacheKey TextureCache::CreateKey(const std::string& sourceFilename)
+{
+	TextureCacheKey key = {};
+	key.sourceSize = static_cast<uint64_t>(std::filesystem::file_size(sourceFilename));
+	key.sourceWriteTime = static_cast<int64_t>(std::filesystem::last_write_time(sourceFilename).time_since_epoch().count());
+	return key;
+}
+
+bool TextureCache::Matches(const TextureCacheKey& key) const
+{
+	const TextureCacheKey& cooked = m_header->key;
+	return cooked.sourceSize == key.sourceSize &&
+		cooked.sourceWriteTime == key.sourceWriteTime;
+}
+
+std::unique_ptr<ScratchImage> TextureCache::Load() const
+{
+	std::unique_ptr<ScratchImage> image = std::make_unique<ScratchImage>();
+	ThrowIfFailed(
+		image->Initialize2D(Format(), m_header->width, m_header->height, 1, m_header->mipLevels),
+		"allocate", m_filename, __LINE__
+	);
+
+	const uint8_t* pixels = m_file->Data() + m_header->pixelsOffset;
+	for (unsigned int mip = 0; mip < m_header->mipLevels; ++mip)
+	{
+		const DirectX::Image* img = image->GetImage(mip, 0, 0);
+		size_t size = MipSize(Format(), m_header->width, m_header->height, mip);
+		if (img == nullptr || img->slicePitch != size)
+		{
+			std::ostringstream oss;
+			oss << "Cooked texture mip " << mip << " does not match the DirectXTex layout: " << m_filename;
+			throw TextureCacheException(__LINE__, __FILE__, oss.str());
+		}
+
+		memcpy(img->pixels, pixels, size);
+		pixels += size;
+	}
+
+	return image;
+}
+
+DXGI_FORMAT TextureCache::CompressedFormat(const std::string& sourceFilename, const ScratchImage& image)
+{
+	const TexMetadata& metadata = image.GetMetadata();
+	if (metadata.format != DXGI_FORMAT_R8G8B8A8_UNORM || metadata.dimension != DirectX::TEX_DIMENSION_TEXTURE2D ||
+		metadata.arraySize != 1 || metadata.depth != 1 || (metadata.width % 4) != 0 || (metadata.height % 4) != 0)
+		return DXGI_FORMAT_UNKNOWN;
+
+	std::string stem = std::filesystem::path(sourceFilename).stem().string();
+	std::transform(stem.begin(), stem.end(), stem.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+	if (stem.ends_with("_ddn") || stem.ends_with("_normal"))
+		return DXGI_FORMAT_BC5_UNORM;
+
+	return image.IsAlphaAllOpaque() ? DXGI_FORMAT_BC1_UNORM : DXGI_FORMAT_BC3_UNORM;
+}
+
+std::unique_ptr<ScratchImage> TextureCache::Cook(const std::string& sourceFilename, const ScratchImage& image)
+{
+	DXGI_FORMAT format = CompressedFormat(sourceFilename, image);
+	if (format == DXGI_FORMAT_UNKNOWN)
+		return nullptr;
+
+	// The mips are filtered on the CPU without WIC, so cooking does not depend on COM being initialized
+	ScratchImage mipChain;
+	ThrowIfFailed(
+		DirectX::GenerateMipMaps(*image.GetImage(0, 0, 0), DirectX::TEX_FILTER_DEFAULT | DirectX::TEX_FILTER_FORCE_NON_WIC, 0, mipChain),
+		"generate mips for", sourceFilename, __LINE__
+	);
+
+	// AssetLoader already cooks several textures at once on the thread pool, so each compression runs single threaded
+	std::unique_ptr<ScratchImage> compressed = std::make_unique<ScratchImage>();
+	ThrowIfFailed(
+		DirectX::Compress(mipChain.GetImages(), mipChain.GetImageCount(), mipChain.GetMetadata(), format,
+			DirectX::TEX_COMPRESS_DEFAULT, DirectX::TEX_THRESHOLD_DEFAULT, *compressed),
+		"compress", sourceFilename, __LINE__
+	);
+
+	return compressed;
+}
+
+void TextureCache::Write(const std::string& filename, const TextureCacheKey& key, const ScratchImage& image)
+{
+	std::ostringstream oss;
+
+	const TexMetadata& metadata = image.GetMetadata();
+	if (BlockSize(metadata.format) == 0 || metadata.dimension != DirectX::TEX_DIMENSION_TEXTURE2D || metadata.arraySize != 1 ||
+		(metadata.width % 4) != 0 || (metadata.height % 4) != 0)
+	{
+		oss << "Image cannot be written to a cooked texture file (not a cooked BC1/BC3/BC5 texture): " << filename;
+		throw TextureCacheException(__LINE__, __FILE__, oss.str());
+	}
+
+	// Zero the whole header so that padding bytes are deterministic
+	HeaderType header;
+	ZeroMemory(&header, sizeof(HeaderType));
+	memcpy(header.magic, "CTEX", 4);
+	header.version = VERSION;
+	header.format = static_cast<uint32_t>(metadata.format);
+	header.width = static_cast<uint32_t>(metadata.width);
+	header.height = static_cast<uint32_t>(metadata.height);
+	header.mipLevels = static_cast<uint32_t>(metadata.mipLevels);
+	header.key = key;
+	header.pixelsOffset = sizeof(HeaderType);
+
+	for (unsigned int mip = 0; mip < header.mipLevels; ++mip)
+	{
+		const DirectX::Image* img = image.GetImage(mip, 0, 0);
+		if (img == nullptr || img->slicePitch != MipSize(metadata.format, metadata.width, metadata.height, mip))
+		{
+			oss << "Cooked texture mip " << mip << " is not tightly packed: " << filename;
+			throw TextureCacheException(__LINE__, __FILE__, oss.str());
+		}
+		header.pixelsSize += img->slicePitch;
+	}
+	header.fileSize = header.pixelsOffset + header.pixelsSize;
+
+	std::string temporaryFilename = filename + ".tmp";
+	std::ofstream fout(temporaryFilename, std::ios::binary | std::ios::trunc);
+	if (!fout)
+	{
+		oss << "Failed to open file for writing: " << temporaryFilename;
+		throw TextureCacheException(__LINE__, __FILE__, oss.str());
+	}
+
+	fout.write(reinterpret_cast<const char*>(&header), sizeof(HeaderType));
+	for (unsigned int mip = 0; mip < header.mipLevels; ++mip)
+	{
+		const DirectX::Image* img = image.GetImage(mip, 0, 0);
+		fout.write(reinterpret_cast<const char*>(img->pixels), img->slicePitch);
+	}
+	fout.close();
+
+	if (!fout)
+	{
+		oss << "Failed to write cooked texture file: " << temporaryFilename;
+		throw TextureCacheException(__LINE__, __FILE__, oss.str());
+	}
+
+	if (!MoveFileExA(temporaryFilename.c_str(), filename.c_str(), MOVEFILE_REPLACE_EXISTING))
+	{
+		oss << "Failed to move cooked texture file into place: " << filename;
+		throw TextureCacheException(__LINE__, __FILE__, oss.str());
+	}
+}
+
+size_t TextureCache::BlockSize(DXGI_FORMAT format)
+{
+	switch (format)
+	{
+	case DXGI_FORMAT_BC1_UNORM:
+		return 8;
+	case DXGI_FORMAT_BC3_UNORM:
+	case DXGI_FORMAT_BC5_UNORM:
+		return 16;
+	default:
+		return 0;
+	}
+}
+
+size_t TextureCache::MipSize(DXGI_FORMAT format, size_t width, size_t height, unsigned int mip)
+{
+	// Mips smaller than a block still take up a whole block
+	size_t blocksWide = (std::max<size_t>(width >> mip, 1) + 3) / 4;
+	size_t blocksHigh = (std::max<size_t>(height >> mip, 1) + 3) / 4;
+	return blocksWide * blocksHigh * BlockSize(format);
+}
+
+void TextureCache::ThrowIfFailed(HRESULT hr, const char* operation, const std::string& filename, int line)
+{
+	if (FAILED(hr))
+	{
+		std::ostringstream oss;
+		oss << "Failed to " << operation << " texture: " << filename << " (HRESULT 0x" << std::hex << static_cast<unsigned long>(hr) << ")";
+		throw TextureCacheException(line, __FILE__, oss.str());
+	}
+}
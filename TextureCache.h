@@ -0,0 +1,96 @@
+#pragma once
+#include "pch.h"
+#include "TextureCacheException.h"
+#include "MemoryMappedFile.h"
+
+#include <memory>
+#include <string>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cctype>
+#include <stdint.h>
+
+#include <DirectXTex.h>
+
+// Everything a cooked texture depends on - see ModelCacheKey
+struct TextureCacheKey
+{
+	uint64_t sourceSize;
+	int64_t sourceWriteTime;
+};
+
+// TextureCache reads and writes "cooked" textures - an image file that has already been decoded, given a full mip
+// chain and block compressed, so that loading it is a copy out of a memory mapped file instead of a PNG/JPG/TGA
+// decode followed by GenerateMips on the device:
+//
+//		HeaderType
+//		uint8_t		pixels[pixelsSize]		(mip 0 first, each mip tightly packed in BC blocks)
+//
+// Textures are compressed to BC1 if they are fully opaque, BC3 if they are not, and BC5 if the file name marks them
+// as a normal map (*_ddn.*, *_normal.*) - BC5 only keeps the x and y of the normal, the pixel shader rebuilds z.
+// Compared to R8G8B8A8 that is 8x less memory for BC1 and 4x less for BC3/BC5.
+//
+// Cooking does not touch the device (or WIC), so Cook and Write can run on any thread. Bump VERSION whenever the
+// layout or the cooking (filter, format choice) changes.
+class TextureCache
+{
+public:
+	static constexpr uint32_t VERSION = 1;
+
+private:
+	struct HeaderType
+	{
+		char magic[4];
+		uint32_t version;
+		uint32_t format;			// DXGI_FORMAT
+		uint32_t width;
+		uint32_t height;
+		uint32_t mipLevels;
+		TextureCacheKey key;
+		uint64_t pixelsOffset;
+		uint64_t pixelsSize;
+		uint64_t fileSize;
+	};
+
+public:
+	// Maps an existing cooked file. Throws TextureCacheException if it is not a valid cooked texture file
+	TextureCache(const std::string& filename);
+	TextureCache(const TextureCache&) = delete;
+	TextureCache& operator=(const TextureCache&) = delete;
+
+	static TextureCacheKey CreateKey(const std::string& sourceFilename);
+	bool Matches(const TextureCacheKey& key) const;
+
+	DXGI_FORMAT Format() const { return static_cast<DXGI_FORMAT>(m_header->format); }
+	unsigned int Width() const { return m_header->width; }
+	unsigned int Height() const { return m_header->height; }
+	unsigned int MipLevels() const { return m_header->mipLevels; }
+
+	// Copies the whole mip chain out of the mapped file, so the image outlives the TextureCache
+	std::unique_ptr<DirectX::ScratchImage> Load() const;
+
+	// The compressed format Cook would use for a decoded R8G8B8A8_UNORM image, or DXGI_FORMAT_UNKNOWN if the image
+	// cannot be block compressed (BC textures must be a multiple of 4 texels wide and high)
+	static DXGI_FORMAT CompressedFormat(const std::string& sourceFilename, const DirectX::ScratchImage& image);
+
+	// Builds the full mip chain for a decoded R8G8B8A8_UNORM image and compresses it. Returns nullptr if the image
+	// cannot be block compressed
+	static std::unique_ptr<DirectX::ScratchImage> Cook(const std::string& sourceFilename, const DirectX::ScratchImage& image);
+
+	// Writes a cooked file for an image returned by Cook. Like ModelCache::Write, the file is written under a
+	// temporary name first and then moved into place
+	static void Write(const std::string& filename, const TextureCacheKey& key, const DirectX::ScratchImage& image);
+
+private:
+	// Bytes per 4x4 block, or 0 for a format a cooked file may not contain
+	static size_t BlockSize(DXGI_FORMAT format);
+	static size_t MipSize(DXGI_FORMAT format, size_t width, size_t height, unsigned int mip);
+
+	static void ThrowIfFailed(HRESULT hr, const char* operation, const std::string& filename, int line);
+
+	std::unique_ptr<MemoryMappedFile> m_file;
+	const HeaderType* m_header;
+	std::string m_filename;		// For error messages
+};
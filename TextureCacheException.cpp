@@ -0,0 +1,28 @@
+#include "TextureCacheException.h"
+
+TextureCacheException::TextureCacheException(int line, const char* file, std::string description) noexcept :
+	ChameleonException(line, file)
+{
+	m_info = description;
+}
+
+
+const char* TextureCacheException::what() const noexcept
+{
+	std::ostringstream oss;
+	oss << GetType() << std::endl
+		<< "\n[Error Info]\n" << GetErrorInfo() << std::endl << std::endl;
+	oss << GetOriginString();
+	m_whatBuffer = oss.str();
+	return m_whatBuffer.c_str();
+}
+
+const char* TextureCacheException::GetType() const noexcept
+{
+	return "Texture Cache Exception";
+}
+
+std::string TextureCacheException::GetErrorInfo() const noexcept
+{
+	return m_info;
+}
\ No newline at end of file
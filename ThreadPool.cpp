@@ -0,0 +1,130 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(unsigned int threadCount) :
+	m_stopping(false)
+{
+	for (unsigned int iii = 0; iii < threadCount; ++iii)
+		m_threads.emplace_back(&ThreadPool::WorkerLoop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_condition.notify_all();
+
+	for (std::thread& thread : m_threads)
+		thread.join();
+}
+
+ThreadPool& ThreadPool::Default()
+{
+	// hardware_concurrency may return 0 if it cannot be determined - always keep at least one worker
+	static ThreadPool pool(std::max(2u, std::thread::hardware_concurrency()) - 1u);
+	return pool;
+}
+
+std::future<void> ThreadPool::Submit(std::function<void()> task)
+{
+	std::shared_ptr<std::packaged_task<void()>> packagedTask = std::make_shared<std::packaged_task<void()>>(std::move(task));
+	std::future<void> future = packagedTask->get_future();
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_tasks.push([packagedTask]() { (*packagedTask)(); });
+	}
+	m_condition.notify_one();
+
+	return future;
+}
+
+void ThreadPool::ParallelFor(int begin, int end, int grainSize, const std::function<void(int, int)>& body)
+{
+	if (end <= begin)
+		return;
+
+	grainSize = std::max(1, grainSize);
+	int chunkCount = ((end - begin) + grainSize - 1) / grainSize;
+
+	// State is shared with the helper tasks because a helper may only get to run after this call has returned
+	// (all chunks already claimed by other threads) - in that case it must still be able to look at the counters
+	struct SharedState
+	{
+		std::atomic<int>	nextChunk = 0;
+		std::atomic<int>	chunksDone = 0;
+		std::mutex			mutex;
+		std::condition_variable condition;
+		std::exception_ptr	exception;
+	};
+	std::shared_ptr<SharedState> state = std::make_shared<SharedState>();
+
+	// Runs chunks until there are none left. Returns once this thread can no longer claim a chunk
+	auto work = [state, begin, end, grainSize, chunkCount, &body]()
+	{
+		int chunk;
+		while ((chunk = state->nextChunk.fetch_add(1)) < chunkCount)
+		{
+			int chunkBegin = begin + (chunk * grainSize);
+			int chunkEnd = std::min(end, chunkBegin + grainSize);
+
+			try
+			{
+				body(chunkBegin, chunkEnd);
+			}
+			catch (...)
+			{
+				std::lock_guard<std::mutex> lock(state->mutex);
+				if (!state->exception)
+					state->exception = std::current_exception();
+			}
+
+			if (state->chunksDone.fetch_add(1) + 1 == chunkCount)
+			{
+				std::lock_guard<std::mutex> lock(state->mutex);
+				state->condition.notify_all();
+			}
+		}
+	};
+
+	// Body is only referenced while a chunk is running, and no chunk can run after the wait below finishes
+	int helperCount = std::min(static_cast<int>(m_threads.size()), chunkCount - 1);
+	if (helperCount > 0)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (int iii = 0; iii < helperCount; ++iii)
+			m_tasks.push(work);
+	}
+	m_condition.notify_all();
+
+	work();
+
+	{
+		std::unique_lock<std::mutex> lock(state->mutex);
+		state->condition.wait(lock, [&state, chunkCount]() { return state->chunksDone.load() == chunkCount; });
+	}
+
+	if (state->exception)
+		std::rethrow_exception(state->exception);
+}
+
+void ThreadPool::WorkerLoop()
+{
+	while (true)
+	{
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_condition.wait(lock, [this]() { return m_stopping || !m_tasks.empty(); });
+
+			if (m_stopping && m_tasks.empty())
+				return;
+
+			task = std::move(m_tasks.front());
+			m_tasks.pop();
+		}
+
+		task();
+	}
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include "pch.h"
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <atomic>
+#include <memory>
+#include <exception>
+#include <algorithm>
+
+// ThreadPool runs tasks on a fixed set of worker threads. Default() returns a pool shared by the whole
+// application (one worker per hardware thread, minus one for the calling thread).
+class ThreadPool
+{
+public:
+	ThreadPool(unsigned int threadCount);
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+	~ThreadPool();
+
+	static ThreadPool& Default();
+
+	unsigned int ThreadCount() { return static_cast<unsigned int>(m_threads.size()); }
+
+	// Queue a task - the returned future rethrows any exception the task throws
+	std::future<void> Submit(std::function<void()> task);
+
+	// Splits [begin, end) into chunks of (at most) grainSize and calls body(chunkBegin, chunkEnd) for each of
+	// them. The calling thread works on chunks as well and only returns once every chunk is done, so this may
+	// also be called from inside a task. The first exception thrown by body is rethrown on the calling thread.
+	void ParallelFor(int begin, int end, int grainSize, const std::function<void(int, int)>& body);
+
+private:
+	void WorkerLoop();
+
+	std::vector<std::thread>			m_threads;
+	std::queue<std::function<void()>>	m_tasks;
+	std::mutex							m_mutex;
+	std::condition_variable				m_condition;
+	bool								m_stopping;
+};
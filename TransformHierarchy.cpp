@@ -0,0 +1,124 @@
+#include "TransformHierarchy.h"
+
+using DirectX::XMMATRIX;
+using DirectX::XMVECTOR;
+
+int TransformHierarchy::AddNode(int parent)
+{
+	const int node = static_cast<int>(m_parents.size());
+
+	// Anything else would break the parents first order that Update relies on
+	if (parent < NO_PARENT || parent >= node)
+		throw DrawableException(__LINE__, __FILE__, "TransformHierarchy: parent " + std::to_string(parent) + " has not been added before node " + std::to_string(node));
+
+	m_parents.push_back(parent);
+	m_translationX.push_back(0.0f);
+	m_translationY.push_back(0.0f);
+	m_translationZ.push_back(0.0f);
+	m_pitch.push_back(0.0f);
+	m_yaw.push_back(0.0f);
+	m_roll.push_back(0.0f);
+	m_scaleX.push_back(1.0f);
+	m_scaleY.push_back(1.0f);
+	m_scaleZ.push_back(1.0f);
+	m_dirty.push_back(1);
+	m_worldChanged.push_back(0);
+	m_local.push_back(DirectX::XMMatrixIdentity());
+	m_world.push_back(DirectX::XMMatrixIdentity());
+
+	return node;
+}
+
+void TransformHierarchy::Reserve(size_t count)
+{
+	m_parents.reserve(count);
+	for (std::vector<float>* component : { &m_translationX, &m_translationY, &m_translationZ, &m_pitch, &m_yaw, &m_roll, &m_scaleX, &m_scaleY, &m_scaleZ })
+		component->reserve(count);
+	m_dirty.reserve(count);
+	m_worldChanged.reserve(count);
+	m_local.reserve(count);
+	m_world.reserve(count);
+}
+
+void TransformHierarchy::Clear()
+{
+	m_parents.clear();
+	for (std::vector<float>* component : { &m_translationX, &m_translationY, &m_translationZ, &m_pitch, &m_yaw, &m_roll, &m_scaleX, &m_scaleY, &m_scaleZ })
+		component->clear();
+	m_dirty.clear();
+	m_worldChanged.clear();
+	m_local.clear();
+	m_world.clear();
+}
+
+void TransformHierarchy::SetTranslation(int node, const DirectX::XMFLOAT3& translation)
+{
+	if (m_translationX[node] != translation.x || m_translationY[node] != translation.y || m_translationZ[node] != translation.z)
+	{
+		m_translationX[node] = translation.x;
+		m_translationY[node] = translation.y;
+		m_translationZ[node] = translation.z;
+		m_dirty[node] = 1;
+	}
+}
+
+void TransformHierarchy::SetRotation(int node, float pitch, float yaw, float roll)
+{
+	if (m_pitch[node] != pitch || m_yaw[node] != yaw || m_roll[node] != roll)
+	{
+		m_pitch[node] = pitch;
+		m_yaw[node] = yaw;
+		m_roll[node] = roll;
+		m_dirty[node] = 1;
+	}
+}
+
+void TransformHierarchy::SetScale(int node, const DirectX::XMFLOAT3& scale)
+{
+	if (m_scaleX[node] != scale.x || m_scaleY[node] != scale.y || m_scaleZ[node] != scale.z)
+	{
+		m_scaleX[node] = scale.x;
+		m_scaleY[node] = scale.y;
+		m_scaleZ[node] = scale.z;
+		m_dirty[node] = 1;
+	}
+}
+
+size_t TransformHierarchy::Update()
+{
+	size_t rebuilt = 0;
+	const size_t count = m_parents.size();
+	for (size_t iii = 0; iii < count; ++iii)
+	{
+		const int parent = m_parents[iii];
+
+		// The parent has already been handled, so its flag says whether anything above this node moved
+		const bool parentChanged = parent != NO_PARENT && m_worldChanged[parent] != 0;
+		if (m_dirty[iii] == 0 && !parentChanged)
+		{
+			m_worldChanged[iii] = 0;
+			continue;
+		}
+
+		if (m_dirty[iii] != 0)
+		{
+			// rotation * scale * translation without the two full matrix multiplies: scaling multiplies each row
+			// of the rotation by the scale, and the translation only replaces the last row
+			XMMATRIX local = DirectX::XMMatrixRotationRollPitchYaw(m_pitch[iii], m_yaw[iii], m_roll[iii]);
+			const XMVECTOR scale = DirectX::XMVectorSet(m_scaleX[iii], m_scaleY[iii], m_scaleZ[iii], 1.0f);
+			local.r[0] = DirectX::XMVectorMultiply(local.r[0], scale);
+			local.r[1] = DirectX::XMVectorMultiply(local.r[1], scale);
+			local.r[2] = DirectX::XMVectorMultiply(local.r[2], scale);
+			local.r[3] = DirectX::XMVectorSet(m_translationX[iii], m_translationY[iii], m_translationZ[iii], 1.0f);
+
+			m_local[iii] = local;
+			m_dirty[iii] = 0;
+		}
+
+		m_world[iii] = parent == NO_PARENT ? m_local[iii] : DirectX::XMMatrixMultiply(m_local[iii], m_world[parent]);
+		m_worldChanged[iii] = 1;
+		++rebuilt;
+	}
+
+	return rebuilt;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include "pch.h"
+#include "DrawableException.h"
+
+#include <vector>
+#include <string>
+#include <stdint.h>
+
+// TransformHierarchy holds the transforms of a node hierarchy in flat arrays instead of in the nodes themselves, and
+// builds the world matrices in a single linear pass.
+//
+// Nodes are stored in the order they were added and a node must be added after its parent, so walking the arrays
+// from the front always reaches a parent before any of its children. The local translation, rotation (pitch, yaw,
+// roll as used by XMMatrixRotationRollPitchYaw) and scale are kept as structure of arrays. Setting a value that
+// differs from the stored one marks the node dirty; Update then rebuilds the local matrix of every dirty node, and
+// the world matrix of every dirty node and every node below one, skipping everything else. Nothing here touches the
+// device, so a hierarchy can be built and updated without one.
+//
+// The local matrix is rotation * scale * translation, the same as Drawable::GetPreParentTransformModelMatrix, and
+// the world matrix is local * parent world.
+class TransformHierarchy
+{
+public:
+	static constexpr int NO_PARENT = -1;
+
+	// Returns the index of the new node. parent must be NO_PARENT or the index of a node that was already added,
+	// otherwise DrawableException is thrown. The node starts with an identity transform and dirty
+	int AddNode(int parent);
+	void Reserve(size_t count);
+	void Clear();
+
+	size_t NodeCount() const { return m_parents.size(); }
+	int GetParent(int node) const { return m_parents[node]; }
+
+	void SetTranslation(int node, const DirectX::XMFLOAT3& translation);
+	void SetRotation(int node, float pitch, float yaw, float roll);
+	void SetScale(int node, const DirectX::XMFLOAT3& scale);
+
+	// Returns the number of world matrices that were rebuilt
+	size_t Update();
+
+	// True if the last Update rebuilt the world matrix of the node
+	bool WorldChanged(int node) const { return m_worldChanged[node] != 0; }
+	const DirectX::XMMATRIX& GetWorldMatrix(int node) const { return m_world[node]; }
+
+private:
+	std::vector<int> m_parents;
+
+	std::vector<float> m_translationX;
+	std::vector<float> m_translationY;
+	std::vector<float> m_translationZ;
+	std::vector<float> m_pitch;
+	std::vector<float> m_yaw;
+	std::vector<float> m_roll;
+	std::vector<float> m_scaleX;
+	std::vector<float> m_scaleY;
+	std::vector<float> m_scaleZ;
+
+	std::vector<uint8_t> m_dirty;			// Local transform changed since the last Update
+	std::vector<uint8_t> m_worldChanged;	// World matrix was rebuilt by the last Update
+
+	std::vector<DirectX::XMMATRIX> m_local;
+	std::vector<DirectX::XMMATRIX> m_world;
+};
@@ -1,4 +1,7 @@
 #include "VertexShader.h"
+#include "InstanceBuffer.h"
+
+#include <cstring>
 
 VertexShader::VertexShader(std::shared_ptr<DeviceResources> deviceResources, Microsoft::WRL::ComPtr<ID3DBlob> blob) : 
 	Bindable(deviceResources)
@@ -15,10 +18,27 @@ VertexShader::VertexShader(std::shared_ptr<DeviceResources> deviceResources, Mic
 			m_vertexShader.ReleaseAndGetAddressOf()
 		)
 	);
+
+	// The instanced shaders are told apart by the per instance rows of the model matrix in their input signature
+	Microsoft::WRL::ComPtr<ID3D11ShaderReflection> reflection;
+	GFX_THROW_INFO(D3DReflect(blob->GetBufferPointer(), blob->GetBufferSize(), IID_PPV_ARGS(reflection.GetAddressOf())));
+
+	D3D11_SHADER_DESC shaderDesc;
+	GFX_THROW_INFO(reflection->GetDesc(&shaderDesc));
+	for (UINT iii = 0; iii < shaderDesc.InputParameters; ++iii)
+	{
+		D3D11_SIGNATURE_PARAMETER_DESC parameterDesc;
+		GFX_THROW_INFO(reflection->GetInputParameterDesc(iii, &parameterDesc));
+		if (strcmp(parameterDesc.SemanticName, InstanceBuffer::MODEL_SEMANTIC) == 0)
+			m_readsInstanceData = true;
+	}
 }
 
 void VertexShader::Bind()
 {
+	if (!PipelineState::SetVertexShader(m_vertexShader.Get()))
+		return;
+
 	INFOMAN(m_deviceResources);
 	GFX_THROW_INFO_ONLY(
 		m_deviceResources->D3DDeviceContext()->VSSetShader(m_vertexShader.Get(), nullptr, 0u)
@@ -8,8 +8,11 @@ public:
 	VertexShader(std::shared_ptr<DeviceResources> deviceResources, Microsoft::WRL::ComPtr<ID3DBlob> blob);
 
 	void Bind() override;
+	BindableSlot Slot() const override { return { BindableSlot::Type::VERTEX_SHADER }; }
+	bool ReadsInstanceData() const override { return m_readsInstanceData; }
 
 private:
+	bool m_readsInstanceData = false;
 
 	Microsoft::WRL::ComPtr<ID3D11VertexShader> m_vertexShader;
 };
\ No newline at end of file
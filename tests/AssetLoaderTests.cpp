@@ -0,0 +1,193 @@
+#include "TestFramework.h"
+#include "AssetLoadQueue.h"
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+
+namespace
+{
+	// Stands in for a Texture - remembers what was uploaded into it and how often
+	struct FakeResource
+	{
+		int value = 0;
+		int uploadCount = 0;
+	};
+
+	// AssetLoader's queue with a decode that needs no image files and an upload that needs no device. The decode
+	// of a file called "bad" throws, and every decode waits until release is set
+	struct FakeLoader
+	{
+		ResourceRegistry<FakeResource> registry;
+		ThreadPool pool;
+		std::atomic<int> decodeCount = 0;
+		std::atomic<bool> release = true;
+		std::atomic<bool> decodedOnCallingThread = false;
+		std::thread::id callingThread = std::this_thread::get_id();
+		AssetLoadQueue<FakeResource, int> queue;
+
+		FakeLoader() :
+			registry("fake resources"),
+			pool(1),
+			queue(registry, pool,
+				[]() { return std::make_shared<FakeResource>(); },
+				[this](const std::string& filename)
+				{
+					while (!release)
+						std::this_thread::yield();
+					if (std::this_thread::get_id() == callingThread)
+						decodedOnCallingThread = true;
+					++decodeCount;
+					if (filename == "bad")
+						throw std::runtime_error("Could not decode " + filename);
+					return std::make_unique<int>(static_cast<int>(filename.size()));
+				},
+				[](FakeResource& resource, const int& image)
+				{
+					resource.value = image;
+					++resource.uploadCount;
+				})
+		{
+		}
+
+		// The pool has a single worker and runs its tasks in order, so once a task submitted now has run every
+		// decode queued before it has finished
+		void FinishDecodes() { pool.Submit([]() {}).wait(); }
+	};
+}
+
+// Every request for the same file gets the same resource and shares one decode, and the resource is registered
+// under the filename
+TEST_CASE(AssetLoaderSharesDecodes)
+{
+	FakeLoader loader;
+	std::shared_ptr<FakeResource> first = loader.queue.Load("first");
+	std::shared_ptr<FakeResource> again = loader.queue.Load("first");
+	std::shared_ptr<FakeResource> second = loader.queue.Load("second!");
+	CHECK(first == again);
+	CHECK(first != second);
+	CHECK_EQUAL(static_cast<size_t>(2), loader.queue.PendingCount());
+	CHECK_EQUAL(static_cast<size_t>(2), loader.registry.Size());
+
+	loader.queue.WaitForAll();
+	CHECK_EQUAL(2, loader.decodeCount.load());
+	CHECK(!loader.decodedOnCallingThread);
+	CHECK_EQUAL(5, first->value);
+	CHECK_EQUAL(1, first->uploadCount);
+	CHECK_EQUAL(7, second->value);
+
+	// Once it has been uploaded the resource comes straight from the registry
+	CHECK(first == loader.queue.Load("first"));
+	CHECK_EQUAL(static_cast<size_t>(0), loader.queue.PendingCount());
+	CHECK_EQUAL(2, loader.decodeCount.load());
+}
+
+// Update uploads no more than it is allowed to per call, first requested first, and does not wait for decodes
+// that are still running
+TEST_CASE(AssetLoaderUpdateKeepsToTheUploadBudget)
+{
+	FakeLoader loader;
+	loader.release = false;
+	std::vector<std::shared_ptr<FakeResource>> resources;
+	for (const char* filename : { "a", "bb", "ccc", "dddd", "eeeee" })
+		resources.push_back(loader.queue.Load(filename));
+
+	loader.queue.Update(4);
+	CHECK_EQUAL(static_cast<size_t>(5), loader.queue.PendingCount());
+
+	loader.release = true;
+	loader.FinishDecodes();
+	loader.queue.Update(2);
+	CHECK_EQUAL(static_cast<size_t>(3), loader.queue.PendingCount());
+	CHECK_EQUAL(1, resources[0]->uploadCount);
+	CHECK_EQUAL(1, resources[1]->uploadCount);
+	CHECK_EQUAL(0, resources[2]->uploadCount);
+
+	loader.queue.Update(2);
+	loader.queue.Update(2);
+	CHECK_EQUAL(static_cast<size_t>(0), loader.queue.PendingCount());
+	for (size_t iii = 0; iii < resources.size(); ++iii)
+	{
+		CHECK_EQUAL(1, resources[iii]->uploadCount);
+		CHECK_EQUAL(static_cast<int>(iii) + 1, resources[iii]->value);
+	}
+
+	loader.queue.Update(0);
+	loader.queue.Update(2);
+	CHECK_EQUAL(5, loader.decodeCount.load());
+}
+
+// WaitForAll blocks until the decodes that are still running are done and uploads all of them
+TEST_CASE(AssetLoaderWaitForAllUploadsEverything)
+{
+	FakeLoader loader;
+	loader.release = false;
+	std::shared_ptr<FakeResource> first = loader.queue.Load("first");
+	std::shared_ptr<FakeResource> second = loader.queue.Load("second");
+
+	std::thread releaser([&loader]()
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		loader.release = true;
+	});
+	loader.queue.WaitForAll();
+	releaser.join();
+
+	CHECK_EQUAL(static_cast<size_t>(0), loader.queue.PendingCount());
+	CHECK_EQUAL(1, first->uploadCount);
+	CHECK_EQUAL(1, second->uploadCount);
+}
+
+// A decode that throws on the worker throws from Update (or WaitForAll) on the calling thread, once, and the
+// requests around it still get uploaded
+TEST_CASE(AssetLoaderRethrowsDecodeExceptions)
+{
+	FakeLoader loader;
+	std::shared_ptr<FakeResource> before = loader.queue.Load("before");
+	std::shared_ptr<FakeResource> bad = loader.queue.Load("bad");
+	std::shared_ptr<FakeResource> after = loader.queue.Load("after");
+	loader.FinishDecodes();
+
+	CHECK_THROWS(loader.queue.Update(4));
+	CHECK_EQUAL(1, before->uploadCount);
+	CHECK_EQUAL(0, bad->uploadCount);
+	CHECK_EQUAL(static_cast<size_t>(1), loader.queue.PendingCount());
+
+	loader.queue.Update(4);
+	CHECK_EQUAL(1, after->uploadCount);
+	CHECK_EQUAL(static_cast<size_t>(0), loader.queue.PendingCount());
+
+	// The same through WaitForAll, for a new request of the file
+	loader.registry.Remove(loader.registry.Find("bad"));
+	loader.queue.Load("bad");
+	CHECK_THROWS(loader.queue.WaitForAll());
+	CHECK_EQUAL(static_cast<size_t>(0), loader.queue.PendingCount());
+}
+
+// Clear (what AssetLoader::Shutdown does) with decodes still running waits for them and drops them without
+// uploading, and the queue can go away straight after
+TEST_CASE(AssetLoaderShutdownWithWorkInFlight)
+{
+	std::vector<std::shared_ptr<FakeResource>> resources;
+	{
+		FakeLoader loader;
+		loader.release = false;
+		for (const char* filename : { "a", "b", "c" })
+			resources.push_back(loader.queue.Load(filename));
+
+		std::thread releaser([&loader]()
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+			loader.release = true;
+		});
+		loader.queue.Clear();
+		releaser.join();
+
+		CHECK_EQUAL(3, loader.decodeCount.load());
+		CHECK_EQUAL(static_cast<size_t>(0), loader.queue.PendingCount());
+		loader.queue.Update(4);
+	}
+
+	for (const std::shared_ptr<FakeResource>& resource : resources)
+		CHECK_EQUAL(0, resource->uploadCount);
+}
@@ -0,0 +1,214 @@
+#include "TestFramework.h"
+#include "Base64.h"
+
+#include <random>
+
+namespace
+{
+	const Base64::Implementation IMPLEMENTATIONS[] = { Base64::Implementation::SCALAR, Base64::Implementation::SSSE3, Base64::Implementation::AVX2 };
+
+	const char* ImplementationName(Base64::Implementation implementation)
+	{
+		switch (implementation)
+		{
+		case Base64::Implementation::SSSE3:
+			return "SSSE3";
+		case Base64::Implementation::AVX2:
+			return "AVX2";
+		default:
+			return "scalar";
+		}
+	}
+
+	// Puts back the implementation the process started with when a test is done switching between them
+	struct ImplementationScope
+	{
+		ImplementationScope() : saved(Base64::GetImplementation()) {}
+		~ImplementationScope() { Base64::SetImplementation(saved); }
+		Base64::Implementation saved;
+	};
+
+	// The character at a time encoder and decoder the SIMD code replaced, kept as the reference
+	const std::string ALPHABET = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+	std::string ReferenceEncode(const std::vector<uint8_t>& in)
+	{
+		std::string out;
+		for (size_t iii = 0; iii < in.size(); iii += 3)
+		{
+			uint32_t bits = static_cast<uint32_t>(in[iii]) << 16;
+			if (iii + 1 < in.size())
+				bits |= static_cast<uint32_t>(in[iii + 1]) << 8;
+			if (iii + 2 < in.size())
+				bits |= in[iii + 2];
+
+			out += ALPHABET[(bits >> 18) & 0x3F];
+			out += ALPHABET[(bits >> 12) & 0x3F];
+			out += iii + 1 < in.size() ? ALPHABET[(bits >> 6) & 0x3F] : '=';
+			out += iii + 2 < in.size() ? ALPHABET[bits & 0x3F] : '=';
+		}
+		return out;
+	}
+
+	std::vector<uint8_t> RandomBytes(std::mt19937& random, size_t size)
+	{
+		std::uniform_int_distribution<int> byte(0, 255);
+		std::vector<uint8_t> bytes(size);
+		for (uint8_t& value : bytes)
+			value = static_cast<uint8_t>(byte(random));
+		return bytes;
+	}
+
+	// Decodes into a buffer with guard bytes on either side, so that writing past the end is caught as well
+	std::string DecodeGuarded(const std::string& text, std::vector<uint8_t>& decoded, bool& overrun)
+	{
+		const uint8_t GUARD = 0xA5;
+		const size_t GUARD_SIZE = 64;
+
+		try
+		{
+			size_t size = Base64::DecodedSize(text.data(), text.size());
+			std::vector<uint8_t> buffer(size + (2 * GUARD_SIZE), GUARD);
+			size_t written = Base64::Decode(text.data(), text.size(), buffer.data() + GUARD_SIZE);
+
+			overrun = written != size;
+			for (size_t iii = 0; iii < GUARD_SIZE; ++iii)
+				overrun |= buffer[iii] != GUARD || buffer[GUARD_SIZE + size + iii] != GUARD;
+			decoded.assign(buffer.begin() + GUARD_SIZE, buffer.begin() + GUARD_SIZE + size);
+			return std::string();
+		}
+		catch (const Base64Exception& e)
+		{
+			return e.GetErrorInfo();
+		}
+	}
+}
+
+TEST_CASE(Base64KnownValues)
+{
+	ImplementationScope scope;
+	for (Base64::Implementation implementation : IMPLEMENTATIONS)
+	{
+		Base64::SetImplementation(implementation);
+
+		CHECK_EQUAL(std::string(""), Base64::Encode(std::vector<uint8_t>()));
+		CHECK_EQUAL(std::string("Zg=="), Base64::Encode(std::vector<uint8_t>({ 'f' })));
+		CHECK_EQUAL(std::string("Zm8="), Base64::Encode(std::vector<uint8_t>({ 'f', 'o' })));
+		CHECK_EQUAL(std::string("Zm9vYmFy"), Base64::Encode(std::vector<uint8_t>({ 'f', 'o', 'o', 'b', 'a', 'r' })));
+
+		CHECK(Base64::Decode(std::string_view("")).empty());
+		CHECK(Base64::Decode(std::string_view("Zm9vYg==")) == std::vector<uint8_t>({ 'f', 'o', 'o', 'b' }));
+		CHECK(Base64::Decode(std::string_view("Zm9vYmE=")) == std::vector<uint8_t>({ 'f', 'o', 'o', 'b', 'a' }));
+
+		CHECK_THROWS(Base64::Decode(std::string_view("Zm9")));
+		CHECK_THROWS(Base64::Decode(std::string_view("Zm9vY===")));
+		CHECK_THROWS(Base64::Decode(std::string_view("Zm=vYmFy")));
+	}
+}
+
+// Random data of every length around the register sizes: each implementation encodes exactly like the reference,
+// decodes back to the original bytes and never writes outside the output
+TEST_CASE(Base64RoundTripsRandomData)
+{
+	ImplementationScope scope;
+	std::mt19937 random(12);
+	std::uniform_int_distribution<size_t> longLength(0, 4096);
+	int mismatchCount = 0;
+	int overrunCount = 0;
+
+	for (int round = 0; round < 1200; ++round)
+	{
+		size_t length = round < 200 ? static_cast<size_t>(round) : longLength(random);
+		std::vector<uint8_t> bytes = RandomBytes(random, length);
+		std::string expected = ReferenceEncode(bytes);
+
+		for (Base64::Implementation implementation : IMPLEMENTATIONS)
+		{
+			Base64::SetImplementation(implementation);
+
+			if (Base64::Encode(bytes) != expected)
+				++mismatchCount;
+
+			std::vector<uint8_t> decoded;
+			bool overrun = false;
+			if (!DecodeGuarded(expected, decoded, overrun).empty() || decoded != bytes)
+				++mismatchCount;
+			if (overrun)
+				++overrunCount;
+		}
+	}
+
+	CHECK_EQUAL(0, mismatchCount);
+	CHECK_EQUAL(0, overrunCount);
+}
+
+// Corrupting one character anywhere in the text is rejected by every implementation with the same error - the
+// SIMD loops hand the rest over to the scalar code, which reports the first bad character
+TEST_CASE(Base64RejectsTheSameInputEverywhere)
+{
+	ImplementationScope scope;
+	std::mt19937 random(13);
+	std::uniform_int_distribution<size_t> length(1, 600);
+	const std::string invalid = std::string("!\"#$%&'()*,-.:;<>?@[\\]^_`{|}~ \t\r\n\x80\xFF") + '\0';
+	std::uniform_int_distribution<size_t> invalidCharacter(0, invalid.size() - 1);
+	int disagreementCount = 0;
+	int acceptedCount = 0;
+
+	for (int round = 0; round < 1500; ++round)
+	{
+		std::string text = ReferenceEncode(RandomBytes(random, length(random)));
+
+		// Keep clear of the padding so that the character really is invalid where it lands
+		size_t unpadded = text.find('=') == std::string::npos ? text.size() : text.find('=');
+		size_t position = std::uniform_int_distribution<size_t>(0, unpadded - 1)(random);
+		text[position] = invalid[invalidCharacter(random)];
+
+		std::string scalarError;
+		for (Base64::Implementation implementation : IMPLEMENTATIONS)
+		{
+			Base64::SetImplementation(implementation);
+
+			std::vector<uint8_t> decoded;
+			bool overrun = false;
+			std::string error = DecodeGuarded(text, decoded, overrun);
+			if (error.empty())
+				++acceptedCount;
+			if (implementation == Base64::Implementation::SCALAR)
+				scalarError = error;
+			else if (error != scalarError)
+				++disagreementCount;
+		}
+	}
+
+	CHECK_EQUAL(0, acceptedCount);
+	CHECK_EQUAL(0, disagreementCount);
+}
+
+// Encode and decode throughput of each implementation the processor supports, over a buffer the size of a large
+// embedded glTF buffer
+BENCHMARK(Base64Throughput)
+{
+	ImplementationScope scope;
+	std::mt19937 random(14);
+	std::vector<uint8_t> bytes = RandomBytes(random, 16 * 1024 * 1024);
+	std::string text(Base64::EncodedSize(bytes.size()), '\0');
+	std::vector<uint8_t> decoded(bytes.size());
+
+	for (Base64::Implementation implementation : IMPLEMENTATIONS)
+	{
+		Base64::SetImplementation(implementation);
+		if (Base64::GetImplementation() != implementation)
+		{
+			printf("    %-8s not supported by this processor\n", ImplementationName(implementation));
+			continue;
+		}
+
+		double encodeSeconds = Testing::BestTime(10, [&bytes, &text]() { Base64::Encode(bytes.data(), bytes.size(), &text[0]); });
+		double decodeSeconds = Testing::BestTime(10, [&text, &decoded]() { Base64::Decode(text.data(), text.size(), decoded.data()); });
+		CHECK(decoded == bytes);
+
+		// Throughput is measured on the text side for both, the way base64 codecs are usually compared
+		printf("    %-8s encode %6.2f GB/s   decode %6.2f GB/s\n", ImplementationName(implementation),
+			text.size() / encodeSeconds / 1e9, text.size() / decodeSeconds / 1e9);
+	}
+}
@@ -0,0 +1,184 @@
+#include "TestFramework.h"
+#include "Frustum.h"
+#include "FrustumBoxBatch.h"
+#include "TerrainTestData.h"
+
+#include <random>
+
+namespace
+{
+	// Structure of arrays boxes scattered around (and far outside) the camera loop's frusta, from tiny boxes that
+	// are easily entirely inside to huge ones that straddle several planes
+	struct RandomBoxes
+	{
+		RandomBoxes(size_t count, float terrainSize, unsigned int seed)
+		{
+			std::mt19937 random(seed);
+			std::uniform_real_distribution<float> position(-0.25f * terrainSize, 1.25f * terrainSize);
+			std::uniform_real_distribution<float> height(-100.0f, 400.0f);
+			std::uniform_real_distribution<float> size(0.0f, 1.0f);
+
+			for (size_t iii = 0; iii < count; ++iii)
+			{
+				float extent = size(random);
+				extent = extent * extent * extent * 300.0f;
+
+				minX.push_back(position(random));
+				minY.push_back(height(random));
+				minZ.push_back(position(random));
+				maxX.push_back(minX.back() + (extent * size(random)));
+				maxY.push_back(minY.back() + (extent * size(random)));
+				maxZ.push_back(minZ.back() + (extent * size(random)));
+			}
+		}
+
+		std::vector<float> minX, minY, minZ, maxX, maxY, maxZ;
+	};
+
+	// Counts the boxes whose bits disagree with ClassifyRectangle
+	int CountMismatches(Frustum& frustum, const RandomBoxes& boxes, size_t count, const std::vector<uint32_t>& visibleMask, const std::vector<uint32_t>& insideMask)
+	{
+		int mismatchCount = 0;
+		for (size_t iii = 0; iii < count; ++iii)
+		{
+			FrustumContainment expected = frustum.ClassifyRectangle(boxes.maxX[iii], boxes.maxY[iii], boxes.maxZ[iii], boxes.minX[iii], boxes.minY[iii], boxes.minZ[iii]);
+			bool visible = (visibleMask[iii / 32] & (1u << (iii % 32))) != 0;
+			bool inside = (insideMask[iii / 32] & (1u << (iii % 32))) != 0;
+
+			if (visible != (expected != FrustumContainment::OUTSIDE) || inside != (expected == FrustumContainment::INSIDE))
+				++mismatchCount;
+		}
+
+		// Bits past the last box must stay clear
+		for (size_t iii = count; iii < visibleMask.size() * 32; ++iii)
+		{
+			if ((visibleMask[iii / 32] & (1u << (iii % 32))) != 0 || (insideMask[iii / 32] & (1u << (iii % 32))) != 0)
+				++mismatchCount;
+		}
+		return mismatchCount;
+	}
+
+	const char* ImplementationName(Frustum::Implementation implementation)
+	{
+		switch (implementation)
+		{
+		case Frustum::Implementation::AVX2: return "avx2";
+		case Frustum::Implementation::SSE: return "sse";
+		default: return "scalar";
+		}
+	}
+}
+
+// Every implementation of CheckRectangles must give the same masks as ClassifyRectangle, box for box, including
+// counts that leave a remainder for the narrower paths and masks that span several values
+TEST_CASE(CheckRectanglesMatchesClassifyRectangle)
+{
+	RandomBoxes boxes(1003, 1024.0f, 5);
+	std::vector<TerrainTestData::CameraPose> poses = TerrainTestData::CameraLoop(40, 1024.0f, 150.0f);
+	Frustum::Implementation best = Frustum::GetImplementation();
+
+	int visibleCount = 0;
+	int insideCount = 0;
+	for (Frustum::Implementation implementation : { Frustum::Implementation::SCALAR, Frustum::Implementation::SSE, Frustum::Implementation::AVX2 })
+	{
+		Frustum::SetImplementation(implementation);
+
+		int mismatchCount = 0;
+		for (const TerrainTestData::CameraPose& pose : poses)
+		{
+			Frustum frustum(1500.0f, TerrainTestData::ViewMatrix(pose), TerrainTestData::ProjectionMatrix());
+
+			for (size_t count : { size_t(1003), size_t(64), size_t(37), size_t(8), size_t(3), size_t(0) })
+			{
+				// Start from garbage so that bits the call forgets to clear show up
+				std::vector<uint32_t> visibleMask((count + 31) / 32, 0xFFFFFFFFu);
+				std::vector<uint32_t> insideMask((count + 31) / 32, 0xFFFFFFFFu);
+				frustum.CheckRectangles(boxes.minX.data(), boxes.minY.data(), boxes.minZ.data(), boxes.maxX.data(), boxes.maxY.data(), boxes.maxZ.data(),
+					count, visibleMask.data(), insideMask.data());
+
+				mismatchCount += CountMismatches(frustum, boxes, count, visibleMask, insideMask);
+			}
+
+			for (size_t iii = 0; iii < boxes.minX.size(); ++iii)
+			{
+				FrustumContainment containment = frustum.ClassifyRectangle(boxes.maxX[iii], boxes.maxY[iii], boxes.maxZ[iii], boxes.minX[iii], boxes.minY[iii], boxes.minZ[iii]);
+				visibleCount += containment != FrustumContainment::OUTSIDE ? 1 : 0;
+				insideCount += containment == FrustumContainment::INSIDE ? 1 : 0;
+			}
+		}
+
+		if (mismatchCount != 0)
+			printf("    %s: %d mismatches\n", ImplementationName(Frustum::GetImplementation()), mismatchCount);
+		CHECK_EQUAL(0, mismatchCount);
+	}
+
+	Frustum::SetImplementation(best);
+
+	// The boxes must actually exercise every outcome
+	CHECK(visibleCount > 0);
+	CHECK(insideCount > 0);
+	CHECK(insideCount < visibleCount);
+}
+
+// A batch gives each box the result CheckRectangle2 gives it on its own, however it was filled
+TEST_CASE(FrustumBoxBatchKeepsTheOrderBoxesWereAdded)
+{
+	RandomBoxes boxes(300, 1024.0f, 9);
+	Frustum frustum(1500.0f, TerrainTestData::ViewMatrix(TerrainTestData::CameraLoop(1, 1024.0f, 150.0f)[0]), TerrainTestData::ProjectionMatrix());
+
+	FrustumBoxBatch batch;
+	int mismatchCount = 0;
+	for (size_t count : { size_t(300), size_t(5), size_t(0) })
+	{
+		batch.Clear();
+		for (size_t iii = 0; iii < count; ++iii)
+			CHECK_EQUAL(iii, batch.Add(boxes.minX[iii], boxes.minY[iii], boxes.minZ[iii], boxes.maxX[iii], boxes.maxY[iii], boxes.maxZ[iii]));
+		CHECK_EQUAL(count, batch.Size());
+
+		batch.Check(&frustum);
+		for (size_t iii = 0; iii < count; ++iii)
+		{
+			if (batch.IsVisible(iii) != frustum.CheckRectangle2(boxes.maxX[iii], boxes.maxY[iii], boxes.maxZ[iii], boxes.minX[iii], boxes.minY[iii], boxes.minZ[iii]))
+				++mismatchCount;
+		}
+	}
+
+	CHECK_EQUAL(0, mismatchCount);
+}
+
+// Boxes per second through CheckRectangles for each implementation, against calling ClassifyRectangle per box
+BENCHMARK(FrustumBoxesPerSecond)
+{
+	const size_t boxCount = 1 << 20;
+	RandomBoxes boxes(boxCount, 1024.0f, 3);
+	Frustum frustum(1500.0f, TerrainTestData::ViewMatrix(TerrainTestData::CameraLoop(1, 1024.0f, 150.0f)[0]), TerrainTestData::ProjectionMatrix());
+	std::vector<uint32_t> visibleMask(boxCount / 32);
+	std::vector<uint32_t> insideMask(boxCount / 32);
+	Frustum::Implementation best = Frustum::GetImplementation();
+
+	double classifySeconds = Testing::BestTime(5, [&]()
+	{
+		int visibleCount = 0;
+		for (size_t iii = 0; iii < boxCount; ++iii)
+			visibleCount += frustum.ClassifyRectangle(boxes.maxX[iii], boxes.maxY[iii], boxes.maxZ[iii], boxes.minX[iii], boxes.minY[iii], boxes.minZ[iii]) != FrustumContainment::OUTSIDE ? 1 : 0;
+		Testing::DoNotOptimize(&visibleCount);
+	});
+	printf("    ClassifyRectangle per box: %8.1f M boxes/s\n", boxCount / classifySeconds / 1e6);
+
+	for (Frustum::Implementation implementation : { Frustum::Implementation::SCALAR, Frustum::Implementation::SSE, Frustum::Implementation::AVX2 })
+	{
+		Frustum::SetImplementation(implementation);
+		if (Frustum::GetImplementation() != implementation)
+			continue;
+
+		double seconds = Testing::BestTime(5, [&]()
+		{
+			frustum.CheckRectangles(boxes.minX.data(), boxes.minY.data(), boxes.minZ.data(), boxes.maxX.data(), boxes.maxY.data(), boxes.maxZ.data(),
+				boxCount, visibleMask.data(), insideMask.data());
+			Testing::DoNotOptimize(visibleMask.data());
+		});
+		printf("    CheckRectangles %-6s:    %8.1f M boxes/s\n", ImplementationName(implementation), boxCount / seconds / 1e6);
+	}
+
+	Frustum::SetImplementation(best);
+}
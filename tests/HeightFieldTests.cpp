@@ -0,0 +1,246 @@
+#include "TestFramework.h"
+#include "HeightField.h"
+#include "TerrainTestData.h"
+
+#include <random>
+
+using DirectX::XMFLOAT3;
+using DirectX::XMVECTOR;
+
+namespace
+{
+	// What Terrain::GetClickLocation used to do - test the ray against both triangles of every quad and keep the
+	// closest hit
+	bool IntersectEveryTriangle(const HeightField& heightField, XMFLOAT3 origin, XMFLOAT3 direction, float& distance)
+	{
+		XMVECTOR rayOrigin = DirectX::XMLoadFloat3(&origin);
+		XMVECTOR rayDirection = DirectX::XMLoadFloat3(&direction);
+		int height = heightField.Height();
+
+		auto Vertex = [&heightField, height](int i, int j)
+		{
+			return DirectX::XMVectorSet(static_cast<float>(i), heightField.GetSample(i, j), static_cast<float>(height - 1 - j), 0.0f);
+		};
+
+		bool hit = false;
+		distance = FLT_MAX;
+		for (int j = 0; j < height - 1; j++)
+		{
+			for (int i = 0; i < heightField.Width() - 1; i++)
+			{
+				float triangleDistance;
+				if (DirectX::TriangleTests::Intersects(rayOrigin, rayDirection, Vertex(i, j), Vertex(i + 1, j), Vertex(i, j + 1), triangleDistance))
+				{
+					hit = true;
+					distance = std::min(distance, triangleDistance);
+				}
+				if (DirectX::TriangleTests::Intersects(rayOrigin, rayDirection, Vertex(i, j + 1), Vertex(i + 1, j), Vertex(i + 1, j + 1), triangleDistance))
+				{
+					hit = true;
+					distance = std::min(distance, triangleDistance);
+				}
+			}
+		}
+		return hit;
+	}
+
+	// Rays of the three kinds a click produces: straight down, from high above at a far away point, and nearly
+	// level from the edge of (or outside) the terrain
+	struct RandomRays
+	{
+		RandomRays(const HeightField& heightField, unsigned int seed) :
+			m_random(seed),
+			m_size(static_cast<float>(heightField.Width() - 1)),
+			m_top(heightField.GetHeight(0.0f, 0.0f))
+		{
+			for (int j = 0; j < heightField.Height(); j++)
+				for (int i = 0; i < heightField.Width(); i++)
+					m_top = std::max(m_top, heightField.GetSample(i, j));
+		}
+
+		void Next(int kind, XMFLOAT3& origin, XMFLOAT3& direction)
+		{
+			std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+			if (kind == 0)
+			{
+				origin = XMFLOAT3(unit(m_random) * m_size, m_top + 10.0f, unit(m_random) * m_size);
+				direction = XMFLOAT3(0.0f, -1.0f, 0.0f);
+				return;
+			}
+
+			XMFLOAT3 target;
+			if (kind == 1)
+			{
+				origin = XMFLOAT3(unit(m_random) * m_size, m_top + 10.0f + (unit(m_random) * 100.0f), unit(m_random) * m_size);
+				target = XMFLOAT3(unit(m_random) * m_size, 0.0f, unit(m_random) * m_size);
+			}
+			else
+			{
+				origin = XMFLOAT3((unit(m_random) * 1.2f - 0.1f) * m_size, unit(m_random) * m_top, (unit(m_random) * 1.2f - 0.1f) * m_size);
+				target = XMFLOAT3(unit(m_random) * m_size, (unit(m_random) - 0.6f) * m_top, unit(m_random) * m_size);
+			}
+
+			float x = target.x - origin.x;
+			float y = target.y - origin.y;
+			float z = target.z - origin.z;
+			float length = std::sqrt((x * x) + (y * y) + (z * z));
+			direction = XMFLOAT3(x / length, y / length, z / length);
+		}
+
+		std::mt19937 m_random;
+		float m_size;
+		float m_top;
+	};
+}
+
+TEST_CASE(HeightsInterpolateTheRenderedTriangles)
+{
+	HeightField heightField(3, 3);
+	float samples[3][3] = { { 1.0f, 2.0f, 3.0f }, { 4.0f, 8.0f, 6.0f }, { 7.0f, 8.0f, 9.0f } };
+	for (int j = 0; j < 3; j++)
+		heightField.SetRow(j, samples[j]);
+	heightField.UpdateBounds();
+
+	// Sample (i, j) sits at x = i, z = 2 - j
+	CHECK_EQUAL(1.0f, heightField.GetHeight(0.0f, 2.0f));
+	CHECK_EQUAL(8.0f, heightField.GetHeight(1.0f, 1.0f));
+	CHECK_EQUAL(9.0f, heightField.GetHeight(2.0f, 0.0f));
+
+	// The centre of the upper left quad lies on the diagonal shared by its two triangles (upper right to bottom left)
+	CHECK_EQUAL(3.0f, heightField.GetHeight(0.5f, 1.5f));
+
+	// Halfway along the top edge of the upper left quad, and a point inside its first triangle
+	CHECK_EQUAL(1.5f, heightField.GetHeight(0.5f, 2.0f));
+	CHECK(std::abs(heightField.GetHeight(0.25f, 1.75f) - 2.0f) < 1e-6f);
+
+	// Outside of the terrain
+	CHECK_EQUAL(0.0f, heightField.GetHeight(-0.5f, 1.0f));
+	CHECK_EQUAL(0.0f, heightField.GetHeight(1.0f, 2.5f));
+}
+
+TEST_CASE(RayMarchFindsTheSameHitAsEveryTriangle)
+{
+	const int size = 97;
+
+	// Smooth hills plus noise, so rays both graze slopes and hit steep single quads
+	std::mt19937 random(7);
+	std::uniform_real_distribution<float> noise(0.0f, 2.0f);
+	HeightField heightField(size, size);
+	for (int j = 0; j < size; j++)
+		for (int i = 0; i < size; i++)
+			heightField.SetSample(i, j, 20.0f + (12.0f * std::sin(i * 0.11f) * std::cos(j * 0.07f)) + noise(random));
+
+	RandomRays rays(heightField, 11);
+	int hitCount = 0;
+	int mismatchCount = 0;
+	for (int n = 0; n < 600; n++)
+	{
+		XMFLOAT3 origin, direction;
+		rays.Next(n % 3, origin, direction);
+
+		XMFLOAT3 hitLocation;
+		float distance = 0.0f;
+		float expectedDistance = 0.0f;
+		bool hit = heightField.Intersects(origin, direction, hitLocation, distance);
+		bool expectedHit = IntersectEveryTriangle(heightField, origin, direction, expectedDistance);
+
+		if (hit != expectedHit || (hit && std::abs(distance - expectedDistance) > 1e-3f * std::max(1.0f, expectedDistance)))
+			++mismatchCount;
+
+		if (hit)
+		{
+			++hitCount;
+
+			// The hit location is the point along the ray at the reported distance
+			CHECK(std::abs(hitLocation.x - (origin.x + direction.x * distance)) < 1e-2f);
+			CHECK(std::abs(hitLocation.z - (origin.z + direction.z * distance)) < 1e-2f);
+		}
+	}
+
+	CHECK_EQUAL(0, mismatchCount);
+	CHECK(hitCount > 300);
+}
+
+// Random rays over heightmap.r16 - the ray march against testing every triangle, which is what clicking on a
+// terrain with every cell in view used to cost
+BENCHMARK(RayMarchPickingOverHeightMap)
+{
+	std::unique_ptr<HeightField> heightField = TerrainTestData::LoadHeightField("heightmap.r16", 1025, 300.0f);
+
+	const int rayCount = 60;
+	RandomRays rays(*heightField, 1);
+	double rayMarchSeconds = 0.0;
+	double everyTriangleSeconds = 0.0;
+	int hitCount = 0;
+	int mismatchCount = 0;
+
+	for (int n = 0; n < rayCount; n++)
+	{
+		XMFLOAT3 origin, direction;
+		rays.Next(n % 3, origin, direction);
+
+		XMFLOAT3 hitLocation;
+		float distance = 0.0f;
+		float expectedDistance = 0.0f;
+		bool hit = false;
+		bool expectedHit = false;
+
+		rayMarchSeconds += Testing::Time([&]() { hit = heightField->Intersects(origin, direction, hitLocation, distance); });
+		everyTriangleSeconds += Testing::Time([&]() { expectedHit = IntersectEveryTriangle(*heightField, origin, direction, expectedDistance); });
+
+		hitCount += hit ? 1 : 0;
+		if (hit != expectedHit || (hit && std::abs(distance - expectedDistance) > 1e-3f * std::max(1.0f, expectedDistance)))
+			++mismatchCount;
+	}
+
+	CHECK_EQUAL(0, mismatchCount);
+	printf("    %d rays, %d hits, %d mismatches\n", rayCount, hitCount, mismatchCount);
+	printf("    ray march:      %10.2f us per ray\n", rayMarchSeconds / rayCount * 1e6);
+	printf("    every triangle: %10.2f us per ray\n", everyTriangleSeconds / rayCount * 1e6);
+}
+
+// TerrainMesh hands out a view of the heights in the mapped cooked file instead of a copy. The view has to answer
+// every query exactly like a height field that owns the same samples
+TEST_CASE(ViewAnswersLikeAnOwnedHeightField)
+{
+	const int size = 65;
+
+	std::shared_ptr<std::vector<float>> samples = std::make_shared<std::vector<float>>(TerrainTestData::RandomHeights(size, size, 8));
+	for (float& sample : *samples)
+		sample /= 300.0f;
+
+	HeightField owned(size, size);
+	for (int j = 0; j < size; j++)
+		owned.SetRow(j, samples->data() + (static_cast<size_t>(size) * j));
+	owned.UpdateBounds();
+
+	auto bounds = std::minmax_element(samples->begin(), samples->end());
+	HeightField view(size, size, samples->data(), *bounds.first, *bounds.second, samples);
+
+	// The view keeps its samples alive
+	const float* data = samples->data();
+	samples.reset();
+	CHECK(view.GetRow(0) == data);
+
+	RandomRays rays(owned, 9);
+	int mismatchCount = 0;
+	for (int n = 0; n < 300; n++)
+	{
+		XMFLOAT3 origin, direction;
+		rays.Next(n % 3, origin, direction);
+
+		XMFLOAT3 ownedHit, viewHit;
+		float ownedDistance = 0.0f;
+		float viewDistance = 0.0f;
+		bool ownedResult = owned.Intersects(origin, direction, ownedHit, ownedDistance);
+		bool viewResult = view.Intersects(origin, direction, viewHit, viewDistance);
+		if (ownedResult != viewResult || (ownedResult && ownedDistance != viewDistance))
+			++mismatchCount;
+
+		if (owned.GetHeight(origin.x, origin.z) != view.GetHeight(origin.x, origin.z))
+			++mismatchCount;
+	}
+
+	CHECK_EQUAL(0, mismatchCount);
+}
@@ -0,0 +1,131 @@
+#include "TestFramework.h"
+#include "Json.h"
+
+#include <filesystem>
+#include <fstream>
+
+TEST_CASE(JsonReadsEveryKindOfValue)
+{
+	Json json = JsonReader::Parse(R"({
+		"bool": true, "false": false, "nothing": null,
+		"integer": -42, "big": 9007199254740993, "float": 2.5e-1, "whole": 3,
+		"string": "plain", "escaped": "tab\there \"quoted\" \\ \/ é 😀",
+		"array": [1, 2, 3], "floats": [0.5, 1, -2.25], "empty": [], "emptyObject": {},
+		"object": { "b": 1, "a": [ { "c": "d" } ] }
+	})");
+
+	CHECK_EQUAL(true, json.Get<bool>("bool"));
+	CHECK_EQUAL(false, json.Get<bool>("false"));
+	CHECK(json.Get<Json>("object").GetValue().Type() == JsonType::OBJECT);
+	CHECK(json.GetValue().Find("nothing")->Type() == JsonType::NUL);
+
+	CHECK_EQUAL(-42, json.Get<int>("integer"));
+	CHECK_EQUAL(9007199254740993ll, json.Get<int64_t>("big"));
+	CHECK_EQUAL(0.25f, json.Get<float>("float"));
+
+	// Integers can be read as floats but not the other way around
+	CHECK_EQUAL(3.0, json.Get<double>("whole"));
+	CHECK_THROWS(json.Get<int>("float"));
+
+	CHECK_EQUAL(std::string("plain"), json.Get<std::string>("string"));
+	CHECK_EQUAL(std::string("tab\there \"quoted\" \\ / \xC3\xA9 \xF0\x9F\x98\x80"), json.Get<std::string>("escaped"));
+
+	std::vector<int> array = json.Get<std::vector<int>>("array");
+	CHECK(array == std::vector<int>({ 1, 2, 3 }));
+	std::vector<float> floats = json.Get<std::vector<float>>("floats");
+	CHECK(floats == std::vector<float>({ 0.5f, 1.0f, -2.25f }));
+	CHECK_EQUAL(static_cast<size_t>(0), json.Get<JsonArray>("empty").Size());
+	CHECK(json.Get<Json>("emptyObject").GetKeys().empty());
+
+	Json object = json.Get<Json>("object");
+	CHECK_EQUAL(1, object.Get<int>("b"));
+	CHECK_EQUAL(std::string("d"), object.Get<JsonArray>("a").Get<Json>(0).Get<std::string>("c"));
+	CHECK_THROWS(object.Get<JsonArray>("a").Get<Json>(1));
+}
+
+TEST_CASE(JsonKeysAreSortedAndFoundByName)
+{
+	Json json = JsonReader::Parse(R"({ "zebra": 1, "apple": 2, "mango": 3, "Apple": 4 })");
+
+	std::vector<std::string> keys = json.GetKeys();
+	CHECK(keys == std::vector<std::string>({ "Apple", "apple", "mango", "zebra" }));
+
+	CHECK(json.HasKey("mango"));
+	CHECK(!json.HasKey("mang"));
+	CHECK(!json.HasKey("mangoes"));
+	CHECK_EQUAL(4, json.Get<int>("Apple"));
+	CHECK_THROWS(json.Get<int>("pear"));
+}
+
+// Values taken out of a Json keep the document alive, so they can outlive the Json they came from
+TEST_CASE(JsonValuesOutliveTheirParent)
+{
+	JsonArray array = JsonReader::Parse(R"({ "items": [ "one", "two" ] })").Get<JsonArray>("items");
+	CHECK_EQUAL(std::string("two"), array.Get<std::string>(1));
+}
+
+TEST_CASE(JsonRejectsMalformedText)
+{
+	const char* malformed[] = {
+		"",
+		"{",
+		"{ \"a\": }",
+		"{ \"a\" 1 }",
+		"{ \"a\": 1, }",
+		"{ a: 1 }",
+		"{ \"a\": [1, 2 }",
+		"{ \"a\": [1 2] }",
+		"{ \"a\": \"unterminated }",
+		"{ \"a\": \"bad \\q escape\" }",
+		"{ \"a\": \"bad \\u12G4 escape\" }",
+		"{ \"a\": tru }",
+		"{ \"a\": 1.2.3 }",
+		"{ \"a\": - }",
+		"{ \"a\": 1 } trailing",
+		"[1, 2]",
+	};
+
+	int acceptedCount = 0;
+	for (const char* text : malformed)
+	{
+		try
+		{
+			JsonReader::Parse(text);
+			printf("    accepted: %s\n", text);
+			++acceptedCount;
+		}
+		catch (const JsonException&)
+		{
+		}
+	}
+	CHECK_EQUAL(0, acceptedCount);
+
+	// Nesting deep enough to run out of stack is an error rather than a crash
+	std::string deep = "{ \"a\": " + std::string(100000, '[') + std::string(100000, ']') + " }";
+	CHECK_THROWS(JsonReader::Parse(deep));
+}
+
+// The glTF models are the largest Json files the engine reads
+BENCHMARK(JsonParseGltf)
+{
+	for (const char* filename : { "models/nanosuit.gltf", "models/nanosuit2.gltf" })
+	{
+		size_t size = static_cast<size_t>(std::filesystem::file_size(filename));
+
+		Json json;
+		double readSeconds = Testing::BestTime(20, [&json, filename]() { json = JsonReader::ReadFile(filename); });
+		CHECK(json.Get<JsonArray>("meshes").Size() > 0);
+
+		std::ifstream file(filename, std::ios::binary);
+		std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		double parseSeconds = Testing::BestTime(20, [&text]()
+		{
+			Json parsed = JsonReader::Parse(text);
+			Testing::DoNotOptimize(&parsed);
+		});
+
+		printf("    %s (%zu KB)\n", filename, size / 1024);
+		printf("        parse:      %8.3f ms  (%.0f MB/s)\n", parseSeconds * 1e3, size / parseSeconds / (1024.0 * 1024.0));
+		printf("        read file:  %8.3f ms\n", readSeconds * 1e3);
+	}
+}
@@ -0,0 +1,193 @@
+#include "TestFramework.h"
+#include "MeshOptimizer.h"
+#include "GltfModel.h"
+
+#include <algorithm>
+#include <array>
+#include <random>
+
+using DirectX::XMFLOAT3;
+
+namespace
+{
+	// A flat grid of quads, two triangles each, with the triangles in random order - the worst case for the cache
+	void ShuffledGrid(int quadsAcross, std::vector<XMFLOAT3>& positions, std::vector<unsigned int>& indices)
+	{
+		int verticesAcross = quadsAcross + 1;
+		positions.clear();
+		for (int z = 0; z < verticesAcross; ++z)
+			for (int x = 0; x < verticesAcross; ++x)
+				positions.push_back(XMFLOAT3(static_cast<float>(x), 0.0f, static_cast<float>(z)));
+
+		std::vector<std::array<unsigned int, 3>> triangles;
+		for (int z = 0; z < quadsAcross; ++z)
+		{
+			for (int x = 0; x < quadsAcross; ++x)
+			{
+				unsigned int corner = static_cast<unsigned int>((z * verticesAcross) + x);
+				triangles.push_back({ corner, corner + verticesAcross, corner + 1 });
+				triangles.push_back({ corner + 1, corner + verticesAcross, corner + verticesAcross + 1 });
+			}
+		}
+
+		std::mt19937 random(15);
+		std::shuffle(triangles.begin(), triangles.end(), random);
+
+		indices.clear();
+		for (const std::array<unsigned int, 3>& triangle : triangles)
+			indices.insert(indices.end(), triangle.begin(), triangle.end());
+	}
+
+	// The triangles as sorted vertex index triples, each rotated (keeping its winding) to start at its smallest index
+	std::vector<std::array<unsigned int, 3>> SortedTriangles(const std::vector<unsigned int>& indices)
+	{
+		std::vector<std::array<unsigned int, 3>> triangles;
+		for (size_t iii = 0; iii + 2 < indices.size(); iii += 3)
+		{
+			std::array<unsigned int, 3> triangle = { indices[iii], indices[iii + 1], indices[iii + 2] };
+			std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+			triangles.push_back(triangle);
+		}
+		std::sort(triangles.begin(), triangles.end());
+		return triangles;
+	}
+}
+
+TEST_CASE(VertexCacheStatisticsOfKnownOrders)
+{
+	// A single triangle transforms every vertex once
+	VertexCacheStatistics triangle = MeshOptimizer::AnalyzeVertexCache({ 0, 1, 2 }, 3);
+	CHECK_EQUAL(3u, triangle.transformedVertexCount);
+	CHECK_EQUAL(3.0f, triangle.acmr);
+	CHECK_EQUAL(1.0f, triangle.atvr);
+
+	// A quad shares two vertices between its triangles
+	VertexCacheStatistics quad = MeshOptimizer::AnalyzeVertexCache({ 0, 1, 2, 2, 1, 3 }, 4);
+	CHECK_EQUAL(4u, quad.transformedVertexCount);
+	CHECK_EQUAL(2.0f, quad.acmr);
+
+	// With a cache of 3 entries, vertex 0 has been evicted by the time the last triangle uses it again
+	VertexCacheStatistics evicted = MeshOptimizer::AnalyzeVertexCache({ 0, 1, 2, 3, 4, 5, 0, 1, 2 }, 6, 3);
+	CHECK_EQUAL(9u, evicted.transformedVertexCount);
+	VertexCacheStatistics kept = MeshOptimizer::AnalyzeVertexCache({ 0, 1, 2, 3, 4, 5, 0, 1, 2 }, 6, 6);
+	CHECK_EQUAL(6u, kept.transformedVertexCount);
+}
+
+// Each pass keeps every triangle (with its winding) and the cache and overdraw passes bring a shuffled grid close
+// to the best order for it
+TEST_CASE(OptimizedGridKeepsEveryTriangle)
+{
+	std::vector<XMFLOAT3> positions;
+	std::vector<unsigned int> indices;
+	ShuffledGrid(64, positions, indices);
+	std::vector<std::array<unsigned int, 3>> original = SortedTriangles(indices);
+
+	float shuffledAcmr = MeshOptimizer::AnalyzeVertexCache(indices, positions.size()).acmr;
+
+	MeshOptimizer::OptimizeVertexCache(indices, positions.size());
+	float cacheAcmr = MeshOptimizer::AnalyzeVertexCache(indices, positions.size()).acmr;
+	CHECK(SortedTriangles(indices) == original);
+	CHECK(cacheAcmr < 0.8f);
+	CHECK(cacheAcmr < shuffledAcmr / 2.0f);
+
+	MeshOptimizer::OptimizeOverdraw(indices, positions.data(), sizeof(XMFLOAT3), positions.size());
+	float overdrawAcmr = MeshOptimizer::AnalyzeVertexCache(indices, positions.size()).acmr;
+	CHECK(SortedTriangles(indices) == original);
+	CHECK(overdrawAcmr <= cacheAcmr * 1.05f);
+}
+
+// The vertex fetch pass renumbers the vertices in the order the triangles first use them and drops the ones that
+// are never used
+TEST_CASE(VertexFetchFollowsTheTriangleOrder)
+{
+	std::vector<XMFLOAT3> positions;
+	std::vector<unsigned int> indices;
+	ShuffledGrid(16, positions, indices);
+
+	// An extra vertex that no triangle uses
+	positions.push_back(XMFLOAT3(-1.0f, -1.0f, -1.0f));
+	std::vector<XMFLOAT3> original = positions;
+	std::vector<unsigned int> originalIndices = indices;
+
+	MeshOptimizer::OptimizeVertexFetch(positions, indices);
+
+	CHECK_EQUAL(original.size() - 1, positions.size());
+
+	int mismatchCount = 0;
+	unsigned int nextNew = 0;
+	for (size_t iii = 0; iii < indices.size(); ++iii)
+	{
+		if (indices[iii] == nextNew)
+			++nextNew;
+		else if (indices[iii] > nextNew)
+			++mismatchCount;
+
+		const XMFLOAT3& before = original[originalIndices[iii]];
+		const XMFLOAT3& after = positions[indices[iii]];
+		if (before.x != after.x || before.y != after.y || before.z != after.z)
+			++mismatchCount;
+	}
+	CHECK_EQUAL(0, mismatchCount);
+	CHECK_EQUAL(static_cast<unsigned int>(positions.size()), nextNew);
+}
+
+// The passes ModelCache::Write runs when it cooks a model, on the meshes of nanosuit.gltf: the time each takes
+// and the ACMR after it, with the cache sizes of older and newer hardware
+BENCHMARK(MeshOptimizerPasses)
+{
+	GltfModel model("models/nanosuit.gltf");
+	std::vector<std::vector<OBJVertex>> meshVertices;
+	std::vector<std::vector<unsigned int>> meshIndices;
+	for (const GltfModel::MeshDescription& mesh : model.GetMeshes())
+	{
+		for (const GltfModel::Primitive& primitive : mesh.primitives)
+		{
+			meshVertices.emplace_back();
+			meshIndices.emplace_back();
+			model.ReadPrimitive(primitive, meshVertices.back(), meshIndices.back());
+		}
+	}
+
+	const unsigned int cacheSizes[] = { 16, 32 };
+	auto Report = [&](const char* pass, double seconds)
+	{
+		size_t triangleCount = 0;
+		size_t vertexCount = 0;
+		size_t transformed[2] = {};
+		for (size_t iii = 0; iii < meshIndices.size(); ++iii)
+		{
+			triangleCount += meshIndices[iii].size() / 3;
+			vertexCount += meshVertices[iii].size();
+			for (int size = 0; size < 2; ++size)
+				transformed[size] += MeshOptimizer::AnalyzeVertexCache(meshIndices[iii], meshVertices[iii].size(), cacheSizes[size]).transformedVertexCount;
+		}
+
+		printf("    %-16s %8.2f ms   ACMR %5.3f / %5.3f   ATVR %5.3f / %5.3f\n", pass, seconds * 1e3,
+			static_cast<double>(transformed[0]) / triangleCount, static_cast<double>(transformed[1]) / triangleCount,
+			static_cast<double>(transformed[0]) / vertexCount, static_cast<double>(transformed[1]) / vertexCount);
+	};
+
+	printf("    %zu meshes, cache of %u / %u entries\n", meshIndices.size(), cacheSizes[0], cacheSizes[1]);
+	Report("file order", 0.0);
+
+	double seconds = Testing::Time([&]()
+	{
+		for (size_t iii = 0; iii < meshIndices.size(); ++iii)
+			MeshOptimizer::OptimizeVertexCache(meshIndices[iii], meshVertices[iii].size());
+	});
+	Report("vertex cache", seconds);
+
+	seconds = Testing::Time([&]()
+	{
+		for (size_t iii = 0; iii < meshIndices.size(); ++iii)
+			MeshOptimizer::OptimizeOverdraw(meshIndices[iii], &meshVertices[iii][0].position, sizeof(OBJVertex), meshVertices[iii].size());
+	});
+	Report("overdraw", seconds);
+
+	seconds = Testing::Time([&]()
+	{
+		for (size_t iii = 0; iii < meshIndices.size(); ++iii)
+			MeshOptimizer::OptimizeVertexFetch(meshVertices[iii], meshIndices[iii]);
+	});
+	Report("vertex fetch", seconds);
+}
@@ -0,0 +1,234 @@
+#include "TestFramework.h"
+#include "ModelCache.h"
+
+#include <assimp/Importer.hpp>
+#include <assimp/postprocess.h>
+
+#include <algorithm>
+#include <array>
+#include <filesystem>
+
+namespace
+{
+	const char* OBJ_MODELS[] = { "models/nanosuit.obj", "models/suzanne.obj" };
+
+	std::string TemporaryFilename(const char* name)
+	{
+		return (std::filesystem::temp_directory_path() / name).string();
+	}
+
+	// The same import Drawable::ConstructFromAssimpFile runs on a cold start
+	const aiScene* Import(Assimp::Importer& importer, const std::string& filename)
+	{
+		return importer.ReadFile(filename.c_str(), aiProcess_Triangulate | aiProcess_JoinIdenticalVertices);
+	}
+
+	template <typename I>
+	std::vector<unsigned int> WidenIndices(const I* indices, size_t count)
+	{
+		return std::vector<unsigned int>(indices, indices + count);
+	}
+
+	std::vector<unsigned int> GetIndices(const ModelCache& cache, const ModelCache::MeshType& mesh)
+	{
+		if (mesh.indexSize == sizeof(uint16_t))
+			return WidenIndices(cache.GetIndices<uint16_t>(mesh), mesh.indexCount);
+		return WidenIndices(cache.GetIndices<uint32_t>(mesh), mesh.indexCount);
+	}
+
+	int CountNodes(const aiNode& node)
+	{
+		int count = 1;
+		for (unsigned int iii = 0; iii < node.mNumChildren; ++iii)
+			count += CountNodes(*node.mChildren[iii]);
+		return count;
+	}
+}
+
+// Cooked without the mesh optimizations, every mesh has to come back exactly as Drawable::LoadMesh would have
+// built it from the import - same vertices, same indices (narrowed to 16 bits where they fit), same hierarchy
+TEST_CASE(CookedModelMatchesTheImport)
+{
+	const std::string cookedFilename = TemporaryFilename("chameleon-tests-model.cooked");
+
+	for (const char* filename : OBJ_MODELS)
+	{
+		Assimp::Importer importer;
+		const aiScene* scene = Import(importer, filename);
+		REQUIRE(scene != nullptr);
+
+		ModelCacheKey key = ModelCache::CreateKey(filename);
+		ModelCache::Write(cookedFilename, key, *scene, false);
+
+		ModelCache cache(cookedFilename);
+		CHECK(cache.Matches(key));
+		CHECK_EQUAL(CountNodes(*scene->mRootNode), cache.NodeCount());
+		CHECK_EQUAL(static_cast<int>(scene->mNumMaterials), cache.MaterialCount());
+		REQUIRE(cache.MeshCount() == static_cast<int>(scene->mNumMeshes));
+
+		int mismatchCount = 0;
+		std::vector<OBJVertex> vertices;
+		std::vector<unsigned int> indices;
+		for (int iii = 0; iii < cache.MeshCount(); ++iii)
+		{
+			ModelCache::ConvertMesh(*scene->mMeshes[iii], vertices, indices);
+			const ModelCache::MeshType& mesh = cache.GetMesh(iii);
+
+			if (cache.GetString(mesh.name) != scene->mMeshes[iii]->mName.C_Str() || mesh.materialIndex != scene->mMeshes[iii]->mMaterialIndex)
+				++mismatchCount;
+			if (mesh.vertexCount != vertices.size() || memcmp(cache.GetVertices(mesh), vertices.data(), vertices.size() * sizeof(OBJVertex)) != 0)
+				++mismatchCount;
+			if (mesh.indexSize != (vertices.size() <= 0x10000 ? sizeof(uint16_t) : sizeof(uint32_t)) || GetIndices(cache, mesh) != indices)
+				++mismatchCount;
+		}
+		CHECK_EQUAL(0, mismatchCount);
+	}
+
+	std::filesystem::remove(cookedFilename);
+}
+
+// Optimizing reorders the triangles and vertices but must not lose or change any of them
+TEST_CASE(OptimizedCookedModelKeepsEveryTriangle)
+{
+	const std::string cookedFilename = TemporaryFilename("chameleon-tests-optimized.cooked");
+
+	Assimp::Importer importer;
+	const aiScene* scene = Import(importer, "models/nanosuit.obj");
+	REQUIRE(scene != nullptr);
+
+	ModelCache::Write(cookedFilename, ModelCache::CreateKey("models/nanosuit.obj"), *scene, true);
+	ModelCache cache(cookedFilename);
+	REQUIRE(cache.MeshCount() == static_cast<int>(scene->mNumMeshes));
+
+	int mismatchCount = 0;
+	std::vector<OBJVertex> vertices;
+	std::vector<unsigned int> indices;
+	for (int iii = 0; iii < cache.MeshCount(); ++iii)
+	{
+		ModelCache::ConvertMesh(*scene->mMeshes[iii], vertices, indices);
+		const ModelCache::MeshType& mesh = cache.GetMesh(iii);
+		const OBJVertex* cookedVertices = cache.GetVertices(mesh);
+		std::vector<unsigned int> cookedIndices = GetIndices(cache, mesh);
+
+		// Compare the triangles by their corner positions, each rotated to start at its smallest corner
+		auto Triangles = [](const OBJVertex* triangleVertices, const std::vector<unsigned int>& triangleIndices)
+		{
+			std::vector<std::array<float, 9>> triangles;
+			for (size_t jjj = 0; jjj + 2 < triangleIndices.size(); jjj += 3)
+			{
+				std::array<std::array<float, 3>, 3> corners;
+				for (int corner = 0; corner < 3; ++corner)
+				{
+					const DirectX::XMFLOAT3& position = triangleVertices[triangleIndices[jjj + corner]].position;
+					corners[corner] = { position.x, position.y, position.z };
+				}
+				std::rotate(corners.begin(), std::min_element(corners.begin(), corners.end()), corners.end());
+
+				std::array<float, 9> triangle;
+				for (int corner = 0; corner < 3; ++corner)
+					std::copy(corners[corner].begin(), corners[corner].end(), triangle.begin() + (corner * 3));
+				triangles.push_back(triangle);
+			}
+			std::sort(triangles.begin(), triangles.end());
+			return triangles;
+		};
+
+		if (Triangles(vertices.data(), indices) != Triangles(cookedVertices, cookedIndices))
+			++mismatchCount;
+	}
+	CHECK_EQUAL(0, mismatchCount);
+
+	std::filesystem::remove(cookedFilename);
+}
+
+// A cooked file is only used for the exact source it was cooked from, and a damaged one is rejected when it is
+// opened rather than crashing Drawable later
+TEST_CASE(CookedModelRejectsStaleAndDamagedFiles)
+{
+	const std::string cookedFilename = TemporaryFilename("chameleon-tests-damaged.cooked");
+
+	Assimp::Importer importer;
+	const aiScene* scene = Import(importer, "models/suzanne.obj");
+	REQUIRE(scene != nullptr);
+
+	ModelCacheKey key = ModelCache::CreateKey("models/suzanne.obj");
+	ModelCache::Write(cookedFilename, key, *scene);
+
+	{
+		ModelCache cache(cookedFilename);
+		ModelCacheKey touched = key;
+		touched.sourceWriteTime += 1;
+		ModelCacheKey resized = key;
+		resized.sourceSize += 1;
+
+		CHECK(cache.Matches(key));
+		CHECK(!cache.Matches(touched));
+		CHECK(!cache.Matches(resized));
+	}
+
+	std::filesystem::resize_file(cookedFilename, std::filesystem::file_size(cookedFilename) - 1);
+	CHECK_THROWS(ModelCache{ cookedFilename });
+
+	std::filesystem::resize_file(cookedFilename, 8);
+	CHECK_THROWS(ModelCache{ cookedFilename });
+
+	std::filesystem::remove(cookedFilename);
+}
+
+// A cold start imports the model with Assimp, builds every mesh and writes the cooked file. A warm start only
+// checks the key, maps the cooked file and reads every vertex and index array - it does not construct a
+// Drawable, so the node hierarchy, the meshes' GPU buffers and the materials are not part of either time
+BENCHMARK(ModelCacheColdAndWarmStart)
+{
+	const std::string cookedFilename = TemporaryFilename("chameleon-tests-start.cooked");
+
+	for (const char* filename : OBJ_MODELS)
+	{
+		double coldSeconds = Testing::BestTime(5, [&cookedFilename, filename]()
+		{
+			ModelCacheKey key = ModelCache::CreateKey(filename);
+			Assimp::Importer importer;
+			const aiScene* scene = Import(importer, filename);
+
+			std::vector<OBJVertex> vertices;
+			std::vector<unsigned int> indices;
+			for (unsigned int iii = 0; iii < scene->mNumMeshes; ++iii)
+			{
+				ModelCache::ConvertMesh(*scene->mMeshes[iii], vertices, indices);
+				Testing::DoNotOptimize(vertices.data());
+			}
+
+			ModelCache::Write(cookedFilename, key, *scene);
+		});
+
+		size_t vertexCount = 0;
+		double warmSeconds = Testing::BestTime(20, [&cookedFilename, &vertexCount, filename]()
+		{
+			ModelCacheKey key = ModelCache::CreateKey(filename);
+			ModelCache cache(cookedFilename);
+			CHECK(cache.Matches(key));
+
+			// Touch every byte the GPU upload would read
+			vertexCount = 0;
+			uint32_t sum = 0;
+			for (int iii = 0; iii < cache.MeshCount(); ++iii)
+			{
+				const ModelCache::MeshType& mesh = cache.GetMesh(iii);
+				const uint8_t* vertices = reinterpret_cast<const uint8_t*>(cache.GetVertices(mesh));
+				for (size_t byte = 0; byte < mesh.vertexCount * sizeof(OBJVertex); byte += 64)
+					sum += vertices[byte];
+				const uint8_t* indices = cache.GetIndices<uint8_t>(mesh);
+				for (size_t byte = 0; byte < static_cast<size_t>(mesh.indexCount) * mesh.indexSize; byte += 64)
+					sum += indices[byte];
+				vertexCount += mesh.vertexCount;
+			}
+			Testing::DoNotOptimize(&sum);
+		});
+
+		printf("    %s (%zu vertices, %.1f KB cooked)\n", filename, vertexCount, std::filesystem::file_size(cookedFilename) / 1024.0);
+		printf("        cold (Assimp + cook):  %8.2f ms\n", coldSeconds * 1e3);
+		printf("        warm (map + read):     %8.2f ms  (%.0fx)\n", warmSeconds * 1e3, coldSeconds / warmSeconds);
+	}
+
+	std::filesystem::remove(cookedFilename);
+}
@@ -0,0 +1,213 @@
+#include "TestFramework.h"
+#include "GltfModel.h"
+#include "ModelCache.h"
+
+#include <assimp/Importer.hpp>
+#include <assimp/postprocess.h>
+
+#include <cfloat>
+#include <filesystem>
+#include <fstream>
+
+using DirectX::XMFLOAT3;
+
+namespace
+{
+	const char* GLTF_MODELS[] = { "models/nanosuit.gltf", "models/nanosuit2.gltf" };
+
+	// What both loaders hand to Mesh::LoadBuffers, summed over every mesh of the model
+	struct LoadedModel
+	{
+		size_t meshCount = 0;
+		size_t vertexCount = 0;
+		size_t triangleCount = 0;
+		int badIndexCount = 0;
+		XMFLOAT3 minimum = XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX);
+		XMFLOAT3 maximum = XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+		void Add(const std::vector<OBJVertex>& vertices, const std::vector<unsigned int>& indices)
+		{
+			++meshCount;
+			vertexCount += vertices.size();
+			triangleCount += indices.size() / 3;
+
+			for (unsigned int index : indices)
+				if (index >= vertices.size())
+					++badIndexCount;
+
+			for (const OBJVertex& vertex : vertices)
+			{
+				minimum = XMFLOAT3(std::min(minimum.x, vertex.position.x), std::min(minimum.y, vertex.position.y), std::min(minimum.z, vertex.position.z));
+				maximum = XMFLOAT3(std::max(maximum.x, vertex.position.x), std::max(maximum.y, vertex.position.y), std::max(maximum.z, vertex.position.z));
+			}
+		}
+	};
+
+	// Drawable's glTF path: GltfModel reads the file, then every primitive is read into vertices and indices
+	LoadedModel LoadGltf(const std::string& filename)
+	{
+		LoadedModel loaded;
+		GltfModel model(filename);
+		std::vector<OBJVertex> vertices;
+		std::vector<unsigned int> indices;
+
+		for (const GltfModel::MeshDescription& mesh : model.GetMeshes())
+		{
+			for (const GltfModel::Primitive& primitive : mesh.primitives)
+			{
+				model.ReadPrimitive(primitive, vertices, indices);
+				loaded.Add(vertices, indices);
+			}
+		}
+		return loaded;
+	}
+
+	// Drawable's Assimp path: the same import flags and the same conversion Drawable::LoadMesh uses
+	LoadedModel LoadAssimp(const std::string& filename)
+	{
+		LoadedModel loaded;
+		Assimp::Importer importer;
+		const aiScene* scene = importer.ReadFile(filename.c_str(), aiProcess_Triangulate | aiProcess_JoinIdenticalVertices);
+		REQUIRE(scene != nullptr);
+
+		std::vector<OBJVertex> vertices;
+		std::vector<unsigned int> indices;
+		for (unsigned int iii = 0; iii < scene->mNumMeshes; ++iii)
+		{
+			ModelCache::ConvertMesh(*scene->mMeshes[iii], vertices, indices);
+			loaded.Add(vertices, indices);
+		}
+		return loaded;
+	}
+}
+
+// The native loader has to give Drawable the same model Assimp did: one mesh per primitive, the same triangles
+// and the same extent. Vertex counts may differ since Assimp welds identical vertices
+TEST_CASE(GltfModelLoadsWhatAssimpLoads)
+{
+	for (const char* filename : GLTF_MODELS)
+	{
+		LoadedModel gltf = LoadGltf(filename);
+		LoadedModel assimp = LoadAssimp(filename);
+
+		CHECK(gltf.meshCount > 0);
+		CHECK_EQUAL(0, gltf.badIndexCount);
+		CHECK_EQUAL(assimp.meshCount, gltf.meshCount);
+		CHECK_EQUAL(assimp.triangleCount, gltf.triangleCount);
+		CHECK(gltf.vertexCount >= assimp.vertexCount);
+
+		CHECK_EQUAL(assimp.minimum.x, gltf.minimum.x);
+		CHECK_EQUAL(assimp.minimum.y, gltf.minimum.y);
+		CHECK_EQUAL(assimp.minimum.z, gltf.minimum.z);
+		CHECK_EQUAL(assimp.maximum.x, gltf.maximum.x);
+		CHECK_EQUAL(assimp.maximum.y, gltf.maximum.y);
+		CHECK_EQUAL(assimp.maximum.z, gltf.maximum.z);
+	}
+}
+
+TEST_CASE(GltfModelRejectsBadFiles)
+{
+	CHECK_THROWS(GltfModel("models/does-not-exist.gltf"));
+	CHECK_THROWS(GltfModel("models/nanosuit.obj"));
+}
+
+// Nodes have to form strict trees: no node may be its own ancestor, have two parents or be both a scene root and
+// a child
+TEST_CASE(GltfModelRejectsNodesThatAreNotTrees)
+{
+	const std::string filename = (std::filesystem::temp_directory_path() / "chameleon-tests-nodes.gltf").string();
+	auto load = [&filename](const std::string& nodes, const std::string& sceneNodes)
+	{
+		{
+			std::ofstream file(filename);
+			file << R"({ "asset": { "version": "2.0" }, "nodes": [ )" << nodes << R"( ], "scenes": [ { "nodes": [ )" << sceneNodes << " ] } ] }";
+		}
+		return GltfModel(filename);
+	};
+
+	CHECK_THROWS(load(R"({ "children": [ 0 ] })", "0"));
+	CHECK_THROWS(load(R"({ "children": [ 1 ] }, { "children": [ 2 ] }, { "children": [ 1 ] })", "0"));
+	CHECK_THROWS(load(R"({ "children": [ 1 ] }, { "children": [ 0 ] })", ""));
+	CHECK_THROWS(load(R"({ "children": [ 2 ] }, { "children": [ 2 ] }, { })", "0, 1"));
+	CHECK_THROWS(load(R"({ "children": [ 1 ] }, { })", "0, 1"));
+
+	// A tree whose children come before their parent in the file is fine
+	GltfModel model = load(R"({ }, { "children": [ 0, 3 ] }, { "children": [ 1 ] }, { })", "2");
+	CHECK_EQUAL(static_cast<size_t>(4), model.GetNodes().size());
+	CHECK_EQUAL(static_cast<size_t>(1), model.GetSceneNodes().size());
+
+	std::filesystem::remove(filename);
+}
+
+// A primitive's own TANGENT attribute is used as it is, and only primitives without one get generated tangents
+TEST_CASE(GltfModelReadsTangents)
+{
+	const std::filesystem::path directory = std::filesystem::temp_directory_path();
+	const std::string filename = (directory / "chameleon-tests-tangents.gltf").string();
+
+	// One triangle with u along x and v along z, and tangents that point along z instead
+	const float positions[] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f };
+	const float texcoords[] = { 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f };
+	const float tangents[] = { 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f };
+	{
+		std::ofstream buffer(directory / "chameleon-tests-tangents.bin", std::ios::binary);
+		buffer.write(reinterpret_cast<const char*>(positions), sizeof(positions));
+		buffer.write(reinterpret_cast<const char*>(texcoords), sizeof(texcoords));
+		buffer.write(reinterpret_cast<const char*>(tangents), sizeof(tangents));
+	}
+
+	auto read = [&filename](const std::string& attributes, std::vector<OBJVertex>& vertices)
+	{
+		{
+			std::ofstream file(filename);
+			file << R"({ "asset": { "version": "2.0" },
+				"buffers": [ { "uri": "chameleon-tests-tangents.bin", "byteLength": 108 } ],
+				"bufferViews": [ { "buffer": 0, "byteLength": 36 }, { "buffer": 0, "byteOffset": 36, "byteLength": 24 }, { "buffer": 0, "byteOffset": 60, "byteLength": 48 } ],
+				"accessors": [ { "bufferView": 0, "componentType": 5126, "count": 3, "type": "VEC3" },
+					{ "bufferView": 1, "componentType": 5126, "count": 3, "type": "VEC2" },
+					{ "bufferView": 2, "componentType": 5126, "count": 3, "type": "VEC4" } ],
+				"meshes": [ { "primitives": [ { "attributes": { )" << attributes << R"( } } ] } ] })";
+		}
+		GltfModel model(filename);
+		std::vector<unsigned int> indices;
+		model.ReadPrimitive(model.GetMeshes()[0].primitives[0], vertices, indices);
+	};
+
+	std::vector<OBJVertex> vertices;
+	read(R"("POSITION": 0, "TEXCOORD_0": 1, "TANGENT": 2)", vertices);
+	REQUIRE(vertices.size() == 3);
+	for (const OBJVertex& vertex : vertices)
+	{
+		CHECK_EQUAL(1.0f, vertex.tangent.z);
+		CHECK_EQUAL(1.0f, vertex.tangent.w);
+	}
+
+	read(R"("POSITION": 0, "TEXCOORD_0": 1)", vertices);
+	REQUIRE(vertices.size() == 3);
+	for (const OBJVertex& vertex : vertices)
+		CHECK_EQUAL(0.0f, vertex.tangent.z);
+
+	// A tangent accessor of the wrong type
+	CHECK_THROWS(read(R"("POSITION": 0, "TEXCOORD_0": 1, "TANGENT": 0)", vertices));
+
+	std::filesystem::remove(filename);
+	std::filesystem::remove(directory / "chameleon-tests-tangents.bin");
+}
+
+// Loading each model from scratch into the vertex and index arrays Drawable uploads, with no device involved and
+// no cooked file. Both paths generate tangents, so the difference is reading and decoding the file
+BENCHMARK(GltfModelVersusAssimp)
+{
+	for (const char* filename : GLTF_MODELS)
+	{
+		LoadedModel gltf;
+		LoadedModel assimp;
+		double gltfSeconds = Testing::BestTime(10, [&gltf, filename]() { gltf = LoadGltf(filename); });
+		double assimpSeconds = Testing::BestTime(10, [&assimp, filename]() { assimp = LoadAssimp(filename); });
+		CHECK_EQUAL(assimp.triangleCount, gltf.triangleCount);
+
+		printf("    %s (%zu meshes, %zu triangles)\n", filename, gltf.meshCount, gltf.triangleCount);
+		printf("        GltfModel:  %8.2f ms\n", gltfSeconds * 1e3);
+		printf("        Assimp:     %8.2f ms  (%.1fx)\n", assimpSeconds * 1e3, assimpSeconds / gltfSeconds);
+	}
+}
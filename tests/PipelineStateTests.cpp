@@ -0,0 +1,299 @@
+#include "TestFramework.h"
+#include "PipelineState.h"
+
+#include <map>
+#include <random>
+#include <tuple>
+
+namespace
+{
+	// One call into PipelineState, as the bindables make it. objects are fake object addresses - PipelineState only
+	// ever compares them
+	enum class Call
+	{
+		VERTEX_SHADER,
+		PIXEL_SHADER,
+		INPUT_LAYOUT,
+		RASTERIZER_STATE,
+		DEPTH_STENCIL_STATE,
+		PRIMITIVE_TOPOLOGY,
+		VERTEX_BUFFER,
+		INSTANCE_BUFFER,
+		INDEX_BUFFER,
+		CONSTANT_BUFFERS,
+		CONSTANT_BUFFER_RANGE,
+		SHADER_RESOURCES,
+		SAMPLERS,
+		INVALIDATE,
+		CALL_COUNT
+	};
+
+	struct Command
+	{
+		Call call;
+		std::vector<uintptr_t> objects;
+		int stage;
+		unsigned int slot;
+		unsigned int first;		// Stride, stencil reference, index format or first constant, depending on the call
+		unsigned int second;	// Offset or constant count
+	};
+
+	const int PIXEL_STAGE = 5;
+	const int VERTEX_STAGE = 1;
+
+	template <typename T>
+	T* Fake(uintptr_t object)
+	{
+		return reinterpret_cast<T*>(object);
+	}
+
+	template <typename T>
+	std::vector<T*> FakeArray(const std::vector<uintptr_t>& objects)
+	{
+		std::vector<T*> array;
+		for (uintptr_t object : objects)
+			array.push_back(Fake<T>(object));
+		return array;
+	}
+
+	// Makes the call and returns what PipelineState said - whether it has to be made on the context
+	bool Replay(const Command& command)
+	{
+		const uintptr_t object = command.objects.empty() ? 0 : command.objects[0];
+		const unsigned int count = static_cast<unsigned int>(command.objects.size());
+		switch (command.call)
+		{
+		case Call::VERTEX_SHADER:
+			return PipelineState::SetVertexShader(Fake<ID3D11VertexShader>(object));
+		case Call::PIXEL_SHADER:
+			return PipelineState::SetPixelShader(Fake<ID3D11PixelShader>(object));
+		case Call::INPUT_LAYOUT:
+			return PipelineState::SetInputLayout(Fake<ID3D11InputLayout>(object));
+		case Call::RASTERIZER_STATE:
+			return PipelineState::SetRasterizerState(Fake<ID3D11RasterizerState>(object));
+		case Call::DEPTH_STENCIL_STATE:
+			return PipelineState::SetDepthStencilState(Fake<ID3D11DepthStencilState>(object), command.first);
+		case Call::PRIMITIVE_TOPOLOGY:
+			return PipelineState::SetPrimitiveTopology(static_cast<D3D11_PRIMITIVE_TOPOLOGY>(command.first));
+		case Call::VERTEX_BUFFER:
+			return PipelineState::SetVertexBuffer(Fake<ID3D11Buffer>(object), command.first, command.second);
+		case Call::INSTANCE_BUFFER:
+			return PipelineState::SetInstanceBuffer(Fake<ID3D11Buffer>(object), command.first, command.second);
+		case Call::INDEX_BUFFER:
+			return PipelineState::SetIndexBuffer(Fake<ID3D11Buffer>(object), static_cast<DXGI_FORMAT>(command.first), command.second);
+		case Call::CONSTANT_BUFFERS:
+			return PipelineState::SetConstantBuffers(command.stage, command.slot, count, FakeArray<ID3D11Buffer>(command.objects).data());
+		case Call::CONSTANT_BUFFER_RANGE:
+			return PipelineState::SetConstantBufferRange(command.stage, command.slot, Fake<ID3D11Buffer>(object), command.first, command.second);
+		case Call::SHADER_RESOURCES:
+			return PipelineState::SetShaderResources(command.stage, command.slot, count, FakeArray<ID3D11ShaderResourceView>(command.objects).data());
+		case Call::SAMPLERS:
+			return PipelineState::SetSamplers(command.stage, command.slot, count, FakeArray<ID3D11SamplerState>(command.objects).data());
+		default:
+			PipelineState::Invalidate();
+			return false;
+		}
+	}
+
+	// What the context holds, worked out the obvious way: a call has to be made when any slot it sets would change.
+	// Slots past the ones PipelineState tracks, and stages that do not exist, are never known
+	class ReferenceState
+	{
+	public:
+		bool Apply(const Command& command)
+		{
+			if (command.call == Call::INVALIDATE)
+			{
+				m_slots.clear();
+				return false;
+			}
+
+			const bool isArray = command.call == Call::CONSTANT_BUFFERS || command.call == Call::CONSTANT_BUFFER_RANGE ||
+				command.call == Call::SHADER_RESOURCES || command.call == Call::SAMPLERS;
+			if (!isArray)
+				return Set({ static_cast<int>(command.call), 0, 0 }, { command.objects[0], command.first, command.second });
+
+			if (command.objects.empty())
+				return false;
+
+			// Constant buffers and their ranges live in the same slots
+			const int group = command.call == Call::CONSTANT_BUFFER_RANGE ? static_cast<int>(Call::CONSTANT_BUFFERS) : static_cast<int>(command.call);
+			const unsigned int end = command.slot + static_cast<unsigned int>(command.objects.size());
+			if (command.stage < 0 || command.stage >= 6 || end > 16)
+			{
+				for (unsigned int slot = command.slot; slot < 16; ++slot)
+					m_slots.erase({ group, command.stage, slot });
+				return true;
+			}
+
+			bool changed = false;
+			for (unsigned int iii = 0; iii < command.objects.size(); ++iii)
+			{
+				// A whole buffer is bound as the range 0, 0
+				std::tuple<uintptr_t, unsigned int, unsigned int> value = { command.objects[iii], 0, 0 };
+				if (command.call == Call::CONSTANT_BUFFER_RANGE)
+					value = { command.objects[iii], command.first, command.second };
+				changed |= Set({ group, command.stage, command.slot + iii }, value);
+			}
+			return changed;
+		}
+
+	private:
+		using Key = std::tuple<int, int, unsigned int>;
+		using Value = std::tuple<uintptr_t, unsigned int, unsigned int>;
+
+		bool Set(const Key& key, const Value& value)
+		{
+			auto [iterator, inserted] = m_slots.try_emplace(key, value);
+			if (inserted)
+				return true;
+			if (iterator->second == value)
+				return false;
+			iterator->second = value;
+			return true;
+		}
+
+		std::map<Key, Value> m_slots;
+	};
+
+	// What Drawable::Draw binds for one node of a model: everything of the node and, before it, everything it
+	// inherits from the model
+	void RecordNode(std::vector<Command>& stream, uintptr_t vertexShader, uintptr_t pixelShader, uintptr_t texture, uintptr_t mesh,
+		unsigned int firstConstant)
+	{
+		stream.push_back({ Call::VERTEX_SHADER, { vertexShader } });
+		stream.push_back({ Call::PIXEL_SHADER, { pixelShader } });
+		stream.push_back({ Call::INPUT_LAYOUT, { 0x3000 } });
+		stream.push_back({ Call::RASTERIZER_STATE, { 0x4000 } });
+		stream.push_back({ Call::DEPTH_STENCIL_STATE, { 0x5000 }, 0, 0, 1 });
+		stream.push_back({ Call::CONSTANT_BUFFERS, { 0x6000, 0x6010 }, PIXEL_STAGE, 0 });
+		stream.push_back({ Call::SAMPLERS, { 0x7000 }, PIXEL_STAGE, 0 });
+		stream.push_back({ Call::SHADER_RESOURCES, { texture, 0x8100 }, PIXEL_STAGE, 0 });
+		stream.push_back({ Call::PRIMITIVE_TOPOLOGY, { 0 }, 0, 0, D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST });
+		stream.push_back({ Call::VERTEX_BUFFER, { mesh }, 0, 0, 48, 0 });
+		stream.push_back({ Call::INDEX_BUFFER, { mesh + 8 }, 0, 0, DXGI_FORMAT_R32_UINT, 0 });
+		stream.push_back({ Call::CONSTANT_BUFFER_RANGE, { 0x9000 }, VERTEX_STAGE, 0, firstConstant, 16 });
+	}
+}
+
+// A frame as the hierarchy draws it: two models of three nodes each, sharing everything but the shaders of the
+// second model, the textures of its second node and (always) the mesh and the constant range
+TEST_CASE(PipelineStateSkipsWhatTheFrameAlreadyBound)
+{
+	std::vector<Command> stream;
+	for (unsigned int node = 0; node < 3; ++node)
+		RecordNode(stream, 0x1000, 0x2000, 0x8000, 0xA000 + node * 0x100, node * 16);
+	for (unsigned int node = 0; node < 3; ++node)
+		RecordNode(stream, 0x1100, 0x2100, node == 1 ? 0x8200 : 0x8000, 0xB000 + node * 0x100, (node + 3) * 16);
+
+	PipelineState::BeginFrame();
+	int issued = 0;
+	for (const Command& command : stream)
+		issued += Replay(command) ? 1 : 0;
+
+	// The first node binds all 12, every other node its mesh (vertex and index buffer) and its constant range. The
+	// second model binds its two shaders, and its second and third nodes swap the texture in and back out
+	const int expectedIssued = 12 + (5 * 3) + 2 + 2;
+	CHECK_EQUAL(expectedIssued, issued);
+
+	const PipelineState::Statistics& current = PipelineState::GetCurrentStatistics();
+	CHECK_EQUAL(static_cast<uint64_t>(expectedIssued), current.issued);
+	CHECK_EQUAL(static_cast<uint64_t>(stream.size() - expectedIssued), current.skipped);
+
+	// BeginFrame keeps the counts of the frame that just ended and forgets the state, so the same frame binds the
+	// same again
+	PipelineState::BeginFrame();
+	CHECK_EQUAL(static_cast<uint64_t>(expectedIssued), PipelineState::GetFrameStatistics().issued);
+	CHECK_EQUAL(static_cast<uint64_t>(0), PipelineState::GetCurrentStatistics().issued);
+	issued = 0;
+	for (const Command& command : stream)
+		issued += Replay(command) ? 1 : 0;
+	CHECK_EQUAL(expectedIssued, issued);
+}
+
+// Calls that set a slot to what it already holds are skipped, every other call is issued - checked call by call on
+// a long random stream over a few objects per slot, with untracked slots, unknown stages and Invalidate mixed in
+TEST_CASE(PipelineStateCountsMatchAReference)
+{
+	std::mt19937 random(21);
+	auto Pick = [&random](int count) { return std::uniform_int_distribution<int>(0, count - 1)(random); };
+
+	std::vector<Command> stream;
+	for (int iii = 0; iii < 20000; ++iii)
+	{
+		Command command = { static_cast<Call>(Pick(static_cast<int>(Call::CALL_COUNT))) };
+		uintptr_t object = 0x1000 * (1 + Pick(3));
+		switch (command.call)
+		{
+		case Call::CONSTANT_BUFFERS:
+		case Call::SHADER_RESOURCES:
+		case Call::SAMPLERS:
+		{
+			// Mostly the stages and slots the engine uses, sometimes slots and stages that are not tracked
+			command.stage = Pick(10) == 0 ? 6 + Pick(2) : (Pick(2) == 0 ? VERTEX_STAGE : PIXEL_STAGE);
+			command.slot = Pick(10) == 0 ? 14 + Pick(4) : Pick(3);
+			int count = Pick(4);
+			for (int slot = 0; slot < count; ++slot)
+				command.objects.push_back(0x1000 * (1 + Pick(3)));
+			break;
+		}
+		case Call::CONSTANT_BUFFER_RANGE:
+			command.stage = VERTEX_STAGE;
+			command.slot = Pick(2);
+			command.objects = { object };
+			command.first = 16 * Pick(3);
+			command.second = 16;
+			break;
+		case Call::INVALIDATE:
+			// Rarely, or nothing would ever be skipped
+			if (Pick(50) != 0)
+				continue;
+			break;
+		case Call::PRIMITIVE_TOPOLOGY:
+			command.objects = { 0 };
+			command.first = Pick(2) == 0 ? D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST : D3D11_PRIMITIVE_TOPOLOGY_LINELIST;
+			break;
+		case Call::DEPTH_STENCIL_STATE:
+			command.objects = { object };
+			command.first = Pick(2);
+			break;
+		case Call::VERTEX_BUFFER:
+		case Call::INSTANCE_BUFFER:
+		case Call::INDEX_BUFFER:
+			command.objects = { object };
+			command.first = Pick(2) == 0 ? DXGI_FORMAT_R32_UINT : DXGI_FORMAT_R16_UINT;
+			command.second = Pick(2);
+			break;
+		default:
+			command.objects = { object };
+			break;
+		}
+		stream.push_back(command);
+	}
+
+	PipelineState::BeginFrame();
+	ReferenceState reference;
+	int mismatchCount = 0;
+	uint64_t expectedIssued = 0;
+	uint64_t expectedSkipped = 0;
+	for (const Command& command : stream)
+	{
+		bool expected = reference.Apply(command);
+		if (Replay(command) != expected)
+			++mismatchCount;
+
+		// Invalidate is not a bind, and an empty array changes nothing on the context but is still counted
+		if (command.call == Call::INVALIDATE)
+			continue;
+		if (expected)
+			++expectedIssued;
+		else
+			++expectedSkipped;
+	}
+
+	CHECK_EQUAL(0, mismatchCount);
+	CHECK_EQUAL(expectedIssued, PipelineState::GetCurrentStatistics().issued);
+	CHECK_EQUAL(expectedSkipped, PipelineState::GetCurrentStatistics().skipped);
+	CHECK(expectedSkipped > 0);
+	CHECK(expectedIssued > 0);
+}
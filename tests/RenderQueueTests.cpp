@@ -0,0 +1,248 @@
+#include "TestFramework.h"
+#include "RenderQueue.h"
+#include "RecordingRenderBackend.h"
+
+#include <cmath>
+#include <memory>
+
+namespace
+{
+	// A bindable that binds nothing, for queues that are only ever executed against a RecordingRenderBackend
+	class FakeBindable : public Bindable
+	{
+	public:
+		FakeBindable(BindableSlot slot, bool readsInstanceData = false) : Bindable(nullptr), m_slot(slot), m_readsInstanceData(readsInstanceData) {}
+
+		void Bind() override {}
+		BindableSlot Slot() const override { return m_slot; }
+		bool ReadsInstanceData() const override { return m_readsInstanceData; }
+
+	private:
+		BindableSlot m_slot;
+		bool m_readsInstanceData;
+	};
+
+	std::unique_ptr<FakeBindable> MakeBindable(BindableSlot::Type type, int stage = 0, unsigned int slot = 0)
+	{
+		return std::make_unique<FakeBindable>(BindableSlot{ type, stage, slot });
+	}
+
+	std::unique_ptr<FakeBindable> MakeInstancedBindable(BindableSlot::Type type)
+	{
+		return std::make_unique<FakeBindable>(BindableSlot{ type }, true);
+	}
+
+	// The queue and the recording backend only pass the drawables around, so any distinct addresses will do
+	struct FakeDrawables
+	{
+		std::vector<char> storage;
+
+		FakeDrawables(size_t count) : storage(count) {}
+		Drawable* operator[](size_t index) { return reinterpret_cast<Drawable*>(&storage[index]); }
+	};
+
+	// The drawables in the order the backend drew them
+	std::vector<const void*> DrawOrder(const RecordingRenderBackend& backend)
+	{
+		std::vector<const void*> order;
+		for (const RecordingRenderBackend::Command& command : backend.Commands())
+		{
+			if (command.type != RecordingRenderBackend::CommandType::BIND)
+				order.push_back(command.object);
+		}
+		return order;
+	}
+}
+
+// The pass decides first, then the shader pair, then the depth from near to far
+TEST_CASE(RenderQueueDrawsInSortKeyOrder)
+{
+	std::unique_ptr<FakeBindable> vertexShaders[2] = { MakeBindable(BindableSlot::Type::VERTEX_SHADER), MakeBindable(BindableSlot::Type::VERTEX_SHADER) };
+	std::unique_ptr<FakeBindable> pixelShader = MakeBindable(BindableSlot::Type::PIXEL_SHADER);
+	FakeDrawables drawables(5);
+
+	RenderQueue queue;
+	Bindable* first[] = { vertexShaders[0].get(), pixelShader.get() };
+	Bindable* second[] = { vertexShaders[1].get(), pixelShader.get() };
+	queue.Submit(drawables[0], RenderPass::SOLID, 30.0f, first, 2);
+	queue.Submit(drawables[1], RenderPass::SOLID, 5.0f, second, 2);
+	queue.Submit(drawables[2], RenderPass::SOLID, 10.0f, first, 2);
+	queue.Submit(drawables[3], RenderPass::BACKGROUND, 1000.0f, second, 2);
+	queue.Submit(drawables[4], RenderPass::SOLID, 20.0f, second, 2);
+	CHECK_EQUAL(static_cast<size_t>(5), queue.PacketCount());
+
+	RecordingRenderBackend backend;
+	queue.Execute(backend);
+
+	std::vector<const void*> expected = { drawables[3], drawables[2], drawables[0], drawables[1], drawables[4] };
+	CHECK(DrawOrder(backend) == expected);
+	CHECK_EQUAL(static_cast<size_t>(5), backend.DrawCount());
+	CHECK_EQUAL(static_cast<size_t>(10), backend.BindCount());
+
+	// Negative and NaN depths sort as 0, and a nearer depth never sorts after a further one
+	CHECK(RenderQueue::MakeKey(RenderPass::SOLID, 0, 0, -1.0f) == RenderQueue::MakeKey(RenderPass::SOLID, 0, 0, 0.0f));
+	CHECK(RenderQueue::MakeKey(RenderPass::SOLID, 0, 0, std::nanf("")) == RenderQueue::MakeKey(RenderPass::SOLID, 0, 0, 0.0f));
+	CHECK(RenderQueue::MakeKey(RenderPass::SOLID, 0, 0, 1.0f) <= RenderQueue::MakeKey(RenderPass::SOLID, 0, 0, 1.001f));
+	CHECK(RenderQueue::MakeKey(RenderPass::SOLID, 0, 0, 1e6f) < RenderQueue::MakeKey(RenderPass::SOLID, 1, 0, 0.0f));
+}
+
+// Changes are counted per binding location, so arrays bound to different stages or slots do not replace each other
+TEST_CASE(RecordingBackendCountsChangesPerSlot)
+{
+	std::unique_ptr<FakeBindable> vertexBuffers = MakeBindable(BindableSlot::Type::CONSTANT_BUFFERS, 1, 1);
+	std::unique_ptr<FakeBindable> pixelBuffers = MakeBindable(BindableSlot::Type::CONSTANT_BUFFERS, 5, 1);
+	std::unique_ptr<FakeBindable> pixelTextures = MakeBindable(BindableSlot::Type::SHADER_RESOURCES, 5, 0);
+	std::unique_ptr<FakeBindable> otherTextures = MakeBindable(BindableSlot::Type::SHADER_RESOURCES, 5, 0);
+
+	RecordingRenderBackend backend;
+	for (int iii = 0; iii < 3; ++iii)
+	{
+		backend.Bind(*vertexBuffers);
+		backend.Bind(*pixelBuffers);
+		backend.Bind(*pixelTextures);
+	}
+	CHECK_EQUAL(static_cast<size_t>(9), backend.BindCount());
+	CHECK_EQUAL(static_cast<size_t>(3), backend.BindChanges());
+
+	// Two texture arrays for the same slot do replace each other
+	backend.Bind(*otherTextures);
+	backend.Bind(*pixelTextures);
+	CHECK_EQUAL(static_cast<size_t>(5), backend.BindChanges());
+
+	backend.Reset();
+	CHECK_EQUAL(static_cast<size_t>(0), backend.BindCount());
+	CHECK(backend.Commands().empty());
+	backend.Bind(*pixelTextures);
+	CHECK_EQUAL(static_cast<size_t>(1), backend.BindChanges());
+}
+
+// Sorting puts the drawables that share shaders next to each other, so executing the queue changes shaders far less
+// often than drawing in the order the hierarchy submitted them
+TEST_CASE(RenderQueueGroupsSharedShaders)
+{
+	const int shaderCount = 4;
+	const int drawableCount = 64;
+	std::vector<std::unique_ptr<FakeBindable>> vertexShaders;
+	std::vector<std::unique_ptr<FakeBindable>> pixelShaders;
+	for (int iii = 0; iii < shaderCount; ++iii)
+	{
+		vertexShaders.push_back(MakeBindable(BindableSlot::Type::VERTEX_SHADER));
+		pixelShaders.push_back(MakeBindable(BindableSlot::Type::PIXEL_SHADER));
+	}
+	FakeDrawables drawables(drawableCount);
+
+	RenderQueue queue;
+	RecordingRenderBackend submitted;
+	for (int iii = 0; iii < drawableCount; ++iii)
+	{
+		Bindable* bindables[] = { vertexShaders[iii % shaderCount].get(), pixelShaders[iii % shaderCount].get() };
+		queue.Submit(drawables[iii], RenderPass::SOLID, static_cast<float>(iii), bindables, 2);
+
+		submitted.Bind(*bindables[0]);
+		submitted.Bind(*bindables[1]);
+		submitted.Draw(*drawables[iii]);
+	}
+
+	RecordingRenderBackend sorted;
+	queue.Execute(sorted);
+
+	CHECK_EQUAL(submitted.BindCount(), sorted.BindCount());
+	CHECK_EQUAL(static_cast<size_t>(drawableCount * 2), submitted.BindChanges());
+	CHECK_EQUAL(static_cast<size_t>(shaderCount * 2), sorted.BindChanges());
+}
+
+// Clear forgets the ids along with the packets: a frame that submits the same shaders in a different order draws
+// them in that order, and a bindable freed after a frame is never mistaken for one submitted in the next
+TEST_CASE(RenderQueueClearStartsTheIdsOver)
+{
+	std::unique_ptr<FakeBindable> first = MakeBindable(BindableSlot::Type::VERTEX_SHADER);
+	std::unique_ptr<FakeBindable> second = MakeBindable(BindableSlot::Type::VERTEX_SHADER);
+	FakeDrawables drawables(2);
+	Bindable* firstBindables[] = { first.get() };
+	Bindable* secondBindables[] = { second.get() };
+
+	RenderQueue queue;
+	queue.Submit(drawables[0], RenderPass::SOLID, 10.0f, firstBindables, 1);
+	queue.Submit(drawables[1], RenderPass::SOLID, 1.0f, secondBindables, 1);
+	RecordingRenderBackend backend;
+	queue.Execute(backend);
+	std::vector<const void*> expected = { drawables[0], drawables[1] };
+	CHECK(DrawOrder(backend) == expected);
+
+	queue.Clear();
+	CHECK_EQUAL(static_cast<size_t>(0), queue.PacketCount());
+	queue.Submit(drawables[1], RenderPass::SOLID, 1.0f, secondBindables, 1);
+	queue.Submit(drawables[0], RenderPass::SOLID, 10.0f, firstBindables, 1);
+	backend.Reset();
+	queue.Execute(backend);
+	expected = { drawables[1], drawables[0] };
+	CHECK(DrawOrder(backend) == expected);
+}
+
+// Instanced drawables that share the mesh and every bindable, material included, are drawn with one call. A
+// drawable with a material of its own lands in a group of its own, and the others are still drawn one by one
+TEST_CASE(RenderQueueDrawsSharedInstancesWithOneCall)
+{
+	std::unique_ptr<FakeBindable> instancedShader = MakeInstancedBindable(BindableSlot::Type::VERTEX_SHADER);
+	std::unique_ptr<FakeBindable> instancedLayout = MakeInstancedBindable(BindableSlot::Type::INPUT_LAYOUT);
+	std::unique_ptr<FakeBindable> shader = MakeBindable(BindableSlot::Type::VERTEX_SHADER);
+	std::unique_ptr<FakeBindable> layout = MakeBindable(BindableSlot::Type::INPUT_LAYOUT);
+	std::unique_ptr<FakeBindable> pixelShader = MakeBindable(BindableSlot::Type::PIXEL_SHADER);
+	std::unique_ptr<FakeBindable> sharedMaterial = MakeBindable(BindableSlot::Type::CONSTANT_BUFFERS, 5, 1);
+	std::unique_ptr<FakeBindable> ownMaterial = MakeBindable(BindableSlot::Type::CONSTANT_BUFFERS, 5, 1);
+	std::unique_ptr<FakeBindable> mesh = MakeBindable(BindableSlot::Type::MESH);
+	FakeDrawables drawables(24);
+
+	RenderQueue queue;
+	Bindable* shared[] = { instancedShader.get(), instancedLayout.get(), pixelShader.get(), sharedMaterial.get() };
+	Bindable* own[] = { instancedShader.get(), instancedLayout.get(), pixelShader.get(), ownMaterial.get() };
+	Bindable* single[] = { shader.get(), layout.get(), pixelShader.get(), sharedMaterial.get() };
+	for (int iii = 0; iii < 20; ++iii)
+		queue.Submit(drawables[iii], RenderPass::SOLID, static_cast<float>(iii), shared, 4, mesh.get());
+	queue.Submit(drawables[20], RenderPass::SOLID, 0.0f, own, 4, mesh.get());
+	for (int iii = 21; iii < 24; ++iii)
+		queue.Submit(drawables[iii], RenderPass::SOLID, static_cast<float>(iii), single, 4);
+
+	RecordingRenderBackend backend;
+	queue.Execute(backend);
+	CHECK_EQUAL(static_cast<size_t>(5), backend.DrawCount());
+	CHECK_EQUAL(static_cast<size_t>(21), backend.InstanceCount());
+
+	size_t sharedCalls = 0;
+	for (const RecordingRenderBackend::Command& command : backend.Commands())
+	{
+		if (command.type == RecordingRenderBackend::CommandType::DRAW_INSTANCED && command.instanceCount == 20)
+		{
+			CHECK(command.object == drawables[0]);
+			++sharedCalls;
+		}
+	}
+	CHECK_EQUAL(static_cast<size_t>(1), sharedCalls);
+}
+
+// The shaders and the drawable have to agree on whether the matrices come from the InstanceBuffer
+TEST_CASE(RenderQueueRejectsMismatchedInstancing)
+{
+	std::unique_ptr<FakeBindable> instancedShader = MakeInstancedBindable(BindableSlot::Type::VERTEX_SHADER);
+	std::unique_ptr<FakeBindable> instancedLayout = MakeInstancedBindable(BindableSlot::Type::INPUT_LAYOUT);
+	std::unique_ptr<FakeBindable> shader = MakeBindable(BindableSlot::Type::VERTEX_SHADER);
+	std::unique_ptr<FakeBindable> layout = MakeBindable(BindableSlot::Type::INPUT_LAYOUT);
+	std::unique_ptr<FakeBindable> mesh = MakeBindable(BindableSlot::Type::MESH);
+	FakeDrawables drawables(1);
+	RenderQueue queue;
+
+	Bindable* plain[] = { shader.get(), layout.get() };
+	Bindable* instanced[] = { instancedShader.get(), instancedLayout.get() };
+	Bindable* mixed[] = { instancedShader.get(), layout.get() };
+	CHECK_THROWS(queue.Submit(drawables[0], RenderPass::SOLID, 1.0f, plain, 2, mesh.get()));
+	CHECK_THROWS(queue.Submit(drawables[0], RenderPass::SOLID, 1.0f, instanced, 2));
+	CHECK_THROWS(queue.Submit(drawables[0], RenderPass::SOLID, 1.0f, mixed, 2, mesh.get()));
+	CHECK_THROWS(queue.Submit(drawables[0], RenderPass::SOLID, 1.0f, instanced, 1, mesh.get()));
+	CHECK_EQUAL(static_cast<size_t>(0), queue.PacketCount());
+
+	// A later layout overrides the one inherited from an ancestor, the same as when they are bound in order
+	Bindable* overridden[] = { shader.get(), layout.get(), instancedShader.get(), instancedLayout.get() };
+	queue.Submit(drawables[0], RenderPass::SOLID, 1.0f, overridden, 4, mesh.get());
+	queue.Submit(drawables[0], RenderPass::SOLID, 1.0f, plain, 2);
+	CHECK_EQUAL(static_cast<size_t>(2), queue.PacketCount());
+}
@@ -0,0 +1,190 @@
+#include "TestFramework.h"
+#include "ResourceRegistry.h"
+
+#include <map>
+#include <random>
+
+namespace
+{
+	struct Resource
+	{
+		int id;
+		size_t size;
+	};
+
+	using Registry = ResourceRegistry<Resource>;
+
+	std::shared_ptr<Resource> MakeResource(int id, size_t size = 100)
+	{
+		return std::make_shared<Resource>(Resource{ id, size });
+	}
+}
+
+// A handle resolves to its resource until the resource is removed, and never to whatever reuses the slot
+TEST_CASE(HandlesResolveUntilRemoved)
+{
+	Registry registry("test resources");
+	Registry::Handle first = registry.Add("first", MakeResource(1));
+	Registry::Handle second = registry.Add("second", MakeResource(2));
+
+	CHECK(first.IsValid());
+	CHECK(registry.Find("first") == first);
+	CHECK(!registry.Find("third").IsValid());
+	CHECK_EQUAL(1, registry.Get(first)->id);
+	CHECK_EQUAL(2, registry.Get("second")->id);
+
+	// Adding an existing name keeps the resource that is already there
+	CHECK(registry.Add("first", MakeResource(10)) == first);
+	CHECK_EQUAL(1, registry.Get(first)->id);
+	CHECK_EQUAL(static_cast<size_t>(2), registry.Size());
+
+	registry.Remove(first);
+	CHECK(!registry.Exists(first));
+	CHECK(!registry.Exists("first"));
+	CHECK_THROWS(registry.Get(first));
+	CHECK_THROWS(registry.Get("first"));
+
+	// The freed slot is reused, but under a new generation
+	Registry::Handle third = registry.Add("third", MakeResource(3));
+	CHECK_EQUAL(first.index, third.index);
+	CHECK(!(third == first));
+	CHECK_THROWS(registry.Get(first));
+	CHECK_EQUAL(3, registry.Get(third)->id);
+	CHECK_EQUAL(2, registry.Get(second)->id);
+}
+
+// Handles that were never valid are rejected in every build rather than read out of bounds
+TEST_CASE(InvalidHandlesAreRejected)
+{
+	Registry registry("test resources");
+	registry.Add("only", MakeResource(1));
+
+	Registry::Handle invalid;
+	CHECK(!invalid.IsValid());
+	CHECK_THROWS(registry.Get(invalid));
+
+	Registry::Handle pastTheEnd = { 1000, 0 };
+	CHECK_THROWS(registry.Get(pastTheEnd));
+
+	Registry::Handle wrongGeneration = registry.Find("only");
+	wrongGeneration.generation += 1;
+	CHECK_THROWS(registry.Get(wrongGeneration));
+
+	// Removing a handle that does not resolve is ignored
+	registry.Remove(invalid);
+	registry.Remove(pastTheEnd);
+	CHECK_EQUAL(static_cast<size_t>(1), registry.Size());
+}
+
+TEST_CASE(ClearInvalidatesEveryHandle)
+{
+	Registry registry("test resources");
+	std::vector<Registry::Handle> handles;
+	for (int iii = 0; iii < 8; ++iii)
+		handles.push_back(registry.Add("resource " + std::to_string(iii), MakeResource(iii)));
+
+	registry.Clear();
+	CHECK_EQUAL(static_cast<size_t>(0), registry.Size());
+	CHECK_EQUAL(static_cast<size_t>(0), registry.Statistics().residentCount);
+
+	int resolvedCount = 0;
+	for (const Registry::Handle& handle : handles)
+		if (registry.Exists(handle))
+			++resolvedCount;
+	CHECK_EQUAL(0, resolvedCount);
+
+	// The same names come back under handles that do not match the old ones
+	Registry::Handle again = registry.Add("resource 0", MakeResource(0));
+	CHECK(!(again == handles[0]));
+	CHECK_THROWS(registry.Get(handles[0]));
+}
+
+// Update evicts the least recently used resources that can be reloaded and that nothing else holds on to, until
+// the rest fit the budget. Get brings an evicted resource back through its reload function
+TEST_CASE(EvictionKeepsResidentResourcesWithinBudget)
+{
+	Registry registry("test resources");
+	registry.SetSizeFunction([](const Resource& resource) { return resource.size; });
+	registry.SetBudget(250);
+
+	int reloadCount = 0;
+	std::vector<Registry::Handle> handles;
+	for (int iii = 0; iii < 4; ++iii)
+	{
+		handles.push_back(registry.Add("resource " + std::to_string(iii), MakeResource(iii),
+			[&reloadCount, iii]() { ++reloadCount; return MakeResource(iii); }));
+	}
+
+	// One resource without a reload function and one still held elsewhere can never be evicted
+	registry.Add("pinned", MakeResource(10, 50));
+	std::shared_ptr<Resource> held = registry.Get(handles[3]);
+
+	// Frame 1 uses resource 2, so 0 and 1 are the least recently used
+	registry.Update(1);
+	registry.Get(handles[2]);
+	registry.Update(2);
+
+	const ResidencyStatistics& statistics = registry.Statistics();
+	CHECK(statistics.residentBytes <= 250);
+	CHECK_EQUAL(static_cast<uint64_t>(2), statistics.evictions);
+	CHECK_EQUAL(static_cast<size_t>(2), statistics.evictedCount);
+	CHECK_EQUAL(static_cast<size_t>(3), statistics.residentCount);
+
+	// Evicted resources keep their handle and come back on the next Get
+	uint64_t misses = statistics.misses;
+	CHECK_EQUAL(0, registry.Get(handles[0])->id);
+	CHECK_EQUAL(1, reloadCount);
+	CHECK_EQUAL(misses + 1, statistics.misses);
+	CHECK_EQUAL(3, registry.Get("resource 3")->id);
+	CHECK_EQUAL(1, reloadCount);
+}
+
+// Resolving a handle against looking up the name in the registry and in the std::map<std::string, ...> that
+// ObjectStore used before, for a registry the size of a scene with a few dozen models
+BENCHMARK(ResourceLookup)
+{
+	const int resourceCount = 2000;
+	const int lookupCount = 1000000;
+
+	Registry registry("test resources");
+	std::map<std::string, std::shared_ptr<Resource>> map;
+	std::vector<std::string> names;
+	std::vector<Registry::Handle> handles;
+	for (int iii = 0; iii < resourceCount; ++iii)
+	{
+		names.push_back("models/nanosuit.gltf-Mesh_" + std::to_string(iii));
+		std::shared_ptr<Resource> resource = MakeResource(iii);
+		handles.push_back(registry.Add(names.back(), resource));
+		map.emplace(names.back(), resource);
+	}
+
+	// The same pseudo random order for every kind of lookup
+	std::mt19937 random(16);
+	std::uniform_int_distribution<int> pick(0, resourceCount - 1);
+	std::vector<int> order(lookupCount);
+	for (int& index : order)
+		index = pick(random);
+
+	long long sum = 0;
+	double handleSeconds = Testing::BestTime(5, [&]()
+	{
+		for (int index : order)
+			sum += registry.Get(handles[index])->id;
+	});
+	double nameSeconds = Testing::BestTime(5, [&]()
+	{
+		for (int index : order)
+			sum += registry.Get(names[index])->id;
+	});
+	double mapSeconds = Testing::BestTime(5, [&]()
+	{
+		for (int index : order)
+			sum += map.find(names[index])->second->id;
+	});
+	Testing::DoNotOptimize(&sum);
+
+	printf("    %d resources, %d lookups\n", resourceCount, lookupCount);
+	printf("    handle:           %6.1f ns per lookup\n", handleSeconds * 1e9 / lookupCount);
+	printf("    registry name:    %6.1f ns per lookup\n", nameSeconds * 1e9 / lookupCount);
+	printf("    std::map name:    %6.1f ns per lookup\n", mapSeconds * 1e9 / lookupCount);
+}
@@ -0,0 +1,159 @@
+#include "TestFramework.h"
+#include "RingAllocator.h"
+
+#include <random>
+#include <vector>
+
+namespace
+{
+	// Stands in for the driver: every DISCARD renames the buffer, and a range handed out since the last rename must
+	// not be handed out again, because a draw the GPU has not run yet may still read it
+	struct RenamedBuffer
+	{
+		std::vector<bool> used;
+		int overlapCount = 0;
+		int outOfBoundsCount = 0;
+
+		void Rename(size_t capacity) { used.assign(capacity, false); }
+
+		void Use(size_t offset, size_t size)
+		{
+			if (offset + size > used.size())
+			{
+				++outOfBoundsCount;
+				return;
+			}
+			for (size_t iii = offset; iii < offset + size; ++iii)
+			{
+				if (used[iii])
+					++overlapCount;
+				used[iii] = true;
+			}
+		}
+	};
+
+	// Runs frames of randomly sized batches the way ConstantRingBuffer drives the allocator
+	void SimulateFrames(bool noOverwriteSupported, int& discardCount, RenamedBuffer& buffer)
+	{
+		std::mt19937 random(23);
+		std::uniform_int_distribution<int> batchCount(1, 12);
+		std::uniform_int_distribution<int> writeCount(1, 40);
+		std::uniform_int_distribution<size_t> writeSize(1, 600);
+
+		RingAllocator ring(256);
+		ring.SetNoOverwriteSupported(noOverwriteSupported);
+		ring.Reset(4096);
+		discardCount = 0;
+		for (int frame = 0; frame < 300; ++frame)
+		{
+			ring.BeginFrame();
+			for (int batch = batchCount(random); batch > 0; --batch)
+			{
+				std::vector<size_t> sizes(writeCount(random));
+				size_t total = 0;
+				for (size_t& size : sizes)
+				{
+					size = writeSize(random);
+					total += ring.AlignedSize(size);
+				}
+
+				if (total > ring.Capacity())
+					ring.Reset(ring.GrownCapacity(total));
+				if (ring.Begin(total))
+				{
+					buffer.Rename(ring.Capacity());
+					++discardCount;
+				}
+
+				for (size_t size : sizes)
+				{
+					size_t offset = 0;
+					CHECK(ring.Allocate(size, offset));
+					CHECK_EQUAL(static_cast<size_t>(0), offset % 256);
+					buffer.Use(offset, size);
+				}
+			}
+		}
+	}
+}
+
+// The first batch of a frame discards, later ones are appended behind it, and one that does not fit wraps around
+TEST_CASE(RingAllocatorDiscardsOnlyWhenItHasTo)
+{
+	RingAllocator ring(256);
+	ring.Reset(1024);
+
+	CHECK(ring.Begin(300));
+	size_t offset = 1;
+	CHECK(ring.Allocate(10, offset));
+	CHECK_EQUAL(static_cast<size_t>(0), offset);
+	CHECK(ring.Allocate(257, offset));
+	CHECK_EQUAL(static_cast<size_t>(256), offset);
+	CHECK_EQUAL(static_cast<size_t>(768), ring.Offset());
+
+	// 256 bytes are left, so a batch of that size appends and anything more wraps
+	CHECK(!ring.Begin(256));
+	CHECK(ring.Allocate(256, offset));
+	CHECK_EQUAL(static_cast<size_t>(768), offset);
+	CHECK(ring.Begin(1));
+	CHECK(ring.Allocate(1, offset));
+	CHECK_EQUAL(static_cast<size_t>(0), offset);
+
+	// A new frame discards even with room to spare
+	CHECK(!ring.Begin(256));
+	ring.BeginFrame();
+	CHECK(ring.Begin(256));
+	CHECK_EQUAL(static_cast<size_t>(0), ring.Offset());
+
+	// Without NO_OVERWRITE every batch has to discard
+	ring.SetNoOverwriteSupported(false);
+	CHECK(ring.Begin(16));
+	CHECK(ring.Allocate(16, offset));
+	CHECK(ring.Begin(16));
+	CHECK_EQUAL(static_cast<size_t>(0), ring.Offset());
+}
+
+// Writes past the end are refused rather than handed a range that is not there, and a buffer that is too small
+// grows to hold the batch, at least doubling
+TEST_CASE(RingAllocatorRefusesAndGrows)
+{
+	RingAllocator ring(256);
+	size_t offset = 7;
+	CHECK(ring.Begin(1));
+	CHECK(!ring.Allocate(1, offset));
+	CHECK_EQUAL(static_cast<size_t>(7), offset);
+
+	ring.Reset(512);
+	CHECK(ring.Begin(512));
+	CHECK(ring.Allocate(300, offset));
+	CHECK(!ring.Allocate(300, offset));
+	CHECK_EQUAL(static_cast<size_t>(0), offset);
+	CHECK_EQUAL(static_cast<size_t>(512), ring.Offset());
+
+	CHECK_EQUAL(static_cast<size_t>(1024), ring.GrownCapacity(600));
+	CHECK_EQUAL(static_cast<size_t>(2304), ring.GrownCapacity(2200));
+
+	// The replacement buffer starts empty and its first batch discards
+	ring.Reset(ring.GrownCapacity(600));
+	CHECK_EQUAL(static_cast<size_t>(0), ring.Offset());
+	CHECK(ring.Begin(1024));
+}
+
+// Over many frames of randomly sized batches no range is handed out twice between two discards, and NO_OVERWRITE
+// saves most of them
+TEST_CASE(RingAllocatorNeverReusesARangeTheGPUMayRead)
+{
+	int appendingDiscards = 0;
+	RenamedBuffer appending;
+	SimulateFrames(true, appendingDiscards, appending);
+	CHECK_EQUAL(0, appending.overlapCount);
+	CHECK_EQUAL(0, appending.outOfBoundsCount);
+
+	int discardingDiscards = 0;
+	RenamedBuffer discarding;
+	SimulateFrames(false, discardingDiscards, discarding);
+	CHECK_EQUAL(0, discarding.overlapCount);
+	CHECK_EQUAL(0, discarding.outOfBoundsCount);
+
+	CHECK(appendingDiscards < discardingDiscards);
+}
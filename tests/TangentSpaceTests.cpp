@@ -0,0 +1,331 @@
+#include "TestFramework.h"
+#include "TangentSpace.h"
+
+#include <cstring>
+#include <random>
+
+using DirectX::XMFLOAT4;
+
+namespace
+{
+	const TangentSpace::Implementation IMPLEMENTATIONS[] = { TangentSpace::Implementation::SCALAR, TangentSpace::Implementation::SSE, TangentSpace::Implementation::AVX };
+
+	const char* ImplementationName(TangentSpace::Implementation implementation)
+	{
+		switch (implementation)
+		{
+		case TangentSpace::Implementation::SSE:
+			return "SSE";
+		case TangentSpace::Implementation::AVX:
+			return "AVX";
+		default:
+			return "scalar";
+		}
+	}
+
+	// Puts back the implementation the process started with when a test is done switching between them
+	struct ImplementationScope
+	{
+		ImplementationScope() : saved(TangentSpace::GetImplementation()) {}
+		~ImplementationScope() { TangentSpace::SetImplementation(saved); }
+		TangentSpace::Implementation saved;
+	};
+
+	// Structure of arrays vertices with the storage for the streams
+	struct Vertices
+	{
+		std::vector<float> x, y, z, u, v, nx, ny, nz;
+
+		void Add(float px, float py, float pz, float tu, float tv, float normalX = 0.0f, float normalY = 1.0f, float normalZ = 0.0f)
+		{
+			x.push_back(px);
+			y.push_back(py);
+			z.push_back(pz);
+			u.push_back(tu);
+			v.push_back(tv);
+			nx.push_back(normalX);
+			ny.push_back(normalY);
+			nz.push_back(normalZ);
+		}
+
+		size_t Size() const { return x.size(); }
+
+		TangentSpace::VertexStreams Streams() const
+		{
+			return { x.data(), y.data(), z.data(), u.data(), v.data(), nx.data(), ny.data(), nz.data() };
+		}
+	};
+
+	// Face vectors with the storage for them
+	struct Faces
+	{
+		std::vector<float> data;
+		size_t count;
+
+		Faces(size_t triangleCount) : data(triangleCount * 6), count(triangleCount) {}
+
+		TangentSpace::FaceVectors Vectors()
+		{
+			float* base = data.data();
+			return { base, base + count, base + (count * 2), base + (count * 3), base + (count * 4), base + (count * 5) };
+		}
+	};
+
+	// A terrain-like grid of size x size vertices in the xz plane with a rolling height, u along x and v along z
+	void HeightGrid(int size, Vertices& vertices, std::vector<unsigned int>& indices)
+	{
+		std::mt19937 random(20);
+		std::uniform_real_distribution<float> height(0.0f, 0.5f);
+		for (int z = 0; z < size; ++z)
+			for (int x = 0; x < size; ++x)
+				vertices.Add(static_cast<float>(x), height(random), static_cast<float>(z), x / 32.0f, z / 32.0f);
+
+		for (int z = 0; z + 1 < size; ++z)
+		{
+			for (int x = 0; x + 1 < size; ++x)
+			{
+				unsigned int corner = static_cast<unsigned int>((z * size) + x);
+				unsigned int above = corner + static_cast<unsigned int>(size);
+				indices.insert(indices.end(), { corner, above, corner + 1, corner + 1, above, above + 1 });
+			}
+		}
+	}
+
+	bool Near(float expected, float actual)
+	{
+		return std::fabs(expected - actual) < 1e-5f;
+	}
+}
+
+// A triangle whose texture is mapped straight onto it: u runs along x and v along z
+TEST_CASE(FaceVectorsOfAMappedTriangle)
+{
+	ImplementationScope scope;
+
+	Vertices vertices;
+	vertices.Add(0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+	vertices.Add(0.0f, 0.0f, 2.0f, 0.0f, 1.0f);
+	vertices.Add(2.0f, 0.0f, 0.0f, 1.0f, 0.0f);
+	const unsigned int indices[] = { 0, 1, 2 };
+
+	for (TangentSpace::Implementation implementation : IMPLEMENTATIONS)
+	{
+		TangentSpace::SetImplementation(implementation);
+		Faces faces(1);
+		TangentSpace::CalculateFaceVectors(vertices.Streams(), indices, 0, 1, faces.Vectors());
+
+		CHECK(Near(1.0f, faces.data[0]));
+		CHECK(Near(0.0f, faces.data[1]));
+		CHECK(Near(0.0f, faces.data[2]));
+		CHECK(Near(0.0f, faces.data[3]));
+		CHECK(Near(0.0f, faces.data[4]));
+		CHECK(Near(1.0f, faces.data[5]));
+	}
+}
+
+// The vector paths have to give the scalar code's bits exactly, for full vectors and for the remainder, or the
+// cooked terrain and models would depend on the processor that cooked them
+TEST_CASE(FaceVectorsAreTheSameWithEveryImplementation)
+{
+	ImplementationScope scope;
+
+	std::mt19937 random(20);
+	std::uniform_real_distribution<float> coordinate(-10.0f, 10.0f);
+	Vertices vertices;
+	for (int iii = 0; iii < 500; ++iii)
+		vertices.Add(coordinate(random), coordinate(random), coordinate(random), coordinate(random), coordinate(random));
+
+	// 1003 triangles leave a remainder after both the 8 and the 4 wide loops
+	std::uniform_int_distribution<unsigned int> vertex(0, 499);
+	std::vector<unsigned int> indices(1003 * 3);
+	for (unsigned int& index : indices)
+		index = vertex(random);
+
+	Faces expected(1003);
+	TangentSpace::SetImplementation(TangentSpace::Implementation::SCALAR);
+	TangentSpace::CalculateFaceVectors(vertices.Streams(), indices.data(), 0, 1003, expected.Vectors());
+
+	for (TangentSpace::Implementation implementation : IMPLEMENTATIONS)
+	{
+		TangentSpace::SetImplementation(implementation);
+		if (TangentSpace::GetImplementation() != implementation)
+			continue;
+
+		// A range that does not start on a multiple of the vector width, the way the pool splits the triangles
+		Faces faces(1003);
+		TangentSpace::CalculateFaceVectors(vertices.Streams(), indices.data(), 0, 5, faces.Vectors());
+		TangentSpace::CalculateFaceVectors(vertices.Streams(), indices.data(), 5, 1003, faces.Vectors());
+		CHECK(std::memcmp(expected.data.data(), faces.data.data(), faces.data.size() * sizeof(float)) == 0);
+	}
+}
+
+// Every tangent is a unit vector in the plane of its vertex normal, and the result does not depend on how many
+// threads share the work
+TEST_CASE(GeneratedTangentsAreUnitAndOrthogonal)
+{
+	Vertices vertices;
+	std::vector<unsigned int> indices;
+	HeightGrid(65, vertices, indices);
+
+	// Tilt the normals so that the projection into their plane matters
+	for (size_t iii = 0; iii < vertices.Size(); ++iii)
+	{
+		float tilt = std::sin(static_cast<float>(iii)) * 0.3f;
+		float length = std::sqrt(1.0f + tilt * tilt);
+		vertices.nx[iii] = tilt / length;
+		vertices.ny[iii] = 1.0f / length;
+	}
+
+	ThreadPool single(1);
+	ThreadPool several(4);
+	std::vector<XMFLOAT4> tangents(vertices.Size());
+	std::vector<XMFLOAT4> threaded(vertices.Size());
+	TangentSpace::Generate(vertices.Streams(), vertices.Size(), indices.data(), indices.size(), tangents.data(), single);
+	TangentSpace::Generate(vertices.Streams(), vertices.Size(), indices.data(), indices.size(), threaded.data(), several);
+	CHECK(std::memcmp(tangents.data(), threaded.data(), tangents.size() * sizeof(XMFLOAT4)) == 0);
+
+	int badCount = 0;
+	for (size_t iii = 0; iii < tangents.size(); ++iii)
+	{
+		const XMFLOAT4& t = tangents[iii];
+		float length = std::sqrt(t.x * t.x + t.y * t.y + t.z * t.z);
+		float d = t.x * vertices.nx[iii] + t.y * vertices.ny[iii] + t.z * vertices.nz[iii];
+		if (!Near(1.0f, length) || std::fabs(d) > 1e-4f || t.w != tangents[0].w)
+			++badCount;
+	}
+	CHECK_EQUAL(0, badCount);
+}
+
+// Mirroring the texture flips the tangent and the handedness, and a vertex without usable texture coordinates
+// still gets a tangent in the plane of its normal
+TEST_CASE(GeneratedHandednessAndFallback)
+{
+	ThreadPool pool(1);
+	const unsigned int triangle[] = { 0, 1, 2 };
+
+	// u along x and v along z under a normal along y - the bitangent points away from cross(normal, tangent)
+	Vertices mapped;
+	mapped.Add(0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+	mapped.Add(0.0f, 0.0f, 1.0f, 0.0f, 1.0f);
+	mapped.Add(1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
+	XMFLOAT4 tangents[3];
+	TangentSpace::Generate(mapped.Streams(), 3, triangle, 3, tangents, pool);
+	for (const XMFLOAT4& tangent : tangents)
+	{
+		CHECK(Near(1.0f, tangent.x));
+		CHECK_EQUAL(-1.0f, tangent.w);
+	}
+
+	Vertices mirrored = mapped;
+	mirrored.u[2] = -1.0f;
+	TangentSpace::Generate(mirrored.Streams(), 3, triangle, 3, tangents, pool);
+	for (const XMFLOAT4& tangent : tangents)
+	{
+		CHECK(Near(-1.0f, tangent.x));
+		CHECK_EQUAL(1.0f, tangent.w);
+	}
+
+	// Every corner has the same texture coordinate
+	Vertices flat;
+	flat.Add(0.0f, 0.0f, 0.0f, 0.5f, 0.5f, 1.0f, 0.0f, 0.0f);
+	flat.Add(0.0f, 0.0f, 1.0f, 0.5f, 0.5f, 1.0f, 0.0f, 0.0f);
+	flat.Add(0.0f, 1.0f, 0.0f, 0.5f, 0.5f, 1.0f, 0.0f, 0.0f);
+	TangentSpace::Generate(flat.Streams(), 3, triangle, 3, tangents, pool);
+	for (const XMFLOAT4& tangent : tangents)
+	{
+		CHECK(Near(1.0f, std::sqrt(tangent.x * tangent.x + tangent.y * tangent.y + tangent.z * tangent.z)));
+		CHECK(Near(0.0f, tangent.x));
+	}
+}
+
+// Two triangles that share an edge, with the texture mirrored across it: the shared vertices are split so that
+// each side keeps its own handedness, while a quad mapped without a mirror keeps its 4 vertices
+TEST_CASE(GeneratedSplitsMirroredVertices)
+{
+	struct Vertex
+	{
+		DirectX::XMFLOAT3 position;
+		DirectX::XMFLOAT2 texture;
+		DirectX::XMFLOAT3 normal;
+		XMFLOAT4 tangent;
+	};
+	auto Quad = [](float u3, float v3)
+	{
+		const DirectX::XMFLOAT3 up(0.0f, 1.0f, 0.0f);
+		const XMFLOAT4 none(0.0f, 0.0f, 0.0f, 0.0f);
+		return std::vector<Vertex>{
+			{ { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f }, up, none },
+			{ { 0.0f, 0.0f, 1.0f }, { 0.0f, 1.0f }, up, none },
+			{ { 1.0f, 0.0f, 0.0f }, { 1.0f, 0.0f }, up, none },
+			{ { 1.0f, 0.0f, 1.0f }, { u3, v3 }, up, none }
+		};
+	};
+	ThreadPool pool(1);
+
+	std::vector<Vertex> mirrored = Quad(0.0f, 0.0f);
+	std::vector<unsigned int> indices = { 0, 1, 2, 2, 1, 3 };
+	TangentSpace::Generate(mirrored, indices, pool);
+	REQUIRE(mirrored.size() == 6);
+	const std::vector<unsigned int> split = { 0, 4, 5, 2, 1, 3 };
+	CHECK(indices == split);
+	CHECK_EQUAL(mirrored[1].position.z, mirrored[4].position.z);
+	CHECK_EQUAL(mirrored[2].position.x, mirrored[5].position.x);
+	for (unsigned int iii = 0; iii < 3; ++iii)
+	{
+		CHECK_EQUAL(mirrored[indices[0]].tangent.w, mirrored[indices[iii]].tangent.w);
+		CHECK_EQUAL(mirrored[indices[3]].tangent.w, mirrored[indices[3 + iii]].tangent.w);
+	}
+	CHECK(mirrored[indices[0]].tangent.w != mirrored[indices[3]].tangent.w);
+
+	std::vector<Vertex> mapped = Quad(1.0f, 1.0f);
+	indices = { 0, 1, 2, 2, 1, 3 };
+	TangentSpace::Generate(mapped, indices, pool);
+	CHECK_EQUAL(static_cast<size_t>(4), mapped.size());
+	CHECK_EQUAL(3u, indices[5]);
+}
+
+// The 1025x1025 grid of the terrain heightmap: the face kernel on one core with each implementation, then the
+// whole of Generate on one thread and on the default pool
+BENCHMARK(TangentSpaceTerrainGrid)
+{
+	ImplementationScope scope;
+
+	Vertices vertices;
+	std::vector<unsigned int> indices;
+	HeightGrid(1025, vertices, indices);
+	const size_t triangleCount = indices.size() / 3;
+	Faces faces(triangleCount);
+
+	printf("    %zu vertices, %zu triangles\n", vertices.Size(), triangleCount);
+	for (TangentSpace::Implementation implementation : IMPLEMENTATIONS)
+	{
+		TangentSpace::SetImplementation(implementation);
+		if (TangentSpace::GetImplementation() != implementation)
+		{
+			printf("    %-8s not supported by this processor\n", ImplementationName(implementation));
+			continue;
+		}
+
+		double seconds = Testing::BestTime(5, [&]()
+		{
+			TangentSpace::CalculateFaceVectors(vertices.Streams(), indices.data(), 0, triangleCount, faces.Vectors());
+		});
+		Testing::DoNotOptimize(faces.data.data());
+		printf("    %-8s  face vectors  %7.2f ms\n", ImplementationName(implementation), seconds * 1e3);
+	}
+
+	TangentSpace::SetImplementation(scope.saved);
+	std::vector<XMFLOAT4> tangents(vertices.Size());
+	ThreadPool single(1);
+	double singleSeconds = Testing::BestTime(3, [&]()
+	{
+		TangentSpace::Generate(vertices.Streams(), vertices.Size(), indices.data(), indices.size(), tangents.data(), single);
+	});
+	double poolSeconds = Testing::BestTime(3, [&]()
+	{
+		TangentSpace::Generate(vertices.Streams(), vertices.Size(), indices.data(), indices.size(), tangents.data(), ThreadPool::Default());
+	});
+	Testing::DoNotOptimize(tangents.data());
+	printf("    Generate  1 thread    %7.2f ms\n", singleSeconds * 1e3);
+	printf("    Generate  %2u threads  %7.2f ms\n", ThreadPool::Default().ThreadCount(), poolSeconds * 1e3);
+}
@@ -0,0 +1,285 @@
+#include "TestFramework.h"
+#include "TerrainBuilder.h"
+#include "TerrainLodPatterns.h"
+#include "TerrainTestData.h"
+#include "ThreadPool.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <mutex>
+
+using DirectX::XMFLOAT3;
+
+namespace
+{
+	// The bands TerrainBuilder hands out, put back together into the full terrain
+	struct BuiltTerrain
+	{
+		std::vector<float> heights;
+		std::vector<TerrainVertexType> vertices;
+		std::vector<int> rowWriteCounts;
+	};
+
+	// build is handed the writer to pass on to TerrainBuilder::Build
+	BuiltTerrain Collect(int width, int height, const std::function<void(const TerrainBuilder::BandWriter&)>& build)
+	{
+		BuiltTerrain terrain;
+		terrain.heights.resize(static_cast<size_t>(width) * height);
+		terrain.vertices.resize(static_cast<size_t>(width) * height);
+		terrain.rowWriteCounts.resize(height);
+
+		std::mutex countMutex;
+		build([&](int firstRow, int rowCount, const float* heights, const TerrainVertexType* vertices)
+		{
+			size_t first = static_cast<size_t>(width) * firstRow;
+			size_t count = static_cast<size_t>(width) * rowCount;
+			std::copy(heights, heights + count, terrain.heights.begin() + first);
+			std::copy(vertices, vertices + count, terrain.vertices.begin() + first);
+
+			std::lock_guard<std::mutex> lock(countMutex);
+			for (int row = firstRow; row < firstRow + rowCount; row++)
+				++terrain.rowWriteCounts[row];
+		});
+		return terrain;
+	}
+
+	BuiltTerrain Build(int width, int height, float heightScale, const std::vector<float>& rawHeights, const std::vector<XMFLOAT3>& colors, ThreadPool& pool)
+	{
+		TerrainBuilder builder(width, height, heightScale);
+		return Collect(width, height, [&](const TerrainBuilder::BandWriter& writer) { builder.Build(rawHeights, colors, pool, writer); });
+	}
+
+	std::vector<XMFLOAT3> RandomColors(int width, int height, unsigned int seed)
+	{
+		std::mt19937 random(seed);
+		std::uniform_int_distribution<int> channel(0, 255);
+
+		std::vector<XMFLOAT3> colors(static_cast<size_t>(width) * height);
+		for (XMFLOAT3& color : colors)
+			color = XMFLOAT3(channel(random) / 255.0f, channel(random) / 255.0f, channel(random) / 255.0f);
+		return colors;
+	}
+
+	bool SameVertex(const TerrainVertexType& a, const TerrainVertexType& b)
+	{
+		// Texture coordinates are left out on purpose - the expanded quads restarted them at 0 for every quad
+		return a.position.x == b.position.x && a.position.y == b.position.y && a.position.z == b.position.z &&
+			a.normal.x == b.normal.x && a.normal.y == b.normal.y && a.normal.z == b.normal.z &&
+			a.color.x == b.color.x && a.color.y == b.color.y && a.color.z == b.color.z;
+	}
+}
+
+// The terrain used to be drawn from TerrainMesh::BuildTerrainModel, which expanded every quad of the height map
+// into six separate vertices (upper left, upper right, bottom left, bottom left, upper right, bottom right) and
+// copied each cell's quads out of that array row by row. Drawing the shared vertices of a cell with the full
+// resolution index pattern must give exactly the same triangles in exactly the same order
+TEST_CASE(IndexedCellsDrawTheSameTrianglesAsExpandedQuads)
+{
+	const int terrainSize = 129;
+	const int cellSize = 33;
+	const int cellRowCount = (terrainSize - 1) / (cellSize - 1);
+
+	ThreadPool pool(3);
+	BuiltTerrain terrain = Build(terrainSize, terrainSize, 300.0f, TerrainTestData::RandomHeights(terrainSize, terrainSize, 1), RandomColors(terrainSize, terrainSize, 2), pool);
+	const std::vector<TerrainVertexType>& vertices = terrain.vertices;
+	REQUIRE(vertices.size() == static_cast<size_t>(terrainSize) * terrainSize);
+
+	// The old expanded model - six vertices per quad
+	std::vector<TerrainVertexType> model;
+	model.reserve(static_cast<size_t>(terrainSize - 1) * (terrainSize - 1) * 6);
+	for (int j = 0; j < terrainSize - 1; j++)
+	{
+		for (int i = 0; i < terrainSize - 1; i++)
+		{
+			size_t upperLeft = (static_cast<size_t>(terrainSize) * j) + i;
+			size_t upperRight = upperLeft + 1;
+			size_t bottomLeft = upperLeft + terrainSize;
+			size_t bottomRight = bottomLeft + 1;
+
+			for (size_t index : { upperLeft, upperRight, bottomLeft, bottomLeft, upperRight, bottomRight })
+				model.push_back(vertices[index]);
+		}
+	}
+
+	TerrainLodPatterns patterns(cellSize);
+	TerrainLodPatterns::PatternRange fullResolution = patterns.GetPattern(0, 0);
+	const unsigned int* indices = patterns.GetIndices().data() + fullResolution.startIndex;
+	CHECK_EQUAL(static_cast<unsigned int>((cellSize - 1) * (cellSize - 1) * 6), fullResolution.indexCount);
+
+	int mismatchCount = 0;
+	for (int cellY = 0; cellY < cellRowCount; cellY++)
+	{
+		for (int cellX = 0; cellX < cellRowCount; cellX++)
+		{
+			// The cell's own block of shared vertices, as TerrainCellMesh copies it
+			std::vector<TerrainVertexType> cellVertices;
+			size_t terrainIndex = (static_cast<size_t>(cellX) * (cellSize - 1)) + (static_cast<size_t>(cellY) * (cellSize - 1) * terrainSize);
+			for (int row = 0; row < cellSize; row++, terrainIndex += terrainSize)
+				cellVertices.insert(cellVertices.end(), vertices.begin() + terrainIndex, vertices.begin() + terrainIndex + cellSize);
+
+			// The cell's quads of the expanded model, as the old TerrainCellMesh copied them
+			size_t modelIndex = ((static_cast<size_t>(cellX) * (cellSize - 1)) + (static_cast<size_t>(cellY) * (cellSize - 1) * (terrainSize - 1))) * 6;
+			size_t patternIndex = 0;
+			for (int row = 0; row < cellSize - 1; row++, modelIndex += static_cast<size_t>(terrainSize - 1) * 6)
+			{
+				for (size_t vertex = 0; vertex < static_cast<size_t>(cellSize - 1) * 6; vertex++, patternIndex++)
+				{
+					if (!SameVertex(model[modelIndex + vertex], cellVertices[indices[patternIndex]]))
+						++mismatchCount;
+				}
+			}
+		}
+	}
+
+	CHECK_EQUAL(0, mismatchCount);
+}
+
+// Every sample is one vertex and the vertex of sample (i, j) sits at x = i, z = (height - 1) - j
+TEST_CASE(OneSharedVertexPerSample)
+{
+	const int width = 65;
+	const int height = 33;
+	const float heightScale = 4.0f;
+
+	std::vector<float> heights = TerrainTestData::RandomHeights(width, height, 3);
+
+	ThreadPool pool(2);
+	BuiltTerrain terrain = Build(width, height, heightScale, heights, {}, pool);
+	const std::vector<TerrainVertexType>& vertices = terrain.vertices;
+
+	int mismatchCount = 0;
+	for (int j = 0; j < height; j++)
+	{
+		for (int i = 0; i < width; i++)
+		{
+			const TerrainVertexType& vertex = vertices[(static_cast<size_t>(width) * j) + i];
+			float expectedHeight = heights[(static_cast<size_t>(width) * j) + i] / heightScale;
+
+			if (vertex.position.x != static_cast<float>(i) || vertex.position.z != static_cast<float>(height - 1 - j) ||
+				vertex.position.y != expectedHeight || terrain.heights[(static_cast<size_t>(width) * j) + i] != expectedHeight ||
+				vertex.color.x != 1.0f || vertex.color.y != 1.0f || vertex.color.z != 1.0f)
+				++mismatchCount;
+		}
+	}
+
+	CHECK_EQUAL(0, mismatchCount);
+}
+
+// Each band recomputes the faces along its edges from the vertex rows either side of it. The normals must come
+// out exactly as one serial pass over the whole terrain gives them - summed over the faces touching each vertex
+// in the same order - and every row must reach the writer exactly once
+TEST_CASE(BandsGiveTheSameNormalsAsOneSerialPass)
+{
+	// 77 rows is not a multiple of the band size, so the last band is a short one
+	const int width = 50;
+	const int height = 77;
+
+	ThreadPool pool(4);
+	BuiltTerrain terrain = Build(width, height, 300.0f, TerrainTestData::RandomHeights(width, height, 4), {}, pool);
+
+	int badRowCount = 0;
+	for (int count : terrain.rowWriteCounts)
+		badRowCount += count == 1 ? 0 : 1;
+	CHECK_EQUAL(0, badRowCount);
+
+	auto Position = [&terrain, width](int i, int j) { return terrain.vertices[(static_cast<size_t>(width) * j) + i].position; };
+
+	// Normal of the quad whose upper left vertex is (i, j), worked out the way the old CalculateNormals did
+	std::vector<XMFLOAT3> faceNormals(static_cast<size_t>(width - 1) * (height - 1));
+	for (int j = 0; j < height - 1; j++)
+	{
+		for (int i = 0; i < width - 1; i++)
+		{
+			XMFLOAT3 vertex1 = Position(i, j + 1);
+			XMFLOAT3 vertex2 = Position(i + 1, j + 1);
+			XMFLOAT3 vertex3 = Position(i, j);
+			float vector1[3] = { vertex1.x - vertex3.x, vertex1.y - vertex3.y, vertex1.z - vertex3.z };
+			float vector2[3] = { vertex3.x - vertex2.x, vertex3.y - vertex2.y, vertex3.z - vertex2.z };
+
+			XMFLOAT3 normal((vector1[1] * vector2[2]) - (vector1[2] * vector2[1]),
+				(vector1[2] * vector2[0]) - (vector1[0] * vector2[2]),
+				(vector1[0] * vector2[1]) - (vector1[1] * vector2[0]));
+			float length = std::sqrt((normal.x * normal.x) + (normal.y * normal.y) + (normal.z * normal.z));
+			faceNormals[(static_cast<size_t>(width - 1) * j) + i] = XMFLOAT3(normal.x / length, normal.y / length, normal.z / length);
+		}
+	}
+
+	int mismatchCount = 0;
+	for (int j = 0; j < height; j++)
+	{
+		for (int i = 0; i < width; i++)
+		{
+			// Bottom left, bottom right, upper left and upper right faces
+			float sum[3] = { 0.0f, 0.0f, 0.0f };
+			int faces[4][2] = { { i - 1, j - 1 }, { i, j - 1 }, { i - 1, j }, { i, j } };
+			for (const auto& face : faces)
+			{
+				if (face[0] < 0 || face[0] >= width - 1 || face[1] < 0 || face[1] >= height - 1)
+					continue;
+
+				const XMFLOAT3& normal = faceNormals[(static_cast<size_t>(width - 1) * face[1]) + face[0]];
+				sum[0] += normal.x;
+				sum[1] += normal.y;
+				sum[2] += normal.z;
+			}
+
+			float length = std::sqrt((sum[0] * sum[0]) + (sum[1] * sum[1]) + (sum[2] * sum[2]));
+			const XMFLOAT3& normal = terrain.vertices[(static_cast<size_t>(width) * j) + i].normal;
+			if (std::abs(normal.x - (sum[0] / length)) > 1e-6f || std::abs(normal.y - (sum[1] / length)) > 1e-6f || std::abs(normal.z - (sum[2] / length)) > 1e-6f)
+				++mismatchCount;
+		}
+	}
+
+	CHECK_EQUAL(0, mismatchCount);
+}
+
+// Reading the heights and colors band by band out of the mapped RAW and bitmap files has to build exactly the
+// terrain the in-memory arrays build. The width makes every bitmap row end in padding
+TEST_CASE(MappedFilesBuildTheSameTerrainAsArrays)
+{
+	const int width = 67;
+	const int height = 45;
+	const std::string rawFilename = (std::filesystem::temp_directory_path() / "chameleon-tests-mapped.r16").string();
+	const std::string colorFilename = (std::filesystem::temp_directory_path() / "chameleon-tests-mapped.bmp").string();
+
+	std::vector<float> rawHeights = TerrainTestData::RandomHeights(width, height, 7);
+	{
+		std::vector<uint16_t> samples(rawHeights.begin(), rawHeights.end());
+		std::ofstream file(rawFilename, std::ios::binary);
+		file.write(reinterpret_cast<const char*>(samples.data()), samples.size() * sizeof(uint16_t));
+	}
+
+	auto color = [](int i, int j) { return XMFLOAT3(((i * 7) % 256) / 255.0f, ((j * 5) % 256) / 255.0f, (((i + j) * 3) % 256) / 255.0f); };
+	std::vector<XMFLOAT3> colors;
+	for (int j = 0; j < height; j++)
+		for (int i = 0; i < width; i++)
+			colors.push_back(color(i, j));
+	TerrainTestData::WriteColorMap(colorFilename, width, height, color);
+
+	ThreadPool pool(3);
+	BuiltTerrain expected = Build(width, height, 300.0f, rawHeights, colors, pool);
+	BuiltTerrain mapped;
+	{
+		RawHeightMap heightMap(rawFilename, width, height);
+		BitmapColorMap colorMap(colorFilename, width, height);
+		TerrainBuilder builder(width, height, 300.0f);
+		mapped = Collect(width, height, [&](const TerrainBuilder::BandWriter& writer) { builder.Build(heightMap, &colorMap, pool, writer); });
+	}
+
+	CHECK(expected.heights == mapped.heights);
+	int badCount = 0;
+	for (size_t iii = 0; iii < expected.vertices.size(); ++iii)
+	{
+		if (std::memcmp(&expected.vertices[iii], &mapped.vertices[iii], sizeof(TerrainVertexType)) != 0)
+			++badCount;
+	}
+	CHECK_EQUAL(0, badCount);
+
+	// A color map of the wrong size is refused
+	CHECK_THROWS(BitmapColorMap(colorFilename, width + 1, height));
+
+	std::filesystem::remove(rawFilename);
+	std::filesystem::remove(colorFilename);
+}
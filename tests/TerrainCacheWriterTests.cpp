@@ -0,0 +1,260 @@
+#include "TestFramework.h"
+#include "TerrainCacheWriter.h"
+#include "TerrainCache.h"
+#include "TerrainBuilder.h"
+#include "TerrainLodPatterns.h"
+#include "TerrainTestData.h"
+#include "RawHeightMap.h"
+#include "BitmapColorMap.h"
+#include "ThreadPool.h"
+
+#include <psapi.h>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <thread>
+
+namespace
+{
+	TerrainCacheKey TestKey(int terrainSize, int cellSize)
+	{
+		TerrainCacheKey key;
+		ZeroMemory(&key, sizeof(TerrainCacheKey));
+		key.heightMapHash = 1;
+		key.colorMapHash = 2;
+		key.terrainWidth = terrainSize;
+		key.terrainHeight = terrainSize;
+		key.cellWidth = cellSize;
+		key.cellHeight = cellSize;
+		key.heightScale = 300.0f;
+		return key;
+	}
+
+	std::string TemporaryFilename(const char* name)
+	{
+		return (std::filesystem::temp_directory_path() / name).string();
+	}
+
+	size_t WorkingSetSize()
+	{
+		PROCESS_MEMORY_COUNTERS counters = {};
+		counters.cb = sizeof(PROCESS_MEMORY_COUNTERS);
+		GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(PROCESS_MEMORY_COUNTERS));
+		return counters.WorkingSetSize;
+	}
+
+	size_t PeakWorkingSetSize()
+	{
+		PROCESS_MEMORY_COUNTERS counters = {};
+		counters.cb = sizeof(PROCESS_MEMORY_COUNTERS);
+		GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(PROCESS_MEMORY_COUNTERS));
+		return counters.PeakWorkingSetSize;
+	}
+}
+
+// Cooking band by band into the mapped file must give the same heights, cell vertices and bounds as building the
+// whole terrain in memory and cutting it into cells afterwards
+TEST_CASE(CookedBandsMatchTheTerrainBuiltInMemory)
+{
+	const int terrainSize = 129;
+	const int cellSize = 33;
+	const int cellRowCount = (terrainSize - 1) / (cellSize - 1);
+	const TerrainCacheKey key = TestKey(terrainSize, cellSize);
+	const std::string filename = TemporaryFilename("chameleon-tests-terrain.cooked");
+
+	std::vector<float> rawHeights = TerrainTestData::RandomHeights(terrainSize, terrainSize, 5);
+	TerrainLodPatterns patterns(cellSize);
+	ThreadPool pool(3);
+
+	// The reference - every band collected into one array
+	std::vector<float> heights(static_cast<size_t>(terrainSize) * terrainSize);
+	std::vector<TerrainVertexType> vertices(static_cast<size_t>(terrainSize) * terrainSize);
+	{
+		TerrainBuilder builder(terrainSize, terrainSize, key.heightScale);
+		builder.Build(rawHeights, {}, pool, [&](int firstRow, int rowCount, const float* bandHeights, const TerrainVertexType* bandVertices)
+		{
+			size_t first = static_cast<size_t>(terrainSize) * firstRow;
+			size_t count = static_cast<size_t>(terrainSize) * rowCount;
+			std::copy(bandHeights, bandHeights + count, heights.begin() + first);
+			std::copy(bandVertices, bandVertices + count, vertices.begin() + first);
+		});
+	}
+
+	{
+		TerrainCacheWriter writer(filename, key, cellRowCount, patterns.GetIndices());
+		TerrainBuilder builder(terrainSize, terrainSize, key.heightScale);
+		builder.Build(rawHeights, {}, pool, [&writer](int firstRow, int rowCount, const float* bandHeights, const TerrainVertexType* bandVertices)
+		{
+			writer.WriteBand(firstRow, rowCount, bandHeights, bandVertices);
+		});
+		writer.Commit();
+	}
+
+	CHECK(!std::filesystem::exists(filename + ".tmp"));
+
+	{
+		TerrainCache cache(filename);
+		REQUIRE(cache.Matches(key));
+		CHECK_EQUAL(cellRowCount, cache.CellRowCount());
+		CHECK_EQUAL(static_cast<int>(patterns.GetIndices().size()), cache.IndexCount());
+		CHECK(memcmp(patterns.GetIndices().data(), cache.GetIndices(), patterns.GetIndices().size() * sizeof(unsigned int)) == 0);
+		CHECK(memcmp(heights.data(), cache.GetHeights(), heights.size() * sizeof(float)) == 0);
+
+		HeightField heightField(terrainSize, terrainSize);
+		for (int j = 0; j < terrainSize; j++)
+			heightField.SetRow(j, heights.data() + (static_cast<size_t>(terrainSize) * j));
+		std::vector<TerrainCellBounds> bounds = TerrainTestData::CalculateCellBounds(heightField, cellSize);
+		CHECK(memcmp(bounds.data(), cache.GetCellBounds(), bounds.size() * sizeof(TerrainCellBounds)) == 0);
+
+		int mismatchCount = 0;
+		for (int cellY = 0; cellY < cellRowCount; cellY++)
+		{
+			for (int cellX = 0; cellX < cellRowCount; cellX++)
+			{
+				const TerrainVertexType* cellVertices = cache.GetCellVertices((cellRowCount * cellY) + cellX);
+				for (int row = 0; row < cellSize; row++)
+				{
+					size_t terrainIndex = (static_cast<size_t>(terrainSize) * ((cellY * (cellSize - 1)) + row)) + (static_cast<size_t>(cellX) * (cellSize - 1));
+					if (memcmp(vertices.data() + terrainIndex, cellVertices + (static_cast<size_t>(cellSize) * row), cellSize * sizeof(TerrainVertexType)) != 0)
+						++mismatchCount;
+				}
+			}
+		}
+		CHECK_EQUAL(0, mismatchCount);
+	}
+
+	std::filesystem::remove(filename);
+}
+
+// A cook that never reaches Commit (the build threw, the process is shutting down) leaves nothing behind
+TEST_CASE(UncommittedCookLeavesNoFile)
+{
+	const TerrainCacheKey key = TestKey(65, 33);
+	const std::string filename = TemporaryFilename("chameleon-tests-uncommitted.cooked");
+	std::filesystem::remove(filename);
+
+	{
+		TerrainCacheWriter writer(filename, key, 2, TerrainLodPatterns(33).GetIndices());
+		CHECK(std::filesystem::exists(filename + ".tmp"));
+	}
+
+	CHECK(!std::filesystem::exists(filename + ".tmp"));
+	CHECK(!std::filesystem::exists(filename));
+}
+
+// Cooks a 2049 x 2049 terrain (a cooked file of about 300 MB) from a RAW file the way TerrainMesh does and
+// samples the working set as every band is written. Neither the whole vertex array nor the whole height field
+// may ever be resident - the growth has to stay well below the size of the vertex array alone
+BENCHMARK(CookTerrainWorkingSet)
+{
+	const int terrainSize = 2049;
+	const int cellSize = 33;
+	const int cellRowCount = (terrainSize - 1) / (cellSize - 1);
+	const TerrainCacheKey key = TestKey(terrainSize, cellSize);
+	const std::string rawFilename = TemporaryFilename("chameleon-tests-stress.r16");
+	const std::string cookedFilename = TemporaryFilename("chameleon-tests-stress.cooked");
+
+	{
+		std::mt19937 random(6);
+		std::uniform_int_distribution<int> sample(0, 65535);
+		std::vector<uint16_t> samples(static_cast<size_t>(terrainSize) * terrainSize);
+		for (uint16_t& value : samples)
+			value = static_cast<uint16_t>(sample(random));
+
+		std::ofstream file(rawFilename, std::ios::binary);
+		file.write(reinterpret_cast<const char*>(samples.data()), samples.size() * sizeof(uint16_t));
+	}
+
+	ThreadPool pool(std::max(std::thread::hardware_concurrency(), 2u) - 1);
+	TerrainLodPatterns patterns(cellSize);
+	size_t before = WorkingSetSize();
+	std::atomic<size_t> largest(before);
+
+	double seconds = Testing::Time([&]()
+	{
+		RawHeightMap heightMap(rawFilename, terrainSize, terrainSize);
+		TerrainCacheWriter writer(cookedFilename, key, cellRowCount, patterns.GetIndices());
+		TerrainBuilder builder(terrainSize, terrainSize, key.heightScale);
+		builder.Build(heightMap, {}, pool, [&writer, &largest](int firstRow, int rowCount, const float* heights, const TerrainVertexType* vertices)
+		{
+			writer.WriteBand(firstRow, rowCount, heights, vertices);
+
+			size_t current = WorkingSetSize();
+			size_t seen = largest.load();
+			while (current > seen && !largest.compare_exchange_weak(seen, current))
+			{
+			}
+		});
+		writer.Commit();
+	});
+
+	size_t vertexArraySize = static_cast<size_t>(terrainSize) * terrainSize * sizeof(TerrainVertexType);
+	size_t growth = largest.load() - before;
+	CHECK(growth < vertexArraySize / 4);
+
+	printf("    %d x %d cooked in %.2f s\n", terrainSize, terrainSize, seconds);
+	printf("    vertex array:        %8.1f MB\n", vertexArraySize / (1024.0 * 1024.0));
+	printf("    working set growth:  %8.1f MB\n", growth / (1024.0 * 1024.0));
+	printf("    peak working set:    %8.1f MB\n", PeakWorkingSetSize() / (1024.0 * 1024.0));
+
+	std::filesystem::remove(rawFilename);
+	std::filesystem::remove(cookedFilename);
+}
+
+// Builds an 8193 x 8193 terrain from a RAW height map and a bitmap color map the way TerrainMesh cooks it, but
+// hands every band to a writer that only samples the working set, so no cooked file (of over 4 GB) is written.
+// The vertex array alone would be over 4 GB and a copy of the colors 768 MB - the working set growth has to stay
+// well below even the colors. The pool is kept to 8 threads so that the bands in flight stay small next to that
+BENCHMARK(BuildLargeTerrainWorkingSet)
+{
+	const int terrainSize = 8193;
+	const std::string rawFilename = TemporaryFilename("chameleon-tests-large.r16");
+	const std::string colorFilename = TemporaryFilename("chameleon-tests-large.bmp");
+
+	// Both files are written a row at a time, so the peak working set is the build's
+	TerrainTestData::WriteRandomHeightMap(rawFilename, terrainSize, terrainSize, 8);
+	TerrainTestData::WriteColorMap(colorFilename, terrainSize, terrainSize, [](int i, int j)
+	{
+		return DirectX::XMFLOAT3((i % 256) / 255.0f, (j % 256) / 255.0f, ((i ^ j) % 256) / 255.0f);
+	});
+
+	ThreadPool pool(std::min(std::max(std::thread::hardware_concurrency(), 2u), 8u) - 1);
+	size_t before = WorkingSetSize();
+	std::atomic<size_t> largest(before);
+	std::atomic<int> rowCount(0);
+
+	double seconds = Testing::Time([&]()
+	{
+		RawHeightMap heightMap(rawFilename, terrainSize, terrainSize);
+		BitmapColorMap colorMap(colorFilename, terrainSize, terrainSize);
+		TerrainBuilder builder(terrainSize, terrainSize, 300.0f);
+		builder.Build(heightMap, &colorMap, pool, [&largest, &rowCount](int firstRow, int bandRowCount, const float* heights, const TerrainVertexType* vertices)
+		{
+			Testing::DoNotOptimize(heights);
+			Testing::DoNotOptimize(vertices);
+			rowCount += bandRowCount;
+
+			size_t current = WorkingSetSize();
+			size_t seen = largest.load();
+			while (current > seen && !largest.compare_exchange_weak(seen, current))
+			{
+			}
+		});
+	});
+
+	size_t vertexArraySize = static_cast<size_t>(terrainSize) * terrainSize * sizeof(TerrainVertexType);
+	size_t colorArraySize = static_cast<size_t>(terrainSize) * terrainSize * sizeof(DirectX::XMFLOAT3);
+	size_t growth = largest.load() - before;
+	CHECK_EQUAL(terrainSize, rowCount.load());
+	CHECK(growth < colorArraySize / 2);
+
+	printf("    %d x %d built in %.2f s (%u threads)\n", terrainSize, terrainSize, seconds, pool.ThreadCount() + 1);
+	printf("    vertex array:        %8.1f MB\n", vertexArraySize / (1024.0 * 1024.0));
+	printf("    color array:         %8.1f MB\n", colorArraySize / (1024.0 * 1024.0));
+	printf("    working set growth:  %8.1f MB\n", growth / (1024.0 * 1024.0));
+	printf("    peak working set:    %8.1f MB\n", PeakWorkingSetSize() / (1024.0 * 1024.0));
+
+	std::filesystem::remove(rawFilename);
+	std::filesystem::remove(colorFilename);
+}
@@ -0,0 +1,195 @@
+#include "TestFramework.h"
+#include "TerrainCellStreamer.h"
+#include "TerrainTestData.h"
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <memory>
+
+using DirectX::XMFLOAT3;
+
+namespace
+{
+	const int TERRAIN_SIZE = 1025;
+	const int CELL_SIZE = 33;
+	const int CELL_ROW_COUNT = (TERRAIN_SIZE - 1) / (CELL_SIZE - 1);
+	const size_t BYTES_PER_CELL = 1000;
+
+	// Stands in for TerrainMesh/Terrain - keeps track of which cells are loaded and counts everything that
+	// should never happen (a cell loaded twice, a cell unloaded or handed over that was never loaded)
+	struct ScriptedTerrain
+	{
+		ScriptedTerrain(const TerrainStreamingSettings& settings, ThreadPool& pool) :
+			loaded(static_cast<size_t>(CELL_ROW_COUNT) * CELL_ROW_COUNT),
+			loadCount(0),
+			unloadCount(0),
+			errorCount(0)
+		{
+			HeightField flat(TERRAIN_SIZE, TERRAIN_SIZE);
+			bounds = TerrainTestData::CalculateCellBounds(flat, CELL_SIZE);
+
+			streamer = std::make_unique<TerrainCellStreamer>(bounds, CELL_ROW_COUNT, BYTES_PER_CELL, settings, pool,
+				[this](int cellIndex)
+				{
+					++loadCount;
+					if (loaded[cellIndex].exchange(1) != 0)
+						++errorCount;
+				},
+				[this](int cellIndex)
+				{
+					if (loaded[cellIndex].load() != 1)
+						++errorCount;
+				},
+				[this](int cellIndex)
+				{
+					++unloadCount;
+					if (loaded[cellIndex].exchange(0) != 1)
+						++errorCount;
+				});
+		}
+
+		// Updates until the streamer stops queueing loads for this position - a few frames in the game
+		void Settle(XMFLOAT3 position, XMFLOAT3 velocity)
+		{
+			for (int iii = 0; iii < 64; ++iii)
+			{
+				streamer->Update(position, velocity);
+				bool queued = streamer->PendingLoadCount() != 0;
+				streamer->WaitForPendingLoads();
+				if (!queued)
+					return;
+			}
+		}
+
+		int LoadedCount()
+		{
+			int count = 0;
+			for (const std::atomic<int>& cell : loaded)
+				count += cell.load();
+			return count;
+		}
+
+		// Cells within radius of the point (in x/z) that are not loaded
+		int MissingCellCount(XMFLOAT3 position, float radius)
+		{
+			int missingCount = 0;
+			for (size_t iii = 0; iii < bounds.size(); ++iii)
+			{
+				float dx = std::max(std::max(bounds[iii].minX - position.x, position.x - bounds[iii].maxX), 0.0f);
+				float dz = std::max(std::max(bounds[iii].minZ - position.z, position.z - bounds[iii].maxZ), 0.0f);
+				if (std::sqrt((dx * dx) + (dz * dz)) <= radius && loaded[iii].load() == 0)
+					++missingCount;
+			}
+			return missingCount;
+		}
+
+		std::vector<TerrainCellBounds> bounds;
+		std::vector<std::atomic<int>> loaded;
+		std::atomic<int> loadCount;
+		int unloadCount;
+		std::atomic<int> errorCount;
+		std::unique_ptr<TerrainCellStreamer> streamer;
+	};
+
+	TerrainStreamingSettings Settings(float loadRadius, size_t cellBudget)
+	{
+		TerrainStreamingSettings settings;
+		settings.loadRadius = loadRadius;
+		settings.hysteresis = 64.0f;
+		settings.prefetchTime = 2.0f;
+		settings.memoryBudget = cellBudget * BYTES_PER_CELL;
+		settings.maxPendingLoads = 8;
+		return settings;
+	}
+}
+
+// Flies the camera loop the culling benchmarks use over the terrain at 60 frames per second. Once the streamer
+// has settled at each pose, every cell within the load radius is loaded, the loaded cells fit the budget, and no
+// cell was ever loaded twice or unloaded without being loaded
+TEST_CASE(StreamerFollowsTheCameraPath)
+{
+	ThreadPool pool(3);
+	TerrainStreamingSettings settings = Settings(192.0f, 400);
+	ScriptedTerrain terrain(settings, pool);
+
+	std::vector<TerrainTestData::CameraPose> path = TerrainTestData::CameraLoop(300, static_cast<float>(TERRAIN_SIZE - 1), 50.0f);
+	int missingCount = 0;
+	int overBudgetCount = 0;
+
+	for (size_t pose = 0; pose + 1 < path.size(); ++pose)
+	{
+		XMFLOAT3 position = path[pose].eye;
+		XMFLOAT3 next = path[pose + 1].eye;
+		XMFLOAT3 velocity((next.x - position.x) * 60.0f, 0.0f, (next.z - position.z) * 60.0f);
+
+		terrain.Settle(position, velocity);
+
+		missingCount += terrain.MissingCellCount(position, settings.loadRadius);
+		if (terrain.streamer->ResidentMemory() > settings.memoryBudget)
+			++overBudgetCount;
+		if (terrain.LoadedCount() != static_cast<int>(terrain.streamer->GetResidentCells().size()))
+			++overBudgetCount;
+	}
+
+	CHECK_EQUAL(0, missingCount);
+	CHECK_EQUAL(0, overBudgetCount);
+	CHECK_EQUAL(0, terrain.errorCount.load());
+
+	// Moving along the path has to evict the cells that were left behind
+	CHECK(terrain.unloadCount > 0);
+	CHECK(terrain.LoadedCount() <= terrain.streamer->CellCapacity());
+}
+
+// Standing on a cell corner and shuffling back and forth across it must not load or evict anything once the
+// cells around the player have been loaded - the hysteresis keeps the cells on the edge of the ring
+TEST_CASE(StreamerDoesNotThrashOnACellBoundary)
+{
+	ThreadPool pool(2);
+	ScriptedTerrain terrain(Settings(160.0f, 400), pool);
+
+	// Each side of the corner has a few cells at the edge of its ring that the other side does not - once both
+	// sides have been visited they all stay loaded
+	XMFLOAT3 corner(512.0f, 50.0f, 512.0f);
+	terrain.Settle(XMFLOAT3(corner.x + 3.0f, corner.y, corner.z + 3.0f), XMFLOAT3(0.0f, 0.0f, 0.0f));
+	terrain.Settle(XMFLOAT3(corner.x - 3.0f, corner.y, corner.z - 3.0f), XMFLOAT3(0.0f, 0.0f, 0.0f));
+	int loadCount = terrain.loadCount.load();
+	int unloadCount = terrain.unloadCount;
+
+	for (int step = 0; step < 200; ++step)
+	{
+		float offset = (step % 2 == 0) ? 3.0f : -3.0f;
+		XMFLOAT3 position(corner.x + offset, corner.y, corner.z + offset);
+		terrain.Settle(position, XMFLOAT3(0.0f, 0.0f, 0.0f));
+	}
+
+	CHECK_EQUAL(loadCount, terrain.loadCount.load());
+	CHECK_EQUAL(unloadCount, terrain.unloadCount);
+	CHECK_EQUAL(0, terrain.errorCount.load());
+}
+
+// With a budget far smaller than the load radius asks for, the closest cells win and the budget is never exceeded
+TEST_CASE(StreamerKeepsTheClosestCellsWithinBudget)
+{
+	ThreadPool pool(2);
+	TerrainStreamingSettings settings = Settings(512.0f, 24);
+	ScriptedTerrain terrain(settings, pool);
+
+	std::vector<TerrainTestData::CameraPose> path = TerrainTestData::CameraLoop(120, static_cast<float>(TERRAIN_SIZE - 1), 50.0f);
+	int overBudgetCount = 0;
+	int missingCount = 0;
+
+	for (const TerrainTestData::CameraPose& pose : path)
+	{
+		terrain.Settle(pose.eye, XMFLOAT3(0.0f, 0.0f, 0.0f));
+
+		if (terrain.LoadedCount() > 24)
+			++overBudgetCount;
+
+		// The cell under the player and its direct neighbours are always among the closest 24
+		missingCount += terrain.MissingCellCount(pose.eye, 1.0f);
+	}
+
+	CHECK_EQUAL(0, overBudgetCount);
+	CHECK_EQUAL(0, missingCount);
+	CHECK_EQUAL(0, terrain.errorCount.load());
+}
@@ -0,0 +1,265 @@
+#include "TestFramework.h"
+#include "TerrainLodPatterns.h"
+#include "TerrainLodSelector.h"
+#include "TerrainTestData.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <utility>
+
+using DirectX::XMFLOAT3;
+
+namespace
+{
+	const int CELL_SIZE = 33;
+	const int SIDES[4] = { TerrainLodPatterns::STITCH_TOP, TerrainLodPatterns::STITCH_RIGHT, TerrainLodPatterns::STITCH_BOTTOM, TerrainLodPatterns::STITCH_LEFT };
+
+	int OppositeSide(int side)
+	{
+		switch (side)
+		{
+		case TerrainLodPatterns::STITCH_TOP:	return TerrainLodPatterns::STITCH_BOTTOM;
+		case TerrainLodPatterns::STITCH_RIGHT:	return TerrainLodPatterns::STITCH_LEFT;
+		case TerrainLodPatterns::STITCH_BOTTOM:	return TerrainLodPatterns::STITCH_TOP;
+		default:								return TerrainLodPatterns::STITCH_RIGHT;
+		}
+	}
+
+	// The segments that make up one side of a cell drawn with a pattern, as (from, to) positions along that side
+	// (i for the top and bottom, j for the left and right). A segment is a triangle edge that lies on the side and
+	// belongs to exactly one triangle - two cells drawn next to each other only meet without a crack or a
+	// T-junction if their segments along the shared side are the same
+	std::vector<std::pair<int, int>> SideSegments(const TerrainLodPatterns& patterns, int level, int stitchMask, int side)
+	{
+		int last = CELL_SIZE - 1;
+		TerrainLodPatterns::PatternRange range = patterns.GetPattern(level, stitchMask);
+		const unsigned int* indices = patterns.GetIndices().data() + range.startIndex;
+
+		auto OnSide = [side, last](int i, int j)
+		{
+			return (side == TerrainLodPatterns::STITCH_TOP && j == 0) || (side == TerrainLodPatterns::STITCH_BOTTOM && j == last) ||
+				(side == TerrainLodPatterns::STITCH_LEFT && i == 0) || (side == TerrainLodPatterns::STITCH_RIGHT && i == last);
+		};
+		auto Along = [side](int i, int j) { return (side == TerrainLodPatterns::STITCH_TOP || side == TerrainLodPatterns::STITCH_BOTTOM) ? i : j; };
+
+		std::map<std::pair<int, int>, int> edgeCounts;
+		for (unsigned int triangle = 0; triangle < range.indexCount; triangle += 3)
+		{
+			for (int edge = 0; edge < 3; edge++)
+			{
+				unsigned int a = indices[triangle + edge];
+				unsigned int b = indices[triangle + ((edge + 1) % 3)];
+				int ai = a % CELL_SIZE, aj = a / CELL_SIZE;
+				int bi = b % CELL_SIZE, bj = b / CELL_SIZE;
+				if (!OnSide(ai, aj) || !OnSide(bi, bj))
+					continue;
+
+				int from = std::min(Along(ai, aj), Along(bi, bj));
+				int to = std::max(Along(ai, aj), Along(bi, bj));
+				++edgeCounts[{ from, to }];
+			}
+		}
+
+		std::vector<std::pair<int, int>> segments;
+		for (const auto& edge : edgeCounts)
+		{
+			if (edge.second == 1)
+				segments.push_back(edge.first);
+		}
+		return segments;
+	}
+
+	// Twice the signed area of a triangle in (i, j) grid space
+	int DoubleArea(unsigned int a, unsigned int b, unsigned int c)
+	{
+		int ai = a % CELL_SIZE, aj = a / CELL_SIZE;
+		int bi = b % CELL_SIZE, bj = b / CELL_SIZE;
+		int ci = c % CELL_SIZE, cj = c / CELL_SIZE;
+		return ((bi - ai) * (cj - aj)) - ((bj - aj) * (ci - ai));
+	}
+}
+
+// Every pattern has to cover the whole cell exactly once, with every triangle wound the same way as the full
+// resolution terrain and none of them collapsed to a line
+TEST_CASE(EveryPatternCoversTheCell)
+{
+	TerrainLodPatterns patterns(CELL_SIZE);
+	CHECK_EQUAL(6, patterns.LevelCount());
+
+	const unsigned int* fullResolution = patterns.GetIndices().data() + patterns.GetPattern(0, 0).startIndex;
+	int winding = DoubleArea(fullResolution[0], fullResolution[1], fullResolution[2]) > 0 ? 1 : -1;
+
+	int badPatternCount = 0;
+	for (int level = 0; level < patterns.LevelCount(); ++level)
+	{
+		for (int stitchMask = 0; stitchMask < TerrainLodPatterns::STITCH_MASK_COUNT; ++stitchMask)
+		{
+			TerrainLodPatterns::PatternRange range = patterns.GetPattern(level, stitchMask);
+			const unsigned int* indices = patterns.GetIndices().data() + range.startIndex;
+
+			int totalArea = 0;
+			bool degenerate = false;
+			for (unsigned int triangle = 0; triangle < range.indexCount; triangle += 3)
+			{
+				int area = DoubleArea(indices[triangle], indices[triangle + 1], indices[triangle + 2]) * winding;
+				degenerate = degenerate || area <= 0;
+				totalArea += area;
+			}
+
+			if (degenerate || totalArea != 2 * (CELL_SIZE - 1) * (CELL_SIZE - 1) || range.indexCount % 3 != 0)
+				++badPatternCount;
+		}
+	}
+
+	CHECK_EQUAL(0, badPatternCount);
+}
+
+// A stitched side has to be made of exactly the segments of the coarser neighbour's side, and stitching one side
+// must not change any of the others
+TEST_CASE(StitchedSidesMatchTheCoarserNeighbour)
+{
+	TerrainLodPatterns patterns(CELL_SIZE);
+
+	int mismatchCount = 0;
+	for (int level = 0; level < patterns.LevelCount() - 1; ++level)
+	{
+		for (int stitchMask = 0; stitchMask < TerrainLodPatterns::STITCH_MASK_COUNT; ++stitchMask)
+		{
+			for (int side : SIDES)
+			{
+				std::vector<std::pair<int, int>> segments = SideSegments(patterns, level, stitchMask, side);
+				std::vector<std::pair<int, int>> expected = (stitchMask & side) ?
+					SideSegments(patterns, level + 1, 0, OppositeSide(side)) :
+					SideSegments(patterns, level, 0, side);
+
+				if (segments != expected)
+					++mismatchCount;
+			}
+		}
+	}
+
+	CHECK_EQUAL(0, mismatchCount);
+}
+
+// Runs the selector over a streamed looking set of cells (a disk around the eye) for eyes all over the terrain and
+// checks every pair of neighbouring cells that can be drawn: the levels differ by at most one, and the patterns
+// they are drawn with meet along the shared side without a crack
+TEST_CASE(SelectedLevelsAreCrackFree)
+{
+	const int terrainSize = 513;
+	const int cellRowCount = (terrainSize - 1) / (CELL_SIZE - 1);
+
+	// Smooth hills plus noise so that the errors differ from cell to cell
+	std::mt19937 random(10);
+	std::uniform_real_distribution<float> noise(0.0f, 3.0f);
+	HeightField heightField(terrainSize, terrainSize);
+	for (int j = 0; j < terrainSize; j++)
+		for (int i = 0; i < terrainSize; i++)
+			heightField.SetSample(i, j, 40.0f + (30.0f * std::sin(i * 0.02f) * std::cos(j * 0.03f)) + ((i / 64) % 2 == 0 ? noise(random) : 0.0f));
+
+	std::vector<TerrainCellBounds> cellBounds = TerrainTestData::CalculateCellBounds(heightField, CELL_SIZE);
+	TerrainLodPatterns patterns(CELL_SIZE);
+	ThreadPool pool(2);
+	TerrainLodSelector selector(heightField, cellBounds, cellRowCount, CELL_SIZE, patterns.LevelCount(), pool);
+
+	int farLevelDifferenceCount = 0;
+	int crackCount = 0;
+	int inactiveDrawnCount = 0;
+	std::uniform_real_distribution<float> position(0.0f, static_cast<float>(terrainSize - 1));
+
+	for (int n = 0; n < 40; n++)
+	{
+		XMFLOAT3 eye(position(random), 60.0f + (n * 5.0f), position(random));
+
+		std::vector<int> resident;
+		for (int cellIndex = 0; cellIndex < static_cast<int>(cellBounds.size()); cellIndex++)
+		{
+			float dx = ((cellBounds[cellIndex].minX + cellBounds[cellIndex].maxX) * 0.5f) - eye.x;
+			float dz = ((cellBounds[cellIndex].minZ + cellBounds[cellIndex].maxZ) * 0.5f) - eye.z;
+			if ((dx * dx) + (dz * dz) < 200.0f * 200.0f)
+				resident.push_back(cellIndex);
+		}
+
+		selector.SelectLevels(resident, eye, 540.0f, n % 2 == 0 ? 2.0f : 8.0f);
+		const std::vector<int>& active = selector.GetActiveCells();
+		auto IsActive = [&active](int cellIndex) { return std::find(active.begin(), active.end(), cellIndex) != active.end(); };
+
+		for (int cellIndex : resident)
+			inactiveDrawnCount += IsActive(cellIndex) ? 0 : 1;
+
+		// Right and bottom neighbours of every active cell, so that each pair is checked once
+		for (int cellIndex : active)
+		{
+			int i = cellIndex % cellRowCount;
+			int j = cellIndex / cellRowCount;
+			std::pair<int, int> neighbours[2] = { { i < cellRowCount - 1 ? cellIndex + 1 : -1, TerrainLodPatterns::STITCH_RIGHT },
+				{ j < cellRowCount - 1 ? cellIndex + cellRowCount : -1, TerrainLodPatterns::STITCH_BOTTOM } };
+
+			for (const std::pair<int, int>& neighbour : neighbours)
+			{
+				if (neighbour.first < 0 || !IsActive(neighbour.first))
+					continue;
+
+				int level = selector.GetLevel(cellIndex);
+				int neighbourLevel = selector.GetLevel(neighbour.first);
+				if (std::abs(level - neighbourLevel) > 1)
+				{
+					++farLevelDifferenceCount;
+					continue;
+				}
+
+				if (SideSegments(patterns, level, selector.GetStitchMask(cellIndex), neighbour.second) !=
+					SideSegments(patterns, neighbourLevel, selector.GetStitchMask(neighbour.first), OppositeSide(neighbour.second)))
+					++crackCount;
+			}
+		}
+	}
+
+	CHECK_EQUAL(0, inactiveDrawnCount);
+	CHECK_EQUAL(0, farLevelDifferenceCount);
+	CHECK_EQUAL(0, crackCount);
+}
+
+// Only the cells that are passed in and their neighbours take part - nothing else reads the height field
+TEST_CASE(SelectionOnlyMeasuresResidentCellsAndTheirNeighbours)
+{
+	const int terrainSize = 257;
+	const int cellRowCount = (terrainSize - 1) / (CELL_SIZE - 1);
+
+	HeightField heightField(terrainSize, terrainSize);
+	std::vector<float> heights = TerrainTestData::RandomHeights(terrainSize, terrainSize, 11);
+	for (int j = 0; j < terrainSize; j++)
+		heightField.SetRow(j, heights.data() + (static_cast<size_t>(terrainSize) * j));
+	heightField.UpdateBounds();
+
+	std::vector<TerrainCellBounds> cellBounds = TerrainTestData::CalculateCellBounds(heightField, CELL_SIZE);
+	TerrainLodPatterns patterns(CELL_SIZE);
+	ThreadPool pool(2);
+	TerrainLodSelector selector(heightField, cellBounds, cellRowCount, CELL_SIZE, patterns.LevelCount(), pool);
+
+	// Cell (0, 0) and cell (3, 3) - their neighbours are (1, 0), (0, 1) and (3, 2), (4, 3), (3, 4), (2, 3)
+	selector.SelectLevels({ 0, (cellRowCount * 3) + 3 }, XMFLOAT3(0.0f, 100.0f, 0.0f), 540.0f, 2.0f);
+	std::vector<int> expected = { 0, 1, cellRowCount, (cellRowCount * 2) + 3, (cellRowCount * 3) + 2, (cellRowCount * 3) + 3, (cellRowCount * 3) + 4, (cellRowCount * 4) + 3 };
+
+	std::vector<int> active = selector.GetActiveCells();
+	std::sort(active.begin(), active.end());
+	CHECK(active == expected);
+
+	int measuredCount = 0;
+	for (int cellIndex = 0; cellIndex < static_cast<int>(cellBounds.size()); cellIndex++)
+		measuredCount += selector.HasErrors(cellIndex) ? 1 : 0;
+	CHECK_EQUAL(static_cast<int>(expected.size()), measuredCount);
+
+	// Selecting every cell gives every cell errors that never shrink with the level
+	selector.SelectLevels(XMFLOAT3(0.0f, 100.0f, 0.0f), 540.0f, 2.0f);
+	int badErrorCount = 0;
+	for (int cellIndex = 0; cellIndex < static_cast<int>(cellBounds.size()); cellIndex++)
+	{
+		badErrorCount += selector.HasErrors(cellIndex) ? 0 : 1;
+		for (int level = 1; level < patterns.LevelCount(); level++)
+			badErrorCount += selector.GetError(cellIndex, level) >= selector.GetError(cellIndex, level - 1) ? 0 : 1;
+	}
+	CHECK_EQUAL(0, badErrorCount);
+}
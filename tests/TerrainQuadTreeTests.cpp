@@ -0,0 +1,139 @@
+#include "TestFramework.h"
+#include "TerrainQuadTree.h"
+#include "TerrainTestData.h"
+
+#include <random>
+
+namespace
+{
+	// What Terrain::Render did before the quad tree - test every cell against the frustum on its own
+	void TestEveryCell(Frustum& frustum, const std::vector<TerrainCellBounds>& cells, std::vector<int>& visibleCells)
+	{
+		visibleCells.clear();
+		for (int index = 0; index < static_cast<int>(cells.size()); index++)
+		{
+			const TerrainCellBounds& cell = cells[index];
+			if (frustum.CheckRectangle2(cell.maxX, cell.maxY, cell.maxZ, cell.minX, cell.minY, cell.minZ))
+				visibleCells.push_back(index);
+		}
+	}
+
+	// A (cellRowCount x cellRowCount) grid of 32 unit wide cells with random height ranges, so that some cells
+	// stick out of the frustum where their neighbours do not
+	std::vector<TerrainCellBounds> RandomCells(int cellRowCount, unsigned int seed)
+	{
+		std::mt19937 random(seed);
+		std::uniform_real_distribution<float> height(0.0f, 200.0f);
+
+		std::vector<TerrainCellBounds> cells;
+		float terrainSize = static_cast<float>(cellRowCount * 32);
+		for (int j = 0; j < cellRowCount; j++)
+		{
+			for (int i = 0; i < cellRowCount; i++)
+			{
+				TerrainCellBounds cell;
+				cell.minX = static_cast<float>(i * 32);
+				cell.maxX = cell.minX + 32.0f;
+				cell.maxZ = terrainSize - static_cast<float>(j * 32);
+				cell.minZ = cell.maxZ - 32.0f;
+				cell.minY = height(random);
+				cell.maxY = cell.minY + height(random);
+				cells.push_back(cell);
+			}
+		}
+		return cells;
+	}
+}
+
+// The quad tree rejects and accepts whole subtrees, but must end up with exactly the cells that testing every
+// cell finds. Odd grid sizes leave nodes with fewer than four children
+TEST_CASE(QuadTreeFindsTheSameCellsAsTestingEveryCell)
+{
+	int mismatchCount = 0;
+	int visibleCount = 0;
+
+	for (int cellRowCount : { 32, 7, 5, 1 })
+	{
+		std::vector<TerrainCellBounds> cells = RandomCells(cellRowCount, static_cast<unsigned int>(cellRowCount));
+		TerrainQuadTree quadTree(cells, cellRowCount);
+		float terrainSize = static_cast<float>(cellRowCount * 32);
+
+		std::vector<int> visibleCells;
+		std::vector<int> expectedCells;
+		for (const TerrainTestData::CameraPose& pose : TerrainTestData::CameraLoop(90, terrainSize, 150.0f))
+		{
+			Frustum frustum(1500.0f, TerrainTestData::ViewMatrix(pose), TerrainTestData::ProjectionMatrix());
+
+			quadTree.GetVisibleCells(&frustum, visibleCells);
+			TestEveryCell(frustum, cells, expectedCells);
+
+			// The quad tree reports cells in tree order
+			std::sort(visibleCells.begin(), visibleCells.end());
+			if (visibleCells != expectedCells)
+				++mismatchCount;
+
+			visibleCount += static_cast<int>(expectedCells.size());
+			CHECK(quadTree.LastTestCount() > 0);
+		}
+	}
+
+	CHECK_EQUAL(0, mismatchCount);
+	CHECK(visibleCount > 0);
+}
+
+// A camera flying a loop over heightmap.r16 - how many frustum tests and how long the quad tree takes per frame
+// against testing each of the 1024 cells
+BENCHMARK(QuadTreeCullingCameraSweep)
+{
+	const int cellSize = 33;
+	std::unique_ptr<HeightField> heightField = TerrainTestData::LoadHeightField("heightmap.r16", 1025, 300.0f);
+	std::vector<TerrainCellBounds> cells = TerrainTestData::CalculateCellBounds(*heightField, cellSize);
+	int cellRowCount = (heightField->Width() - 1) / (cellSize - 1);
+	TerrainQuadTree quadTree(cells, cellRowCount);
+
+	std::vector<TerrainTestData::CameraPose> poses = TerrainTestData::CameraLoop(500, static_cast<float>(heightField->Width() - 1), 250.0f);
+	std::vector<int> visibleCells;
+	visibleCells.reserve(cells.size());
+
+	long long testCount = 0;
+	long long visibleCount = 0;
+	int mismatchCount = 0;
+	for (const TerrainTestData::CameraPose& pose : poses)
+	{
+		Frustum frustum(1500.0f, TerrainTestData::ViewMatrix(pose), TerrainTestData::ProjectionMatrix());
+		std::vector<int> expectedCells;
+
+		quadTree.GetVisibleCells(&frustum, visibleCells);
+		TestEveryCell(frustum, cells, expectedCells);
+
+		std::sort(visibleCells.begin(), visibleCells.end());
+		mismatchCount += visibleCells == expectedCells ? 0 : 1;
+		testCount += quadTree.LastTestCount();
+		visibleCount += static_cast<long long>(visibleCells.size());
+	}
+	CHECK_EQUAL(0, mismatchCount);
+
+	// The frusta are built up front so that only the culling itself is timed
+	std::vector<std::unique_ptr<Frustum>> frusta;
+	for (const TerrainTestData::CameraPose& pose : poses)
+		frusta.push_back(std::make_unique<Frustum>(1500.0f, TerrainTestData::ViewMatrix(pose), TerrainTestData::ProjectionMatrix()));
+
+	double quadTreeSeconds = Testing::BestTime(5, [&]()
+	{
+		for (std::unique_ptr<Frustum>& frustum : frusta)
+			quadTree.GetVisibleCells(frustum.get(), visibleCells);
+		Testing::DoNotOptimize(visibleCells.data());
+	});
+
+	double everyCellSeconds = Testing::BestTime(5, [&]()
+	{
+		for (std::unique_ptr<Frustum>& frustum : frusta)
+			TestEveryCell(*frustum, cells, visibleCells);
+		Testing::DoNotOptimize(visibleCells.data());
+	});
+
+	double frameCount = static_cast<double>(poses.size());
+	printf("    %zu cells, %.1f visible and %.1f frustum tests per frame on average\n", cells.size(), visibleCount / frameCount, testCount / frameCount);
+	printf("    quad tree:  %10.2f us per frame\n", quadTreeSeconds / frameCount * 1e6);
+	printf("    every cell: %10.2f us per frame\n", everyCellSeconds / frameCount * 1e6);
+}
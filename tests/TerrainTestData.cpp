@@ -0,0 +1,156 @@
+#include "TerrainTestData.h"
+#include "RawHeightMap.h"
+
+#include <cmath>
+#include <fstream>
+#include <random>
+
+using DirectX::XMFLOAT3;
+
+std::vector<float> TerrainTestData::RandomHeights(int width, int height, unsigned int seed)
+{
+	std::mt19937 random(seed);
+	std::uniform_int_distribution<int> sample(0, 65535);
+
+	std::vector<float> heights(static_cast<size_t>(width) * height);
+	for (float& value : heights)
+		value = static_cast<float>(sample(random));
+	return heights;
+}
+
+void TerrainTestData::WriteRandomHeightMap(const std::string& filename, int width, int height, unsigned int seed)
+{
+	std::mt19937 random(seed);
+	std::uniform_int_distribution<int> sample(0, 65535);
+
+	std::ofstream file(filename, std::ios::binary);
+	std::vector<uint16_t> row(width);
+	for (int j = 0; j < height; j++)
+	{
+		for (uint16_t& value : row)
+			value = static_cast<uint16_t>(sample(random));
+		file.write(reinterpret_cast<const char*>(row.data()), row.size() * sizeof(uint16_t));
+	}
+}
+
+void TerrainTestData::WriteColorMap(const std::string& filename, int width, int height, const std::function<XMFLOAT3(int i, int j)>& color)
+{
+	size_t rowPitch = ((static_cast<size_t>(width) * 3) + 3) & ~static_cast<size_t>(3);
+
+	BITMAPFILEHEADER fileHeader = {};
+	BITMAPINFOHEADER infoHeader = {};
+	fileHeader.bfType = 0x4D42;
+	fileHeader.bfOffBits = sizeof(BITMAPFILEHEADER) + sizeof(BITMAPINFOHEADER);
+	fileHeader.bfSize = static_cast<DWORD>(fileHeader.bfOffBits + (rowPitch * height));
+	infoHeader.biSize = sizeof(BITMAPINFOHEADER);
+	infoHeader.biWidth = width;
+	infoHeader.biHeight = height;
+	infoHeader.biPlanes = 1;
+	infoHeader.biBitCount = 24;
+	infoHeader.biCompression = BI_RGB;
+
+	std::ofstream file(filename, std::ios::binary);
+	file.write(reinterpret_cast<const char*>(&fileHeader), sizeof(BITMAPFILEHEADER));
+	file.write(reinterpret_cast<const char*>(&infoHeader), sizeof(BITMAPINFOHEADER));
+
+	auto Channel = [](float value) { return static_cast<uint8_t>(std::lround(value * 255.0f)); };
+	std::vector<uint8_t> row(rowPitch, 0);
+	for (int j = height - 1; j >= 0; j--)
+	{
+		for (int i = 0; i < width; i++)
+		{
+			XMFLOAT3 c = color(i, j);
+			row[(i * 3)] = Channel(c.z);
+			row[(i * 3) + 1] = Channel(c.y);
+			row[(i * 3) + 2] = Channel(c.x);
+		}
+		file.write(reinterpret_cast<const char*>(row.data()), row.size());
+	}
+}
+
+std::unique_ptr<HeightField> TerrainTestData::LoadHeightField(const std::string& filename, int size, float heightScale)
+{
+	RawHeightMap heightMap(filename, size, size);
+	std::unique_ptr<HeightField> heightField = std::make_unique<HeightField>(size, size);
+
+	std::vector<float> row(size);
+	for (int j = 0; j < size; j++)
+	{
+		heightMap.ReadRows(j, 1, row.data());
+		for (float& height : row)
+			height /= heightScale;
+		heightField->SetRow(j, row.data());
+	}
+	heightField->UpdateBounds();
+	return heightField;
+}
+
+std::vector<TerrainCellBounds> TerrainTestData::CalculateCellBounds(const HeightField& heightField, int cellSize)
+{
+	int cellRowCount = (heightField.Width() - 1) / (cellSize - 1);
+	std::vector<TerrainCellBounds> bounds;
+
+	for (int cellY = 0; cellY < cellRowCount; cellY++)
+	{
+		for (int cellX = 0; cellX < cellRowCount; cellX++)
+		{
+			TerrainCellBounds cell;
+			cell.minX = static_cast<float>(cellX * (cellSize - 1));
+			cell.maxX = cell.minX + static_cast<float>(cellSize - 1);
+			cell.maxZ = static_cast<float>(heightField.Height() - 1 - (cellY * (cellSize - 1)));
+			cell.minZ = cell.maxZ - static_cast<float>(cellSize - 1);
+			cell.minY = FLT_MAX;
+			cell.maxY = -FLT_MAX;
+
+			for (int j = 0; j < cellSize; j++)
+			{
+				for (int i = 0; i < cellSize; i++)
+				{
+					float height = heightField.GetSample((cellX * (cellSize - 1)) + i, (cellY * (cellSize - 1)) + j);
+					cell.minY = std::min(cell.minY, height);
+					cell.maxY = std::max(cell.maxY, height);
+				}
+			}
+
+			bounds.push_back(cell);
+		}
+	}
+
+	return bounds;
+}
+
+std::vector<TerrainTestData::CameraPose> TerrainTestData::CameraLoop(int poseCount, float terrainSize, float height)
+{
+	std::vector<CameraPose> poses;
+	poses.reserve(poseCount);
+
+	float centre = terrainSize * 0.5f;
+	for (int iii = 0; iii < poseCount; iii++)
+	{
+		float t = static_cast<float>(iii) / static_cast<float>(poseCount);
+		float around = t * 2.0f * DirectX::XM_PI;
+		float radius = terrainSize * (0.1f + (0.35f * t));
+		float yaw = around * 3.0f;
+
+		CameraPose pose;
+		pose.eye = XMFLOAT3(centre + (radius * std::cos(around)), height, centre + (radius * std::sin(around)));
+		pose.direction = XMFLOAT3(std::cos(yaw), -0.25f, std::sin(yaw));
+		poses.push_back(pose);
+	}
+
+	return poses;
+}
+
+DirectX::XMMATRIX TerrainTestData::ViewMatrix(const CameraPose& pose)
+{
+	return DirectX::XMMatrixLookToRH(
+		DirectX::XMVectorSet(pose.eye.x, pose.eye.y, pose.eye.z, 1.0f),
+		DirectX::XMVectorSet(pose.direction.x, pose.direction.y, pose.direction.z, 0.0f),
+		DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)
+	);
+}
+
+DirectX::XMMATRIX TerrainTestData::ProjectionMatrix()
+{
+	return DirectX::XMMatrixPerspectiveFovRH(DirectX::XM_PIDIV4, 1920.0f / 1080.0f, 0.01f, 1000.0f);
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include "pch.h"
+#include "HeightField.h"
+#include "TerrainCellBounds.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <functional>
+
+// Height maps, cell bounds and camera paths shared by the terrain tests and benchmarks
+namespace TerrainTestData
+{
+	struct CameraPose
+	{
+		DirectX::XMFLOAT3 eye;
+		DirectX::XMFLOAT3 direction;
+	};
+
+	// Raw 16 bit samples between 0 and 65535 (unscaled), row major
+	std::vector<float> RandomHeights(int width, int height, unsigned int seed);
+
+	// Writes a (width x height) RAW16 height map of random samples one row at a time, so that even a very large map
+	// is never held in memory
+	void WriteRandomHeightMap(const std::string& filename, int width, int height, unsigned int seed);
+
+	// Writes a (width x height) 24 bit bitmap laid out like the terrain color maps (bottom row first, rows padded
+	// to 4 bytes) one row at a time. color(i, j) gives the color of terrain sample (i, j) - channels are rounded to
+	// the nearest 1/255
+	void WriteColorMap(const std::string& filename, int width, int height, const std::function<DirectX::XMFLOAT3(int i, int j)>& color);
+
+	// Reads a (size x size) RAW16 height map and scales it like TerrainMesh does
+	std::unique_ptr<HeightField> LoadHeightField(const std::string& filename, int size, float heightScale);
+
+	// Bounds of every (cellSize x cellSize) cell in the TerrainMesh layout
+	std::vector<TerrainCellBounds> CalculateCellBounds(const HeightField& heightField, int cellSize);
+
+	// poseCount cameras on a loop over a (terrainSize x terrainSize) terrain, looking around as they go and
+	// tilted slightly down, flying height units above the ground
+	std::vector<CameraPose> CameraLoop(int poseCount, float terrainSize, float height);
+
+	DirectX::XMMATRIX ViewMatrix(const CameraPose& pose);
+
+	// The right handed projection MoveLookController uses, for a 1920x1080 window
+	DirectX::XMMATRIX ProjectionMatrix();
+}
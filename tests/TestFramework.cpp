@@ -0,0 +1,105 @@
+#include "TestFramework.h"
+
+#include <cstring>
+#include <algorithm>
+
+namespace
+{
+	int g_failureCount = 0;
+	int g_currentTestFailures = 0;
+}
+
+std::vector<Testing::TestCase>& Testing::Registry()
+{
+	static std::vector<TestCase> registry;
+	return registry;
+}
+
+void Testing::Fail(const char* file, int line, const std::string& message)
+{
+	++g_failureCount;
+	++g_currentTestFailures;
+	printf("    %s(%d): %s\n", file, line, message.c_str());
+}
+
+double Testing::Time(const std::function<void()>& body)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	body();
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+double Testing::BestTime(int repeatCount, const std::function<void()>& body)
+{
+	double best = Time(body);
+	for (int iii = 1; iii < repeatCount; ++iii)
+		best = std::min(best, Time(body));
+	return best;
+}
+
+void Testing::DoNotOptimize(const void* value)
+{
+	static const void* volatile sink;
+	sink = value;
+}
+
+static bool RunTestCase(const Testing::TestCase& test)
+{
+	printf("%s %s\n", test.benchmark ? "[bench]" : "[test] ", test.name);
+	fflush(stdout);
+
+	g_currentTestFailures = 0;
+	try
+	{
+		test.function();
+	}
+	catch (const Testing::RequireFailure&)
+	{
+	}
+	catch (const std::exception& e)
+	{
+		Testing::Fail(__FILE__, __LINE__, std::string("unexpected exception: ") + e.what());
+	}
+
+	if (g_currentTestFailures != 0)
+		printf("    FAILED\n");
+	return g_currentTestFailures == 0;
+}
+
+int main(int argc, char** argv)
+{
+	bool runBenchmarks = false;
+	const char* filter = nullptr;
+
+	for (int iii = 1; iii < argc; ++iii)
+	{
+		if (strcmp(argv[iii], "--bench") == 0)
+			runBenchmarks = true;
+		else
+			filter = argv[iii];
+	}
+
+	int testCount = 0;
+	int failedCount = 0;
+
+	// Every test case runs before any benchmark, so a benchmark never measures something that is broken
+	for (int pass = 0; pass < 2; ++pass)
+	{
+		bool benchmarks = pass == 1;
+		if (benchmarks && !runBenchmarks)
+			break;
+
+		for (const Testing::TestCase& test : Testing::Registry())
+		{
+			if (test.benchmark != benchmarks || (filter != nullptr && strstr(test.name, filter) == nullptr))
+				continue;
+
+			++testCount;
+			if (!RunTestCase(test))
+				++failedCount;
+		}
+	}
+
+	printf("\n%d run, %d failed (%d failed checks)\n", testCount, failedCount, g_failureCount);
+	return failedCount == 0 ? 0 : 1;
+}
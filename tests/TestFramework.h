@@ -0,0 +1,95 @@
+#pragma once
+#include "pch.h"
+
+#include <exception>
+#include <string>
+#include <sstream>
+#include <vector>
+#include <chrono>
+#include <functional>
+#include <stdio.h>
+
+// A minimal test runner for the parts of the engine that do not need a device or a window. Test cases and
+// benchmarks register themselves with TEST_CASE / BENCHMARK and are run from TestFramework.cpp:
+//
+//		chameleon-tests						runs every test case
+//		chameleon-tests --bench				runs every test case and then every benchmark
+//		chameleon-tests [--bench] <filter>	only runs the ones whose name contains <filter>
+//
+// Tests that read assets (heightmap.r16, models/...) expect to be run from the solution directory, which is
+// what the project sets as the debugger working directory.
+namespace Testing
+{
+	struct TestCase
+	{
+		const char* name;
+		void (*function)();
+		bool benchmark;
+	};
+
+	std::vector<TestCase>& Registry();
+
+	struct Registrar
+	{
+		Registrar(const char* name, void (*function)(), bool benchmark) { Registry().push_back({ name, function, benchmark }); }
+	};
+
+	// Thrown by REQUIRE to stop the current test case. CHECK only records the failure and carries on
+	class RequireFailure : public std::exception
+	{
+	};
+
+	void Fail(const char* file, int line, const std::string& message);
+
+	template<typename T>
+	std::string ToString(const T& value)
+	{
+		std::ostringstream oss;
+		oss << value;
+		return oss.str();
+	}
+
+	// Seconds it takes to run body once
+	double Time(const std::function<void()>& body);
+
+	// Best of repeatCount runs - benchmarks report the best run so that they are less noisy
+	double BestTime(int repeatCount, const std::function<void()>& body);
+
+	// Keeps the optimizer from discarding a result that is otherwise never used
+	void DoNotOptimize(const void* value);
+}
+
+#define TESTING_CONCATENATE_IMPL(a, b) a##b
+#define TESTING_CONCATENATE(a, b) TESTING_CONCATENATE_IMPL(a, b)
+
+#define TEST_CASE(name) \
+	static void name(); \
+	static Testing::Registrar TESTING_CONCATENATE(name, Registrar)(#name, name, false); \
+	static void name()
+
+#define BENCHMARK(name) \
+	static void name(); \
+	static Testing::Registrar TESTING_CONCATENATE(name, Registrar)(#name, name, true); \
+	static void name()
+
+#define CHECK(condition) \
+	do { if (!(condition)) Testing::Fail(__FILE__, __LINE__, "CHECK(" #condition ")"); } while (false)
+
+#define CHECK_EQUAL(expected, actual) \
+	do { \
+		auto&& testingExpected = (expected); \
+		auto&& testingActual = (actual); \
+		if (!(testingExpected == testingActual)) \
+			Testing::Fail(__FILE__, __LINE__, "CHECK_EQUAL(" #expected ", " #actual ") - expected " + \
+				Testing::ToString(testingExpected) + ", got " + Testing::ToString(testingActual)); \
+	} while (false)
+
+#define CHECK_THROWS(expression) \
+	do { \
+		bool testingThrew = false; \
+		try { expression; } catch (const std::exception&) { testingThrew = true; } \
+		if (!testingThrew) Testing::Fail(__FILE__, __LINE__, "CHECK_THROWS(" #expression ") - nothing was thrown"); \
+	} while (false)
+
+#define REQUIRE(condition) \
+	do { if (!(condition)) { Testing::Fail(__FILE__, __LINE__, "REQUIRE(" #condition ")"); throw Testing::RequireFailure(); } } while (false)
@@ -0,0 +1,257 @@
+#include "TestFramework.h"
+#include "TextureCache.h"
+
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+
+using DirectX::ScratchImage;
+
+namespace
+{
+	std::string TemporaryFilename(const char* name)
+	{
+		return (std::filesystem::temp_directory_path() / name).string();
+	}
+
+	uint8_t* Texel(const DirectX::Image& image, size_t x, size_t y)
+	{
+		return image.pixels + (y * image.rowPitch) + (x * 4);
+	}
+
+	// A smooth R8G8B8A8 gradient - what a diffuse texture looks like to the block compressor. The alpha ramps from
+	// left to right unless the image is opaque
+	std::unique_ptr<ScratchImage> GradientImage(size_t width, size_t height, bool opaque)
+	{
+		std::unique_ptr<ScratchImage> image = std::make_unique<ScratchImage>();
+		REQUIRE(SUCCEEDED(image->Initialize2D(DXGI_FORMAT_R8G8B8A8_UNORM, width, height, 1, 1)));
+
+		const DirectX::Image& pixels = *image->GetImage(0, 0, 0);
+		for (size_t y = 0; y < height; ++y)
+		{
+			for (size_t x = 0; x < width; ++x)
+			{
+				uint8_t* texel = Texel(pixels, x, y);
+				texel[0] = static_cast<uint8_t>((x * 255) / (width - 1));
+				texel[1] = static_cast<uint8_t>((y * 255) / (height - 1));
+				texel[2] = static_cast<uint8_t>(((x + y) * 255) / (width + height - 2));
+				texel[3] = opaque ? 255 : static_cast<uint8_t>((x * 255) / (width - 1));
+			}
+		}
+		return image;
+	}
+
+	// A tangent space normal map of gentle bumps, encoded the usual way (0.5 * n + 0.5)
+	std::unique_ptr<ScratchImage> NormalMapImage(size_t width, size_t height)
+	{
+		std::unique_ptr<ScratchImage> image = std::make_unique<ScratchImage>();
+		REQUIRE(SUCCEEDED(image->Initialize2D(DXGI_FORMAT_R8G8B8A8_UNORM, width, height, 1, 1)));
+
+		const DirectX::Image& pixels = *image->GetImage(0, 0, 0);
+		for (size_t y = 0; y < height; ++y)
+		{
+			for (size_t x = 0; x < width; ++x)
+			{
+				float nx = 0.4f * std::sin(static_cast<float>(x) * 0.1f);
+				float ny = 0.4f * std::cos(static_cast<float>(y) * 0.07f);
+				float nz = std::sqrt(1.0f - (nx * nx) - (ny * ny));
+
+				uint8_t* texel = Texel(pixels, x, y);
+				texel[0] = static_cast<uint8_t>(std::lround((nx * 0.5f + 0.5f) * 255.0f));
+				texel[1] = static_cast<uint8_t>(std::lround((ny * 0.5f + 0.5f) * 255.0f));
+				texel[2] = static_cast<uint8_t>(std::lround((nz * 0.5f + 0.5f) * 255.0f));
+				texel[3] = 255;
+			}
+		}
+		return image;
+	}
+
+	// Largest difference in any of the first channelCount channels between the source and mip 0 of the cooked image
+	int MaxError(const ScratchImage& source, const ScratchImage& cooked, int channelCount)
+	{
+		ScratchImage decompressed;
+		REQUIRE(SUCCEEDED(DirectX::Decompress(*cooked.GetImage(0, 0, 0), DXGI_FORMAT_R8G8B8A8_UNORM, decompressed)));
+
+		const DirectX::Image& expected = *source.GetImage(0, 0, 0);
+		const DirectX::Image& actual = *decompressed.GetImage(0, 0, 0);
+		int maxError = 0;
+		for (size_t y = 0; y < expected.height; ++y)
+			for (size_t x = 0; x < expected.width; ++x)
+				for (int channel = 0; channel < channelCount; ++channel)
+					maxError = std::max(maxError, std::abs(Texel(expected, x, y)[channel] - Texel(actual, x, y)[channel]));
+		return maxError;
+	}
+
+	size_t ChainSize(const ScratchImage& image)
+	{
+		size_t size = 0;
+		for (size_t mip = 0; mip < image.GetMetadata().mipLevels; ++mip)
+			size += image.GetImage(mip, 0, 0)->slicePitch;
+		return size;
+	}
+}
+
+TEST_CASE(CookPicksTheFormatFromTheImage)
+{
+	std::unique_ptr<ScratchImage> opaque = GradientImage(64, 64, true);
+	std::unique_ptr<ScratchImage> translucent = GradientImage(64, 64, false);
+
+	CHECK_EQUAL(DXGI_FORMAT_BC1_UNORM, TextureCache::CompressedFormat("models/body_dif.png", *opaque));
+	CHECK_EQUAL(DXGI_FORMAT_BC3_UNORM, TextureCache::CompressedFormat("models/glass_dif.png", *translucent));
+
+	// Normal maps are recognized by name, whatever their alpha and the case of the name
+	CHECK_EQUAL(DXGI_FORMAT_BC5_UNORM, TextureCache::CompressedFormat("models/body_showroom_ddn.png", *opaque));
+	CHECK_EQUAL(DXGI_FORMAT_BC5_UNORM, TextureCache::CompressedFormat("models/GLASS_DDN.PNG", *translucent));
+	CHECK_EQUAL(DXGI_FORMAT_BC5_UNORM, TextureCache::CompressedFormat("rock_normal.tga", *opaque));
+	CHECK_EQUAL(DXGI_FORMAT_BC1_UNORM, TextureCache::CompressedFormat("ddn_body.png", *opaque));
+
+	// Sizes that are not a whole number of blocks and formats other than R8G8B8A8 are left uncompressed
+	std::unique_ptr<ScratchImage> odd = GradientImage(30, 64, true);
+	CHECK_EQUAL(DXGI_FORMAT_UNKNOWN, TextureCache::CompressedFormat("odd.png", *odd));
+	CHECK(TextureCache::Cook("odd.png", *odd) == nullptr);
+
+	ScratchImage bgra;
+	REQUIRE(SUCCEEDED(bgra.Initialize2D(DXGI_FORMAT_B8G8R8A8_UNORM, 64, 64, 1, 1)));
+	CHECK_EQUAL(DXGI_FORMAT_UNKNOWN, TextureCache::CompressedFormat("bgra.png", bgra));
+}
+
+// Every mip down to 1x1 is generated, and mip 0 stays close to the source in the channels the format keeps
+TEST_CASE(CookedTexturesHaveAFullMipChain)
+{
+	struct Case
+	{
+		const char* name;
+		std::unique_ptr<ScratchImage> source;
+		DXGI_FORMAT format;
+		int channelCount;
+		int tolerance;
+	};
+
+	Case cases[] = {
+		{ "diffuse.png", GradientImage(256, 128, true), DXGI_FORMAT_BC1_UNORM, 3, 24 },
+		{ "decal.png", GradientImage(256, 128, false), DXGI_FORMAT_BC3_UNORM, 4, 24 },
+		{ "bumps_ddn.png", NormalMapImage(256, 128), DXGI_FORMAT_BC5_UNORM, 2, 8 },
+	};
+
+	for (Case& test : cases)
+	{
+		std::unique_ptr<ScratchImage> cooked = TextureCache::Cook(test.name, *test.source);
+		REQUIRE(cooked != nullptr);
+
+		const DirectX::TexMetadata& metadata = cooked->GetMetadata();
+		CHECK_EQUAL(test.format, metadata.format);
+		CHECK_EQUAL(static_cast<size_t>(256), metadata.width);
+		CHECK_EQUAL(static_cast<size_t>(128), metadata.height);
+		CHECK_EQUAL(static_cast<size_t>(9), metadata.mipLevels);
+
+		const DirectX::Image* smallest = cooked->GetImage(metadata.mipLevels - 1, 0, 0);
+		REQUIRE(smallest != nullptr);
+		CHECK_EQUAL(static_cast<size_t>(1), smallest->width);
+		CHECK_EQUAL(static_cast<size_t>(1), smallest->height);
+
+		int error = MaxError(*test.source, *cooked, test.channelCount);
+		if (error > test.tolerance)
+			printf("    %s: largest error %d\n", test.name, error);
+		CHECK(error <= test.tolerance);
+
+		// BC1 is 4 bits per texel, BC3 and BC5 are 8 - against 32 for R8G8B8A8
+		size_t uncompressed = 256 * 128 * 4;
+		CHECK_EQUAL(uncompressed / (test.format == DXGI_FORMAT_BC1_UNORM ? 8 : 4), cooked->GetImage(0, 0, 0)->slicePitch);
+	}
+}
+
+TEST_CASE(CookedTextureFileRoundTrips)
+{
+	const std::string filename = TemporaryFilename("chameleon-tests-texture.cooked");
+	const TextureCacheKey key = { 12345, 67890 };
+
+	std::unique_ptr<ScratchImage> cooked = TextureCache::Cook("decal.png", *GradientImage(128, 64, false));
+	REQUIRE(cooked != nullptr);
+	TextureCache::Write(filename, key, *cooked);
+	CHECK(!std::filesystem::exists(filename + ".tmp"));
+
+	{
+		TextureCache cache(filename);
+		TextureCacheKey touched = key;
+		touched.sourceWriteTime += 1;
+		CHECK(cache.Matches(key));
+		CHECK(!cache.Matches(touched));
+		CHECK_EQUAL(DXGI_FORMAT_BC3_UNORM, cache.Format());
+		CHECK_EQUAL(128u, cache.Width());
+		CHECK_EQUAL(64u, cache.Height());
+		CHECK_EQUAL(static_cast<unsigned int>(cooked->GetMetadata().mipLevels), cache.MipLevels());
+
+		std::unique_ptr<ScratchImage> loaded = cache.Load();
+		int mismatchCount = 0;
+		for (size_t mip = 0; mip < cooked->GetMetadata().mipLevels; ++mip)
+		{
+			const DirectX::Image* expected = cooked->GetImage(mip, 0, 0);
+			const DirectX::Image* actual = loaded->GetImage(mip, 0, 0);
+			if (actual == nullptr || actual->slicePitch != expected->slicePitch || memcmp(actual->pixels, expected->pixels, expected->slicePitch) != 0)
+				++mismatchCount;
+		}
+		CHECK_EQUAL(0, mismatchCount);
+	}
+
+	// Only cooked (block compressed) images can be written, and a damaged file is rejected when it is opened
+	CHECK_THROWS(TextureCache::Write(filename, key, *GradientImage(64, 64, true)));
+
+	std::filesystem::resize_file(filename, std::filesystem::file_size(filename) - 1);
+	CHECK_THROWS(TextureCache{ filename });
+
+	std::filesystem::remove(filename);
+}
+
+// Decoding and cooking nanosuit textures the way Texture::Create does on a first run, against loading the cooked
+// file on the next one. Decoding the PNG files needs WIC, so COM is initialized here like AssetLoader does on its
+// threads
+BENCHMARK(CookNanosuitTextures)
+{
+	HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+	REQUIRE(SUCCEEDED(hr) || hr == RPC_E_CHANGED_MODE);
+
+	const std::string cookedFilename = TemporaryFilename("chameleon-tests-nanosuit.cooked");
+
+	for (const char* filename : { "models/nanosuit-textured/arm_dif.png", "models/nanosuit-textured/arm_showroom_ddn.png" })
+	{
+		std::wstring wideFilename = std::wstring(filename, filename + strlen(filename));
+		std::unique_ptr<ScratchImage> decoded;
+		double decodeSeconds = Testing::BestTime(3, [&decoded, &wideFilename]()
+		{
+			ScratchImage image;
+			REQUIRE(SUCCEEDED(DirectX::LoadFromWICFile(wideFilename.c_str(), DirectX::WIC_FLAGS_NONE, nullptr, image)));
+
+			decoded = std::make_unique<ScratchImage>();
+			if (image.GetMetadata().format == DXGI_FORMAT_R8G8B8A8_UNORM)
+				*decoded = std::move(image);
+			else
+				REQUIRE(SUCCEEDED(DirectX::Convert(*image.GetImage(0, 0, 0), DXGI_FORMAT_R8G8B8A8_UNORM, DirectX::TEX_FILTER_DEFAULT, DirectX::TEX_THRESHOLD_DEFAULT, *decoded)));
+		});
+
+		std::unique_ptr<ScratchImage> cooked;
+		double cookSeconds = Testing::BestTime(3, [&cooked, &decoded, filename]() { cooked = TextureCache::Cook(filename, *decoded); });
+		REQUIRE(cooked != nullptr);
+		TextureCache::Write(cookedFilename, TextureCache::CreateKey(filename), *cooked);
+
+		std::unique_ptr<ScratchImage> loaded;
+		double loadSeconds = Testing::BestTime(10, [&loaded, &cookedFilename, filename]()
+		{
+			TextureCache cache(cookedFilename);
+			CHECK(cache.Matches(TextureCache::CreateKey(filename)));
+			loaded = cache.Load();
+		});
+
+		// The uncompressed chain is what GenerateMips on the device used to create - a third more than mip 0
+		const DirectX::TexMetadata& metadata = cooked->GetMetadata();
+		size_t uncompressedSize = (metadata.width * metadata.height * 4 * 4) / 3;
+		printf("    %s (%zu x %zu, %s)\n", filename, metadata.width, metadata.height,
+			metadata.format == DXGI_FORMAT_BC5_UNORM ? "BC5" : (metadata.format == DXGI_FORMAT_BC1_UNORM ? "BC1" : "BC3"));
+		printf("        decode:        %8.1f ms\n", decodeSeconds * 1e3);
+		printf("        mips + BC:     %8.1f ms\n", cookSeconds * 1e3);
+		printf("        load cooked:   %8.1f ms\n", loadSeconds * 1e3);
+		printf("        memory:        %8.1f MB -> %.1f MB\n", uncompressedSize / (1024.0 * 1024.0), ChainSize(*loaded) / (1024.0 * 1024.0));
+	}
+
+	std::filesystem::remove(cookedFilename);
+	CoUninitialize();
+}
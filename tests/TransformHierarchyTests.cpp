@@ -0,0 +1,230 @@
+#include "TestFramework.h"
+#include "TransformHierarchy.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+using DirectX::XMFLOAT3;
+using DirectX::XMMATRIX;
+
+namespace
+{
+	// The transforms of a node the way a Drawable keeps them, to build the reference matrices from
+	struct NodeTransform
+	{
+		XMFLOAT3 translation;
+		float pitch, yaw, roll;
+		XMFLOAT3 scale;
+	};
+
+	// A forest of count nodes where every node's parent is one of the nodes before it, or none
+	void RandomHierarchy(size_t count, TransformHierarchy& hierarchy, std::vector<NodeTransform>& transforms)
+	{
+		std::mt19937 random(25);
+		std::uniform_real_distribution<float> position(-10.0f, 10.0f);
+		std::uniform_real_distribution<float> angle(-3.0f, 3.0f);
+		std::uniform_real_distribution<float> size(0.5f, 2.0f);
+
+		hierarchy.Reserve(count);
+		transforms.clear();
+		for (size_t iii = 0; iii < count; ++iii)
+		{
+			int parent = TransformHierarchy::NO_PARENT;
+			if (iii % 50 != 0)
+				parent = std::uniform_int_distribution<int>(std::max(0, static_cast<int>(iii) - 8), static_cast<int>(iii) - 1)(random);
+
+			int node = hierarchy.AddNode(parent);
+			NodeTransform transform = { { position(random), position(random), position(random) }, angle(random), angle(random), angle(random), { size(random), size(random), size(random) } };
+			hierarchy.SetTranslation(node, transform.translation);
+			hierarchy.SetRotation(node, transform.pitch, transform.yaw, transform.roll);
+			hierarchy.SetScale(node, transform.scale);
+			transforms.push_back(transform);
+		}
+	}
+
+	// What Drawable::GetPreParentTransformModelMatrix builds, with full matrix multiplies
+	XMMATRIX ReferenceLocal(const NodeTransform& transform)
+	{
+		return DirectX::XMMatrixRotationRollPitchYaw(transform.pitch, transform.yaw, transform.roll) *
+			DirectX::XMMatrixScaling(transform.scale.x, transform.scale.y, transform.scale.z) *
+			DirectX::XMMatrixTranslation(transform.translation.x, transform.translation.y, transform.translation.z);
+	}
+
+	void ReferenceWorld(const TransformHierarchy& hierarchy, const std::vector<NodeTransform>& transforms, std::vector<XMMATRIX>& world)
+	{
+		world.resize(transforms.size());
+		for (size_t iii = 0; iii < transforms.size(); ++iii)
+		{
+			int parent = hierarchy.GetParent(static_cast<int>(iii));
+			world[iii] = parent == TransformHierarchy::NO_PARENT ? ReferenceLocal(transforms[iii]) : ReferenceLocal(transforms[iii]) * world[parent];
+		}
+	}
+
+	// Element-wise, relative to the size of the matrices - deep chains of scales of up to 2 get large
+	bool Near(const XMMATRIX& expected, const XMMATRIX& actual)
+	{
+		DirectX::XMFLOAT4X4 a, b;
+		DirectX::XMStoreFloat4x4(&a, expected);
+		DirectX::XMStoreFloat4x4(&b, actual);
+		for (int row = 0; row < 4; ++row)
+		{
+			for (int column = 0; column < 4; ++column)
+			{
+				float tolerance = 1e-4f * std::max(1.0f, std::fabs(a.m[row][column]));
+				if (std::fabs(a.m[row][column] - b.m[row][column]) > tolerance)
+					return false;
+			}
+		}
+		return true;
+	}
+
+	// Every node below node, itself included. Children always come after their parents
+	size_t SubtreeSize(const TransformHierarchy& hierarchy, int node)
+	{
+		std::vector<uint8_t> inside(hierarchy.NodeCount(), 0);
+		inside[node] = 1;
+		size_t size = 1;
+		for (size_t iii = node + 1; iii < hierarchy.NodeCount(); ++iii)
+		{
+			int parent = hierarchy.GetParent(static_cast<int>(iii));
+			if (parent != TransformHierarchy::NO_PARENT && inside[parent])
+			{
+				inside[iii] = 1;
+				++size;
+			}
+		}
+		return size;
+	}
+}
+
+// The world matrices are local * parent world, with the local matrix built the same as a Drawable builds it
+TEST_CASE(TransformHierarchyMatchesTheMatrixProduct)
+{
+	TransformHierarchy hierarchy;
+	std::vector<NodeTransform> transforms;
+	RandomHierarchy(500, hierarchy, transforms);
+	CHECK_EQUAL(static_cast<size_t>(500), hierarchy.Update());
+
+	std::vector<XMMATRIX> expected;
+	ReferenceWorld(hierarchy, transforms, expected);
+	int badCount = 0;
+	for (size_t iii = 0; iii < expected.size(); ++iii)
+	{
+		if (!Near(expected[iii], hierarchy.GetWorldMatrix(static_cast<int>(iii))))
+			++badCount;
+	}
+	CHECK_EQUAL(0, badCount);
+}
+
+// Update only rebuilds the nodes that moved and everything below them, and setting a value that is already stored
+// moves nothing
+TEST_CASE(TransformHierarchyOnlyRebuildsWhatMoved)
+{
+	TransformHierarchy hierarchy;
+	std::vector<NodeTransform> transforms;
+	RandomHierarchy(500, hierarchy, transforms);
+	hierarchy.Update();
+
+	CHECK_EQUAL(static_cast<size_t>(0), hierarchy.Update());
+	hierarchy.SetTranslation(7, transforms[7].translation);
+	hierarchy.SetRotation(7, transforms[7].pitch, transforms[7].yaw, transforms[7].roll);
+	hierarchy.SetScale(7, transforms[7].scale);
+	CHECK_EQUAL(static_cast<size_t>(0), hierarchy.Update());
+	CHECK(!hierarchy.WorldChanged(7));
+
+	const int moved[] = { 7, 260 };
+	transforms[7].yaw += 0.5f;
+	hierarchy.SetRotation(7, transforms[7].pitch, transforms[7].yaw, transforms[7].roll);
+	transforms[260].scale.y = 3.0f;
+	hierarchy.SetScale(260, transforms[260].scale);
+	CHECK_EQUAL(SubtreeSize(hierarchy, moved[0]) + SubtreeSize(hierarchy, moved[1]), hierarchy.Update());
+	CHECK(hierarchy.WorldChanged(7));
+	CHECK(hierarchy.WorldChanged(260));
+	CHECK(!hierarchy.WorldChanged(0));
+
+	std::vector<XMMATRIX> expected;
+	ReferenceWorld(hierarchy, transforms, expected);
+	int badCount = 0;
+	for (size_t iii = 0; iii < expected.size(); ++iii)
+	{
+		if (!Near(expected[iii], hierarchy.GetWorldMatrix(static_cast<int>(iii))))
+			++badCount;
+	}
+	CHECK_EQUAL(0, badCount);
+
+	// The flags only cover the last Update
+	CHECK_EQUAL(static_cast<size_t>(0), hierarchy.Update());
+	CHECK(!hierarchy.WorldChanged(7));
+}
+
+// A parent has to be added before its children, which is what lets Update work in a single pass
+TEST_CASE(TransformHierarchyRejectsParentsAddedLater)
+{
+	TransformHierarchy hierarchy;
+	CHECK_THROWS(hierarchy.AddNode(0));
+	CHECK_THROWS(hierarchy.AddNode(-2));
+
+	CHECK_EQUAL(0, hierarchy.AddNode(TransformHierarchy::NO_PARENT));
+	CHECK_EQUAL(1, hierarchy.AddNode(0));
+	CHECK_THROWS(hierarchy.AddNode(2));
+	CHECK_EQUAL(static_cast<size_t>(2), hierarchy.NodeCount());
+
+	hierarchy.Clear();
+	CHECK_EQUAL(static_cast<size_t>(0), hierarchy.NodeCount());
+	CHECK_THROWS(hierarchy.AddNode(0));
+}
+
+// 20000 nodes: rebuilding every world matrix the way the recursive Drawable update did, against Update with
+// everything dirty, with 1% of the nodes moved and with nothing moved
+BENCHMARK(TransformHierarchyUpdate)
+{
+	const size_t count = 20000;
+	TransformHierarchy hierarchy;
+	std::vector<NodeTransform> transforms;
+	RandomHierarchy(count, hierarchy, transforms);
+	hierarchy.Update();
+
+	std::vector<XMMATRIX> world;
+	double referenceSeconds = Testing::BestTime(5, [&]()
+	{
+		ReferenceWorld(hierarchy, transforms, world);
+	});
+	Testing::DoNotOptimize(world.data());
+
+	double allSeconds = Testing::BestTime(5, [&]()
+	{
+		for (size_t iii = 0; iii < count; ++iii)
+		{
+			transforms[iii].yaw += 0.001f;
+			hierarchy.SetRotation(static_cast<int>(iii), transforms[iii].pitch, transforms[iii].yaw, transforms[iii].roll);
+		}
+		hierarchy.Update();
+	});
+
+	std::mt19937 random(25);
+	std::uniform_int_distribution<int> node(0, static_cast<int>(count) - 1);
+	size_t rebuilt = 0;
+	double fewSeconds = Testing::BestTime(5, [&]()
+	{
+		for (size_t iii = 0; iii < count / 100; ++iii)
+		{
+			int moved = node(random);
+			transforms[moved].yaw += 0.001f;
+			hierarchy.SetRotation(moved, transforms[moved].pitch, transforms[moved].yaw, transforms[moved].roll);
+		}
+		rebuilt = hierarchy.Update();
+	});
+
+	double noneSeconds = Testing::BestTime(5, [&]()
+	{
+		hierarchy.Update();
+	});
+	Testing::DoNotOptimize(&hierarchy.GetWorldMatrix(0));
+
+	printf("    %zu nodes\n", count);
+	printf("    matrix products           %7.3f ms\n", referenceSeconds * 1e3);
+	printf("    Update, all moved         %7.3f ms\n", allSeconds * 1e3);
+	printf("    Update, 1%% moved          %7.3f ms  (%zu rebuilt)\n", fewSeconds * 1e3, rebuilt);
+	printf("    Update, nothing moved     %7.3f ms\n", noneSeconds * 1e3);
+}
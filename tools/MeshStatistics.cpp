@@ -0,0 +1,144 @@
+#include "pch.h"
+#include "MeshOptimizer.h"
+#include "ModelCache.h"
+#include "ChameleonException.h"
+
+#include <assimp/Importer.hpp>
+#include <assimp/postprocess.h>
+
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <stdio.h>
+
+// Reports the post-transform vertex cache statistics of every mesh of a model before and after each MeshOptimizer
+// pass, the same way ModelCache::Write runs them when it cooks a model:
+//
+//		chameleon-meshstats [--cache-size <entries>] <model> [<model> ...]
+//
+// The model is imported with the same Assimp flags and converted with the same code as Drawable, so the numbers
+// are the ones of the meshes the engine actually draws. The cache size defaults to 16 entries, a FIFO the size of
+// the smallest post-transform caches in use; ACMR (transformed vertices per triangle) is at best 0.5 and at
+// worst 3, ATVR (transformed vertices per vertex) is at best 1.
+namespace
+{
+	struct Totals
+	{
+		size_t vertexCount = 0;
+		size_t triangleCount = 0;
+		size_t transformed[4] = {};
+	};
+
+	void PrintRow(const char* name, size_t vertexCount, size_t triangleCount, const size_t transformed[4])
+	{
+		printf("  %-28.28s %9zu %10zu ", name, vertexCount, triangleCount);
+		for (int pass = 0; pass < 4; ++pass)
+			printf(" %6.3f", triangleCount == 0 ? 0.0 : static_cast<double>(transformed[pass]) / triangleCount);
+		printf("   %6.3f %6.3f\n",
+			vertexCount == 0 ? 0.0 : static_cast<double>(transformed[0]) / vertexCount,
+			vertexCount == 0 ? 0.0 : static_cast<double>(transformed[3]) / vertexCount);
+	}
+
+	bool ReportModel(const char* filename, unsigned int cacheSize, Totals& totals)
+	{
+		Assimp::Importer importer;
+		const aiScene* scene = importer.ReadFile(filename, aiProcess_Triangulate | aiProcess_JoinIdenticalVertices);
+		if (scene == nullptr)
+		{
+			fprintf(stderr, "%s: %s\n", filename, importer.GetErrorString());
+			return false;
+		}
+
+		printf("%s\n", filename);
+		printf("  %-28s %9s %10s  %-27s   %-13s\n", "", "", "", "ACMR", "ATVR");
+		printf("  %-28s %9s %10s  %6s %6s %6s %6s   %6s %6s\n", "mesh", "vertices", "triangles", "import", "cache", "ovrdrw", "fetch", "import", "cooked");
+
+		Totals model;
+		std::vector<OBJVertex> vertices;
+		std::vector<unsigned int> indices;
+		for (unsigned int iii = 0; iii < scene->mNumMeshes; ++iii)
+		{
+			const aiMesh& mesh = *scene->mMeshes[iii];
+			ModelCache::ConvertMesh(mesh, vertices, indices);
+
+			size_t vertexCount = vertices.size();
+			size_t triangleCount = indices.size() / 3;
+			size_t transformed[4] = {};
+			transformed[0] = MeshOptimizer::AnalyzeVertexCache(indices, vertices.size(), cacheSize).transformedVertexCount;
+
+			if (!vertices.empty())
+			{
+				MeshOptimizer::OptimizeVertexCache(indices, vertices.size());
+				transformed[1] = MeshOptimizer::AnalyzeVertexCache(indices, vertices.size(), cacheSize).transformedVertexCount;
+
+				MeshOptimizer::OptimizeOverdraw(indices, &vertices[0].position, sizeof(OBJVertex), vertices.size());
+				transformed[2] = MeshOptimizer::AnalyzeVertexCache(indices, vertices.size(), cacheSize).transformedVertexCount;
+
+				// Only changes the order of the vertices (and drops unused ones), so the cache misses stay the same
+				MeshOptimizer::OptimizeVertexFetch(vertices, indices);
+				transformed[3] = MeshOptimizer::AnalyzeVertexCache(indices, vertices.size(), cacheSize).transformedVertexCount;
+			}
+
+			PrintRow(mesh.mName.C_Str(), vertexCount, triangleCount, transformed);
+
+			model.vertexCount += vertexCount;
+			model.triangleCount += triangleCount;
+			for (int pass = 0; pass < 4; ++pass)
+				model.transformed[pass] += transformed[pass];
+		}
+
+		PrintRow("(all meshes)", model.vertexCount, model.triangleCount, model.transformed);
+		printf("\n");
+
+		totals.vertexCount += model.vertexCount;
+		totals.triangleCount += model.triangleCount;
+		for (int pass = 0; pass < 4; ++pass)
+			totals.transformed[pass] += model.transformed[pass];
+		return true;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	unsigned int cacheSize = 16;
+	std::vector<const char*> filenames;
+
+	for (int iii = 1; iii < argc; ++iii)
+	{
+		if (strcmp(argv[iii], "--cache-size") == 0 && iii + 1 < argc)
+			cacheSize = static_cast<unsigned int>(std::max(atoi(argv[++iii]), 3));
+		else
+			filenames.push_back(argv[iii]);
+	}
+
+	if (filenames.empty())
+	{
+		fprintf(stderr, "usage: chameleon-meshstats [--cache-size <entries>] <model> [<model> ...]\n");
+		return 2;
+	}
+
+	printf("FIFO post-transform cache of %u entries\n\n", cacheSize);
+
+	Totals totals;
+	int failedCount = 0;
+	for (const char* filename : filenames)
+	{
+		try
+		{
+			if (!ReportModel(filename, cacheSize, totals))
+				++failedCount;
+		}
+		catch (const ChameleonException& e)
+		{
+			fprintf(stderr, "%s: %s\n", filename, e.what());
+			++failedCount;
+		}
+	}
+
+	if (filenames.size() > 1)
+		PrintRow("(all models)", totals.vertexCount, totals.triangleCount, totals.transformed);
+
+	return failedCount == 0 ? 0 : 1;
+}